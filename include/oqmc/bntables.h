@@ -15,7 +15,9 @@
 #include "encode.h"
 #include "gpu.h"
 
+#include <cassert>
 #include <cstdint>
+#include <cstring>
 
 namespace oqmc
 {
@@ -66,6 +68,71 @@ tableValue(std::uint16_t pixel, std::uint16_t shift,
 	};
 }
 
+/// Interleaved table entry.
+///
+/// This type stores the key and rank values for a single pixel next to each
+/// other, with the rank value reduced to 16 bits. The key is split into two 16
+/// bit halves so that the entry is 6 bytes in size with a 2 byte alignment.
+struct TableEntry
+{
+	std::uint16_t keyLow;  ///< Low 16 bits of key value.
+	std::uint16_t keyHigh; ///< High 16 bits of key value.
+	std::uint16_t rank;    ///< rank value to shuffle.
+};
+
+static_assert(sizeof(TableEntry) == 6, "TableEntry must be 6 bytes in size.");
+
+/// Pack a key and rank value pair into an entry.
+///
+/// Rank values are used to shuffle a 16 bit sample index, and must be less
+/// than 2^16 to be stored in the entry without loss.
+///
+/// @param [in] key Key value to store.
+/// @param [in] rank Rank value to store.
+/// @return Interleaved table entry.
+OQMC_HOST_DEVICE constexpr TableEntry packTableEntry(std::uint32_t key,
+                                                     std::uint32_t rank)
+{
+	return {
+	    static_cast<std::uint16_t>(key),
+	    static_cast<std::uint16_t>(key >> 16),
+	    static_cast<std::uint16_t>(rank),
+	};
+}
+
+/// Lookup value pair from interleaved table.
+///
+/// Equivalent to the tableValue() function above, but the key and rank value
+/// pair is read from a single table of interleaved entries. This means that a
+/// lookup will usually touch a single cache line rather than two.
+///
+/// @tparam XBits Precision along the X axis used for encoding.
+/// @tparam YBits Precision along the Y axis used for encoding.
+/// @tparam ZBits Precision along the Z axis used for encoding.
+/// @param [in] pixel Encoded pixel coordinate for lookup.
+/// @param [in] shift Encoded pixel shift for lookup.
+/// @param [in] table Table of interleaved entries.
+/// @return Key and rank pair from lookup.
+template <int XBits, int YBits, int ZBits>
+OQMC_HOST_DEVICE constexpr TableReturnValue
+tableValue(std::uint16_t pixel, std::uint16_t shift, const TableEntry table[])
+{
+	const auto pixelOffset = decodeBits16<XBits, YBits, ZBits>(pixel);
+	const auto shiftOffset = decodeBits16<XBits, YBits, ZBits>(shift);
+
+	const auto x = pixelOffset.x + shiftOffset.x;
+	const auto y = pixelOffset.y + shiftOffset.y;
+	const auto z = pixelOffset.z + shiftOffset.z;
+	const auto index = encodeBits16<XBits, YBits, ZBits>({x, y, z});
+
+	const auto entry = table[index];
+
+	return {
+	    static_cast<std::uint32_t>(entry.keyHigh) << 16 | entry.keyLow,
+	    entry.rank,
+	};
+}
+
 constexpr auto xBits = 8;                   ///< 256 pixels in x.
 constexpr auto yBits = 8;                   ///< 256 pixels in y.
 constexpr auto size = 1 << (xBits + yBits); ///< 2^16 table size.
@@ -157,6 +224,191 @@ constexpr std::uint32_t rankTable[] = {
 
 } // namespace lattice
 
+/// Spatio-temporal blue noise tables.
+///
+/// Tables in this namespace place the frame index along the Z axis, so that
+/// each 2D slice is spatial blue noise, and each pixel has a blue noise
+/// sequence of values over consecutive frames. Tables were optimised using a
+/// combined spatial and temporal energy term with the optimise cli tool. These
+/// tables are preliminary, as they were optimised with reduced settings.
+///
+/// Spatio-temporal samplers encode the pixel and frame of a sample in the pixel
+/// id with xBits, yBits and zBits, and seed the pattern with the frame shifted
+/// down by zBits. Consecutive frames within a block of 2^zBits then share the
+/// same random shift into the table and walk along its Z axis, and each block
+/// of frames uses a new random shift.
+namespace temporal
+{
+
+constexpr auto xBits = 5;                           ///< 32 pixels in x.
+constexpr auto yBits = 5;                           ///< 32 pixels in y.
+constexpr auto zBits = 4;                           ///< 16 frames in z.
+constexpr auto size = 1 << (xBits + yBits + zBits); ///< 2^14 table size.
+
+static_assert(xBits == yBits,
+              "Optimisation tables have equal resolution in x and y");
+
+namespace pmj
+{
+
+#if defined(OQMC_ENABLE_BINARY)
+
+/// Optimised spatio-temporal blue noise key table for pmj.
+extern const std::uint32_t keyTable[size];
+
+/// Optimised spatio-temporal blue noise rank table for pmj.
+extern const std::uint32_t rankTable[size];
+
+#else
+
+/// Optimised spatio-temporal blue noise key table for pmj.
+constexpr std::uint32_t keyTable[] = {
+#include "data/temporal/pmj/keys.txt"
+};
+
+/// Optimised spatio-temporal blue noise rank table for pmj.
+constexpr std::uint32_t rankTable[] = {
+#include "data/temporal/pmj/ranks.txt"
+};
+
+#endif
+
+} // namespace pmj
+
+namespace sobol
+{
+
+#if defined(OQMC_ENABLE_BINARY)
+
+/// Optimised spatio-temporal blue noise key table for sobol.
+extern const std::uint32_t keyTable[size];
+
+/// Optimised spatio-temporal blue noise rank table for sobol.
+extern const std::uint32_t rankTable[size];
+
+#else
+
+/// Optimised spatio-temporal blue noise key table for sobol.
+constexpr std::uint32_t keyTable[] = {
+#include "data/temporal/sobol/keys.txt"
+};
+
+/// Optimised spatio-temporal blue noise rank table for sobol.
+constexpr std::uint32_t rankTable[] = {
+#include "data/temporal/sobol/ranks.txt"
+};
+
+#endif
+
+} // namespace sobol
+
+namespace lattice
+{
+
+#if defined(OQMC_ENABLE_BINARY)
+
+/// Optimised spatio-temporal blue noise key table for lattice.
+extern const std::uint32_t keyTable[size];
+
+/// Optimised spatio-temporal blue noise rank table for lattice.
+extern const std::uint32_t rankTable[size];
+
+#else
+
+/// Optimised spatio-temporal blue noise key table for lattice.
+constexpr std::uint32_t keyTable[] = {
+#include "data/temporal/lattice/keys.txt"
+};
+
+/// Optimised spatio-temporal blue noise rank table for lattice.
+constexpr std::uint32_t rankTable[] = {
+#include "data/temporal/lattice/ranks.txt"
+};
+
+#endif
+
+} // namespace lattice
+
+} // namespace temporal
+
+/// Blue noise table cache.
+///
+/// Copy of the key and rank tables used by the blue noise sampler variants. By
+/// default the tables are stored as two separate arrays of 32 bit values. When
+/// OQMC_COMPACT_TABLES is defined the tables are interleaved into a single
+/// array of TableEntry values, which reduces the cache size by a quarter and
+/// keeps the key and rank of a pixel within the same cache line.
+///
+/// @tparam Size Number of entries in each table.
+template <int Size>
+struct TableCache
+{
+#if defined(OQMC_COMPACT_TABLES)
+	TableEntry entries[Size]; ///< Interleaved key and rank values.
+#else
+	std::uint32_t keyTable[Size];  ///< Table of key values.
+	std::uint32_t rankTable[Size]; ///< Table of rank values.
+#endif
+};
+
+/// Initialise a cache from key and rank tables.
+///
+/// Copy the key and rank tables into the cache using the layout selected at
+/// compile time.
+///
+/// @tparam Size Number of entries in each table.
+/// @param [in] keyTable Table of key values.
+/// @param [in] rankTable Table of rank values.
+/// @param [out] cache Cache to initialise.
+template <int Size>
+void initialiseTableCache(const std::uint32_t keyTable[],
+                          const std::uint32_t rankTable[],
+                          TableCache<Size>* cache)
+{
+	assert(cache);
+
+#if defined(OQMC_COMPACT_TABLES)
+	for(int i = 0; i < Size; ++i)
+	{
+		assert(rankTable[i] <= UINT16_MAX);
+
+		cache->entries[i] = packTableEntry(keyTable[i], rankTable[i]);
+	}
+#else
+	std::memcpy(cache->keyTable, keyTable, sizeof(cache->keyTable));
+	std::memcpy(cache->rankTable, rankTable, sizeof(cache->rankTable));
+#endif
+}
+
+/// Lookup value pair from cache.
+///
+/// Equivalent to the tableValue() functions above, using the layout of the
+/// cache selected at compile time.
+///
+/// @tparam XBits Precision along the X axis used for encoding.
+/// @tparam YBits Precision along the Y axis used for encoding.
+/// @tparam ZBits Precision along the Z axis used for encoding.
+/// @tparam Size Number of entries in each table.
+/// @param [in] pixel Encoded pixel coordinate for lookup.
+/// @param [in] shift Encoded pixel shift for lookup.
+/// @param [in] cache Initialised table cache.
+/// @return Key and rank pair from lookup.
+template <int XBits, int YBits, int ZBits, int Size>
+OQMC_HOST_DEVICE constexpr TableReturnValue
+tableValue(std::uint16_t pixel, std::uint16_t shift,
+           const TableCache<Size>& cache)
+{
+	static_assert(1 << (XBits + YBits + ZBits) == Size,
+	              "Encoding precision must match cache size.");
+
+#if defined(OQMC_COMPACT_TABLES)
+	return tableValue<XBits, YBits, ZBits>(pixel, shift, cache.entries);
+#else
+	return tableValue<XBits, YBits, ZBits>(pixel, shift, cache.keyTable,
+	                                       cache.rankTable);
+#endif
+}
+
 } // namespace bntables
 
 } // namespace oqmc
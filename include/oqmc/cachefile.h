@@ -0,0 +1,199 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Contributors to the OpenQMC Project.
+
+/// @file
+/// @details Versioned binary layout to store an initialised sampler cache
+/// outside of the process. A cache file can be written once, and then mapped
+/// read-only into memory by any number of processes, removing the cost of
+/// cache initialisation from process startup.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace oqmc
+{
+
+/// Magic number at the start of a cache file, the characters 'OQMC'.
+///
+/// @ingroup utilities
+constexpr std::uint32_t cacheFileMagic = 0x434d514f;
+
+/// Version of the cache file header layout.
+///
+/// @ingroup utilities
+constexpr std::uint32_t cacheFileVersion = 1;
+
+/// Header at the start of a cache file.
+///
+/// The header is followed directly by the cache data as initialised by the
+/// sampler type. The size of the header is 64 bytes, so the cache data is well
+/// aligned when the file is mapped to the start of a page. All values are
+/// stored in the byte order of the machine that wrote the file, a file written
+/// with a different byte order is rejected by the magic number.
+///
+/// @ingroup utilities
+struct CacheFileHeader
+{
+	std::uint32_t magic;        ///< Equal to oqmc::cacheFileMagic.
+	std::uint32_t version;      ///< Equal to oqmc::cacheFileVersion.
+	std::uint32_t cacheId;      ///< Sampler type cacheId value.
+	std::uint32_t cacheVersion; ///< Sampler type cacheVersion value.
+	std::uint64_t cacheSize;    ///< Sampler type cacheSize value.
+	std::uint32_t checksum;     ///< Checksum of the cache data.
+	std::uint32_t reserved[9];  ///< Reserved, set to zero.
+};
+
+static_assert(sizeof(CacheFileHeader) == 64, "Header must be 64 bytes.");
+
+/// Compute a checksum of cache data.
+///
+/// Computes an FNV-1a hash over the data, consuming 32 bit words at a time,
+/// with a final pass over any remaining bytes. This is not intended to detect
+/// malicious changes, only truncated or corrupt files.
+///
+/// @ingroup utilities
+/// @param [in] data Pointer to the cache data.
+/// @param [in] size Size of the cache data in bytes.
+/// @return Checksum value.
+inline std::uint32_t cacheChecksum(const void* data, std::size_t size)
+{
+	constexpr std::uint32_t basis = 0x811c9dc5;
+	constexpr std::uint32_t prime = 0x01000193;
+
+	const auto bytes = static_cast<const unsigned char*>(data);
+
+	auto hash = basis;
+	std::size_t i = 0;
+
+	for(; i + sizeof(std::uint32_t) <= size; i += sizeof(std::uint32_t))
+	{
+		std::uint32_t word;
+		std::memcpy(&word, bytes + i, sizeof(word));
+
+		hash ^= word;
+		hash *= prime;
+	}
+
+	for(; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= prime;
+	}
+
+	return hash;
+}
+
+/// Size of a cache file for a given sampler type.
+///
+/// Computes the number of bytes needed to store the header and cache data for
+/// a sampler type. Use this to allocate memory prior to calling
+/// initialiseCacheFile, or to validate the size of an existing file.
+///
+/// @ingroup utilities
+/// @tparam Sampler Sampler type, or a packet of a sampler type.
+/// @return Size of the cache file in bytes.
+template <typename Sampler>
+constexpr std::size_t cacheFileSize()
+{
+	return sizeof(CacheFileHeader) + Sampler::cacheSize;
+}
+
+/// Initialise the contents of a cache file.
+///
+/// Given an allocation of cacheFileSize bytes, initialise the cache data of
+/// a sampler type and write a header describing it. The resulting bytes can
+/// then be written to a file as is. The allocation must be aligned to at least
+/// 8 bytes. The cache is initialised using a loop function, as described by
+/// oqmc::SamplerInterface::initialiseCache.
+///
+/// @ingroup utilities
+/// @tparam Sampler Sampler type, or a packet of a sampler type.
+/// @param [out] file Allocation of cacheFileSize bytes.
+/// @param [in] forloop Loop function to run independent ranges.
+template <typename Sampler, typename ForLoop>
+void initialiseCacheFile(void* file, ForLoop forloop)
+{
+	const auto data = static_cast<char*>(file) + sizeof(CacheFileHeader);
+	Sampler::initialiseCache(data, forloop);
+
+	CacheFileHeader header{};
+	header.magic = cacheFileMagic;
+	header.version = cacheFileVersion;
+	header.cacheId = Sampler::cacheId;
+	header.cacheVersion = Sampler::cacheVersion;
+	header.cacheSize = Sampler::cacheSize;
+	header.checksum = cacheChecksum(data, Sampler::cacheSize);
+
+	std::memcpy(file, &header, sizeof(header));
+}
+
+/// Initialise the contents of a cache file.
+///
+/// Serial version of the function above.
+///
+/// @ingroup utilities
+/// @tparam Sampler Sampler type, or a packet of a sampler type.
+/// @param [out] file Allocation of cacheFileSize bytes.
+template <typename Sampler>
+void initialiseCacheFile(void* file)
+{
+	initialiseCacheFile<Sampler>(file, [](int size, auto func) {
+		for(int i = 0; i < size; ++i)
+		{
+			func(i);
+		}
+	});
+}
+
+/// Validate a cache file and return the cache data.
+///
+/// Given the contents of a cache file, for example a read-only memory mapping,
+/// check that the header matches the sampler type and the version of the
+/// library. On success, return a pointer to the cache data that can be passed
+/// directly to the sampler constructor, without copying or initialisation.
+///
+/// Verifying the checksum touches every byte of the cache data, which would
+/// fault in all pages of a lazy mapping. When this cost is undesirable the
+/// checksum can be skipped, and only the header is validated.
+///
+/// @ingroup utilities
+/// @tparam Sampler Sampler type, or a packet of a sampler type.
+/// @param [in] file Contents of a cache file.
+/// @param [in] size Size of the contents in bytes.
+/// @param [in] verifyChecksum Whether to verify the checksum of the data.
+/// @return Pointer to the cache data, or nullptr if the file is not valid.
+template <typename Sampler>
+const void* cacheFileData(const void* file, std::size_t size,
+                          bool verifyChecksum = true)
+{
+	if(file == nullptr || size != cacheFileSize<Sampler>())
+	{
+		return nullptr;
+	}
+
+	CacheFileHeader header;
+	std::memcpy(&header, file, sizeof(header));
+
+	if(header.magic != cacheFileMagic || header.version != cacheFileVersion ||
+	   header.cacheId != Sampler::cacheId ||
+	   header.cacheVersion != Sampler::cacheVersion ||
+	   header.cacheSize != Sampler::cacheSize)
+	{
+		return nullptr;
+	}
+
+	const auto data = static_cast<const char*>(file) + sizeof(CacheFileHeader);
+
+	if(verifyChecksum &&
+	   header.checksum != cacheChecksum(data, Sampler::cacheSize))
+	{
+		return nullptr;
+	}
+
+	return data;
+}
+
+} // namespace oqmc
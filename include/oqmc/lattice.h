@@ -7,6 +7,8 @@
 #pragma once
 
 #include "gpu.h"
+#include "pcg.h"
+#include "permute.h"
 #include "rank1.h"
 #include "sampler.h"
 #include "state.h"
@@ -19,76 +21,147 @@ namespace oqmc
 {
 
 /// @cond
-class LatticeImpl
+template <typename State>
+class BasicLatticeImpl
 {
 	// See SamplerInterface for public API documentation.
-	friend SamplerInterface<LatticeImpl>;
+	friend SamplerInterface<BasicLatticeImpl>;
+
+	// See PacketInterface for public API documentation.
+	template <typename, int>
+	friend class PacketInterface;
 
 	static constexpr std::size_t cacheSize = 0;
+	static constexpr std::uint32_t cacheId = 0x5aae6265;
+	static constexpr std::uint32_t cacheVersion = 1;
+	static constexpr auto maxDrawValue = 4;
 	static void initialiseCache(void* cache);
 
-	/*AUTO_DEFINED*/ LatticeImpl() = default;
-	OQMC_HOST_DEVICE LatticeImpl(State64Bit state);
-	OQMC_HOST_DEVICE LatticeImpl(int x, int y, int frame, int index,
-	                             const void* cache);
+	/*AUTO_DEFINED*/ BasicLatticeImpl() = default;
+	OQMC_HOST_DEVICE BasicLatticeImpl(State state);
+	OQMC_HOST_DEVICE BasicLatticeImpl(int x, int y, int frame, int index,
+	                                  const void* cache);
 
-	OQMC_HOST_DEVICE LatticeImpl newDomain(int key) const;
-	OQMC_HOST_DEVICE LatticeImpl newDomainSplit(int key, int size,
-	                                            int index) const;
-	OQMC_HOST_DEVICE LatticeImpl newDomainDistrib(int key, int index) const;
+	OQMC_HOST_DEVICE BasicLatticeImpl newDomain(int key) const;
+	OQMC_HOST_DEVICE BasicLatticeImpl newDomainSplit(int key, int size,
+	                                                 int index) const;
+	OQMC_HOST_DEVICE BasicLatticeImpl newDomainDistrib(int key,
+	                                                   int index) const;
+	OQMC_HOST_DEVICE BasicLatticeImpl newDomainPath(DomainPath path) const;
 
 	template <int Size>
 	OQMC_HOST_DEVICE void drawSample(std::uint32_t sample[Size]) const;
 
+	template <int Size>
+	OQMC_HOST_DEVICE void drawSampleBatch(int begin, int end,
+	                                      std::uint32_t sample[]) const;
+
 	template <int Size>
 	OQMC_HOST_DEVICE void drawRnd(std::uint32_t rnd[Size]) const;
 
-	State64Bit state;
+	OQMC_HOST_DEVICE State rndDomain() const;
+
+	State state;
 };
 
-inline void LatticeImpl::initialiseCache(void* cache)
+using LatticeImpl = BasicLatticeImpl<State64Bit>;
+
+template <typename State>
+void BasicLatticeImpl<State>::initialiseCache(void* cache)
 {
 	OQMC_MAYBE_UNUSED(cache);
 }
 
-inline LatticeImpl::LatticeImpl(State64Bit state) : state(state)
+template <typename State>
+BasicLatticeImpl<State>::BasicLatticeImpl(State state) : state(state)
 {
 }
 
-inline LatticeImpl::LatticeImpl(int x, int y, int frame, int index,
-                                const void* cache)
+template <typename State>
+BasicLatticeImpl<State>::BasicLatticeImpl(int x, int y, int frame, int index,
+                                          const void* cache)
     : state(x, y, frame, index)
 {
 	OQMC_MAYBE_UNUSED(cache);
 	state = state.pixelDecorrelate();
 }
 
-inline LatticeImpl LatticeImpl::newDomain(int key) const
+template <typename State>
+BasicLatticeImpl<State> BasicLatticeImpl<State>::newDomain(int key) const
 {
 	return {state.newDomain(key)};
 }
 
-inline LatticeImpl LatticeImpl::newDomainSplit(int key, int size,
-                                               int index) const
+template <typename State>
+BasicLatticeImpl<State>
+BasicLatticeImpl<State>::newDomainSplit(int key, int size, int index) const
 {
 	return {state.newDomainSplit(key, size, index)};
 }
 
-inline LatticeImpl LatticeImpl::newDomainDistrib(int key, int index) const
+template <typename State>
+BasicLatticeImpl<State>
+BasicLatticeImpl<State>::newDomainDistrib(int key, int index) const
 {
 	return {state.newDomainDistrib(key, index)};
 }
 
+template <typename State>
+BasicLatticeImpl<State>
+BasicLatticeImpl<State>::newDomainPath(DomainPath path) const
+{
+	return {state.newDomainPath(path)};
+}
+
+template <typename State>
 template <int Size>
-void LatticeImpl::drawSample(std::uint32_t sample[Size]) const
+void BasicLatticeImpl<State>::drawSample(std::uint32_t sample[Size]) const
 {
+	// The lattice is already computed at 32 bits of precision, so the full
+	// sampleId of a wider state can be used directly.
 	shuffledRotatedLattice<Size>(state.sampleId, state.patternId, sample);
 }
 
+template <typename State>
 template <int Size>
-void LatticeImpl::drawRnd(std::uint32_t rnd[Size]) const
+void BasicLatticeImpl<State>::drawSampleBatch(int begin, int end,
+                                              std::uint32_t sample[]) const
 {
-	state.drawRnd<Size>(rnd);
+	const auto hash = pcg::output(state.patternId);
+	const auto count = end - begin;
+
+	auto rngState = state.patternId;
+
+	std::uint32_t distances[Size];
+	for(int i = 0; i < Size; ++i)
+	{
+		distances[i] = pcg::rng(rngState);
+	}
+
+	for(int i = 0; i < count; ++i)
+	{
+		const auto index = State::computeSampleId(begin + i);
+		const auto shuffled = reverseAndShuffle(index, hash);
+
+		for(int j = 0; j < Size; ++j)
+		{
+			const auto value = latticeReversedIndex(shuffled, j);
+			sample[j * count + i] = rotate(value, distances[j]);
+		}
+	}
+}
+
+template <typename State>
+State BasicLatticeImpl<State>::rndDomain() const
+{
+	return state;
+}
+
+template <typename State>
+template <int Size>
+void BasicLatticeImpl<State>::drawRnd(std::uint32_t rnd[Size]) const
+{
+	rndDomain().template drawRnd<Size>(rnd);
 }
 /// @endcond
 
@@ -108,4 +181,18 @@ void LatticeImpl::drawRnd(std::uint32_t rnd[Size]) const
 /// @ingroup samplers
 using LatticeSampler = SamplerInterface<LatticeImpl>;
 
+/// Rank one lattice sampler with a selectable state type.
+///
+/// Equivalent to the LatticeSampler when the State is oqmc::State64Bit. Using
+/// oqmc::State96Bit instead gives a sampler that uses the full 32 bit index,
+/// keeping progressive stratification beyond 2^16 samples per pixel. As the
+/// lattice is already computed at 32 bits of precision, this has no additional
+/// cost per draw sample call.
+///
+/// @ingroup samplers
+/// @tparam State Sampler state type, either oqmc::State64Bit or
+/// oqmc::State96Bit.
+template <typename State>
+using BasicLatticeSampler = SamplerInterface<BasicLatticeImpl<State>>;
+
 } // namespace oqmc
@@ -9,6 +9,7 @@
 #include "bntables.h"
 #include "gpu.h"
 #include "pcg.h"
+#include "permute.h"
 #include "rank1.h"
 #include "sampler.h"
 #include "state.h"
@@ -16,7 +17,6 @@
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
-#include <cstring>
 
 namespace oqmc
 {
@@ -27,13 +27,19 @@ class LatticeBnImpl
 	// See SamplerInterface for public API documentation.
 	friend SamplerInterface<LatticeBnImpl>;
 
+	// See PacketInterface for public API documentation.
+	template <typename, int>
+	friend class PacketInterface;
+
 	struct CacheType
 	{
-		std::uint32_t keyTable[bntables::size];
-		std::uint32_t rankTable[bntables::size];
+		bntables::TableCache<bntables::size> tables;
 	};
 
 	static constexpr std::size_t cacheSize = sizeof(CacheType);
+	static constexpr std::uint32_t cacheId = 0x804c2b71;
+	static constexpr std::uint32_t cacheVersion = 1;
+	static constexpr auto maxDrawValue = 4;
 	static void initialiseCache(void* cache);
 
 	/*AUTO_DEFINED*/ LatticeBnImpl() = default;
@@ -45,13 +51,20 @@ class LatticeBnImpl
 	OQMC_HOST_DEVICE LatticeBnImpl newDomainSplit(int key, int size,
 	                                              int index) const;
 	OQMC_HOST_DEVICE LatticeBnImpl newDomainDistrib(int key, int index) const;
+	OQMC_HOST_DEVICE LatticeBnImpl newDomainPath(DomainPath path) const;
 
 	template <int Size>
 	OQMC_HOST_DEVICE void drawSample(std::uint32_t sample[Size]) const;
 
+	template <int Size>
+	OQMC_HOST_DEVICE void drawSampleBatch(int begin, int end,
+	                                      std::uint32_t sample[]) const;
+
 	template <int Size>
 	OQMC_HOST_DEVICE void drawRnd(std::uint32_t rnd[Size]) const;
 
+	OQMC_HOST_DEVICE State64Bit rndDomain() const;
+
 	State64Bit state;
 	const CacheType* cache;
 };
@@ -62,10 +75,9 @@ inline void LatticeBnImpl::initialiseCache(void* cache)
 
 	auto typedCache = static_cast<CacheType*>(cache);
 
-	std::memcpy(typedCache->keyTable, bntables::lattice::keyTable,
-	            sizeof(bntables::lattice::keyTable));
-	std::memcpy(typedCache->rankTable, bntables::lattice::rankTable,
-	            sizeof(bntables::lattice::rankTable));
+	bntables::initialiseTableCache(bntables::lattice::keyTable,
+	                               bntables::lattice::rankTable,
+	                               &typedCache->tables);
 }
 
 inline LatticeBnImpl::LatticeBnImpl(State64Bit state, const CacheType* cache)
@@ -97,6 +109,11 @@ inline LatticeBnImpl LatticeBnImpl::newDomainDistrib(int key, int index) const
 	return {state.newDomainDistrib(key, index), cache};
 }
 
+inline LatticeBnImpl LatticeBnImpl::newDomainPath(DomainPath path) const
+{
+	return {state.newDomainPath(path), cache};
+}
+
 template <int Size>
 void LatticeBnImpl::drawSample(std::uint32_t sample[Size]) const
 {
@@ -109,17 +126,55 @@ void LatticeBnImpl::drawSample(std::uint32_t sample[Size]) const
 	              "Pixel y encoding must match table.");
 
 	const auto table = bntables::tableValue<xBits, yBits, 0>(
-	    state.pixelId, pcg::output(state.patternId), cache->keyTable,
-	    cache->rankTable);
+	    state.pixelId, pcg::output(state.patternId), cache->tables);
 
 	shuffledRotatedLattice<Size>(state.sampleId ^ table.rank, table.key,
 	                             sample);
 }
 
+template <int Size>
+void LatticeBnImpl::drawSampleBatch(int begin, int end,
+                                    std::uint32_t sample[]) const
+{
+	constexpr auto xBits = State64Bit::spatialEncodeBitSizeX;
+	constexpr auto yBits = State64Bit::spatialEncodeBitSizeY;
+
+	const auto table = bntables::tableValue<xBits, yBits, 0>(
+	    state.pixelId, pcg::output(state.patternId), cache->tables);
+
+	const auto hash = pcg::output(table.key);
+	const auto count = end - begin;
+
+	auto rngState = table.key;
+
+	std::uint32_t distances[Size];
+	for(int i = 0; i < Size; ++i)
+	{
+		distances[i] = pcg::rng(rngState);
+	}
+
+	for(int i = 0; i < count; ++i)
+	{
+		const std::uint32_t index = computeIndexId(begin + i);
+		const auto shuffled = reverseAndShuffle(index ^ table.rank, hash);
+
+		for(int j = 0; j < Size; ++j)
+		{
+			const auto value = latticeReversedIndex(shuffled, j);
+			sample[j * count + i] = rotate(value, distances[j]);
+		}
+	}
+}
+
+inline State64Bit LatticeBnImpl::rndDomain() const
+{
+	return state.newDomain(state.pixelId);
+}
+
 template <int Size>
 void LatticeBnImpl::drawRnd(std::uint32_t rnd[Size]) const
 {
-	state.newDomain(state.pixelId).drawRnd<Size>(rnd);
+	rndDomain().drawRnd<Size>(rnd);
 }
 /// @endcond
 
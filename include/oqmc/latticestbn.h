@@ -0,0 +1,198 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Contributors to the OpenQMC Project.
+
+/// @file
+/// @details Latticestbn sampler implementation.
+
+#pragma once
+
+#include "bntables.h"
+#include "encode.h"
+#include "gpu.h"
+#include "pcg.h"
+#include "permute.h"
+#include "rank1.h"
+#include "sampler.h"
+#include "state.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace oqmc
+{
+
+/// @cond
+class LatticeStBnImpl
+{
+	// See SamplerInterface for public API documentation.
+	friend SamplerInterface<LatticeStBnImpl>;
+
+	// See PacketInterface for public API documentation.
+	template <typename, int>
+	friend class PacketInterface;
+
+	struct CacheType
+	{
+		bntables::TableCache<bntables::temporal::size> tables;
+	};
+
+	static constexpr std::size_t cacheSize = sizeof(CacheType);
+	static constexpr std::uint32_t cacheId = 0x536a29aa;
+	static constexpr std::uint32_t cacheVersion = 1;
+	static constexpr auto maxDrawValue = 4;
+	static void initialiseCache(void* cache);
+
+	/*AUTO_DEFINED*/ LatticeStBnImpl() = default;
+	OQMC_HOST_DEVICE LatticeStBnImpl(State64Bit state, const CacheType* cache);
+	OQMC_HOST_DEVICE LatticeStBnImpl(int x, int y, int frame, int index,
+	                                 const void* cache);
+
+	OQMC_HOST_DEVICE LatticeStBnImpl newDomain(int key) const;
+	OQMC_HOST_DEVICE LatticeStBnImpl newDomainSplit(int key, int size,
+	                                                int index) const;
+	OQMC_HOST_DEVICE LatticeStBnImpl newDomainDistrib(int key, int index) const;
+	OQMC_HOST_DEVICE LatticeStBnImpl newDomainPath(DomainPath path) const;
+
+	template <int Size>
+	OQMC_HOST_DEVICE void drawSample(std::uint32_t sample[Size]) const;
+
+	template <int Size>
+	OQMC_HOST_DEVICE void drawSampleBatch(int begin, int end,
+	                                      std::uint32_t sample[]) const;
+
+	template <int Size>
+	OQMC_HOST_DEVICE void drawRnd(std::uint32_t rnd[Size]) const;
+
+	OQMC_HOST_DEVICE State64Bit rndDomain() const;
+
+	State64Bit state;
+	const CacheType* cache;
+};
+
+inline void LatticeStBnImpl::initialiseCache(void* cache)
+{
+	assert(cache);
+
+	auto typedCache = static_cast<CacheType*>(cache);
+
+	bntables::initialiseTableCache(
+	    bntables::temporal::lattice::keyTable,
+	    bntables::temporal::lattice::rankTable,
+	    &typedCache->tables);
+}
+
+inline LatticeStBnImpl::LatticeStBnImpl(State64Bit state,
+                                        const CacheType* cache)
+    : state(state), cache(cache)
+{
+	assert(cache);
+}
+
+inline LatticeStBnImpl::LatticeStBnImpl(int x, int y, int frame, int index,
+                                        const void* cache)
+    : state(x, y, frame >> bntables::temporal::zBits, index),
+      cache(static_cast<const CacheType*>(cache))
+{
+	assert(cache);
+
+	constexpr auto xBits = bntables::temporal::xBits;
+	constexpr auto yBits = bntables::temporal::yBits;
+	constexpr auto zBits = bntables::temporal::zBits;
+
+	// Frames index the Z axis of the table, see bntables::temporal.
+	state.pixelId = encodeBits16<xBits, yBits, zBits>({x, y, frame});
+}
+
+inline LatticeStBnImpl LatticeStBnImpl::newDomain(int key) const
+{
+	return {state.newDomain(key), cache};
+}
+
+inline LatticeStBnImpl LatticeStBnImpl::newDomainSplit(int key, int size,
+                                                       int index) const
+{
+	return {state.newDomainSplit(key, size, index), cache};
+}
+
+inline LatticeStBnImpl LatticeStBnImpl::newDomainDistrib(int key,
+                                                         int index) const
+{
+	return {state.newDomainDistrib(key, index), cache};
+}
+
+inline LatticeStBnImpl LatticeStBnImpl::newDomainPath(DomainPath path) const
+{
+	return {state.newDomainPath(path), cache};
+}
+
+template <int Size>
+void LatticeStBnImpl::drawSample(std::uint32_t sample[Size]) const
+{
+	constexpr auto xBits = bntables::temporal::xBits;
+	constexpr auto yBits = bntables::temporal::yBits;
+	constexpr auto zBits = bntables::temporal::zBits;
+
+	const auto table = bntables::tableValue<xBits, yBits, zBits>(
+	    state.pixelId, pcg::output(state.patternId), cache->tables);
+
+	shuffledRotatedLattice<Size>(state.sampleId ^ table.rank, table.key,
+	                             sample);
+}
+
+template <int Size>
+void LatticeStBnImpl::drawSampleBatch(int begin, int end,
+                                      std::uint32_t sample[]) const
+{
+	constexpr auto xBits = bntables::temporal::xBits;
+	constexpr auto yBits = bntables::temporal::yBits;
+	constexpr auto zBits = bntables::temporal::zBits;
+
+	const auto table = bntables::tableValue<xBits, yBits, zBits>(
+	    state.pixelId, pcg::output(state.patternId), cache->tables);
+
+	const auto hash = pcg::output(table.key);
+	const auto count = end - begin;
+
+	auto rngState = table.key;
+
+	std::uint32_t distances[Size];
+	for(int i = 0; i < Size; ++i)
+	{
+		distances[i] = pcg::rng(rngState);
+	}
+
+	for(int i = 0; i < count; ++i)
+	{
+		const std::uint32_t index = computeIndexId(begin + i);
+		const auto shuffled = reverseAndShuffle(index ^ table.rank, hash);
+
+		for(int j = 0; j < Size; ++j)
+		{
+			const auto value = latticeReversedIndex(shuffled, j);
+			sample[j * count + i] = rotate(value, distances[j]);
+		}
+	}
+}
+
+inline State64Bit LatticeStBnImpl::rndDomain() const
+{
+	return state.newDomain(state.pixelId);
+}
+
+template <int Size>
+void LatticeStBnImpl::drawRnd(std::uint32_t rnd[Size]) const
+{
+	rndDomain().drawRnd<Size>(rnd);
+}
+/// @endcond
+
+/// Spatio-temporal blue noise variant of lattice sampler.
+///
+/// Same as oqmc::LatticeBnSampler, with the frame index along the Z axis of the
+/// oqmc::bntables::temporal tables.
+///
+/// @ingroup samplers
+using LatticeStBnSampler = SamplerInterface<LatticeStBnImpl>;
+
+} // namespace oqmc
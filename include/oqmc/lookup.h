@@ -74,4 +74,40 @@ shuffledScrambledLookup(std::uint32_t index, std::uint32_t hash,
 	}
 }
 
+/// Compute a randomised value from a partially pre-computed table.
+///
+/// Same as shuffledScrambledLookup(), but the index is shuffled using
+/// levelShuffle(). An index less than 2^n then only reads from the first 2^n
+/// elements of the table, so the table only needs to be initialised for the
+/// range of indices that are used.
+///
+/// @ingroup utilities
+/// @tparam Table Dimensional size of input table.
+/// @tparam Depth Dimensional space of output, up to 4 dimensions.
+/// @param [in] index Input index of sequence value.
+/// @param [in] hash Hashed seed to randomise the sequence.
+/// @param [in] table Pre-computed input table.
+/// @param [out] sample Randomised sequence value.
+/// @pre Table input must be pre-computed up to the power of two level of index.
+template <int Table, int Depth>
+OQMC_HOST_DEVICE inline void
+shuffledScrambledLevelLookup(std::uint32_t index, std::uint32_t hash,
+                             const std::uint32_t table[][Table],
+                             std::uint32_t sample[Depth])
+{
+	static_assert(Table >= Depth, "Table size is greater or equal to Depth.");
+	static_assert(Depth >= 1, "Pattern depth is greater or equal to one.");
+	static_assert(Depth <= 4, "Pattern depth is less or equal to four.");
+
+	index = levelShuffle(index, hash);
+
+	for(int i = 0; i < Depth; ++i)
+	{
+		constexpr auto indexMask = 0xffff;
+
+		sample[i] = table[index & indexMask][i];
+		sample[i] = randomDigitScramble(sample[i], rotateBytes(hash, i));
+	}
+}
+
 } // namespace oqmc
@@ -33,52 +33,38 @@
 namespace oqmc
 {
 
-/// Compute sobol sequence value at an index with reversed bits.
+/// @cond
+struct SobolMatrix
+{
+	std::uint16_t columns[16];
+};
+
+struct SobolMatrix32
+{
+	std::uint32_t columns[32];
+};
+/// @endcond
+
+/// Sobol sequence generator matrix for a dimension.
 ///
-/// Given a 16 bit index, where the order of bits in the index have been
-/// reversed, compute a sobol sequence value to 16 bits of precision for a given
-/// dimension. Dimensions must be within the range [0, 4).
+/// Get the 16 generator matrix columns of a sobol sequence dimension, ordered
+/// so that they can be applied to an index with reversed bits. Dimensions must
+/// be within the range [0, 4).
 ///
-/// @param [in] index Bit reversed index of element.
 /// @param [in] dimension Dimension of sobol sequence.
-/// @return Sobol sequence value.
-OQMC_HOST_DEVICE inline std::uint16_t sobolReversedIndex(std::uint16_t index,
-                                                         int dimension)
+/// @return Generator matrix columns.
+OQMC_HOST_DEVICE constexpr SobolMatrix sobolMatrix(int dimension)
 {
 	assert(dimension >= 0);
 	assert(dimension <= 3);
 
-	if(dimension == 0)
-	{
-		return reverseBits16(index);
-	}
-
 	// Following matrices were produced using the matrices cli tool found in the
 	// source file src/tools/cli/matrices.cpp. This in turn uses matrices that
 	// were copied from MIT licensed code written by Leonhard Gruenschloss.
 
 	// clang-format off
-	constexpr std::uint16_t masks[16] = {
-		0b0000000000000001,
-		0b0000000000000010,
-		0b0000000000000100,
-		0b0000000000001000,
-		0b0000000000010000,
-		0b0000000000100000,
-		0b0000000001000000,
-		0b0000000010000000,
-		0b0000000100000000,
-		0b0000001000000000,
-		0b0000010000000000,
-		0b0000100000000000,
-		0b0001000000000000,
-		0b0010000000000000,
-		0b0100000000000000,
-		0b1000000000000000,
-	};
-
-	constexpr std::uint16_t directions[4][16] = {
-		{
+	constexpr SobolMatrix matrices[4] = {
+		{{
 		0b1000000000000000,
 		0b0100000000000000,
 		0b0010000000000000,
@@ -95,9 +81,9 @@ OQMC_HOST_DEVICE inline std::uint16_t sobolReversedIndex(std::uint16_t index,
 		0b0000000000000100,
 		0b0000000000000010,
 		0b0000000000000001,
-		},
+		}},
 
-		{
+		{{
 		0b1111111111111111,
 		0b0101010101010101,
 		0b0011001100110011,
@@ -114,9 +100,9 @@ OQMC_HOST_DEVICE inline std::uint16_t sobolReversedIndex(std::uint16_t index,
 		0b0000000000000101,
 		0b0000000000000011,
 		0b0000000000000001,
-		},
+		}},
 
-		{
+		{{
 		0b1010101000001001,
 		0b0111011100000110,
 		0b0011100100000011,
@@ -133,9 +119,9 @@ OQMC_HOST_DEVICE inline std::uint16_t sobolReversedIndex(std::uint16_t index,
 		0b0000000000000110,
 		0b0000000000000011,
 		0b0000000000000001,
-		},
+		}},
 
-		{
+		{{
 		0b1010000011000011,
 		0b0100000001000001,
 		0b0011000000101101,
@@ -152,11 +138,227 @@ OQMC_HOST_DEVICE inline std::uint16_t sobolReversedIndex(std::uint16_t index,
 		0b0000000000000100,
 		0b0000000000000011,
 		0b0000000000000001,
-		},
+		}},
+	};
+	// clang-format on
+
+	return matrices[dimension];
+}
+
+/// Sobol sequence generator matrix for a dimension at 32 bits of precision.
+///
+/// Get the 32 generator matrix columns of a sobol sequence dimension, ordered
+/// so that they can be applied to an index with reversed bits. This is the full
+/// precision equivalent of sobolMatrix(). Dimensions must be within the range
+/// [0, 4).
+///
+/// @param [in] dimension Dimension of sobol sequence.
+/// @return Generator matrix columns.
+OQMC_HOST_DEVICE constexpr SobolMatrix32 sobolMatrix32(int dimension)
+{
+	assert(dimension >= 0);
+	assert(dimension <= 3);
+
+	// Following matrices were produced using the matrices cli tool found in the
+	// source file src/tools/cli/matrices.cpp with a precision of 32 bits.
+
+	// clang-format off
+	constexpr SobolMatrix32 matrices[4] = {
+		{{
+		0b10000000000000000000000000000000,
+		0b01000000000000000000000000000000,
+		0b00100000000000000000000000000000,
+		0b00010000000000000000000000000000,
+		0b00001000000000000000000000000000,
+		0b00000100000000000000000000000000,
+		0b00000010000000000000000000000000,
+		0b00000001000000000000000000000000,
+		0b00000000100000000000000000000000,
+		0b00000000010000000000000000000000,
+		0b00000000001000000000000000000000,
+		0b00000000000100000000000000000000,
+		0b00000000000010000000000000000000,
+		0b00000000000001000000000000000000,
+		0b00000000000000100000000000000000,
+		0b00000000000000010000000000000000,
+		0b00000000000000001000000000000000,
+		0b00000000000000000100000000000000,
+		0b00000000000000000010000000000000,
+		0b00000000000000000001000000000000,
+		0b00000000000000000000100000000000,
+		0b00000000000000000000010000000000,
+		0b00000000000000000000001000000000,
+		0b00000000000000000000000100000000,
+		0b00000000000000000000000010000000,
+		0b00000000000000000000000001000000,
+		0b00000000000000000000000000100000,
+		0b00000000000000000000000000010000,
+		0b00000000000000000000000000001000,
+		0b00000000000000000000000000000100,
+		0b00000000000000000000000000000010,
+		0b00000000000000000000000000000001,
+		}},
+
+		{{
+		0b11111111111111111111111111111111,
+		0b01010101010101010101010101010101,
+		0b00110011001100110011001100110011,
+		0b00010001000100010001000100010001,
+		0b00001111000011110000111100001111,
+		0b00000101000001010000010100000101,
+		0b00000011000000110000001100000011,
+		0b00000001000000010000000100000001,
+		0b00000000111111110000000011111111,
+		0b00000000010101010000000001010101,
+		0b00000000001100110000000000110011,
+		0b00000000000100010000000000010001,
+		0b00000000000011110000000000001111,
+		0b00000000000001010000000000000101,
+		0b00000000000000110000000000000011,
+		0b00000000000000010000000000000001,
+		0b00000000000000001111111111111111,
+		0b00000000000000000101010101010101,
+		0b00000000000000000011001100110011,
+		0b00000000000000000001000100010001,
+		0b00000000000000000000111100001111,
+		0b00000000000000000000010100000101,
+		0b00000000000000000000001100000011,
+		0b00000000000000000000000100000001,
+		0b00000000000000000000000011111111,
+		0b00000000000000000000000001010101,
+		0b00000000000000000000000000110011,
+		0b00000000000000000000000000010001,
+		0b00000000000000000000000000001111,
+		0b00000000000000000000000000000101,
+		0b00000000000000000000000000000011,
+		0b00000000000000000000000000000001,
+		}},
+
+		{{
+		0b10101010101010100000000010100011,
+		0b01110111011101110000000001110001,
+		0b00111001001110010000000000111010,
+		0b00010110000101100000000000010111,
+		0b00001001101000110000000000001001,
+		0b00000110011100010000000000000110,
+		0b00000011001110100000000000000011,
+		0b00000001000101110000000000000001,
+		0b00000000101000111010101010101010,
+		0b00000000011100010111011101110111,
+		0b00000000001110100011100100111001,
+		0b00000000000101110001011000010110,
+		0b00000000000010010000100110100011,
+		0b00000000000001100000011001110001,
+		0b00000000000000110000001100111010,
+		0b00000000000000010000000100010111,
+		0b00000000000000001010101000001001,
+		0b00000000000000000111011100000110,
+		0b00000000000000000011100100000011,
+		0b00000000000000000001011000000001,
+		0b00000000000000000000100110101010,
+		0b00000000000000000000011001110111,
+		0b00000000000000000000001100111001,
+		0b00000000000000000000000100010110,
+		0b00000000000000000000000010100011,
+		0b00000000000000000000000001110001,
+		0b00000000000000000000000000111010,
+		0b00000000000000000000000000010111,
+		0b00000000000000000000000000001001,
+		0b00000000000000000000000000000110,
+		0b00000000000000000000000000000011,
+		0b00000000000000000000000000000001,
+		}},
+
+		{{
+		0b11001001000000001010000000001010,
+		0b01000101000000000100000000000100,
+		0b00101110000000000011000000000011,
+		0b00011111000000000001000000000001,
+		0b00001010000000000000101101101101,
+		0b00000100000000000000011110011110,
+		0b00000011000000000000001010100111,
+		0b00000001000000000000000100011010,
+		0b00000000101101101101101110100100,
+		0b00000000011110011110011111011011,
+		0b00000000001010100111001010001001,
+		0b00000000000100011010000100000101,
+		0b00000000000011001001101110101110,
+		0b00000000000001000101011111011111,
+		0b00000000000000101110001010001010,
+		0b00000000000000011111000100000100,
+		0b00000000000000001010000011000011,
+		0b00000000000000000100000001000001,
+		0b00000000000000000011000000101101,
+		0b00000000000000000001000000011110,
+		0b00000000000000000000101101100111,
+		0b00000000000000000000011110011010,
+		0b00000000000000000000001010100100,
+		0b00000000000000000000000100011011,
+		0b00000000000000000000000011001001,
+		0b00000000000000000000000001000101,
+		0b00000000000000000000000000101110,
+		0b00000000000000000000000000011111,
+		0b00000000000000000000000000001010,
+		0b00000000000000000000000000000100,
+		0b00000000000000000000000000000011,
+		0b00000000000000000000000000000001,
+		}},
+	};
+	// clang-format on
+
+	return matrices[dimension];
+}
+
+/// Compute sobol sequence value at an index with reversed bits.
+///
+/// Given a 16 bit index, where the order of bits in the index have been
+/// reversed, compute a sobol sequence value to 16 bits of precision for a given
+/// dimension. Dimensions must be within the range [0, 4).
+///
+/// @param [in] index Bit reversed index of element.
+/// @param [in] dimension Dimension of sobol sequence.
+/// @return Sobol sequence value.
+OQMC_HOST_DEVICE inline std::uint16_t sobolReversedIndex(std::uint16_t index,
+                                                         int dimension)
+{
+	assert(dimension >= 0);
+	assert(dimension <= 3);
+
+	if(dimension == 0)
+	{
+		return reverseBits16(index);
+	}
+
+	// clang-format off
+	constexpr std::uint16_t masks[16] = {
+		0b0000000000000001,
+		0b0000000000000010,
+		0b0000000000000100,
+		0b0000000000001000,
+		0b0000000000010000,
+		0b0000000000100000,
+		0b0000000001000000,
+		0b0000000010000000,
+		0b0000000100000000,
+		0b0000001000000000,
+		0b0000010000000000,
+		0b0000100000000000,
+		0b0001000000000000,
+		0b0010000000000000,
+		0b0100000000000000,
+		0b1000000000000000,
 	};
+
 	// clang-format on
 
-	const auto matrix = directions[dimension];
+	constexpr SobolMatrix matrices[4] = {
+	    sobolMatrix(0),
+	    sobolMatrix(1),
+	    sobolMatrix(2),
+	    sobolMatrix(3),
+	};
+
+	const auto matrix = matrices[dimension].columns;
 
 #if defined(OQMC_ARCH_AVX)
 	constexpr auto stride = 16;
@@ -256,6 +458,137 @@ OQMC_HOST_DEVICE inline std::uint16_t sobolReversedIndex(std::uint16_t index,
 #endif
 }
 
+/// Compute sobol sequence value at a 32 bit index with reversed bits.
+///
+/// Given a 32 bit index, where the order of bits in the index have been
+/// reversed, compute a sobol sequence value to 32 bits of precision for a given
+/// dimension. Unlike sobolReversedIndex(), the value is not limited to the
+/// first 2^16 elements of the sequence. Dimensions must be within the range
+/// [0, 4).
+///
+/// @param [in] index Bit reversed index of element.
+/// @param [in] dimension Dimension of sobol sequence.
+/// @return Sobol sequence value.
+OQMC_HOST_DEVICE inline std::uint32_t sobolReversedIndex32(std::uint32_t index,
+                                                           int dimension)
+{
+	assert(dimension >= 0);
+	assert(dimension <= 3);
+
+	if(dimension == 0)
+	{
+		return reverseBits32(index);
+	}
+
+	// clang-format off
+	constexpr std::uint32_t masks[32] = {
+		0x00000001, 0x00000002, 0x00000004, 0x00000008,
+		0x00000010, 0x00000020, 0x00000040, 0x00000080,
+		0x00000100, 0x00000200, 0x00000400, 0x00000800,
+		0x00001000, 0x00002000, 0x00004000, 0x00008000,
+		0x00010000, 0x00020000, 0x00040000, 0x00080000,
+		0x00100000, 0x00200000, 0x00400000, 0x00800000,
+		0x01000000, 0x02000000, 0x04000000, 0x08000000,
+		0x10000000, 0x20000000, 0x40000000, 0x80000000,
+	};
+	// clang-format on
+
+	constexpr SobolMatrix32 matrices[4] = {
+	    sobolMatrix32(0),
+	    sobolMatrix32(1),
+	    sobolMatrix32(2),
+	    sobolMatrix32(3),
+	};
+
+	const auto matrix = matrices[dimension].columns;
+
+#if defined(OQMC_ARCH_AVX)
+	constexpr auto stride = 8;
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i value = _mm256_set1_epi32(index);
+
+	__m256i bits = zero;
+	for(int i = 0; i < 32; i += stride)
+	{
+		const auto maskPtr = reinterpret_cast<const __m256i*>(masks + i);
+		const __m256i mask = _mm256_loadu_si256(maskPtr);
+
+		const auto matrixPtr = reinterpret_cast<const __m256i*>(matrix + i);
+		const __m256i column = _mm256_loadu_si256(matrixPtr);
+
+		const __m256i masked = _mm256_and_si256(value, mask);
+		const __m256i cond = _mm256_cmpeq_epi32(masked, zero);
+
+		bits = _mm256_xor_si256(bits, _mm256_andnot_si256(cond, column));
+	}
+
+	bits = _mm256_xor_si256(bits, _mm256_srli_si256(bits, 4));
+	bits = _mm256_xor_si256(bits, _mm256_srli_si256(bits, 8));
+
+	return _mm256_extract_epi32(bits, 0) ^ _mm256_extract_epi32(bits, 4);
+#endif
+
+#if defined(OQMC_ARCH_SSE)
+	constexpr auto stride = 4;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i value = _mm_set1_epi32(index);
+
+	__m128i bits = zero;
+	for(int i = 0; i < 32; i += stride)
+	{
+		const auto maskPtr = reinterpret_cast<const __m128i*>(masks + i);
+		const __m128i mask = _mm_loadu_si128(maskPtr);
+
+		const auto matrixPtr = reinterpret_cast<const __m128i*>(matrix + i);
+		const __m128i column = _mm_loadu_si128(matrixPtr);
+
+		const __m128i masked = _mm_and_si128(value, mask);
+		const __m128i cond = _mm_cmpeq_epi32(masked, zero);
+
+		bits = _mm_xor_si128(bits, _mm_andnot_si128(cond, column));
+	}
+
+	bits = _mm_xor_si128(bits, _mm_srli_si128(bits, 4));
+	bits = _mm_xor_si128(bits, _mm_srli_si128(bits, 8));
+
+	return _mm_cvtsi128_si32(bits);
+#endif
+
+#if defined(OQMC_ARCH_ARM)
+	constexpr auto stride = 4;
+	const uint32x4_t zero = vdupq_n_u32(0);
+	const uint32x4_t value = vdupq_n_u32(index);
+
+	uint32x4_t bits = zero;
+	for(int i = 0; i < 32; i += stride)
+	{
+		const uint32x4_t mask = vld1q_u32(masks + i);
+		const uint32x4_t column = vld1q_u32(matrix + i);
+		const uint32x4_t cond = vtstq_u32(value, mask);
+
+		bits = veorq_u32(bits, vandq_u32(cond, column));
+	}
+
+	bits = veorq_u32(bits, vextq_u32(bits, zero, 1));
+	bits = veorq_u32(bits, vextq_u32(bits, zero, 2));
+
+	return vgetq_lane_u32(bits, 0);
+#endif
+
+#if defined(OQMC_ARCH_SCALAR)
+	std::uint32_t sample = 0;
+	for(int i = 0; i < 32; ++i)
+	{
+		if((index & masks[i]) != 0)
+		{
+			sample ^= matrix[i];
+		}
+	}
+
+	return sample;
+#endif
+}
+
 /// Permute an input integer and reverse the bits.
 ///
 /// Given an input integer value, perform a Laine and Karras style permutation
@@ -303,4 +636,496 @@ OQMC_HOST_DEVICE inline void shuffledScrambledSobol(std::uint32_t index,
 	}
 }
 
+/// Compute a randomised sobol sequence value from a 32 bit index.
+///
+/// Equivalent to shuffledScrambledSobol(), but the shuffled index and sample
+/// values have 32 bits of precision. An index up to 2^32 will not repeat
+/// values, and progressive stratification is kept beyond 2^16 elements. This
+/// costs more per call, so only use it when more than 2^16 samples per domain
+/// are needed.
+///
+/// @tparam Depth Dimensional space of output, up to 4 dimensions.
+/// @param [in] index Input index of sequence value.
+/// @param [in] seed Seed to randomise the sequence.
+/// @param [out] sample Randomised sequence value.
+template <int Depth>
+OQMC_HOST_DEVICE inline void
+shuffledScrambledSobol32(std::uint32_t index, std::uint32_t seed,
+                         std::uint32_t sample[Depth])
+{
+	static_assert(Depth >= 1, "Pattern depth is greater or equal to one.");
+	static_assert(Depth <= 4, "Pattern depth is less or equal to four.");
+
+	index = reverseAndShuffle(index, seed);
+
+	for(int i = 0; i < Depth; ++i)
+	{
+		sample[i] = sobolReversedIndex32(index, i);
+		sample[i] = scrambleAndReverse(sample[i], rotateBytes(seed, i));
+	}
+}
+
+/// @cond
+#if defined(OQMC_ARCH_AVX)
+inline __m256i reverseBits32Avx(__m256i value)
+{
+	const __m256i mask1 = _mm256_set1_epi32(0x55555555);
+	const __m256i mask2 = _mm256_set1_epi32(0x33333333);
+	const __m256i mask4 = _mm256_set1_epi32(0x0f0f0f0f);
+
+	// clang-format off
+	const __m256i bytes = _mm256_setr_epi8(
+		3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+		3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+	// clang-format on
+
+	__m256i high = _mm256_and_si256(_mm256_srli_epi32(value, 1), mask1);
+	__m256i low = _mm256_slli_epi32(_mm256_and_si256(value, mask1), 1);
+	value = _mm256_or_si256(high, low);
+
+	high = _mm256_and_si256(_mm256_srli_epi32(value, 2), mask2);
+	low = _mm256_slli_epi32(_mm256_and_si256(value, mask2), 2);
+	value = _mm256_or_si256(high, low);
+
+	high = _mm256_and_si256(_mm256_srli_epi32(value, 4), mask4);
+	low = _mm256_slli_epi32(_mm256_and_si256(value, mask4), 4);
+	value = _mm256_or_si256(high, low);
+
+	return _mm256_shuffle_epi8(value, bytes);
+}
+
+inline __m256i laineKarrasPermutationAvx(__m256i value, __m256i seed)
+{
+	const __m256i one = _mm256_set1_epi32(1);
+	const __m256i mul0 = _mm256_set1_epi32(0x3d20adea);
+	const __m256i mul1 = _mm256_set1_epi32(0x05526c56);
+	const __m256i mul2 = _mm256_set1_epi32(0x53a22864);
+
+	const __m256i odd = _mm256_or_si256(_mm256_srli_epi32(seed, 16), one);
+
+	value = _mm256_xor_si256(value, _mm256_mullo_epi32(value, mul0));
+	value = _mm256_add_epi32(value, seed);
+	value = _mm256_mullo_epi32(value, odd);
+	value = _mm256_xor_si256(value, _mm256_mullo_epi32(value, mul1));
+	value = _mm256_xor_si256(value, _mm256_mullo_epi32(value, mul2));
+
+	return value;
+}
+
+inline __m256i rotateBytesAvx(__m256i value, int distance)
+{
+	if(distance == 0)
+	{
+		return value;
+	}
+
+	const __m128i right = _mm_cvtsi32_si128(distance * 8);
+	const __m128i left = _mm_cvtsi32_si128(32 - distance * 8);
+
+	return _mm256_or_si256(_mm256_srl_epi32(value, right),
+	                       _mm256_sll_epi32(value, left));
+}
+
+inline __m256i sobolReversedIndexAvx(__m256i index, int dimension)
+{
+	if(dimension == 0)
+	{
+		return _mm256_srli_epi32(reverseBits32Avx(index), 16);
+	}
+
+	const auto matrix = sobolMatrix(dimension);
+	const __m256i zero = _mm256_setzero_si256();
+
+	__m256i bits = zero;
+	for(int i = 0; i < 16; ++i)
+	{
+		const __m256i mask = _mm256_set1_epi32(1 << i);
+		const __m256i column = _mm256_set1_epi32(matrix.columns[i]);
+
+		const __m256i masked = _mm256_and_si256(index, mask);
+		const __m256i cond = _mm256_cmpeq_epi32(masked, zero);
+
+		bits = _mm256_xor_si256(bits, _mm256_andnot_si256(cond, column));
+	}
+
+	return bits;
+}
+#endif
+
+#if defined(OQMC_ARCH_SSE)
+inline __m128i mulloSse(__m128i a, __m128i b)
+{
+	// SSE2 has no 32 bit low multiply, so multiply even and odd elements.
+	const __m128i even = _mm_mul_epu32(a, b);
+	const __m128i odd =
+	    _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+	                          _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+inline __m128i reverseBits32Sse(__m128i value)
+{
+	const __m128i mask1 = _mm_set1_epi32(0x55555555);
+	const __m128i mask2 = _mm_set1_epi32(0x33333333);
+	const __m128i mask4 = _mm_set1_epi32(0x0f0f0f0f);
+
+	value = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(value, 1), mask1),
+	                     _mm_slli_epi32(_mm_and_si128(value, mask1), 1));
+	value = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(value, 2), mask2),
+	                     _mm_slli_epi32(_mm_and_si128(value, mask2), 2));
+	value = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(value, 4), mask4),
+	                     _mm_slli_epi32(_mm_and_si128(value, mask4), 4));
+
+	// SSE2 has no byte shuffle, so swap 16 bit halves and then bytes.
+	value = _mm_or_si128(_mm_srli_epi32(value, 16), _mm_slli_epi32(value, 16));
+	value = _mm_or_si128(_mm_srli_epi16(value, 8), _mm_slli_epi16(value, 8));
+
+	return value;
+}
+
+inline __m128i laineKarrasPermutationSse(__m128i value, __m128i seed)
+{
+	const __m128i one = _mm_set1_epi32(1);
+	const __m128i mul0 = _mm_set1_epi32(0x3d20adea);
+	const __m128i mul1 = _mm_set1_epi32(0x05526c56);
+	const __m128i mul2 = _mm_set1_epi32(0x53a22864);
+
+	const __m128i odd = _mm_or_si128(_mm_srli_epi32(seed, 16), one);
+
+	value = _mm_xor_si128(value, mulloSse(value, mul0));
+	value = _mm_add_epi32(value, seed);
+	value = mulloSse(value, odd);
+	value = _mm_xor_si128(value, mulloSse(value, mul1));
+	value = _mm_xor_si128(value, mulloSse(value, mul2));
+
+	return value;
+}
+
+inline __m128i rotateBytesSse(__m128i value, int distance)
+{
+	if(distance == 0)
+	{
+		return value;
+	}
+
+	const __m128i right = _mm_cvtsi32_si128(distance * 8);
+	const __m128i left = _mm_cvtsi32_si128(32 - distance * 8);
+
+	return _mm_or_si128(_mm_srl_epi32(value, right),
+	                    _mm_sll_epi32(value, left));
+}
+
+inline __m128i sobolReversedIndexSse(__m128i index, int dimension)
+{
+	if(dimension == 0)
+	{
+		return _mm_srli_epi32(reverseBits32Sse(index), 16);
+	}
+
+	const auto matrix = sobolMatrix(dimension);
+	const __m128i zero = _mm_setzero_si128();
+
+	__m128i bits = zero;
+	for(int i = 0; i < 16; ++i)
+	{
+		const __m128i mask = _mm_set1_epi32(1 << i);
+		const __m128i column = _mm_set1_epi32(matrix.columns[i]);
+
+		const __m128i masked = _mm_and_si128(index, mask);
+		const __m128i cond = _mm_cmpeq_epi32(masked, zero);
+
+		bits = _mm_xor_si128(bits, _mm_andnot_si128(cond, column));
+	}
+
+	return bits;
+}
+#endif
+
+#if defined(OQMC_ARCH_ARM)
+inline uint32x4_t reverseBits32Arm(uint32x4_t value)
+{
+	const uint32x4_t mask1 = vdupq_n_u32(0x55555555);
+	const uint32x4_t mask2 = vdupq_n_u32(0x33333333);
+	const uint32x4_t mask4 = vdupq_n_u32(0x0f0f0f0f);
+
+	value = vorrq_u32(vandq_u32(vshrq_n_u32(value, 1), mask1),
+	                  vshlq_n_u32(vandq_u32(value, mask1), 1));
+	value = vorrq_u32(vandq_u32(vshrq_n_u32(value, 2), mask2),
+	                  vshlq_n_u32(vandq_u32(value, mask2), 2));
+	value = vorrq_u32(vandq_u32(vshrq_n_u32(value, 4), mask4),
+	                  vshlq_n_u32(vandq_u32(value, mask4), 4));
+
+	return vreinterpretq_u32_u8(vrev32q_u8(vreinterpretq_u8_u32(value)));
+}
+
+inline uint32x4_t laineKarrasPermutationArm(uint32x4_t value, uint32x4_t seed)
+{
+	const uint32x4_t odd = vorrq_u32(vshrq_n_u32(seed, 16), vdupq_n_u32(1));
+
+	value = veorq_u32(value, vmulq_n_u32(value, 0x3d20adea));
+	value = vaddq_u32(value, seed);
+	value = vmulq_u32(value, odd);
+	value = veorq_u32(value, vmulq_n_u32(value, 0x05526c56));
+	value = veorq_u32(value, vmulq_n_u32(value, 0x53a22864));
+
+	return value;
+}
+
+inline uint32x4_t rotateBytesArm(uint32x4_t value, int distance)
+{
+	if(distance == 0)
+	{
+		return value;
+	}
+
+	const int32x4_t right = vdupq_n_s32(-distance * 8);
+	const int32x4_t left = vdupq_n_s32(32 - distance * 8);
+
+	return vorrq_u32(vshlq_u32(value, right), vshlq_u32(value, left));
+}
+
+inline uint32x4_t sobolReversedIndexArm(uint32x4_t index, int dimension)
+{
+	if(dimension == 0)
+	{
+		return vshrq_n_u32(reverseBits32Arm(index), 16);
+	}
+
+	const auto matrix = sobolMatrix(dimension);
+
+	uint32x4_t bits = vdupq_n_u32(0);
+	for(int i = 0; i < 16; ++i)
+	{
+		const uint32x4_t mask = vdupq_n_u32(1u << i);
+		const uint32x4_t column = vdupq_n_u32(matrix.columns[i]);
+
+		const uint32x4_t cond = vtstq_u32(index, mask);
+
+		bits = veorq_u32(bits, vandq_u32(cond, column));
+	}
+
+	return bits;
+}
+#endif
+/// @endcond
+
+/// Compute randomised sobol sequence values for multiple indices.
+///
+/// Equivalent to calling shuffledScrambledSobol() once for each lane, but with
+/// the lanes evaluated together using CPU vector intrinsics. Each lane has its
+/// own index and seed. Groups of 8 (AVX) or 4 (SSE and ARM) lanes are computed
+/// at once, with any remaining lanes falling back to the scalar function.
+///
+/// @tparam Depth Dimensional space of output, up to 4 dimensions.
+/// @tparam Lanes Number of indices to compute.
+/// @param [in] index Input index of sequence value for each lane.
+/// @param [in] seed Seed to randomise the sequence for each lane.
+/// @param [out] sample Randomised sequence values, indexed [dimension][lane].
+template <int Depth, int Lanes>
+OQMC_HOST_DEVICE inline void
+shuffledScrambledSobolLanes(const std::uint32_t index[Lanes],
+                            const std::uint32_t seed[Lanes],
+                            std::uint32_t sample[Depth][Lanes])
+{
+	static_assert(Depth >= 1, "Pattern depth is greater or equal to one.");
+	static_assert(Depth <= 4, "Pattern depth is less or equal to four.");
+	static_assert(Lanes >= 1, "Lane count is greater or equal to one.");
+
+	int i = 0;
+
+#if defined(OQMC_ARCH_AVX)
+	constexpr auto stride = 8;
+
+	for(; i + stride <= Lanes; i += stride)
+	{
+		const auto indexPtr = reinterpret_cast<const __m256i*>(index + i);
+		const auto seedPtr = reinterpret_cast<const __m256i*>(seed + i);
+
+		const __m256i seeds = _mm256_loadu_si256(seedPtr);
+
+		__m256i shuffled = _mm256_loadu_si256(indexPtr);
+		shuffled = laineKarrasPermutationAvx(reverseBits32Avx(shuffled), seeds);
+		shuffled = _mm256_srli_epi32(shuffled, 16);
+
+		for(int j = 0; j < Depth; ++j)
+		{
+			__m256i value = sobolReversedIndexAvx(shuffled, j);
+			value = laineKarrasPermutationAvx(value, rotateBytesAvx(seeds, j));
+			value = reverseBits32Avx(value);
+
+			const auto samplePtr = reinterpret_cast<__m256i*>(sample[j] + i);
+			_mm256_storeu_si256(samplePtr, value);
+		}
+	}
+#endif
+
+#if defined(OQMC_ARCH_SSE)
+	constexpr auto stride = 4;
+
+	for(; i + stride <= Lanes; i += stride)
+	{
+		const auto indexPtr = reinterpret_cast<const __m128i*>(index + i);
+		const auto seedPtr = reinterpret_cast<const __m128i*>(seed + i);
+
+		const __m128i seeds = _mm_loadu_si128(seedPtr);
+
+		__m128i shuffled = _mm_loadu_si128(indexPtr);
+		shuffled = laineKarrasPermutationSse(reverseBits32Sse(shuffled), seeds);
+		shuffled = _mm_srli_epi32(shuffled, 16);
+
+		for(int j = 0; j < Depth; ++j)
+		{
+			__m128i value = sobolReversedIndexSse(shuffled, j);
+			value = laineKarrasPermutationSse(value, rotateBytesSse(seeds, j));
+			value = reverseBits32Sse(value);
+
+			const auto samplePtr = reinterpret_cast<__m128i*>(sample[j] + i);
+			_mm_storeu_si128(samplePtr, value);
+		}
+	}
+#endif
+
+#if defined(OQMC_ARCH_ARM)
+	constexpr auto stride = 4;
+
+	for(; i + stride <= Lanes; i += stride)
+	{
+		const uint32x4_t seeds = vld1q_u32(seed + i);
+
+		uint32x4_t shuffled = vld1q_u32(index + i);
+		shuffled = laineKarrasPermutationArm(reverseBits32Arm(shuffled), seeds);
+		shuffled = vshrq_n_u32(shuffled, 16);
+
+		for(int j = 0; j < Depth; ++j)
+		{
+			uint32x4_t value = sobolReversedIndexArm(shuffled, j);
+			value = laineKarrasPermutationArm(value, rotateBytesArm(seeds, j));
+			value = reverseBits32Arm(value);
+
+			vst1q_u32(sample[j] + i, value);
+		}
+	}
+#endif
+
+	for(; i < Lanes; ++i)
+	{
+		std::uint32_t value[Depth];
+		shuffledScrambledSobol<Depth>(index[i], seed[i], value);
+
+		for(int j = 0; j < Depth; ++j)
+		{
+			sample[j][i] = value[j];
+		}
+	}
+}
+
+/// Enumerate randomised sobol sequence values in index order.
+///
+/// Computes the same values as shuffledScrambledSobol(), but for consecutive
+/// indices and at a lower cost per index. Stepping from one index to the next
+/// only changes the upper few bits of the shuffled index, so rather than
+/// recomputing the full matrix product, the generator matrix columns for the
+/// changed bits are XOR-ed into the previous value. This is the same update
+/// used by Gray code enumeration, and costs two XOR operations per dimension on
+/// average. The Owen scramble is then applied as usual.
+///
+/// @tparam Depth Dimensional space of output, up to 4 dimensions.
+template <int Depth>
+class SobolEnumerator
+{
+	static_assert(Depth >= 1, "Pattern depth is greater or equal to one.");
+	static_assert(Depth <= 4, "Pattern depth is less or equal to four.");
+
+  public:
+	/// Construct an enumerator at a starting index.
+	///
+	/// @param [in] index Input index of first sequence value.
+	/// @param [in] seed Seed to randomise the sequence.
+	OQMC_HOST_DEVICE SobolEnumerator(std::uint32_t index, std::uint32_t seed);
+
+	/// Advance the enumerator to the next index.
+	OQMC_HOST_DEVICE void next();
+
+	/// Current index of the enumerator.
+	///
+	/// @return Input index of the current sequence value.
+	OQMC_HOST_DEVICE std::uint32_t index() const;
+
+	/// Compute the randomised sequence value at the current index.
+	///
+	/// @param [out] sample Randomised sequence value.
+	OQMC_HOST_DEVICE void drawSample(std::uint32_t sample[Depth]) const;
+
+  private:
+	std::uint32_t current;
+	std::uint32_t seed;
+	std::uint32_t shuffled;
+	std::uint16_t values[Depth];
+};
+
+template <int Depth>
+SobolEnumerator<Depth>::SobolEnumerator(std::uint32_t index,
+                                        std::uint32_t seed)
+    : current(index), seed(seed), shuffled(reverseAndShuffle(index, seed) >> 16)
+{
+	for(int i = 0; i < Depth; ++i)
+	{
+		values[i] = sobolReversedIndex(shuffled, i);
+	}
+}
+
+template <int Depth>
+void SobolEnumerator<Depth>::next()
+{
+	constexpr SobolMatrix matrices[4] = {
+	    sobolMatrix(0),
+	    sobolMatrix(1),
+	    sobolMatrix(2),
+	    sobolMatrix(3),
+	};
+
+	++current;
+
+	const auto nextShuffled = reverseAndShuffle(current, seed) >> 16;
+	auto changed = shuffled ^ nextShuffled;
+
+	shuffled = nextShuffled;
+
+	// Only the bits at or above the lowest changed index bit can differ, and
+	// these are found at the top of the bit reversed index. Walk down from the
+	// top until all changed bits have been applied.
+	for(int i = 15; changed != 0; --i)
+	{
+		const auto mask = 1u << i;
+
+		if((changed & mask) == 0)
+		{
+			continue;
+		}
+
+		changed ^= mask;
+
+		for(int j = 0; j < Depth; ++j)
+		{
+			values[j] ^= matrices[j].columns[i];
+		}
+	}
+}
+
+template <int Depth>
+std::uint32_t SobolEnumerator<Depth>::index() const
+{
+	return current;
+}
+
+template <int Depth>
+void SobolEnumerator<Depth>::drawSample(std::uint32_t sample[Depth]) const
+{
+	for(int i = 0; i < Depth; ++i)
+	{
+		sample[i] = scrambleAndReverse(values[i], rotateBytes(seed, i));
+	}
+}
+
 } // namespace oqmc
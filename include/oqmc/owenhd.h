@@ -0,0 +1,405 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Contributors to the OpenQMC Project.
+
+/// @file
+/// @details An extension of the Owen scrambled sobol sequences in owen.h to a
+/// higher number of dimensions. Generator matrices are stored in a packed
+/// layout, with the columns for all dimensions of an index bit being contiguous
+/// in memory. This allows the matrix multiply to be vectorised across the
+/// dimensions, so that the cost of many dimensions is amortised.
+
+#pragma once
+
+#include "arch.h"
+#include "gpu.h"
+#include "owen.h"
+#include "pcg.h"
+#include "permute.h"
+#include "rotate.h"
+
+#include <cstdint>
+
+#if defined(OQMC_ARCH_AVX)
+#include <immintrin.h>
+#endif
+
+#if defined(OQMC_ARCH_SSE)
+#include <emmintrin.h>
+#endif
+
+#if defined(OQMC_ARCH_ARM)
+#include <arm_neon.h>
+#endif
+
+namespace oqmc
+{
+
+/// Maximum dimensions of the high dimensional sobol sequence.
+constexpr auto sobolHdMaxDepth = 32;
+
+/// Compute high dimensional sobol sequence values at an index with reversed
+/// bits.
+///
+/// Given a 16 bit index, where the order of bits in the index have been
+/// reversed, compute sobol sequence values to 16 bits of precision for the
+/// first Depth dimensions. Values for the first 4 dimensions are equal to those
+/// given by sobolReversedIndex().
+///
+/// @tparam Depth Number of dimensions to compute, up to sobolHdMaxDepth.
+/// @param [in] index Bit reversed index of element.
+/// @param [out] sample Sobol sequence values.
+template <int Depth>
+OQMC_HOST_DEVICE inline void sobolReversedIndexHd(std::uint16_t index,
+                                                  std::uint16_t sample[Depth])
+{
+	static_assert(Depth >= 1, "Pattern depth is greater or equal to one.");
+	static_assert(Depth <= sobolHdMaxDepth,
+	              "Pattern depth is less or equal to max.");
+
+	// Following matrices were produced using the matrices cli tool found in the
+	// source file src/tools/cli/matrices.cpp with the packed layout. This in
+	// turn uses matrices that were copied from MIT licensed code written by
+	// Leonhard Gruenschloss, based on work by S. Joe and F. Y. Kuo.
+
+	// clang-format off
+	constexpr std::uint16_t columns[16][sobolHdMaxDepth] = {
+		{
+		0x8000, 0xffff, 0xaa09, 0xa0c3, 0xdd02, 0xddd1, 0xe621, 0x925d,
+		0xa4a7, 0xaf94, 0xf034, 0xe648, 0xecf7, 0x902a, 0xfbae, 0x8d5e,
+		0xdf14, 0xcdf4, 0x8384, 0xc00e, 0xc089, 0x80b6, 0xc2d0, 0xc2e2,
+		0xcf52, 0x8eb5, 0xcdfd, 0x8935, 0xe2a8, 0xbe5f, 0xe433, 0xf241,
+		},
+
+		{
+		0x4000, 0x5555, 0x7706, 0x4041, 0x4681, 0x6b6d, 0x621e, 0x457f,
+		0x5443, 0x61ca, 0x5011, 0x7946, 0x685d, 0x601a, 0x45d7, 0x55b0,
+		0x553f, 0x56da, 0x41ff, 0x4006, 0x4050, 0x4065, 0x41a4, 0x41d3,
+		0x44d1, 0x47d0, 0x46b4, 0x4512, 0x55c4, 0x59a5, 0x5b90, 0x56c9,
+		},
+
+		{
+		0x2000, 0x3333, 0x3903, 0x302d, 0x23f6, 0x24fb, 0x21e6, 0x28be,
+		0x2a10, 0x3765, 0x2b73, 0x38e3, 0x2438, 0x300a, 0x238e, 0x3d55,
+		0x2fd5, 0x3f4a, 0x2faa, 0x3971, 0x2b6a, 0x3dc3, 0x2f4e, 0x3341,
+		0x3050, 0x23e2, 0x2294, 0x2c0a, 0x22ab, 0x3e94, 0x278c, 0x30cc,
+		},
+
+		{
+		0x1000, 0x1111, 0x1601, 0x101e, 0x115b, 0x1379, 0x1e62, 0x144d,
+		0x1519, 0x1d83, 0x1192, 0x1472, 0x101b, 0x1007, 0x1124, 0x15b4,
+		0x1548, 0x1730, 0x15db, 0x1e4f, 0x1fa9, 0x1952, 0x11f5, 0x1bca,
+		0x13b5, 0x1431, 0x1289, 0x1fd8, 0x15c5, 0x19e8, 0x1adb, 0x17b2,
+		},
+
+		{
+		0x0800, 0x0f0f, 0x09aa, 0x0b67, 0x0d0f, 0x0c28, 0x08cf, 0x0826,
+		0x088c, 0x08fc, 0x0b89, 0x0a4a, 0x0e7a, 0x08a1, 0x08b1, 0x0d56,
+		0x0ff0, 0x0fd9, 0x0c0b, 0x0ea1, 0x0b9c, 0x0edd, 0x09b5, 0x084e,
+		0x0f74, 0x0e11, 0x0f06, 0x0ae0, 0x0cf7, 0x0f5b, 0x093a, 0x0e68,
+		},
+
+		{
+		0x0400, 0x0505, 0x0677, 0x079a, 0x0685, 0x0615, 0x0478, 0x0410,
+		0x0457, 0x044e, 0x05fe, 0x0547, 0x05a9, 0x073f, 0x04be, 0x05b5,
+		0x0551, 0x074b, 0x0438, 0x0690, 0x05da, 0x05d8, 0x0418, 0x054d,
+		0x04cf, 0x078a, 0x0702, 0x0428, 0x07e1, 0x0626, 0x06c8, 0x0456,
+		},
+
+		{
+		0x0200, 0x0303, 0x0339, 0x02a4, 0x03f4, 0x020e, 0x03c4, 0x0279,
+		0x021a, 0x039b, 0x03b5, 0x0290, 0x0284, 0x0255, 0x033a, 0x036e,
+		0x020a, 0x0207, 0x03a9, 0x038a, 0x03bb, 0x0320, 0x02d3, 0x024c,
+		0x02bc, 0x0206, 0x0241, 0x0343, 0x02eb, 0x02f6, 0x03b7, 0x02b9,
+		},
+
+		{
+		0x0100, 0x0101, 0x0116, 0x011b, 0x015a, 0x0107, 0x017d, 0x016e,
+		0x011c, 0x01cc, 0x01ea, 0x012b, 0x01f0, 0x018f, 0x0178, 0x01a5,
+		0x01f1, 0x0182, 0x01e7, 0x0184, 0x0195, 0x0113, 0x01a5, 0x01ab,
+		0x01f1, 0x0140, 0x01e6, 0x016c, 0x016c, 0x01d7, 0x014f, 0x016c,
+		},
+
+		{
+		0x0080, 0x00ff, 0x00a3, 0x00c9, 0x00b9, 0x00df, 0x00c7, 0x00b4,
+		0x008e, 0x00da, 0x00c4, 0x00d4, 0x00cc, 0x00c5, 0x00b9, 0x00a1,
+		0x00e6, 0x00b6, 0x00dd, 0x0082, 0x008a, 0x008e, 0x0091, 0x009c,
+		0x00a9, 0x00ab, 0x00b9, 0x00ad, 0x00ef, 0x00c0, 0x00e9, 0x00d4,
+		},
+
+		{
+		0x0040, 0x0055, 0x0071, 0x0045, 0x005e, 0x006a, 0x007c, 0x0048,
+		0x0056, 0x0051, 0x0079, 0x0069, 0x0047, 0x0042, 0x0059, 0x0062,
+		0x006f, 0x006c, 0x0075, 0x0073, 0x0051, 0x007e, 0x0056, 0x006b,
+		0x007c, 0x005e, 0x0051, 0x0040, 0x006e, 0x004a, 0x0076, 0x0044,
+		},
+
+		{
+		0x0020, 0x0033, 0x003a, 0x002e, 0x003b, 0x0024, 0x0029, 0x0024,
+		0x002b, 0x0029, 0x0036, 0x0035, 0x0031, 0x0023, 0x002a, 0x0023,
+		0x0028, 0x0026, 0x002f, 0x003c, 0x003c, 0x0031, 0x0026, 0x0031,
+		0x002f, 0x0025, 0x002c, 0x0032, 0x0032, 0x002e, 0x0020, 0x0037,
+		},
+
+		{
+		0x0010, 0x0011, 0x0017, 0x001f, 0x001f, 0x0013, 0x001a, 0x0011,
+		0x0014, 0x0019, 0x0010, 0x001a, 0x001f, 0x001c, 0x0015, 0x001b,
+		0x001c, 0x0016, 0x0019, 0x001d, 0x0016, 0x001c, 0x0010, 0x0012,
+		0x001b, 0x0019, 0x0018, 0x0010, 0x0016, 0x0013, 0x001d, 0x0016,
+		},
+
+		{
+		0x0008, 0x000f, 0x0009, 0x000a, 0x000d, 0x000c, 0x000b, 0x000a,
+		0x000a, 0x000d, 0x0008, 0x000c, 0x000a, 0x0009, 0x000f, 0x000b,
+		0x000f, 0x000f, 0x000a, 0x000d, 0x000b, 0x000b, 0x0009, 0x000b,
+		0x000a, 0x000d, 0x000c, 0x000b, 0x000a, 0x0009, 0x000b, 0x000c,
+		},
+
+		{
+		0x0004, 0x0005, 0x0006, 0x0004, 0x0004, 0x0006, 0x0005, 0x0005,
+		0x0005, 0x0007, 0x0005, 0x0004, 0x0005, 0x0006, 0x0004, 0x0004,
+		0x0004, 0x0004, 0x0005, 0x0007, 0x0007, 0x0006, 0x0005, 0x0004,
+		0x0004, 0x0005, 0x0005, 0x0007, 0x0007, 0x0006, 0x0005, 0x0007,
+		},
+
+		{
+		0x0002, 0x0003, 0x0003, 0x0003, 0x0002, 0x0002, 0x0003, 0x0002,
+		0x0002, 0x0002, 0x0002, 0x0002, 0x0003, 0x0003, 0x0002, 0x0003,
+		0x0002, 0x0003, 0x0002, 0x0003, 0x0003, 0x0002, 0x0003, 0x0003,
+		0x0003, 0x0002, 0x0003, 0x0002, 0x0003, 0x0002, 0x0003, 0x0003,
+		},
+
+		{
+		0x0001, 0x0001, 0x0001, 0x0001, 0x0001, 0x0001, 0x0001, 0x0001,
+		0x0001, 0x0001, 0x0001, 0x0001, 0x0001, 0x0001, 0x0001, 0x0001,
+		0x0001, 0x0001, 0x0001, 0x0001, 0x0001, 0x0001, 0x0001, 0x0001,
+		0x0001, 0x0001, 0x0001, 0x0001, 0x0001, 0x0001, 0x0001, 0x0001,
+		},
+	};
+	// clang-format on
+
+#if defined(OQMC_ARCH_AVX)
+	constexpr auto stride = 16;
+	constexpr auto size = (Depth + stride - 1) / stride;
+
+	__m256i bits[size];
+	for(int j = 0; j < size; ++j)
+	{
+		bits[j] = _mm256_setzero_si256();
+	}
+
+	for(int i = 0; i < 16; ++i)
+	{
+		const auto bit = static_cast<short>(-((index >> i) & 1));
+		const __m256i mask = _mm256_set1_epi16(bit);
+
+		for(int j = 0; j < size; ++j)
+		{
+			const auto columnPtr =
+			    reinterpret_cast<const __m256i*>(columns[i] + j * stride);
+			const __m256i column = _mm256_loadu_si256(columnPtr);
+
+			bits[j] = _mm256_xor_si256(bits[j], _mm256_and_si256(mask, column));
+		}
+	}
+
+	std::uint16_t values[size * stride];
+	for(int j = 0; j < size; ++j)
+	{
+		const auto valuePtr = reinterpret_cast<__m256i*>(values + j * stride);
+		_mm256_storeu_si256(valuePtr, bits[j]);
+	}
+
+	for(int i = 0; i < Depth; ++i)
+	{
+		sample[i] = values[i];
+	}
+#endif
+
+#if defined(OQMC_ARCH_SSE)
+	constexpr auto stride = 8;
+	constexpr auto size = (Depth + stride - 1) / stride;
+
+	__m128i bits[size];
+	for(int j = 0; j < size; ++j)
+	{
+		bits[j] = _mm_setzero_si128();
+	}
+
+	for(int i = 0; i < 16; ++i)
+	{
+		const auto bit = static_cast<short>(-((index >> i) & 1));
+		const __m128i mask = _mm_set1_epi16(bit);
+
+		for(int j = 0; j < size; ++j)
+		{
+			const auto columnPtr =
+			    reinterpret_cast<const __m128i*>(columns[i] + j * stride);
+			const __m128i column = _mm_loadu_si128(columnPtr);
+
+			bits[j] = _mm_xor_si128(bits[j], _mm_and_si128(mask, column));
+		}
+	}
+
+	std::uint16_t values[size * stride];
+	for(int j = 0; j < size; ++j)
+	{
+		const auto valuePtr = reinterpret_cast<__m128i*>(values + j * stride);
+		_mm_storeu_si128(valuePtr, bits[j]);
+	}
+
+	for(int i = 0; i < Depth; ++i)
+	{
+		sample[i] = values[i];
+	}
+#endif
+
+#if defined(OQMC_ARCH_ARM)
+	constexpr auto stride = 8;
+	constexpr auto size = (Depth + stride - 1) / stride;
+
+	uint16x8_t bits[size];
+	for(int j = 0; j < size; ++j)
+	{
+		bits[j] = vdupq_n_u16(0);
+	}
+
+	for(int i = 0; i < 16; ++i)
+	{
+		const auto bit = static_cast<std::uint16_t>(-((index >> i) & 1));
+		const uint16x8_t mask = vdupq_n_u16(bit);
+
+		for(int j = 0; j < size; ++j)
+		{
+			const uint16x8_t column = vld1q_u16(columns[i] + j * stride);
+
+			bits[j] = veorq_u16(bits[j], vandq_u16(mask, column));
+		}
+	}
+
+	std::uint16_t values[size * stride];
+	for(int j = 0; j < size; ++j)
+	{
+		vst1q_u16(values + j * stride, bits[j]);
+	}
+
+	for(int i = 0; i < Depth; ++i)
+	{
+		sample[i] = values[i];
+	}
+#endif
+
+#if defined(OQMC_ARCH_SCALAR)
+	for(int i = 0; i < Depth; ++i)
+	{
+		sample[i] = 0;
+	}
+
+	for(int i = 0; i < 16; ++i)
+	{
+		if((index & (1 << i)) == 0)
+		{
+			continue;
+		}
+
+		for(int j = 0; j < Depth; ++j)
+		{
+			sample[j] ^= columns[i][j];
+		}
+	}
+#endif
+}
+
+/// Compute a high dimensional randomised sobol sequence value.
+///
+/// Given an index and a seed, compute an Owen scrambled sobol sequence value
+/// with up to sobolHdMaxDepth dimensions. All dimensions share the same index
+/// shuffle, so that the dimensions remain correlated. The first 4 dimensions
+/// are equal to those given by shuffledScrambledSobol(), and each further block
+/// of 4 dimensions is scrambled using a seed hashed from the block number. For
+/// a given sequence, the seed value must be constant. An index greater than
+/// 2^16 will repeat values.
+///
+/// @tparam Depth Dimensional space of output, up to sobolHdMaxDepth.
+/// @param [in] index Input index of sequence value.
+/// @param [in] seed Seed to randomise the sequence.
+/// @param [out] sample Randomised sequence value.
+template <int Depth>
+OQMC_HOST_DEVICE inline void
+shuffledScrambledSobolHd(std::uint32_t index, std::uint32_t seed,
+                         std::uint32_t sample[Depth])
+{
+	static_assert(Depth >= 1, "Pattern depth is greater or equal to one.");
+	static_assert(Depth <= sobolHdMaxDepth,
+	              "Pattern depth is less or equal to max.");
+
+	index = reverseAndShuffle(index, seed);
+
+	std::uint16_t values[Depth];
+	sobolReversedIndexHd<Depth>(index >> 16, values);
+
+	std::uint32_t seeds[Depth];
+	for(int i = 0; i < Depth; ++i)
+	{
+		const auto block = i / 4;
+		const auto blockSeed = block == 0 ? seed : pcg::hash(seed + block);
+
+		seeds[i] = rotateBytes(blockSeed, i);
+	}
+
+	int i = 0;
+
+#if defined(OQMC_ARCH_AVX)
+	constexpr auto stride = 8;
+
+	for(; i + stride <= Depth; i += stride)
+	{
+		const auto valuePtr = reinterpret_cast<const __m128i*>(values + i);
+		const auto seedPtr = reinterpret_cast<const __m256i*>(seeds + i);
+		const auto samplePtr = reinterpret_cast<__m256i*>(sample + i);
+
+		__m256i value = _mm256_cvtepu16_epi32(_mm_loadu_si128(valuePtr));
+		value = laineKarrasPermutationAvx(value, _mm256_loadu_si256(seedPtr));
+		value = reverseBits32Avx(value);
+
+		_mm256_storeu_si256(samplePtr, value);
+	}
+#endif
+
+#if defined(OQMC_ARCH_SSE)
+	constexpr auto stride = 4;
+	const __m128i zero = _mm_setzero_si128();
+
+	for(; i + stride <= Depth; i += stride)
+	{
+		const auto valuePtr = reinterpret_cast<const __m128i*>(values + i);
+		const auto seedPtr = reinterpret_cast<const __m128i*>(seeds + i);
+		const auto samplePtr = reinterpret_cast<__m128i*>(sample + i);
+
+		__m128i value = _mm_unpacklo_epi16(_mm_loadl_epi64(valuePtr), zero);
+		value = laineKarrasPermutationSse(value, _mm_loadu_si128(seedPtr));
+		value = reverseBits32Sse(value);
+
+		_mm_storeu_si128(samplePtr, value);
+	}
+#endif
+
+#if defined(OQMC_ARCH_ARM)
+	constexpr auto stride = 4;
+
+	for(; i + stride <= Depth; i += stride)
+	{
+		uint32x4_t value = vmovl_u16(vld1_u16(values + i));
+		value = laineKarrasPermutationArm(value, vld1q_u32(seeds + i));
+		value = reverseBits32Arm(value);
+
+		vst1q_u32(sample + i, value);
+	}
+#endif
+
+	for(; i < Depth; ++i)
+	{
+		sample[i] = scrambleAndReverse(values[i], seeds[i]);
+	}
+}
+
+} // namespace oqmc
@@ -0,0 +1,923 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Contributors to the OpenQMC Project.
+
+/// @file
+/// @details Packet sampler interface definition. A packet evaluates the same
+/// domain tree for multiple lanes at once, where each lane is equivalent to a
+/// scalar sampler object. This allows for efficient use with packet based
+/// renderers, where rays for N pixels or paths are processed together.
+
+#pragma once
+
+#include "arch.h"
+#include "float.h" // NOLINT: false positive
+#include "gpu.h"
+#include "owen.h"
+#include "pcg.h"
+#include "range.h"
+#include "sampler.h"
+#include "state.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#if defined(OQMC_ARCH_AVX)
+#include <immintrin.h>
+#endif
+
+#if defined(OQMC_ARCH_SSE)
+#include <emmintrin.h>
+#endif
+
+#if defined(OQMC_ARCH_ARM)
+#include <arm_neon.h>
+#endif
+
+namespace oqmc
+{
+
+/// Generic sampler state type for a packet of lanes.
+///
+/// This type is the structure of arrays equivalent of State64Bit, storing the
+/// state for N lanes. Mutating the state when building new domains is done
+/// for all lanes at once, making use of CPU vector intrinsics when available.
+/// The result for each lane is identical to that of the scalar State64Bit.
+///
+/// @tparam Lanes Number of lanes in the packet. Must be greater than zero.
+template <int Lanes>
+struct StatePacket
+{
+	static_assert(Lanes > 0, "Number of lanes greater than zero.");
+
+	/// Construct an invalid object.
+	///
+	/// Create a placeholder object to allocate containers, etc. The resulting
+	/// object is invalid, and you should initialise it using setLane().
+	/*AUTO_DEFINED*/ StatePacket() = default;
+
+	/// Get the state of a single lane.
+	///
+	/// @param [in] lane Index of the lane. Must be within [0, Lanes).
+	/// @return Scalar state for the lane.
+	OQMC_HOST_DEVICE State64Bit getLane(int lane) const;
+
+	/// Set the state of a single lane.
+	///
+	/// @param [in] lane Index of the lane. Must be within [0, Lanes).
+	/// @param [in] state Scalar state for the lane.
+	OQMC_HOST_DEVICE void setLane(int lane, State64Bit state);
+
+	/// @copydoc oqmc::State64Bit::newDomain()
+	OQMC_HOST_DEVICE StatePacket newDomain(int key) const;
+
+	/// @copydoc oqmc::State64Bit::newDomainSplit()
+	OQMC_HOST_DEVICE StatePacket newDomainSplit(int key, int size,
+	                                            int index) const;
+
+	/// @copydoc oqmc::State64Bit::newDomainDistrib()
+	OQMC_HOST_DEVICE StatePacket newDomainDistrib(int key, int index) const;
+
+	/// @copydoc oqmc::State64Bit::newDomainPath()
+	OQMC_HOST_DEVICE StatePacket newDomainPath(DomainPath path) const;
+
+	/// Draw integer pseudo random values for all lanes.
+	///
+	/// Equivalent to calling oqmc::State64Bit::drawRnd() for each lane. Values
+	/// are stored so that rnd[d][l] is dimension d of lane l.
+	///
+	/// @tparam Size Number of dimensions to draw.
+	/// @param [out] rnd Output array to store rnd values.
+	template <int Size>
+	OQMC_HOST_DEVICE void drawRnd(std::uint32_t rnd[][Lanes]) const;
+
+	std::uint32_t patternId[Lanes]; ///< Identifiers for domain pattern.
+	std::uint16_t sampleId[Lanes];  ///< Identifiers for sample index.
+	std::uint16_t pixelId[Lanes];   ///< Identifiers for pixel position.
+
+  private:
+	// Transition the pattern of each lane after adding a per lane key.
+	OQMC_HOST_DEVICE static void transition(const std::uint32_t state[Lanes],
+	                                        const std::uint32_t key[Lanes],
+	                                        std::uint32_t out[Lanes]);
+
+	// Compute the PRNG output of each lane from its state.
+	OQMC_HOST_DEVICE static void output(const std::uint32_t state[Lanes],
+	                                    std::uint32_t out[Lanes]);
+};
+
+template <int Lanes>
+State64Bit StatePacket<Lanes>::getLane(int lane) const
+{
+	assert(lane >= 0);
+	assert(lane < Lanes);
+
+	State64Bit ret;
+	ret.patternId = patternId[lane];
+	ret.sampleId = sampleId[lane];
+	ret.pixelId = pixelId[lane];
+
+	return ret;
+}
+
+template <int Lanes>
+void StatePacket<Lanes>::setLane(int lane, State64Bit state)
+{
+	assert(lane >= 0);
+	assert(lane < Lanes);
+
+	patternId[lane] = state.patternId;
+	sampleId[lane] = state.sampleId;
+	pixelId[lane] = state.pixelId;
+}
+
+template <int Lanes>
+void StatePacket<Lanes>::transition(const std::uint32_t state[Lanes],
+                                    const std::uint32_t key[Lanes],
+                                    std::uint32_t out[Lanes])
+{
+	int i = 0;
+
+#if !defined(OQMC_ARCH_SCALAR)
+	// Derive the LCG coefficients from the scalar implementation.
+	constexpr auto increment = pcg::stateTransition(0);
+	constexpr auto multiplier = pcg::stateTransition(1) - increment;
+#endif
+
+#if defined(OQMC_ARCH_AVX)
+	constexpr auto stride = 8;
+
+	const __m256i inc = _mm256_set1_epi32(static_cast<int>(increment));
+	const __m256i mul = _mm256_set1_epi32(static_cast<int>(multiplier));
+
+	for(; i + stride <= Lanes; i += stride)
+	{
+		const auto statePtr = reinterpret_cast<const __m256i*>(state + i);
+		const auto keyPtr = reinterpret_cast<const __m256i*>(key + i);
+		const auto outPtr = reinterpret_cast<__m256i*>(out + i);
+
+		__m256i value = _mm256_add_epi32(_mm256_loadu_si256(statePtr),
+		                                 _mm256_loadu_si256(keyPtr));
+
+		value = _mm256_add_epi32(_mm256_mullo_epi32(value, mul), inc);
+
+		_mm256_storeu_si256(outPtr, value);
+	}
+
+	const __m128i incHalf = _mm256_castsi256_si128(inc);
+	const __m128i mulHalf = _mm256_castsi256_si128(mul);
+
+	for(; i + stride / 2 <= Lanes; i += stride / 2)
+	{
+		const auto statePtr = reinterpret_cast<const __m128i*>(state + i);
+		const auto keyPtr = reinterpret_cast<const __m128i*>(key + i);
+		const auto outPtr = reinterpret_cast<__m128i*>(out + i);
+
+		__m128i value = _mm_add_epi32(_mm_loadu_si128(statePtr),
+		                              _mm_loadu_si128(keyPtr));
+
+		value = _mm_add_epi32(_mm_mullo_epi32(value, mulHalf), incHalf);
+
+		_mm_storeu_si128(outPtr, value);
+	}
+#endif
+
+#if defined(OQMC_ARCH_SSE)
+	constexpr auto stride = 4;
+
+	const __m128i inc = _mm_set1_epi32(static_cast<int>(increment));
+	const __m128i mul = _mm_set1_epi32(static_cast<int>(multiplier));
+
+	for(; i + stride <= Lanes; i += stride)
+	{
+		const auto statePtr = reinterpret_cast<const __m128i*>(state + i);
+		const auto keyPtr = reinterpret_cast<const __m128i*>(key + i);
+		const auto outPtr = reinterpret_cast<__m128i*>(out + i);
+
+		const __m128i value = _mm_add_epi32(_mm_loadu_si128(statePtr),
+		                                    _mm_loadu_si128(keyPtr));
+
+		// SSE2 has no 32 bit low multiply, so multiply even and odd elements.
+		const __m128i even = _mm_mul_epu32(value, mul);
+		const __m128i odd =
+		    _mm_mul_epu32(_mm_srli_si128(value, 4), _mm_srli_si128(mul, 4));
+
+		const __m128i product =
+		    _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+		                       _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+
+		_mm_storeu_si128(outPtr, _mm_add_epi32(product, inc));
+	}
+#endif
+
+#if defined(OQMC_ARCH_ARM)
+	constexpr auto stride = 4;
+
+	const uint32x4_t inc = vdupq_n_u32(increment);
+	const uint32x4_t mul = vdupq_n_u32(multiplier);
+
+	for(; i + stride <= Lanes; i += stride)
+	{
+		const uint32x4_t value =
+		    vaddq_u32(vld1q_u32(state + i), vld1q_u32(key + i));
+
+		vst1q_u32(out + i, vmlaq_u32(inc, value, mul));
+	}
+#endif
+
+	for(; i < Lanes; ++i)
+	{
+		out[i] = pcg::stateTransition(state[i] + key[i]);
+	}
+}
+
+template <int Lanes>
+void StatePacket<Lanes>::output(const std::uint32_t state[Lanes],
+                                std::uint32_t out[Lanes])
+{
+	int i = 0;
+
+#if defined(OQMC_ARCH_AVX)
+	constexpr auto stride = 8;
+
+	const __m256i four = _mm256_set1_epi32(4);
+	const __m256i mul = _mm256_set1_epi32(277803737);
+
+	for(; i + stride <= Lanes; i += stride)
+	{
+		const auto statePtr = reinterpret_cast<const __m256i*>(state + i);
+		const auto outPtr = reinterpret_cast<__m256i*>(out + i);
+
+		__m256i value = _mm256_loadu_si256(statePtr);
+
+		const __m256i shift =
+		    _mm256_add_epi32(_mm256_srli_epi32(value, 28), four);
+
+		value = _mm256_xor_si256(value, _mm256_srlv_epi32(value, shift));
+		value = _mm256_mullo_epi32(value, mul);
+		value = _mm256_xor_si256(value, _mm256_srli_epi32(value, 22));
+
+		_mm256_storeu_si256(outPtr, value);
+	}
+
+	const __m128i fourHalf = _mm256_castsi256_si128(four);
+	const __m128i mulHalf = _mm256_castsi256_si128(mul);
+
+	for(; i + stride / 2 <= Lanes; i += stride / 2)
+	{
+		const auto statePtr = reinterpret_cast<const __m128i*>(state + i);
+		const auto outPtr = reinterpret_cast<__m128i*>(out + i);
+
+		__m128i value = _mm_loadu_si128(statePtr);
+
+		const __m128i shift = _mm_add_epi32(_mm_srli_epi32(value, 28), fourHalf);
+
+		value = _mm_xor_si128(value, _mm_srlv_epi32(value, shift));
+		value = _mm_mullo_epi32(value, mulHalf);
+		value = _mm_xor_si128(value, _mm_srli_epi32(value, 22));
+
+		_mm_storeu_si128(outPtr, value);
+	}
+#endif
+
+#if defined(OQMC_ARCH_SSE)
+	constexpr auto stride = 4;
+
+	const __m128i bias = _mm_set1_epi32(28 + 127);
+	const __m128i mul = _mm_set1_epi32(277803737);
+
+	for(; i + stride <= Lanes; i += stride)
+	{
+		const auto statePtr = reinterpret_cast<const __m128i*>(state + i);
+		const auto outPtr = reinterpret_cast<__m128i*>(out + i);
+
+		__m128i value = _mm_loadu_si128(statePtr);
+
+		// SSE2 has no variable shift, so multiply by 2^(32 - shift) and keep
+		// the high half. The power of two is built from a float exponent.
+		const __m128i exponent = _mm_sub_epi32(bias, _mm_srli_epi32(value, 28));
+		const __m128i scale =
+		    _mm_cvttps_epi32(_mm_castsi128_ps(_mm_slli_epi32(exponent, 23)));
+
+		const __m128i even = _mm_mul_epu32(value, scale);
+		const __m128i odd =
+		    _mm_mul_epu32(_mm_srli_si128(value, 4), _mm_srli_si128(scale, 4));
+
+		const __m128i shifted =
+		    _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 3, 1)),
+		                       _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 3, 1)));
+
+		value = _mm_xor_si128(value, shifted);
+		value = mulloSse(value, mul);
+		value = _mm_xor_si128(value, _mm_srli_epi32(value, 22));
+
+		_mm_storeu_si128(outPtr, value);
+	}
+#endif
+
+#if defined(OQMC_ARCH_ARM)
+	constexpr auto stride = 4;
+
+	const uint32x4_t four = vdupq_n_u32(4);
+
+	for(; i + stride <= Lanes; i += stride)
+	{
+		uint32x4_t value = vld1q_u32(state + i);
+
+		const uint32x4_t shift = vaddq_u32(vshrq_n_u32(value, 28), four);
+		const int32x4_t right = vnegq_s32(vreinterpretq_s32_u32(shift));
+
+		value = veorq_u32(value, vshlq_u32(value, right));
+		value = vmulq_n_u32(value, 277803737);
+		value = veorq_u32(value, vshrq_n_u32(value, 22));
+
+		vst1q_u32(out + i, value);
+	}
+#endif
+
+	for(; i < Lanes; ++i)
+	{
+		out[i] = pcg::output(state[i]);
+	}
+}
+
+template <int Lanes>
+StatePacket<Lanes> StatePacket<Lanes>::newDomain(int key) const
+{
+	std::uint32_t keys[Lanes];
+	for(int i = 0; i < Lanes; ++i)
+	{
+		keys[i] = key;
+	}
+
+	auto ret = *this;
+	transition(patternId, keys, ret.patternId);
+
+	return ret;
+}
+
+template <int Lanes>
+StatePacket<Lanes> StatePacket<Lanes>::newDomainSplit(int key, int size,
+                                                      int index) const
+{
+	assert(size > 0);
+	assert(index >= 0);
+
+	std::uint32_t keys[Lanes];
+	for(int i = 0; i < Lanes; ++i)
+	{
+		keys[i] = computeIndexKey(sampleId[i] * size + index);
+	}
+
+	auto ret = newDomain(key);
+	transition(ret.patternId, keys, ret.patternId);
+
+	for(int i = 0; i < Lanes; ++i)
+	{
+		ret.sampleId[i] = computeIndexId(sampleId[i] * size + index);
+	}
+
+	return ret;
+}
+
+template <int Lanes>
+StatePacket<Lanes> StatePacket<Lanes>::newDomainDistrib(int key,
+                                                        int index) const
+{
+	assert(index >= 0);
+
+	const auto indexKey = computeIndexKey(index);
+	const auto indexId = computeIndexId(index);
+
+	std::uint32_t keys[Lanes];
+	for(int i = 0; i < Lanes; ++i)
+	{
+		keys[i] = sampleId[i];
+	}
+
+	auto ret = newDomain(key).newDomain(indexKey);
+	transition(ret.patternId, keys, ret.patternId);
+
+	for(int i = 0; i < Lanes; ++i)
+	{
+		ret.sampleId[i] = indexId;
+	}
+
+	return ret;
+}
+
+template <int Lanes>
+StatePacket<Lanes> StatePacket<Lanes>::newDomainPath(DomainPath path) const
+{
+	auto ret = *this;
+	for(int i = 0; i < Lanes; ++i)
+	{
+		ret.patternId[i] = path.transition(patternId[i]);
+	}
+
+	return ret;
+}
+
+template <int Lanes>
+template <int Size>
+void StatePacket<Lanes>::drawRnd(std::uint32_t rnd[][Lanes]) const
+{
+	static_assert(Size >= 0, "Draw size greater or equal to zero.");
+
+	std::uint32_t keys[Lanes];
+	for(int i = 0; i < Lanes; ++i)
+	{
+		keys[i] = sampleId[i];
+	}
+
+	// Matches pcg::rng(), which transitions the state prior to the output.
+	std::uint32_t rngState[Lanes];
+	transition(patternId, keys, rngState);
+
+	for(int i = 0; i < Size; ++i)
+	{
+		if(i > 0)
+		{
+			for(int j = 0; j < Lanes; ++j)
+			{
+				keys[j] = 0;
+			}
+
+			transition(rngState, keys, rngState);
+		}
+
+		output(rngState, rnd[i]);
+	}
+}
+
+/// @cond
+template <typename Sampler, int Lanes>
+class PacketInterface;
+/// @endcond
+
+/// Public packet sampler API.
+///
+/// This is a packet variant of the SamplerInterface, where each function is
+/// evaluated for N lanes at once. A lane is equivalent to a scalar sampler
+/// object, and for each lane the results are bit identical to those of the
+/// corresponding scalar sampler type. The type is instantiated using a scalar
+/// sampler type and a lane width, e.g. `PacketInterface<PmjBnSampler, 8>`.
+///
+/// Lanes can represent N pixels, or N paths within a pixel. Each lane has its
+/// own pixel coordinate and sample index, while domain keys are shared between
+/// all lanes, as is the case when a packet of rays follows the same code path.
+///
+/// The domain state for all lanes is stored as a structure of arrays. Deriving
+/// domains and drawing rnd values makes use of CPU vector intrinsics when an
+/// `OPENQMC_ARCH_TYPE` is selected, with a lane width of 8 for AVX, or 4 for
+/// SSE and ARM. Sample values from the sobol based samplers are also computed
+/// for all lanes at once, while other samplers draw each lane in turn. Output
+/// values are stored as a structure of arrays, one array per dimension.
+///
+/// @internal
+/// Implementation types must hold their domain state in a State64Bit member
+/// named 'state', and derive domains using only that state. Other members (e.g.
+/// the cache) must be constant for all domains. A member function 'rndDomain'
+/// returns the state that rnd values are drawn from. Implementations built on
+/// shuffledScrambledSobol() can also define a 'sobolIndexSeed' member function
+/// returning the index and seed, so that lanes are evaluated together.
+/// @endinternal
+///
+/// @ingroup samplers
+/// @tparam Impl Internal sampler implementation type.
+/// @tparam Lanes Number of lanes in the packet. Must be greater than zero.
+template <typename Impl, int Lanes>
+class PacketInterface<SamplerInterface<Impl>, Lanes>
+{
+	// Dimensions per pattern.
+	static constexpr auto maxDrawValue = Impl::maxDrawValue;
+
+	// Prevent value-construction.
+	OQMC_HOST_DEVICE PacketInterface(Impl base, StatePacket<Lanes> state);
+
+	// Construct an implementation object for a single lane.
+	OQMC_HOST_DEVICE Impl getLane(int lane) const;
+
+	// Draw sample values for implementations built on the sobol sequence. The
+	// index and seed of each lane are gathered, and the sequence is evaluated
+	// for all lanes at once with shuffledScrambledSobolLanes().
+	template <int Size, typename T = Impl>
+	OQMC_HOST_DEVICE auto drawSampleLanes(std::uint32_t sample[][Lanes],
+	                                      int) const
+	    -> decltype(std::declval<const T&>().sobolIndexSeed(
+	                    std::declval<std::uint32_t&>(),
+	                    std::declval<std::uint32_t&>()),
+	                void());
+
+	// Draw sample values for all other implementations, one lane at a time.
+	template <int Size>
+	OQMC_HOST_DEVICE void drawSampleLanes(std::uint32_t sample[][Lanes],
+	                                      long) const;
+
+	// Implemention type, used as a prototype for each lane.
+	Impl base;
+
+	// State for all lanes.
+	StatePacket<Lanes> state;
+
+  public:
+	/// Number of lanes in the packet.
+	static constexpr int laneSize = Lanes;
+
+	/// @copydoc oqmc::SamplerInterface::cacheSize
+	static constexpr std::size_t cacheSize = Impl::cacheSize;
+
+	/// @copydoc oqmc::SamplerInterface::cacheId
+	static constexpr std::uint32_t cacheId = Impl::cacheId;
+
+	/// @copydoc oqmc::SamplerInterface::cacheVersion
+	static constexpr std::uint32_t cacheVersion = Impl::cacheVersion;
+
+	/// @copydoc oqmc::SamplerInterface::initialiseCache(void*)
+	static void initialiseCache(void* cache);
+
+	/// @copydoc oqmc::SamplerInterface::initialiseCache(void*, ForLoop)
+	template <typename ForLoop>
+	static void initialiseCache(void* cache, ForLoop forloop);
+
+	/// @copydoc oqmc::SamplerInterface::partialCacheSize
+	static std::size_t partialCacheSize(int nsamples);
+
+	/// @copydoc oqmc::SamplerInterface::initialiseCache(void*, int)
+	static void initialiseCache(void* cache, int nsamples);
+
+	/// @copydoc oqmc::SamplerInterface::extendCache
+	static void extendCache(void* cache, int nsamples);
+
+	/// Construct an invalid packet object.
+	///
+	/// Create a placeholder object to allocate containers, etc. The resulting
+	/// object is invalid, and you should initialise it by replacing the object
+	/// with another from a parametrised constructor.
+	/*AUTO_DEFINED*/ PacketInterface() = default;
+
+	/// Parametrised pixel constructor.
+	///
+	/// Create an object based on the pixel and sample indices for each lane,
+	/// and a frame index shared by all lanes. This also requires a
+	/// pre-allocated and initialised cache. Each lane is equal to a scalar
+	/// sampler object constructed with the same arguments.
+	///
+	/// @param [in] x Pixel coordinates on the x axis for each lane.
+	/// @param [in] y Pixel coordinates on the y axis for each lane.
+	/// @param [in] frame Time index value.
+	/// @param [in] index Sample indices for each lane. Must be positive.
+	/// @param [in] cache Allocated and initialised cache.
+	/// @pre Cache has been allocated and initialised.
+	OQMC_HOST_DEVICE PacketInterface(const int x[Lanes], const int y[Lanes],
+	                                 int frame, const int index[Lanes],
+	                                 const void* cache);
+
+	/// @copydoc oqmc::SamplerInterface::newDomain()
+	OQMC_HOST_DEVICE PacketInterface newDomain(int key) const;
+
+	/// @copydoc oqmc::SamplerInterface::newDomainSplit()
+	OQMC_HOST_DEVICE PacketInterface newDomainSplit(int key, int size,
+	                                                int index) const;
+
+	/// @copydoc oqmc::SamplerInterface::newDomainDistrib()
+	OQMC_HOST_DEVICE PacketInterface newDomainDistrib(int key, int index) const;
+
+	/// @copydoc oqmc::SamplerInterface::newDomainChain()
+	OQMC_HOST_DEVICE PacketInterface newDomainChain(int key, int index) const;
+
+	/// @copydoc oqmc::SamplerInterface::newDomainPath()
+	OQMC_HOST_DEVICE PacketInterface newDomainPath(DomainPath path) const;
+
+	/// Draw integer sample values from domain for all lanes.
+	///
+	/// Equivalent to calling oqmc::SamplerInterface::drawSample() for each
+	/// lane. Values are stored so that sample[d][l] is dimension d of lane l.
+	///
+	/// @tparam Size Number of dimensions to draw. Must be within [1, 4], or
+	/// [1, 32] for oqmc::SobolHdSampler.
+	/// @param [out] sample Output array to store sample values.
+	template <int Size>
+	OQMC_HOST_DEVICE void drawSample(std::uint32_t sample[][Lanes]) const;
+
+	/// Draw ranged integer sample values from domain for all lanes.
+	///
+	/// This function wraps the integer variant of drawSample above. But
+	/// transforms the output values into uniformly distributed integers within
+	/// the range of [0, range).
+	///
+	/// @tparam Size Number of dimensions to draw. Must be within [1, 4], or
+	/// [1, 32] for oqmc::SobolHdSampler.
+	/// @param [in] range Exclusive end of range. Greater than zero.
+	/// @param [out] sample Output array to store sample values.
+	template <int Size>
+	OQMC_HOST_DEVICE void drawSample(std::uint32_t range,
+	                                 std::uint32_t sample[][Lanes]) const;
+
+	/// Draw floating point sample values from domain for all lanes.
+	///
+	/// This function wraps the integer variant of drawSample above. But
+	/// transforms the output values into uniformly distributed floats within
+	/// the range of [0, 1).
+	///
+	/// @tparam Size Number of dimensions to draw. Must be within [1, 4], or
+	/// [1, 32] for oqmc::SobolHdSampler.
+	/// @param [out] sample Output array to store sample values.
+	template <int Size>
+	OQMC_HOST_DEVICE void drawSample(float sample[][Lanes]) const;
+
+	/// Draw integer pseudo random values from domain for all lanes.
+	///
+	/// Equivalent to calling oqmc::SamplerInterface::drawRnd() for each lane.
+	/// Values are stored so that rnd[d][l] is dimension d of lane l.
+	///
+	/// @tparam Size Number of dimensions to draw. Must be within [1, 4], or
+	/// [1, 32] for oqmc::SobolHdSampler.
+	/// @param [out] rnd Output array to store rnd values.
+	template <int Size>
+	OQMC_HOST_DEVICE void drawRnd(std::uint32_t rnd[][Lanes]) const;
+
+	/// Draw ranged integer pseudo random values from domain for all lanes.
+	///
+	/// This function wraps the integer variant of drawRnd above. But transforms
+	/// the output values into uniformly distributed integers within the range
+	/// of [0, range).
+	///
+	/// @tparam Size Number of dimensions to draw. Must be within [1, 4], or
+	/// [1, 32] for oqmc::SobolHdSampler.
+	/// @param [in] range Exclusive end of range. Greater than zero.
+	/// @param [out] rnd Output array to store rnd values.
+	template <int Size>
+	OQMC_HOST_DEVICE void drawRnd(std::uint32_t range,
+	                              std::uint32_t rnd[][Lanes]) const;
+
+	/// Draw floating point pseudo random values from domain for all lanes.
+	///
+	/// This function wraps the integer variant of drawRnd above. But transforms
+	/// the output values into uniformly distributed floats within the range of
+	/// [0, 1).
+	///
+	/// @tparam Size Number of dimensions to draw. Must be within [1, 4], or
+	/// [1, 32] for oqmc::SobolHdSampler.
+	/// @param [out] rnd Output array to store rnd values.
+	template <int Size>
+	OQMC_HOST_DEVICE void drawRnd(float rnd[][Lanes]) const;
+};
+
+template <typename Impl, int Lanes>
+void PacketInterface<SamplerInterface<Impl>, Lanes>::initialiseCache(
+    void* cache)
+{
+	Impl::initialiseCache(cache);
+}
+
+template <typename Impl, int Lanes>
+template <typename ForLoop>
+void PacketInterface<SamplerInterface<Impl>, Lanes>::initialiseCache(
+    void* cache, ForLoop forloop)
+{
+	SamplerInterface<Impl>::initialiseCache(cache, forloop);
+}
+
+template <typename Impl, int Lanes>
+std::size_t
+PacketInterface<SamplerInterface<Impl>, Lanes>::partialCacheSize(int nsamples)
+{
+	return SamplerInterface<Impl>::partialCacheSize(nsamples);
+}
+
+template <typename Impl, int Lanes>
+void PacketInterface<SamplerInterface<Impl>, Lanes>::initialiseCache(
+    void* cache, int nsamples)
+{
+	SamplerInterface<Impl>::initialiseCache(cache, nsamples);
+}
+
+template <typename Impl, int Lanes>
+void PacketInterface<SamplerInterface<Impl>, Lanes>::extendCache(void* cache,
+                                                                 int nsamples)
+{
+	SamplerInterface<Impl>::extendCache(cache, nsamples);
+}
+
+template <typename Impl, int Lanes>
+PacketInterface<SamplerInterface<Impl>, Lanes>::PacketInterface(
+    Impl base, StatePacket<Lanes> state)
+    : base(base), state(state)
+{
+}
+
+template <typename Impl, int Lanes>
+PacketInterface<SamplerInterface<Impl>, Lanes>::PacketInterface(
+    const int x[Lanes], const int y[Lanes], int frame, const int index[Lanes],
+    const void* cache)
+{
+	for(int i = 0; i < Lanes; ++i)
+	{
+		assert(index[i] >= 0);
+
+		const auto impl = Impl(x[i], y[i], frame, index[i], cache);
+
+		if(i == 0)
+		{
+			base = impl;
+		}
+
+		state.setLane(i, impl.state);
+	}
+}
+
+template <typename Impl, int Lanes>
+Impl PacketInterface<SamplerInterface<Impl>, Lanes>::getLane(int lane) const
+{
+	auto ret = base;
+	ret.state = state.getLane(lane);
+
+	return ret;
+}
+
+template <typename Impl, int Lanes>
+PacketInterface<SamplerInterface<Impl>, Lanes>
+PacketInterface<SamplerInterface<Impl>, Lanes>::newDomain(int key) const
+{
+	return {base, state.newDomain(key)};
+}
+
+template <typename Impl, int Lanes>
+PacketInterface<SamplerInterface<Impl>, Lanes>
+PacketInterface<SamplerInterface<Impl>, Lanes>::newDomainSplit(int key,
+                                                               int size,
+                                                               int index) const
+{
+	assert(size > 0);
+	assert(index >= 0);
+
+	return {base, state.newDomainSplit(key, size, index)};
+}
+
+template <typename Impl, int Lanes>
+PacketInterface<SamplerInterface<Impl>, Lanes>
+PacketInterface<SamplerInterface<Impl>, Lanes>::newDomainDistrib(
+    int key, int index) const
+{
+	assert(index >= 0);
+
+	return {base, state.newDomainDistrib(key, index)};
+}
+
+template <typename Impl, int Lanes>
+PacketInterface<SamplerInterface<Impl>, Lanes>
+PacketInterface<SamplerInterface<Impl>, Lanes>::newDomainChain(int key,
+                                                               int index) const
+{
+	assert(index >= 0);
+
+	return {base, state.newDomain(key).newDomain(index)};
+}
+
+template <typename Impl, int Lanes>
+PacketInterface<SamplerInterface<Impl>, Lanes>
+PacketInterface<SamplerInterface<Impl>, Lanes>::newDomainPath(
+    DomainPath path) const
+{
+	return {base, state.newDomainPath(path)};
+}
+
+template <typename Impl, int Lanes>
+template <int Size, typename T>
+auto PacketInterface<SamplerInterface<Impl>, Lanes>::drawSampleLanes(
+    std::uint32_t sample[][Lanes], int) const
+    -> decltype(std::declval<const T&>().sobolIndexSeed(
+                    std::declval<std::uint32_t&>(),
+                    std::declval<std::uint32_t&>()),
+                void())
+{
+	std::uint32_t index[Lanes];
+	std::uint32_t seed[Lanes];
+
+	for(int i = 0; i < Lanes; ++i)
+	{
+		getLane(i).sobolIndexSeed(index[i], seed[i]);
+	}
+
+	shuffledScrambledSobolLanes<Size, Lanes>(index, seed, sample);
+}
+
+template <typename Impl, int Lanes>
+template <int Size>
+void PacketInterface<SamplerInterface<Impl>, Lanes>::drawSampleLanes(
+    std::uint32_t sample[][Lanes], long) const
+{
+	for(int i = 0; i < Lanes; ++i)
+	{
+		std::uint32_t laneSample[Size];
+		getLane(i).template drawSample<Size>(laneSample);
+
+		for(int j = 0; j < Size; ++j)
+		{
+			sample[j][i] = laneSample[j];
+		}
+	}
+}
+
+template <typename Impl, int Lanes>
+template <int Size>
+void PacketInterface<SamplerInterface<Impl>, Lanes>::drawSample(
+    std::uint32_t sample[][Lanes]) const
+{
+	static_assert(Size >= 0, "Draw size greater or equal to zero.");
+	static_assert(Size <= maxDrawValue, "Draw size less or equal to max.");
+
+	// Prefer the vectorised overload when the implementation supports it.
+	drawSampleLanes<Size>(sample, 0);
+}
+
+template <typename Impl, int Lanes>
+template <int Size>
+void PacketInterface<SamplerInterface<Impl>, Lanes>::drawSample(
+    std::uint32_t range, std::uint32_t sample[][Lanes]) const
+{
+	assert(range > 0);
+
+	drawSample<Size>(sample);
+
+	for(int i = 0; i < Size; ++i)
+	{
+		for(int j = 0; j < Lanes; ++j)
+		{
+			sample[i][j] = uintToRange(sample[i][j], range);
+		}
+	}
+}
+
+template <typename Impl, int Lanes>
+template <int Size>
+void PacketInterface<SamplerInterface<Impl>, Lanes>::drawSample(
+    float sample[][Lanes]) const
+{
+	std::uint32_t integerSample[Size][Lanes];
+	drawSample<Size>(integerSample);
+
+	for(int i = 0; i < Size; ++i)
+	{
+		for(int j = 0; j < Lanes; ++j)
+		{
+			sample[i][j] = uintToFloat(integerSample[i][j]);
+		}
+	}
+}
+
+template <typename Impl, int Lanes>
+template <int Size>
+void PacketInterface<SamplerInterface<Impl>, Lanes>::drawRnd(
+    std::uint32_t rnd[][Lanes]) const
+{
+	static_assert(Size >= 0, "Draw size greater or equal to zero.");
+	static_assert(Size <= maxDrawValue, "Draw size less or equal to max.");
+
+	StatePacket<Lanes> rndState;
+	for(int i = 0; i < Lanes; ++i)
+	{
+		rndState.setLane(i, getLane(i).rndDomain());
+	}
+
+	rndState.template drawRnd<Size>(rnd);
+}
+
+template <typename Impl, int Lanes>
+template <int Size>
+void PacketInterface<SamplerInterface<Impl>, Lanes>::drawRnd(
+    std::uint32_t range, std::uint32_t rnd[][Lanes]) const
+{
+	assert(range > 0);
+
+	drawRnd<Size>(rnd);
+
+	for(int i = 0; i < Size; ++i)
+	{
+		for(int j = 0; j < Lanes; ++j)
+		{
+			rnd[i][j] = uintToRange(rnd[i][j], range);
+		}
+	}
+}
+
+template <typename Impl, int Lanes>
+template <int Size>
+void PacketInterface<SamplerInterface<Impl>, Lanes>::drawRnd(
+    float rnd[][Lanes]) const
+{
+	std::uint32_t integerRnd[Size][Lanes];
+	drawRnd<Size>(integerRnd);
+
+	for(int i = 0; i < Size; ++i)
+	{
+		for(int j = 0; j < Lanes; ++j)
+		{
+			rnd[i][j] = uintToFloat(integerRnd[i][j]);
+		}
+	}
+}
+
+} // namespace oqmc
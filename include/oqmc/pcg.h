@@ -82,6 +82,44 @@ OQMC_HOST_DEVICE constexpr std::uint32_t stateTransition(std::uint32_t state)
 	return state * 747796405u + 2891336453u;
 }
 
+/// Jump the state function ahead.
+///
+/// Transition state an arbitrary number of steps along the sequence, equal to
+/// calling oqmc::pcg::stateTransition() delta times, but with a cost that is
+/// logarithmic in delta. This allows a sequential stream of random numbers to
+/// be split across parallel workers, while keeping the exact same values. The
+/// implementation is from Brown in 'Random Number Generation with Arbitrary
+/// Strides'.
+///
+/// @ingroup rngs
+/// @param [in] state Internal state of the PRNG.
+/// @param [in] delta Number of state transitions to advance.
+/// @return State after incrementation of index by delta.
+/// @pre State must have been initialised using an init function.
+OQMC_HOST_DEVICE constexpr std::uint32_t advance(std::uint32_t state,
+                                                 std::uint32_t delta)
+{
+	std::uint32_t accMult = 1;
+	std::uint32_t accPlus = 0;
+	std::uint32_t curMult = 747796405u;
+	std::uint32_t curPlus = 2891336453u;
+
+	while(delta > 0)
+	{
+		if(delta & 1)
+		{
+			accMult *= curMult;
+			accPlus = accPlus * curMult + curPlus;
+		}
+
+		curPlus = (curMult + 1) * curPlus;
+		curMult *= curMult;
+		delta >>= 1;
+	}
+
+	return accMult * state + accPlus;
+}
+
 /// Output permutation function.
 ///
 /// Output permutation of the PRNG state, resulting in a usable random value
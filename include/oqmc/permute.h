@@ -79,4 +79,21 @@ OQMC_HOST_DEVICE constexpr std::uint32_t shuffle(std::uint32_t value,
 	return value;
 }
 
+/// Compute a hash based owen scramble within power of two levels.
+///
+/// Same as shuffle(), but the result is offset by the shuffled value of zero.
+/// The shuffle of the first 2^n values shares the same upper bits, so with the
+/// offset the first 2^n values are permuted among themselves. A table that is
+/// only initialised for the first 2^n entries can then be shuffled.
+///
+/// @ingroup utilities
+/// @param [in] value Integer value to be scrambled.
+/// @param [in] seed Seed value to randomise the scramble.
+/// @return Scrambled output value.
+OQMC_HOST_DEVICE constexpr std::uint32_t levelShuffle(std::uint32_t value,
+                                                      std::uint32_t seed)
+{
+	return shuffle(value, seed) ^ shuffle(0, seed);
+}
+
 } // namespace oqmc
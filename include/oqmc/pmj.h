@@ -8,6 +8,9 @@
 
 #include "gpu.h"
 #include "lookup.h"
+#include "pcg.h"
+#include "permute.h"
+#include "rotate.h"
 #include "sampler.h"
 #include "state.h"
 #include "stochastic.h"
@@ -24,14 +27,31 @@ class PmjImpl
 	// See SamplerInterface for public API documentation.
 	friend SamplerInterface<PmjImpl>;
 
+	// See PacketInterface for public API documentation.
+	template <typename, int>
+	friend class PacketInterface;
+
+	// Samples are the last member, so that a cache for fewer samples can be
+	// allocated with a smaller size.
 	struct CacheType
 	{
+		std::int32_t nsamples;
 		std::uint32_t samples[State64Bit::maxIndexSize][4];
 	};
 
 	static constexpr std::size_t cacheSize = sizeof(CacheType);
+	static constexpr std::uint32_t cacheId = 0x5337e024;
+	static constexpr std::uint32_t cacheVersion = 2;
+	static constexpr auto maxDrawValue = 4;
 	static void initialiseCache(void* cache);
 
+	template <typename ForLoop>
+	static void initialiseCache(void* cache, ForLoop forloop);
+
+	static std::size_t partialCacheSize(int nsamples);
+	static void initialiseCache(void* cache, int nsamples);
+	static void extendCache(void* cache, int nsamples);
+
 	/*AUTO_DEFINED*/ PmjImpl() = default;
 	OQMC_HOST_DEVICE PmjImpl(State64Bit state, const CacheType* cache);
 	OQMC_HOST_DEVICE PmjImpl(int x, int y, int frame, int index,
@@ -40,13 +60,20 @@ class PmjImpl
 	OQMC_HOST_DEVICE PmjImpl newDomain(int key) const;
 	OQMC_HOST_DEVICE PmjImpl newDomainSplit(int key, int size, int index) const;
 	OQMC_HOST_DEVICE PmjImpl newDomainDistrib(int key, int index) const;
+	OQMC_HOST_DEVICE PmjImpl newDomainPath(DomainPath path) const;
 
 	template <int Size>
 	OQMC_HOST_DEVICE void drawSample(std::uint32_t sample[Size]) const;
 
+	template <int Size>
+	OQMC_HOST_DEVICE void drawSampleBatch(int begin, int end,
+	                                      std::uint32_t sample[]) const;
+
 	template <int Size>
 	OQMC_HOST_DEVICE void drawRnd(std::uint32_t rnd[Size]) const;
 
+	OQMC_HOST_DEVICE State64Bit rndDomain() const;
+
 	State64Bit state;
 	const CacheType* cache;
 };
@@ -57,7 +84,61 @@ inline void PmjImpl::initialiseCache(void* cache)
 
 	auto typedCache = static_cast<CacheType*>(cache);
 
-	stochasticPmjInit(State64Bit::maxIndexSize, typedCache->samples);
+	stochasticPmjLevelExtend(0, State64Bit::maxIndexSize, typedCache->samples);
+	typedCache->nsamples = State64Bit::maxIndexSize;
+}
+
+template <typename ForLoop>
+void PmjImpl::initialiseCache(void* cache, ForLoop forloop)
+{
+	assert(cache);
+
+	auto typedCache = static_cast<CacheType*>(cache);
+
+	stochasticPmjLevelExtend(0, State64Bit::maxIndexSize, typedCache->samples,
+	                         forloop);
+	typedCache->nsamples = State64Bit::maxIndexSize;
+}
+
+inline std::size_t PmjImpl::partialCacheSize(int nsamples)
+{
+	assert(nsamples >= 1);
+	assert(nsamples <= State64Bit::maxIndexSize);
+
+	const auto npoints = stochasticPmjLevelSize(nsamples);
+
+	return offsetof(CacheType, samples) +
+	       sizeof(CacheType::samples[0]) * npoints;
+}
+
+inline void PmjImpl::initialiseCache(void* cache, int nsamples)
+{
+	assert(cache);
+
+	auto typedCache = static_cast<CacheType*>(cache);
+
+	typedCache->nsamples = 0;
+	extendCache(cache, nsamples);
+}
+
+inline void PmjImpl::extendCache(void* cache, int nsamples)
+{
+	assert(cache);
+	assert(nsamples >= 1);
+	assert(nsamples <= State64Bit::maxIndexSize);
+
+	auto typedCache = static_cast<CacheType*>(cache);
+
+	// Indices are shuffled within power of two levels, so the table is always
+	// computed up to the end of a level.
+	const auto npoints = stochasticPmjLevelSize(nsamples);
+
+	if(npoints > typedCache->nsamples)
+	{
+		stochasticPmjLevelExtend(typedCache->nsamples, npoints,
+		                         typedCache->samples);
+		typedCache->nsamples = npoints;
+	}
 }
 
 inline PmjImpl::PmjImpl(State64Bit state, const CacheType* cache)
@@ -89,17 +170,58 @@ inline PmjImpl PmjImpl::newDomainDistrib(int key, int index) const
 	return {state.newDomainDistrib(key, index), cache};
 }
 
+inline PmjImpl PmjImpl::newDomainPath(DomainPath path) const
+{
+	return {state.newDomainPath(path), cache};
+}
+
 template <int Size>
 void PmjImpl::drawSample(std::uint32_t sample[Size]) const
 {
-	shuffledScrambledLookup<4, Size>(
+	assert(state.sampleId < cache->nsamples);
+
+	shuffledScrambledLevelLookup<4, Size>(
 	    state.sampleId, pcg::output(state.patternId), cache->samples, sample);
 }
 
+template <int Size>
+void PmjImpl::drawSampleBatch(int begin, int end, std::uint32_t sample[]) const
+{
+	const auto hash = pcg::output(state.patternId);
+	const auto count = end - begin;
+
+	std::uint32_t hashes[Size];
+	for(int i = 0; i < Size; ++i)
+	{
+		hashes[i] = rotateBytes(hash, i);
+	}
+
+	for(int i = 0; i < count; ++i)
+	{
+		constexpr auto indexMask = 0xffff;
+
+		const std::uint32_t index = computeIndexId(begin + i);
+		const auto shuffled = levelShuffle(index, hash) & indexMask;
+
+		assert(shuffled < static_cast<std::uint32_t>(cache->nsamples));
+
+		for(int j = 0; j < Size; ++j)
+		{
+			const auto value = cache->samples[shuffled][j];
+			sample[j * count + i] = randomDigitScramble(value, hashes[j]);
+		}
+	}
+}
+
+inline State64Bit PmjImpl::rndDomain() const
+{
+	return state;
+}
+
 template <int Size>
 void PmjImpl::drawRnd(std::uint32_t rnd[Size]) const
 {
-	state.drawRnd<Size>(rnd);
+	rndDomain().drawRnd<Size>(rnd);
 }
 /// @endcond
 
@@ -119,6 +241,10 @@ void PmjImpl::drawRnd(std::uint32_t rnd[Size]) const
 /// first and second pairs of dimensions. You may however not want to use this
 /// implementation if memory space or access is a concern.
 ///
+/// Indices are shuffled within power of two levels of the pattern, so when only
+/// a small number of samples is needed the cache can be initialised for those
+/// samples alone, and extended later on demand.
+///
 /// @ingroup samplers
 using PmjSampler = SamplerInterface<PmjImpl>;
 
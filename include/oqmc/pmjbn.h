@@ -10,6 +10,8 @@
 #include "gpu.h"
 #include "lookup.h"
 #include "pcg.h"
+#include "permute.h"
+#include "rotate.h"
 #include "sampler.h"
 #include "state.h"
 #include "stochastic.h"
@@ -17,7 +19,6 @@
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
-#include <cstring>
 
 namespace oqmc
 {
@@ -28,16 +29,25 @@ class PmjBnImpl
 	// See SamplerInterface for public API documentation.
 	friend SamplerInterface<PmjBnImpl>;
 
+	// See PacketInterface for public API documentation.
+	template <typename, int>
+	friend class PacketInterface;
+
 	struct CacheType
 	{
 		std::uint32_t samples[State64Bit::maxIndexSize][4];
-		std::uint32_t keyTable[bntables::size];
-		std::uint32_t rankTable[bntables::size];
+		bntables::TableCache<bntables::size> tables;
 	};
 
 	static constexpr std::size_t cacheSize = sizeof(CacheType);
+	static constexpr std::uint32_t cacheId = 0x11589ad4;
+	static constexpr std::uint32_t cacheVersion = 1;
+	static constexpr auto maxDrawValue = 4;
 	static void initialiseCache(void* cache);
 
+	template <typename ForLoop>
+	static void initialiseCache(void* cache, ForLoop forloop);
+
 	/*AUTO_DEFINED*/ PmjBnImpl() = default;
 	OQMC_HOST_DEVICE PmjBnImpl(State64Bit state, const CacheType* cache);
 	OQMC_HOST_DEVICE PmjBnImpl(int x, int y, int frame, int index,
@@ -47,13 +57,20 @@ class PmjBnImpl
 	OQMC_HOST_DEVICE PmjBnImpl newDomainSplit(int key, int size,
 	                                          int index) const;
 	OQMC_HOST_DEVICE PmjBnImpl newDomainDistrib(int key, int index) const;
+	OQMC_HOST_DEVICE PmjBnImpl newDomainPath(DomainPath path) const;
 
 	template <int Size>
 	OQMC_HOST_DEVICE void drawSample(std::uint32_t sample[Size]) const;
 
+	template <int Size>
+	OQMC_HOST_DEVICE void drawSampleBatch(int begin, int end,
+	                                      std::uint32_t sample[]) const;
+
 	template <int Size>
 	OQMC_HOST_DEVICE void drawRnd(std::uint32_t rnd[Size]) const;
 
+	OQMC_HOST_DEVICE State64Bit rndDomain() const;
+
 	State64Bit state;
 	const CacheType* cache;
 };
@@ -66,10 +83,23 @@ inline void PmjBnImpl::initialiseCache(void* cache)
 
 	stochasticPmjInit(State64Bit::maxIndexSize, typedCache->samples);
 
-	std::memcpy(typedCache->keyTable, bntables::pmj::keyTable,
-	            sizeof(bntables::pmj::keyTable));
-	std::memcpy(typedCache->rankTable, bntables::pmj::rankTable,
-	            sizeof(bntables::pmj::rankTable));
+	bntables::initialiseTableCache(bntables::pmj::keyTable,
+	                               bntables::pmj::rankTable,
+	                               &typedCache->tables);
+}
+
+template <typename ForLoop>
+void PmjBnImpl::initialiseCache(void* cache, ForLoop forloop)
+{
+	assert(cache);
+
+	auto typedCache = static_cast<CacheType*>(cache);
+
+	stochasticPmjInit(State64Bit::maxIndexSize, typedCache->samples, forloop);
+
+	bntables::initialiseTableCache(bntables::pmj::keyTable,
+	                               bntables::pmj::rankTable,
+	                               &typedCache->tables);
 }
 
 inline PmjBnImpl::PmjBnImpl(State64Bit state, const CacheType* cache)
@@ -100,6 +130,11 @@ inline PmjBnImpl PmjBnImpl::newDomainDistrib(int key, int index) const
 	return {state.newDomainDistrib(key, index), cache};
 }
 
+inline PmjBnImpl PmjBnImpl::newDomainPath(DomainPath path) const
+{
+	return {state.newDomainPath(path), cache};
+}
+
 template <int Size>
 void PmjBnImpl::drawSample(std::uint32_t sample[Size]) const
 {
@@ -112,17 +147,54 @@ void PmjBnImpl::drawSample(std::uint32_t sample[Size]) const
 	              "Pixel y encoding must match table.");
 
 	const auto table = bntables::tableValue<xBits, yBits, 0>(
-	    state.pixelId, pcg::output(state.patternId), cache->keyTable,
-	    cache->rankTable);
+	    state.pixelId, pcg::output(state.patternId), cache->tables);
 
 	shuffledScrambledLookup<4, Size>(state.sampleId ^ table.rank, table.key,
 	                                 cache->samples, sample);
 }
 
+template <int Size>
+void PmjBnImpl::drawSampleBatch(int begin, int end,
+                                std::uint32_t sample[]) const
+{
+	constexpr auto xBits = State64Bit::spatialEncodeBitSizeX;
+	constexpr auto yBits = State64Bit::spatialEncodeBitSizeY;
+
+	const auto table = bntables::tableValue<xBits, yBits, 0>(
+	    state.pixelId, pcg::output(state.patternId), cache->tables);
+
+	const auto count = end - begin;
+
+	std::uint32_t hashes[Size];
+	for(int i = 0; i < Size; ++i)
+	{
+		hashes[i] = rotateBytes(table.key, i);
+	}
+
+	for(int i = 0; i < count; ++i)
+	{
+		constexpr auto indexMask = 0xffff;
+
+		const std::uint32_t index = computeIndexId(begin + i) ^ table.rank;
+		const auto shuffled = shuffle(index, table.key) & indexMask;
+
+		for(int j = 0; j < Size; ++j)
+		{
+			const auto value = cache->samples[shuffled][j];
+			sample[j * count + i] = randomDigitScramble(value, hashes[j]);
+		}
+	}
+}
+
+inline State64Bit PmjBnImpl::rndDomain() const
+{
+	return state.newDomain(state.pixelId);
+}
+
 template <int Size>
 void PmjBnImpl::drawRnd(std::uint32_t rnd[Size]) const
 {
-	state.newDomain(state.pixelId).drawRnd<Size>(rnd);
+	rndDomain().drawRnd<Size>(rnd);
 }
 /// @endcond
 
@@ -0,0 +1,216 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Contributors to the OpenQMC Project.
+
+/// @file
+/// @details Pmjstbn sampler implementation.
+
+#pragma once
+
+#include "bntables.h"
+#include "encode.h"
+#include "gpu.h"
+#include "lookup.h"
+#include "pcg.h"
+#include "permute.h"
+#include "rotate.h"
+#include "sampler.h"
+#include "state.h"
+#include "stochastic.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace oqmc
+{
+
+/// @cond
+class PmjStBnImpl
+{
+	// See SamplerInterface for public API documentation.
+	friend SamplerInterface<PmjStBnImpl>;
+
+	// See PacketInterface for public API documentation.
+	template <typename, int>
+	friend class PacketInterface;
+
+	struct CacheType
+	{
+		std::uint32_t samples[State64Bit::maxIndexSize][4];
+		bntables::TableCache<bntables::temporal::size> tables;
+	};
+
+	static constexpr std::size_t cacheSize = sizeof(CacheType);
+	static constexpr std::uint32_t cacheId = 0x243e7bf7;
+	static constexpr std::uint32_t cacheVersion = 1;
+	static constexpr auto maxDrawValue = 4;
+	static void initialiseCache(void* cache);
+
+	template <typename ForLoop>
+	static void initialiseCache(void* cache, ForLoop forloop);
+
+	/*AUTO_DEFINED*/ PmjStBnImpl() = default;
+	OQMC_HOST_DEVICE PmjStBnImpl(State64Bit state, const CacheType* cache);
+	OQMC_HOST_DEVICE PmjStBnImpl(int x, int y, int frame, int index,
+	                             const void* cache);
+
+	OQMC_HOST_DEVICE PmjStBnImpl newDomain(int key) const;
+	OQMC_HOST_DEVICE PmjStBnImpl newDomainSplit(int key, int size,
+	                                            int index) const;
+	OQMC_HOST_DEVICE PmjStBnImpl newDomainDistrib(int key, int index) const;
+	OQMC_HOST_DEVICE PmjStBnImpl newDomainPath(DomainPath path) const;
+
+	template <int Size>
+	OQMC_HOST_DEVICE void drawSample(std::uint32_t sample[Size]) const;
+
+	template <int Size>
+	OQMC_HOST_DEVICE void drawSampleBatch(int begin, int end,
+	                                      std::uint32_t sample[]) const;
+
+	template <int Size>
+	OQMC_HOST_DEVICE void drawRnd(std::uint32_t rnd[Size]) const;
+
+	OQMC_HOST_DEVICE State64Bit rndDomain() const;
+
+	State64Bit state;
+	const CacheType* cache;
+};
+
+inline void PmjStBnImpl::initialiseCache(void* cache)
+{
+	assert(cache);
+
+	auto typedCache = static_cast<CacheType*>(cache);
+
+	stochasticPmjInit(State64Bit::maxIndexSize, typedCache->samples);
+
+	bntables::initialiseTableCache(bntables::temporal::pmj::keyTable,
+	                               bntables::temporal::pmj::rankTable,
+	                               &typedCache->tables);
+}
+
+template <typename ForLoop>
+void PmjStBnImpl::initialiseCache(void* cache, ForLoop forloop)
+{
+	assert(cache);
+
+	auto typedCache = static_cast<CacheType*>(cache);
+
+	stochasticPmjInit(State64Bit::maxIndexSize, typedCache->samples, forloop);
+
+	bntables::initialiseTableCache(bntables::temporal::pmj::keyTable,
+	                               bntables::temporal::pmj::rankTable,
+	                               &typedCache->tables);
+}
+
+inline PmjStBnImpl::PmjStBnImpl(State64Bit state, const CacheType* cache)
+    : state(state), cache(cache)
+{
+	assert(cache);
+}
+
+inline PmjStBnImpl::PmjStBnImpl(int x, int y, int frame, int index,
+                                const void* cache)
+    : state(x, y, frame >> bntables::temporal::zBits, index),
+      cache(static_cast<const CacheType*>(cache))
+{
+	assert(cache);
+
+	constexpr auto xBits = bntables::temporal::xBits;
+	constexpr auto yBits = bntables::temporal::yBits;
+	constexpr auto zBits = bntables::temporal::zBits;
+
+	// Frames index the Z axis of the table, see bntables::temporal.
+	state.pixelId = encodeBits16<xBits, yBits, zBits>({x, y, frame});
+}
+
+inline PmjStBnImpl PmjStBnImpl::newDomain(int key) const
+{
+	return {state.newDomain(key), cache};
+}
+
+inline PmjStBnImpl PmjStBnImpl::newDomainSplit(int key, int size,
+                                               int index) const
+{
+	return {state.newDomainSplit(key, size, index), cache};
+}
+
+inline PmjStBnImpl PmjStBnImpl::newDomainDistrib(int key, int index) const
+{
+	return {state.newDomainDistrib(key, index), cache};
+}
+
+inline PmjStBnImpl PmjStBnImpl::newDomainPath(DomainPath path) const
+{
+	return {state.newDomainPath(path), cache};
+}
+
+template <int Size>
+void PmjStBnImpl::drawSample(std::uint32_t sample[Size]) const
+{
+	constexpr auto xBits = bntables::temporal::xBits;
+	constexpr auto yBits = bntables::temporal::yBits;
+	constexpr auto zBits = bntables::temporal::zBits;
+
+	const auto table = bntables::tableValue<xBits, yBits, zBits>(
+	    state.pixelId, pcg::output(state.patternId), cache->tables);
+
+	shuffledScrambledLookup<4, Size>(state.sampleId ^ table.rank, table.key,
+	                                 cache->samples, sample);
+}
+
+template <int Size>
+void PmjStBnImpl::drawSampleBatch(int begin, int end,
+                                  std::uint32_t sample[]) const
+{
+	constexpr auto xBits = bntables::temporal::xBits;
+	constexpr auto yBits = bntables::temporal::yBits;
+	constexpr auto zBits = bntables::temporal::zBits;
+
+	const auto table = bntables::tableValue<xBits, yBits, zBits>(
+	    state.pixelId, pcg::output(state.patternId), cache->tables);
+
+	const auto count = end - begin;
+
+	std::uint32_t hashes[Size];
+	for(int i = 0; i < Size; ++i)
+	{
+		hashes[i] = rotateBytes(table.key, i);
+	}
+
+	for(int i = 0; i < count; ++i)
+	{
+		constexpr auto indexMask = 0xffff;
+
+		const std::uint32_t index = computeIndexId(begin + i) ^ table.rank;
+		const auto shuffled = shuffle(index, table.key) & indexMask;
+
+		for(int j = 0; j < Size; ++j)
+		{
+			const auto value = cache->samples[shuffled][j];
+			sample[j * count + i] = randomDigitScramble(value, hashes[j]);
+		}
+	}
+}
+
+inline State64Bit PmjStBnImpl::rndDomain() const
+{
+	return state.newDomain(state.pixelId);
+}
+
+template <int Size>
+void PmjStBnImpl::drawRnd(std::uint32_t rnd[Size]) const
+{
+	rndDomain().drawRnd<Size>(rnd);
+}
+/// @endcond
+
+/// Spatio-temporal blue noise variant of pmj sampler.
+///
+/// Same as oqmc::PmjBnSampler, with the frame index along the Z axis of the
+/// oqmc::bntables::temporal tables.
+///
+/// @ingroup samplers
+using PmjStBnSampler = SamplerInterface<PmjStBnImpl>;
+
+} // namespace oqmc
@@ -9,6 +9,8 @@
 #include "float.h" // NOLINT: false positive
 #include "gpu.h"
 #include "range.h"
+#include "state.h"
+#include "unused.h"
 
 #include <cassert>
 #include <cstddef>
@@ -55,11 +57,11 @@
 /// memory footprint of a sampler must be very small, and the type trivially
 /// copyable.
 ///
-/// Sampler types are either 8 or 16 bytes in size depending on the type. The
-/// small memory footprint is possible due to the state size of PCG-RXS-M-RX-32
-/// from the PCG family of PRNGs as described by O'Neill in 'PCG: A Family of
-/// Simple Fast Space-Efficient Statistically Good Algorithms for Random Number
-/// Generation'.
+/// Sampler types are either 8 or 16 bytes in size depending on the type, or 12
+/// bytes when using the wider oqmc::State96Bit state. The small memory
+/// footprint is possible due to the state size of PCG-RXS-M-RX-32 from the PCG
+/// family of PRNGs as described by O'Neill in 'PCG: A Family of Simple Fast
+/// Space-Efficient Statistically Good Algorithms for Random Number Generation'.
 ///
 /// When deriving domains the sampler will use an LCG state transition, and
 /// only perform a permutation prior to drawing samples analogous to PCG. This
@@ -110,11 +112,40 @@ template <typename Impl>
 class SamplerInterface
 {
 	// Dimensions per pattern.
-	static constexpr auto maxDrawValue = 4;
+	static constexpr auto maxDrawValue = Impl::maxDrawValue;
 
 	// Prevent value-construction.
 	OQMC_HOST_DEVICE SamplerInterface(Impl impl);
 
+	// Initialise the cache using a loop function, for implementations that
+	// can split the work into independent ranges.
+	template <typename ForLoop, typename T = Impl>
+	static auto initialiseCacheLoop(void* cache, ForLoop forloop, int)
+	    -> decltype(T::initialiseCache(cache, forloop), void());
+
+	// Initialise the cache serially for all other implementations.
+	template <typename ForLoop>
+	static void initialiseCacheLoop(void* cache, ForLoop forloop, long);
+
+	// Size, initialise and extend the cache for a number of samples, for
+	// implementations that can initialise part of the cache.
+	template <typename T = Impl>
+	static auto partialCacheSizeImpl(int nsamples, int)
+	    -> decltype(T::partialCacheSize(nsamples));
+
+	template <typename T = Impl>
+	static auto initialiseCacheImpl(void* cache, int nsamples, int)
+	    -> decltype(T::extendCache(cache, nsamples), void());
+
+	template <typename T = Impl>
+	static auto extendCacheImpl(void* cache, int nsamples, int)
+	    -> decltype(T::extendCache(cache, nsamples), void());
+
+	// Use the whole cache for all other implementations.
+	static std::size_t partialCacheSizeImpl(int nsamples, long);
+	static void initialiseCacheImpl(void* cache, int nsamples, long);
+	static void extendCacheImpl(void* cache, int nsamples, long);
+
 	// Implemention type.
 	Impl impl;
 
@@ -128,6 +159,21 @@ class SamplerInterface
 	/// is also that of the caller.
 	static constexpr std::size_t cacheSize = Impl::cacheSize;
 
+	/// Identifier of the cache contents.
+	///
+	/// A value that is unique to each sampler type, used to identify a cache
+	/// that has been stored outside of the process, for example in a cache file
+	/// as described in oqmc/cachefile.h. Implementations use the FNV-1a hash
+	/// of the sampler name.
+	static constexpr std::uint32_t cacheId = Impl::cacheId;
+
+	/// Version of the cache contents.
+	///
+	/// Incremented whenever the values or the layout of the initialised cache
+	/// change for a sampler type, so that a cache stored by an older version
+	/// of the library can be detected and rejected.
+	static constexpr std::uint32_t cacheVersion = Impl::cacheVersion;
+
 	/// Initialise the cache allocation.
 	///
 	/// Prior to construction of a sampler object, a cache needs to be allocated
@@ -152,6 +198,66 @@ class SamplerInterface
 	/// the sampler object have been destroyed.
 	static void initialiseCache(void* cache);
 
+	/// Initialise the cache allocation using a loop function.
+	///
+	/// Same as the function above, but implementations with an expensive cache
+	/// initialisation split the work into independent ranges that are passed
+	/// to a loop function, so that the caller can run them concurrently. The
+	/// loop function is called as `forloop(size, func)`, and must call
+	/// `func(index)` for each index in [0, size) before returning. The result
+	/// is identical to the serial initialisation.
+	///
+	/// @param [in, out] cache Memory address of the cache allocation.
+	/// @param [in] forloop Loop function to run independent ranges.
+	/// @pre Memory for the cache must be allocated prior. The minimum size of
+	/// the allocation can be retrieved using the `cacheSize` variable above.
+	template <typename ForLoop>
+	static void initialiseCache(void* cache, ForLoop forloop);
+
+	/// Required allocation size of a partial cache.
+	///
+	/// Minimum size in bytes of a cache allocation that is initialised for a
+	/// number of samples, see the function below. Implementations that always
+	/// initialise the whole cache return `cacheSize`.
+	///
+	/// @param [in] nsamples Number of sample indices, within [1, 2^16].
+	/// @return Minimum allocation size in bytes.
+	static std::size_t partialCacheSize(int nsamples);
+
+	/// Initialise the cache allocation for a number of samples.
+	///
+	/// Same as the function above, but implementations with an expensive cache
+	/// initialisation only compute the part of the cache that is needed to
+	/// draw sample indices less than nsamples. Sampler objects constructed with
+	/// the cache must not draw a larger sample index, including the indices of
+	/// domains from newDomainSplit(), until the cache has been extended. Other
+	/// implementations initialise the whole cache. The values drawn do not
+	/// depend on the number of samples.
+	///
+	/// @param [in, out] cache Memory address of the cache allocation.
+	/// @param [in] nsamples Number of sample indices, within [1, 2^16].
+	/// @pre Memory for the cache must be allocated prior. The minimum size of
+	/// the allocation can be retrieved using the `partialCacheSize` function
+	/// above.
+	static void initialiseCache(void* cache, int nsamples);
+
+	/// Extend the cache allocation to a number of samples.
+	///
+	/// Given a cache initialised with the function above, compute the part of
+	/// the cache that is needed to draw sample indices less than nsamples,
+	/// reusing the part that was already computed. The result is identical to
+	/// initialising the cache for nsamples at once. Nothing is done when the
+	/// cache already holds nsamples.
+	///
+	/// The cache is extended in place, so no sampler objects may draw from it
+	/// concurrently. To extend into a larger allocation, copy the bytes of the
+	/// current allocation to the start of the new one first.
+	///
+	/// @param [in, out] cache Memory address of the cache allocation.
+	/// @param [in] nsamples Number of sample indices, within [1, 2^16].
+	/// @pre The allocation must be at least `partialCacheSize(nsamples)`.
+	static void extendCache(void* cache, int nsamples);
+
 	/// Construct an invalid sampler object.
 	///
 	/// Create a placeholder object to allocate containers, etc. The resulting
@@ -194,7 +300,8 @@ class SamplerInterface
 	///
 	/// The calling code can use up to 4 dimensions from each domain (these are
 	/// typically of the highest quality), joining them together to form an N
-	/// dimensional pattern. This technique is called padding.
+	/// dimensional pattern. This technique is called padding. The exception is
+	/// oqmc::SobolHdSampler, which provides up to 32 dimensions per domain.
 	///
 	/// @param [in] key Index key of next domain.
 	/// @return Child domain based on the current object state and key.
@@ -281,19 +388,33 @@ class SamplerInterface
 	/// @return Child domain based on the current object state and key.
 	OQMC_HOST_DEVICE SamplerInterface newDomainChain(int key, int index) const;
 
+	/// Derive a sampler object from a precomputed path of domains.
+	///
+	/// The result is equal to calling newDomain once for each key of the path
+	/// in order, but at the cost of a single call. Shading code often derives
+	/// the same fixed sequence of domains at every vertex, for example from
+	/// a camera domain into a lens domain. Folding the keys at compile time
+	/// with oqmc::domainPath() removes the chain of dependent transitions from
+	/// the hot path.
+	///
+	/// @param [in] path Precomputed path of domain keys.
+	/// @return Child domain based on the current object state and path.
+	OQMC_HOST_DEVICE SamplerInterface newDomainPath(DomainPath path) const;
+
 	/// Draw integer sample values from domain.
 	///
-	/// This can compute sample values with up to 4 dimensions for the given
-	/// domain. The operation does not change the state of the object, and for a
-	/// single domain and index, the result of this function will always be the
-	/// same. Output values are uniformly distributed integers within the range
-	/// of [0, 2^32).
+	/// This can compute sample values with up to 4 dimensions (or 32 for
+	/// oqmc::SobolHdSampler) for the given domain. The operation does not
+	/// change the state of the object, and for a single domain and index, the
+	/// result of this function will always be the same. Output values are
+	/// uniformly distributed integers within the range of [0, 2^32).
 	///
 	/// These values are of high quality and should be handled with care as to
 	/// not introduce bias into an estimate. For low quality, but fast and safe
 	/// random numbers, use the drawRnd member functions below.
 	///
-	/// @tparam Size Number of dimensions to draw. Must be within [1, 4].
+	/// @tparam Size Number of dimensions to draw. Must be within [1, 4], or
+	/// [1, 32] for oqmc::SobolHdSampler.
 	/// @param [out] sample Output array to store sample values.
 	template <int Size>
 	OQMC_HOST_DEVICE void drawSample(std::uint32_t sample[Size]) const;
@@ -304,7 +425,8 @@ class SamplerInterface
 	/// transforms the output values into uniformly distributed integers within
 	/// the range of [0, range).
 	///
-	/// @tparam Size Number of dimensions to draw. Must be within [1, 4].
+	/// @tparam Size Number of dimensions to draw. Must be within [1, 4], or
+	/// [1, 32] for oqmc::SobolHdSampler.
 	/// @param [in] range Exclusive end of range. Greater than zero.
 	/// @param [out] sample Output array to store sample values.
 	template <int Size>
@@ -317,24 +439,83 @@ class SamplerInterface
 	/// transforms the output values into uniformly distributed floats within
 	/// the range of [0, 1).
 	///
-	/// @tparam Size Number of dimensions to draw. Must be within [1, 4].
+	/// @tparam Size Number of dimensions to draw. Must be within [1, 4], or
+	/// [1, 32] for oqmc::SobolHdSampler.
 	/// @param [out] sample Output array to store sample values.
 	template <int Size>
 	OQMC_HOST_DEVICE void drawSample(float sample[Size]) const;
 
+	/// Draw integer sample values for a range of indices from domain.
+	///
+	/// This computes the same values as the integer variant of drawSample
+	/// above, but for every sample index within the range [begin, end) of the
+	/// domain pattern in a single call. Work that is constant for a domain is
+	/// computed once and amortised over all indices, making this cheaper than
+	/// constructing a sampler object and deriving a domain for each index.
+	///
+	/// The value for an index is equal to the value from drawSample had the
+	/// domain been derived from a sampler object constructed with that index
+	/// using only the newDomain and newDomainChain functions. An index greater
+	/// than 2^16 will repeat values, unless the sampler uses oqmc::State96Bit.
+	///
+	/// Output values are stored as a structure of arrays, such that the value
+	/// for dimension d and index begin + i is at sample[d * (end - begin) + i].
+	///
+	/// @tparam Size Number of dimensions to draw. Must be within [1, 4], or
+	/// [1, 32] for oqmc::SobolHdSampler.
+	/// @param [in] begin Inclusive beginning of index range. Must be positive.
+	/// @param [in] end Exclusive end of index range. Not less than begin.
+	/// @param [out] sample Output array to store Size * (end - begin) values.
+	template <int Size>
+	OQMC_HOST_DEVICE void drawSampleBatch(int begin, int end,
+	                                      std::uint32_t sample[]) const;
+
+	/// Draw ranged integer sample values for a range of indices from domain.
+	///
+	/// This function wraps the integer variant of drawSampleBatch above. But
+	/// transforms the output values into uniformly distributed integers within
+	/// the range of [0, range).
+	///
+	/// @tparam Size Number of dimensions to draw. Must be within [1, 4], or
+	/// [1, 32] for oqmc::SobolHdSampler.
+	/// @param [in] begin Inclusive beginning of index range. Must be positive.
+	/// @param [in] end Exclusive end of index range. Not less than begin.
+	/// @param [in] range Exclusive end of range. Greater than zero.
+	/// @param [out] sample Output array to store Size * (end - begin) values.
+	template <int Size>
+	OQMC_HOST_DEVICE void drawSampleBatch(int begin, int end,
+	                                      std::uint32_t range,
+	                                      std::uint32_t sample[]) const;
+
+	/// Draw floating point sample values for a range of indices from domain.
+	///
+	/// This function wraps the integer variant of drawSampleBatch above. But
+	/// transforms the output values into uniformly distributed floats within
+	/// the range of [0, 1).
+	///
+	/// @tparam Size Number of dimensions to draw. Must be within [1, 4], or
+	/// [1, 32] for oqmc::SobolHdSampler.
+	/// @param [in] begin Inclusive beginning of index range. Must be positive.
+	/// @param [in] end Exclusive end of index range. Not less than begin.
+	/// @param [out] sample Output array to store Size * (end - begin) values.
+	template <int Size>
+	OQMC_HOST_DEVICE void drawSampleBatch(int begin, int end,
+	                                      float sample[]) const;
+
 	/// Draw integer pseudo random values from domain.
 	///
-	/// This can compute rnd values with up to 4 dimensions for the given
-	/// domain. The operation does not change the state of the object, and for a
-	/// single domain and index, the result of this function will always be the
-	/// same. Output values are uniformly distributed integers within the range
-	/// of [0, 2^32).
+	/// This can compute rnd values with up to 4 dimensions (or 32 for
+	/// oqmc::SobolHdSampler) for the given domain. The operation does not
+	/// change the state of the object, and for a single domain and index, the
+	/// result of this function will always be the same. Output values are
+	/// uniformly distributed integers within the range of [0, 2^32).
 	///
 	/// These values are of low quality but are fast to compute and have little
 	/// risk of biasing an estimate. For higher quality samples, use the
 	/// drawSample member functions above.
 	///
-	/// @tparam Size Number of dimensions to draw. Must be within [1, 4].
+	/// @tparam Size Number of dimensions to draw. Must be within [1, 4], or
+	/// [1, 32] for oqmc::SobolHdSampler.
 	/// @param [out] rnd Output array to store rnd values.
 	template <int Size>
 	OQMC_HOST_DEVICE void drawRnd(std::uint32_t rnd[Size]) const;
@@ -345,7 +526,8 @@ class SamplerInterface
 	/// the output values into uniformly distributed integers within the range
 	/// of [0, range).
 	///
-	/// @tparam Size Number of dimensions to draw. Must be within [1, 4].
+	/// @tparam Size Number of dimensions to draw. Must be within [1, 4], or
+	/// [1, 32] for oqmc::SobolHdSampler.
 	/// @param [in] range Exclusive end of range. Greater than zero.
 	/// @param [out] rnd Output array to store rnd values.
 	template <int Size>
@@ -358,7 +540,8 @@ class SamplerInterface
 	/// the output values into uniformly distributed floats within the range of
 	/// [0, 1).
 	///
-	/// @tparam Size Number of dimensions to draw. Must be within [1, 4].
+	/// @tparam Size Number of dimensions to draw. Must be within [1, 4], or
+	/// [1, 32] for oqmc::SobolHdSampler.
 	/// @param [out] rnd Output array to store rnd values.
 	template <int Size>
 	OQMC_HOST_DEVICE void drawRnd(float rnd[Size]) const;
@@ -370,6 +553,110 @@ void SamplerInterface<Impl>::initialiseCache(void* cache)
 	Impl::initialiseCache(cache);
 }
 
+template <typename Impl>
+template <typename ForLoop, typename T>
+auto SamplerInterface<Impl>::initialiseCacheLoop(void* cache, ForLoop forloop,
+                                                 int)
+    -> decltype(T::initialiseCache(cache, forloop), void())
+{
+	T::initialiseCache(cache, forloop);
+}
+
+template <typename Impl>
+template <typename ForLoop>
+void SamplerInterface<Impl>::initialiseCacheLoop(void* cache, ForLoop forloop,
+                                                 long)
+{
+	OQMC_MAYBE_UNUSED(forloop);
+
+	Impl::initialiseCache(cache);
+}
+
+template <typename Impl>
+template <typename ForLoop>
+void SamplerInterface<Impl>::initialiseCache(void* cache, ForLoop forloop)
+{
+	// Prefer the loop overload when the implementation supports it.
+	initialiseCacheLoop(cache, forloop, 0);
+}
+
+template <typename Impl>
+template <typename T>
+auto SamplerInterface<Impl>::partialCacheSizeImpl(int nsamples, int)
+    -> decltype(T::partialCacheSize(nsamples))
+{
+	return T::partialCacheSize(nsamples);
+}
+
+template <typename Impl>
+template <typename T>
+auto SamplerInterface<Impl>::initialiseCacheImpl(void* cache, int nsamples,
+                                                 int)
+    -> decltype(T::extendCache(cache, nsamples), void())
+{
+	T::initialiseCache(cache, nsamples);
+}
+
+template <typename Impl>
+template <typename T>
+auto SamplerInterface<Impl>::extendCacheImpl(void* cache, int nsamples, int)
+    -> decltype(T::extendCache(cache, nsamples), void())
+{
+	T::extendCache(cache, nsamples);
+}
+
+template <typename Impl>
+std::size_t SamplerInterface<Impl>::partialCacheSizeImpl(int nsamples, long)
+{
+	OQMC_MAYBE_UNUSED(nsamples);
+
+	return cacheSize;
+}
+
+template <typename Impl>
+void SamplerInterface<Impl>::initialiseCacheImpl(void* cache, int nsamples,
+                                                 long)
+{
+	OQMC_MAYBE_UNUSED(nsamples);
+
+	Impl::initialiseCache(cache);
+}
+
+template <typename Impl>
+void SamplerInterface<Impl>::extendCacheImpl(void* cache, int nsamples, long)
+{
+	OQMC_MAYBE_UNUSED(cache);
+	OQMC_MAYBE_UNUSED(nsamples);
+}
+
+template <typename Impl>
+std::size_t SamplerInterface<Impl>::partialCacheSize(int nsamples)
+{
+	assert(nsamples >= 1);
+	assert(nsamples <= State64Bit::maxIndexSize);
+
+	// Prefer the partial overloads when the implementation supports them.
+	return partialCacheSizeImpl(nsamples, 0);
+}
+
+template <typename Impl>
+void SamplerInterface<Impl>::initialiseCache(void* cache, int nsamples)
+{
+	assert(nsamples >= 1);
+	assert(nsamples <= State64Bit::maxIndexSize);
+
+	initialiseCacheImpl(cache, nsamples, 0);
+}
+
+template <typename Impl>
+void SamplerInterface<Impl>::extendCache(void* cache, int nsamples)
+{
+	assert(nsamples >= 1);
+	assert(nsamples <= State64Bit::maxIndexSize);
+
+	extendCacheImpl(cache, nsamples, 0);
+}
+
 template <typename Impl>
 SamplerInterface<Impl>::SamplerInterface(Impl impl) : impl(impl)
 {
@@ -417,6 +704,13 @@ SamplerInterface<Impl> SamplerInterface<Impl>::newDomainChain(int key,
 	return {impl.newDomain(key).newDomain(index)};
 }
 
+template <typename Impl>
+SamplerInterface<Impl> SamplerInterface<Impl>::newDomainPath(
+    DomainPath path) const
+{
+	return {impl.newDomainPath(path)};
+}
+
 template <typename Impl>
 template <int Size>
 void SamplerInterface<Impl>::drawSample(std::uint32_t sample[Size]) const
@@ -456,6 +750,64 @@ void SamplerInterface<Impl>::drawSample(float sample[Size]) const
 	}
 }
 
+template <typename Impl>
+template <int Size>
+void SamplerInterface<Impl>::drawSampleBatch(int begin, int end,
+                                             std::uint32_t sample[]) const
+{
+	static_assert(Size >= 0, "Draw size greater or equal to zero.");
+	static_assert(Size <= maxDrawValue, "Draw size less or equal to max.");
+
+	assert(begin >= 0);
+	assert(begin <= end);
+
+	impl.template drawSampleBatch<Size>(begin, end, sample);
+}
+
+template <typename Impl>
+template <int Size>
+void SamplerInterface<Impl>::drawSampleBatch(int begin, int end,
+                                             std::uint32_t range,
+                                             std::uint32_t sample[]) const
+{
+	assert(range > 0);
+
+	drawSampleBatch<Size>(begin, end, sample);
+
+	for(int i = 0; i < Size * (end - begin); ++i)
+	{
+		sample[i] = uintToRange(sample[i], range);
+	}
+}
+
+template <typename Impl>
+template <int Size>
+void SamplerInterface<Impl>::drawSampleBatch(int begin, int end,
+                                             float sample[]) const
+{
+	// Draw in fixed size chunks to bound the size of the intermediate buffer.
+	constexpr auto chunkSize = 32;
+
+	const auto count = end - begin;
+
+	for(int i = 0; i < count; i += chunkSize)
+	{
+		const auto chunkCount = count - i < chunkSize ? count - i : chunkSize;
+
+		std::uint32_t integerSample[Size * chunkSize];
+		drawSampleBatch<Size>(begin + i, begin + i + chunkCount, integerSample);
+
+		for(int j = 0; j < Size; ++j)
+		{
+			for(int k = 0; k < chunkCount; ++k)
+			{
+				const auto value = integerSample[j * chunkCount + k];
+				sample[j * count + i + k] = uintToFloat(value);
+			}
+		}
+	}
+}
+
 template <typename Impl>
 template <int Size>
 void SamplerInterface<Impl>::drawRnd(std::uint32_t rnd[Size]) const
@@ -8,87 +8,243 @@
 
 #include "gpu.h"
 #include "owen.h"
+#include "pcg.h"
 #include "sampler.h"
 #include "state.h"
 #include "unused.h"
 
 #include <cstddef>
 #include <cstdint>
+#include <type_traits>
 
 namespace oqmc
 {
 
 /// @cond
-class SobolImpl
+template <typename State>
+class BasicSobolImpl
 {
 	// See SamplerInterface for public API documentation.
-	friend SamplerInterface<SobolImpl>;
+	friend SamplerInterface<BasicSobolImpl>;
+
+	// See PacketInterface for public API documentation.
+	template <typename, int>
+	friend class PacketInterface;
 
 	static constexpr std::size_t cacheSize = 0;
+	static constexpr std::uint32_t cacheId = 0xfba1cec4;
+	static constexpr std::uint32_t cacheVersion = 1;
+	static constexpr auto maxDrawValue = 4;
 	static void initialiseCache(void* cache);
 
-	/*AUTO_DEFINED*/ SobolImpl() = default;
-	OQMC_HOST_DEVICE SobolImpl(State64Bit state);
-	OQMC_HOST_DEVICE SobolImpl(int x, int y, int frame, int index,
-	                           const void* cache);
+	/*AUTO_DEFINED*/ BasicSobolImpl() = default;
+	OQMC_HOST_DEVICE BasicSobolImpl(State state);
+	OQMC_HOST_DEVICE BasicSobolImpl(int x, int y, int frame, int index,
+	                                const void* cache);
 
-	OQMC_HOST_DEVICE SobolImpl newDomain(int key) const;
-	OQMC_HOST_DEVICE SobolImpl newDomainSplit(int key, int size,
-	                                          int index) const;
-	OQMC_HOST_DEVICE SobolImpl newDomainDistrib(int key, int index) const;
+	OQMC_HOST_DEVICE BasicSobolImpl newDomain(int key) const;
+	OQMC_HOST_DEVICE BasicSobolImpl newDomainSplit(int key, int size,
+	                                               int index) const;
+	OQMC_HOST_DEVICE BasicSobolImpl newDomainDistrib(int key, int index) const;
+	OQMC_HOST_DEVICE BasicSobolImpl newDomainPath(DomainPath path) const;
 
 	template <int Size>
 	OQMC_HOST_DEVICE void drawSample(std::uint32_t sample[Size]) const;
 
+	template <int Size>
+	OQMC_HOST_DEVICE void drawSampleBatch(int begin, int end,
+	                                      std::uint32_t sample[]) const;
+
 	template <int Size>
 	OQMC_HOST_DEVICE void drawRnd(std::uint32_t rnd[Size]) const;
 
-	State64Bit state;
+	OQMC_HOST_DEVICE State rndDomain() const;
+	OQMC_HOST_DEVICE void sobolIndexSeed(std::uint32_t& index,
+	                                    std::uint32_t& seed) const;
+
+	State state;
 };
 
-inline void SobolImpl::initialiseCache(void* cache)
+using SobolImpl = BasicSobolImpl<State64Bit>;
+
+// The sequence is evaluated with an index precision that matches the state.
+// State64Bit uses the 16 bit sobol construction, and State96Bit uses the 32
+// bit construction so that indices beyond 2^16 remain stratified.
+
+template <int Size>
+OQMC_HOST_DEVICE inline void sobolDrawSample(State64Bit state,
+                                             std::uint32_t sample[Size])
+{
+	shuffledScrambledSobol<Size>(state.sampleId, pcg::output(state.patternId),
+	                             sample);
+}
+
+template <int Size>
+OQMC_HOST_DEVICE inline void sobolDrawSample(State96Bit state,
+                                             std::uint32_t sample[Size])
+{
+	shuffledScrambledSobol32<Size>(state.sampleId,
+	                               pcg::output(state.patternId), sample);
+}
+
+template <int Size>
+OQMC_HOST_DEVICE inline void sobolDrawSampleBatch(State64Bit state, int begin,
+                                                  int end,
+                                                  std::uint32_t sample[])
+{
+	const auto seed = pcg::output(state.patternId);
+	const auto count = end - begin;
+
+	// Evaluate groups of indices together using the vector kernel.
+	constexpr auto lanes = 8;
+
+	std::uint32_t seeds[lanes];
+	for(int i = 0; i < lanes; ++i)
+	{
+		seeds[i] = seed;
+	}
+
+	int i = 0;
+	for(; i + lanes <= count; i += lanes)
+	{
+		std::uint32_t indices[lanes];
+		for(int j = 0; j < lanes; ++j)
+		{
+			indices[j] = computeIndexId(begin + i + j);
+		}
+
+		std::uint32_t values[Size][lanes];
+		shuffledScrambledSobolLanes<Size, lanes>(indices, seeds, values);
+
+		for(int j = 0; j < Size; ++j)
+		{
+			for(int k = 0; k < lanes; ++k)
+			{
+				sample[j * count + i + k] = values[j][k];
+			}
+		}
+	}
+
+	for(; i < count; ++i)
+	{
+		const std::uint32_t index = computeIndexId(begin + i);
+
+		std::uint32_t value[Size];
+		shuffledScrambledSobol<Size>(index, seed, value);
+
+		for(int j = 0; j < Size; ++j)
+		{
+			sample[j * count + i] = value[j];
+		}
+	}
+}
+
+template <int Size>
+OQMC_HOST_DEVICE inline void sobolDrawSampleBatch(State96Bit state, int begin,
+                                                  int end,
+                                                  std::uint32_t sample[])
+{
+	const auto seed = pcg::output(state.patternId);
+	const auto count = end - begin;
+
+	for(int i = 0; i < count; ++i)
+	{
+		const auto index = State96Bit::computeSampleId(begin + i);
+
+		std::uint32_t value[Size];
+		shuffledScrambledSobol32<Size>(index, seed, value);
+
+		for(int j = 0; j < Size; ++j)
+		{
+			sample[j * count + i] = value[j];
+		}
+	}
+}
+
+template <typename State>
+void BasicSobolImpl<State>::initialiseCache(void* cache)
 {
 	OQMC_MAYBE_UNUSED(cache);
 }
 
-inline SobolImpl::SobolImpl(State64Bit state) : state(state)
+template <typename State>
+BasicSobolImpl<State>::BasicSobolImpl(State state) : state(state)
 {
 }
 
-inline SobolImpl::SobolImpl(int x, int y, int frame, int index,
-                            const void* cache)
+template <typename State>
+BasicSobolImpl<State>::BasicSobolImpl(int x, int y, int frame, int index,
+                                      const void* cache)
     : state(x, y, frame, index)
 {
 	OQMC_MAYBE_UNUSED(cache);
 	state = state.pixelDecorrelate();
 }
 
-inline SobolImpl SobolImpl::newDomain(int key) const
+template <typename State>
+BasicSobolImpl<State> BasicSobolImpl<State>::newDomain(int key) const
 {
 	return {state.newDomain(key)};
 }
 
-inline SobolImpl SobolImpl::newDomainSplit(int key, int size, int index) const
+template <typename State>
+BasicSobolImpl<State> BasicSobolImpl<State>::newDomainSplit(int key, int size,
+                                                            int index) const
 {
 	return {state.newDomainSplit(key, size, index)};
 }
 
-inline SobolImpl SobolImpl::newDomainDistrib(int key, int index) const
+template <typename State>
+BasicSobolImpl<State> BasicSobolImpl<State>::newDomainDistrib(int key,
+                                                              int index) const
 {
 	return {state.newDomainDistrib(key, index)};
 }
 
+template <typename State>
+BasicSobolImpl<State>
+BasicSobolImpl<State>::newDomainPath(DomainPath path) const
+{
+	return {state.newDomainPath(path)};
+}
+
+template <typename State>
+void BasicSobolImpl<State>::sobolIndexSeed(std::uint32_t& index,
+                                           std::uint32_t& seed) const
+{
+	static_assert(std::is_same<State, State64Bit>::value,
+	              "Only the 16 bit construction takes an index and seed.");
+
+	index = state.sampleId;
+	seed = pcg::output(state.patternId);
+}
+
+template <typename State>
 template <int Size>
-void SobolImpl::drawSample(std::uint32_t sample[Size]) const
+void BasicSobolImpl<State>::drawSample(std::uint32_t sample[Size]) const
 {
-	shuffledScrambledSobol<Size>(state.sampleId, pcg::output(state.patternId),
-	                             sample);
+	sobolDrawSample<Size>(state, sample);
 }
 
+template <typename State>
 template <int Size>
-void SobolImpl::drawRnd(std::uint32_t rnd[Size]) const
+void BasicSobolImpl<State>::drawSampleBatch(int begin, int end,
+                                            std::uint32_t sample[]) const
 {
-	state.drawRnd<Size>(rnd);
+	sobolDrawSampleBatch<Size>(state, begin, end, sample);
+}
+
+template <typename State>
+State BasicSobolImpl<State>::rndDomain() const
+{
+	return state;
+}
+
+template <typename State>
+template <int Size>
+void BasicSobolImpl<State>::drawRnd(std::uint32_t rnd[Size]) const
+{
+	rndDomain().template drawRnd<Size>(rnd);
 }
 /// @endcond
 
@@ -110,4 +266,17 @@ void SobolImpl::drawRnd(std::uint32_t rnd[Size]) const
 /// @ingroup samplers
 using SobolSampler = SamplerInterface<SobolImpl>;
 
+/// Owen scrambled sobol sampler with a selectable state type.
+///
+/// Equivalent to the SobolSampler when the State is oqmc::State64Bit. Using
+/// oqmc::State96Bit instead gives a sampler that evaluates the sequence with
+/// 32 bit indices, keeping progressive stratification beyond 2^16 samples per
+/// pixel at a higher cost per draw sample call.
+///
+/// @ingroup samplers
+/// @tparam State Sampler state type, either oqmc::State64Bit or
+/// oqmc::State96Bit.
+template <typename State>
+using BasicSobolSampler = SamplerInterface<BasicSobolImpl<State>>;
+
 } // namespace oqmc
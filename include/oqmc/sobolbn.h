@@ -16,7 +16,6 @@
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
-#include <cstring>
 
 namespace oqmc
 {
@@ -27,13 +26,19 @@ class SobolBnImpl
 	// See SamplerInterface for public API documentation.
 	friend SamplerInterface<SobolBnImpl>;
 
+	// See PacketInterface for public API documentation.
+	template <typename, int>
+	friend class PacketInterface;
+
 	struct CacheType
 	{
-		std::uint32_t keyTable[bntables::size];
-		std::uint32_t rankTable[bntables::size];
+		bntables::TableCache<bntables::size> tables;
 	};
 
 	static constexpr std::size_t cacheSize = sizeof(CacheType);
+	static constexpr std::uint32_t cacheId = 0x7d24bb74;
+	static constexpr std::uint32_t cacheVersion = 1;
+	static constexpr auto maxDrawValue = 4;
 	static void initialiseCache(void* cache);
 
 	/*AUTO_DEFINED*/ SobolBnImpl() = default;
@@ -45,13 +50,22 @@ class SobolBnImpl
 	OQMC_HOST_DEVICE SobolBnImpl newDomainSplit(int key, int size,
 	                                            int index) const;
 	OQMC_HOST_DEVICE SobolBnImpl newDomainDistrib(int key, int index) const;
+	OQMC_HOST_DEVICE SobolBnImpl newDomainPath(DomainPath path) const;
 
 	template <int Size>
 	OQMC_HOST_DEVICE void drawSample(std::uint32_t sample[Size]) const;
 
+	template <int Size>
+	OQMC_HOST_DEVICE void drawSampleBatch(int begin, int end,
+	                                      std::uint32_t sample[]) const;
+
 	template <int Size>
 	OQMC_HOST_DEVICE void drawRnd(std::uint32_t rnd[Size]) const;
 
+	OQMC_HOST_DEVICE State64Bit rndDomain() const;
+	OQMC_HOST_DEVICE void sobolIndexSeed(std::uint32_t& index,
+	                                    std::uint32_t& seed) const;
+
 	State64Bit state;
 	const CacheType* cache;
 };
@@ -62,10 +76,9 @@ inline void SobolBnImpl::initialiseCache(void* cache)
 
 	auto typedCache = static_cast<CacheType*>(cache);
 
-	std::memcpy(typedCache->keyTable, bntables::sobol::keyTable,
-	            sizeof(bntables::sobol::keyTable));
-	std::memcpy(typedCache->rankTable, bntables::sobol::rankTable,
-	            sizeof(bntables::sobol::rankTable));
+	bntables::initialiseTableCache(bntables::sobol::keyTable,
+	                               bntables::sobol::rankTable,
+	                               &typedCache->tables);
 }
 
 inline SobolBnImpl::SobolBnImpl(State64Bit state, const CacheType* cache)
@@ -97,8 +110,13 @@ inline SobolBnImpl SobolBnImpl::newDomainDistrib(int key, int index) const
 	return {state.newDomainDistrib(key, index), cache};
 }
 
-template <int Size>
-void SobolBnImpl::drawSample(std::uint32_t sample[Size]) const
+inline SobolBnImpl SobolBnImpl::newDomainPath(DomainPath path) const
+{
+	return {state.newDomainPath(path), cache};
+}
+
+inline void SobolBnImpl::sobolIndexSeed(std::uint32_t& index,
+                                        std::uint32_t& seed) const
 {
 	constexpr auto xBits = State64Bit::spatialEncodeBitSizeX;
 	constexpr auto yBits = State64Bit::spatialEncodeBitSizeY;
@@ -109,17 +127,87 @@ void SobolBnImpl::drawSample(std::uint32_t sample[Size]) const
 	              "Pixel y encoding must match table.");
 
 	const auto table = bntables::tableValue<xBits, yBits, 0>(
-	    state.pixelId, pcg::output(state.patternId), cache->keyTable,
-	    cache->rankTable);
+	    state.pixelId, pcg::output(state.patternId), cache->tables);
 
-	shuffledScrambledSobol<Size>(state.sampleId ^ table.rank, table.key,
-	                             sample);
+	index = state.sampleId ^ table.rank;
+	seed = table.key;
+}
+
+template <int Size>
+void SobolBnImpl::drawSample(std::uint32_t sample[Size]) const
+{
+	std::uint32_t index;
+	std::uint32_t seed;
+	sobolIndexSeed(index, seed);
+
+	shuffledScrambledSobol<Size>(index, seed, sample);
+}
+
+template <int Size>
+void SobolBnImpl::drawSampleBatch(int begin, int end,
+                                  std::uint32_t sample[]) const
+{
+	constexpr auto xBits = State64Bit::spatialEncodeBitSizeX;
+	constexpr auto yBits = State64Bit::spatialEncodeBitSizeY;
+
+	const auto table = bntables::tableValue<xBits, yBits, 0>(
+	    state.pixelId, pcg::output(state.patternId), cache->tables);
+
+	const auto count = end - begin;
+
+	// Evaluate groups of indices together using the vector kernel.
+	constexpr auto lanes = 8;
+
+	std::uint32_t seeds[lanes];
+	for(int i = 0; i < lanes; ++i)
+	{
+		seeds[i] = table.key;
+	}
+
+	int i = 0;
+	for(; i + lanes <= count; i += lanes)
+	{
+		std::uint32_t indices[lanes];
+		for(int j = 0; j < lanes; ++j)
+		{
+			indices[j] = computeIndexId(begin + i + j) ^ table.rank;
+		}
+
+		std::uint32_t values[Size][lanes];
+		shuffledScrambledSobolLanes<Size, lanes>(indices, seeds, values);
+
+		for(int j = 0; j < Size; ++j)
+		{
+			for(int k = 0; k < lanes; ++k)
+			{
+				sample[j * count + i + k] = values[j][k];
+			}
+		}
+	}
+
+	for(; i < count; ++i)
+	{
+		const std::uint32_t index = computeIndexId(begin + i) ^ table.rank;
+
+		std::uint32_t value[Size];
+		shuffledScrambledSobol<Size>(index, table.key, value);
+
+		for(int j = 0; j < Size; ++j)
+		{
+			sample[j * count + i] = value[j];
+		}
+	}
+}
+
+inline State64Bit SobolBnImpl::rndDomain() const
+{
+	return state.newDomain(state.pixelId);
 }
 
 template <int Size>
 void SobolBnImpl::drawRnd(std::uint32_t rnd[Size]) const
 {
-	state.newDomain(state.pixelId).drawRnd<Size>(rnd);
+	rndDomain().drawRnd<Size>(rnd);
 }
 /// @endcond
 
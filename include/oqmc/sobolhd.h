@@ -0,0 +1,158 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Contributors to the OpenQMC Project.
+
+/// @file
+/// @details High dimensional sobol sampler implementation.
+
+#pragma once
+
+#include "gpu.h"
+#include "owenhd.h"
+#include "pcg.h"
+#include "sampler.h"
+#include "state.h"
+#include "unused.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace oqmc
+{
+
+/// @cond
+class SobolHdImpl
+{
+	// See SamplerInterface for public API documentation.
+	friend SamplerInterface<SobolHdImpl>;
+
+	// See PacketInterface for public API documentation.
+	template <typename, int>
+	friend class PacketInterface;
+
+	static constexpr std::size_t cacheSize = 0;
+	static constexpr std::uint32_t cacheId = 0x533383e0;
+	static constexpr std::uint32_t cacheVersion = 1;
+	static constexpr auto maxDrawValue = sobolHdMaxDepth;
+	static void initialiseCache(void* cache);
+
+	/*AUTO_DEFINED*/ SobolHdImpl() = default;
+	OQMC_HOST_DEVICE SobolHdImpl(State64Bit state);
+	OQMC_HOST_DEVICE SobolHdImpl(int x, int y, int frame, int index,
+	                             const void* cache);
+
+	OQMC_HOST_DEVICE SobolHdImpl newDomain(int key) const;
+	OQMC_HOST_DEVICE SobolHdImpl newDomainSplit(int key, int size,
+	                                            int index) const;
+	OQMC_HOST_DEVICE SobolHdImpl newDomainDistrib(int key, int index) const;
+	OQMC_HOST_DEVICE SobolHdImpl newDomainPath(DomainPath path) const;
+
+	template <int Size>
+	OQMC_HOST_DEVICE void drawSample(std::uint32_t sample[Size]) const;
+
+	template <int Size>
+	OQMC_HOST_DEVICE void drawSampleBatch(int begin, int end,
+	                                      std::uint32_t sample[]) const;
+
+	template <int Size>
+	OQMC_HOST_DEVICE void drawRnd(std::uint32_t rnd[Size]) const;
+
+	OQMC_HOST_DEVICE State64Bit rndDomain() const;
+
+	State64Bit state;
+};
+
+inline void SobolHdImpl::initialiseCache(void* cache)
+{
+	OQMC_MAYBE_UNUSED(cache);
+}
+
+inline SobolHdImpl::SobolHdImpl(State64Bit state) : state(state)
+{
+}
+
+inline SobolHdImpl::SobolHdImpl(int x, int y, int frame, int index,
+                                const void* cache)
+    : state(x, y, frame, index)
+{
+	OQMC_MAYBE_UNUSED(cache);
+	state = state.pixelDecorrelate();
+}
+
+inline SobolHdImpl SobolHdImpl::newDomain(int key) const
+{
+	return {state.newDomain(key)};
+}
+
+inline SobolHdImpl SobolHdImpl::newDomainSplit(int key, int size,
+                                               int index) const
+{
+	return {state.newDomainSplit(key, size, index)};
+}
+
+inline SobolHdImpl SobolHdImpl::newDomainDistrib(int key, int index) const
+{
+	return {state.newDomainDistrib(key, index)};
+}
+
+inline SobolHdImpl SobolHdImpl::newDomainPath(DomainPath path) const
+{
+	return {state.newDomainPath(path)};
+}
+
+template <int Size>
+void SobolHdImpl::drawSample(std::uint32_t sample[Size]) const
+{
+	shuffledScrambledSobolHd<Size>(state.sampleId,
+	                               pcg::output(state.patternId), sample);
+}
+
+template <int Size>
+void SobolHdImpl::drawSampleBatch(int begin, int end,
+                                  std::uint32_t sample[]) const
+{
+	const auto seed = pcg::output(state.patternId);
+	const auto count = end - begin;
+
+	for(int i = 0; i < count; ++i)
+	{
+		const std::uint32_t index = computeIndexId(begin + i);
+
+		std::uint32_t value[Size];
+		shuffledScrambledSobolHd<Size>(index, seed, value);
+
+		for(int j = 0; j < Size; ++j)
+		{
+			sample[j * count + i] = value[j];
+		}
+	}
+}
+
+inline State64Bit SobolHdImpl::rndDomain() const
+{
+	return state;
+}
+
+template <int Size>
+void SobolHdImpl::drawRnd(std::uint32_t rnd[Size]) const
+{
+	rndDomain().drawRnd<Size>(rnd);
+}
+/// @endcond
+
+/// High dimensional Owen scrambled sobol sampler.
+///
+/// A variant of the SobolSampler that can draw up to 32 correlated dimensions
+/// from a single domain, rather than 4. The generator matrices are the Joe and
+/// Kuo matrices from 'Constructing Sobol sequences with better two-dimensional
+/// projections', and the first 4 dimensions are equal to those of the
+/// SobolSampler for the same domain.
+///
+/// This is useful for integrands with many dimensions, such as hair shading or
+/// volumetrics, which would otherwise need to derive a new domain for every 4
+/// dimensions. The matrix multiply and scramble are vectorised across the
+/// dimensions, so a single large draw costs less than many small draws.
+///
+/// @ingroup samplers
+using SobolHdSampler = SamplerInterface<SobolHdImpl>;
+
+} // namespace oqmc
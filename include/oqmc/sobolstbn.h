@@ -0,0 +1,228 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Contributors to the OpenQMC Project.
+
+/// @file
+/// @details Sobolstbn sampler implementation.
+
+#pragma once
+
+#include "bntables.h"
+#include "encode.h"
+#include "gpu.h"
+#include "owen.h"
+#include "pcg.h"
+#include "sampler.h"
+#include "state.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace oqmc
+{
+
+/// @cond
+class SobolStBnImpl
+{
+	// See SamplerInterface for public API documentation.
+	friend SamplerInterface<SobolStBnImpl>;
+
+	// See PacketInterface for public API documentation.
+	template <typename, int>
+	friend class PacketInterface;
+
+	struct CacheType
+	{
+		bntables::TableCache<bntables::temporal::size> tables;
+	};
+
+	static constexpr std::size_t cacheSize = sizeof(CacheType);
+	static constexpr std::uint32_t cacheId = 0xc9d9fc97;
+	static constexpr std::uint32_t cacheVersion = 1;
+	static constexpr auto maxDrawValue = 4;
+	static void initialiseCache(void* cache);
+
+	/*AUTO_DEFINED*/ SobolStBnImpl() = default;
+	OQMC_HOST_DEVICE SobolStBnImpl(State64Bit state, const CacheType* cache);
+	OQMC_HOST_DEVICE SobolStBnImpl(int x, int y, int frame, int index,
+	                               const void* cache);
+
+	OQMC_HOST_DEVICE SobolStBnImpl newDomain(int key) const;
+	OQMC_HOST_DEVICE SobolStBnImpl newDomainSplit(int key, int size,
+	                                              int index) const;
+	OQMC_HOST_DEVICE SobolStBnImpl newDomainDistrib(int key, int index) const;
+	OQMC_HOST_DEVICE SobolStBnImpl newDomainPath(DomainPath path) const;
+
+	template <int Size>
+	OQMC_HOST_DEVICE void drawSample(std::uint32_t sample[Size]) const;
+
+	template <int Size>
+	OQMC_HOST_DEVICE void drawSampleBatch(int begin, int end,
+	                                      std::uint32_t sample[]) const;
+
+	template <int Size>
+	OQMC_HOST_DEVICE void drawRnd(std::uint32_t rnd[Size]) const;
+
+	OQMC_HOST_DEVICE State64Bit rndDomain() const;
+	OQMC_HOST_DEVICE void sobolIndexSeed(std::uint32_t& index,
+	                                    std::uint32_t& seed) const;
+
+	State64Bit state;
+	const CacheType* cache;
+};
+
+inline void SobolStBnImpl::initialiseCache(void* cache)
+{
+	assert(cache);
+
+	auto typedCache = static_cast<CacheType*>(cache);
+
+	bntables::initialiseTableCache(bntables::temporal::sobol::keyTable,
+	                               bntables::temporal::sobol::rankTable,
+	                               &typedCache->tables);
+}
+
+inline SobolStBnImpl::SobolStBnImpl(State64Bit state, const CacheType* cache)
+    : state(state), cache(cache)
+{
+	assert(cache);
+}
+
+inline SobolStBnImpl::SobolStBnImpl(int x, int y, int frame, int index,
+                                    const void* cache)
+    : state(x, y, frame >> bntables::temporal::zBits, index),
+      cache(static_cast<const CacheType*>(cache))
+{
+	assert(cache);
+
+	constexpr auto xBits = bntables::temporal::xBits;
+	constexpr auto yBits = bntables::temporal::yBits;
+	constexpr auto zBits = bntables::temporal::zBits;
+
+	// Frames index the Z axis of the table, see bntables::temporal.
+	state.pixelId = encodeBits16<xBits, yBits, zBits>({x, y, frame});
+}
+
+inline SobolStBnImpl SobolStBnImpl::newDomain(int key) const
+{
+	return {state.newDomain(key), cache};
+}
+
+inline SobolStBnImpl SobolStBnImpl::newDomainSplit(int key, int size,
+                                                   int index) const
+{
+	return {state.newDomainSplit(key, size, index), cache};
+}
+
+inline SobolStBnImpl SobolStBnImpl::newDomainDistrib(int key, int index) const
+{
+	return {state.newDomainDistrib(key, index), cache};
+}
+
+inline SobolStBnImpl SobolStBnImpl::newDomainPath(DomainPath path) const
+{
+	return {state.newDomainPath(path), cache};
+}
+
+inline void SobolStBnImpl::sobolIndexSeed(std::uint32_t& index,
+                                          std::uint32_t& seed) const
+{
+	constexpr auto xBits = bntables::temporal::xBits;
+	constexpr auto yBits = bntables::temporal::yBits;
+	constexpr auto zBits = bntables::temporal::zBits;
+
+	const auto table = bntables::tableValue<xBits, yBits, zBits>(
+	    state.pixelId, pcg::output(state.patternId), cache->tables);
+
+	index = state.sampleId ^ table.rank;
+	seed = table.key;
+}
+
+template <int Size>
+void SobolStBnImpl::drawSample(std::uint32_t sample[Size]) const
+{
+	std::uint32_t index;
+	std::uint32_t seed;
+	sobolIndexSeed(index, seed);
+
+	shuffledScrambledSobol<Size>(index, seed, sample);
+}
+
+template <int Size>
+void SobolStBnImpl::drawSampleBatch(int begin, int end,
+                                    std::uint32_t sample[]) const
+{
+	constexpr auto xBits = bntables::temporal::xBits;
+	constexpr auto yBits = bntables::temporal::yBits;
+	constexpr auto zBits = bntables::temporal::zBits;
+
+	const auto table = bntables::tableValue<xBits, yBits, zBits>(
+	    state.pixelId, pcg::output(state.patternId), cache->tables);
+
+	const auto count = end - begin;
+
+	// Evaluate groups of indices together using the vector kernel.
+	constexpr auto lanes = 8;
+
+	std::uint32_t seeds[lanes];
+	for(int i = 0; i < lanes; ++i)
+	{
+		seeds[i] = table.key;
+	}
+
+	int i = 0;
+	for(; i + lanes <= count; i += lanes)
+	{
+		std::uint32_t indices[lanes];
+		for(int j = 0; j < lanes; ++j)
+		{
+			indices[j] = computeIndexId(begin + i + j) ^ table.rank;
+		}
+
+		std::uint32_t values[Size][lanes];
+		shuffledScrambledSobolLanes<Size, lanes>(indices, seeds, values);
+
+		for(int j = 0; j < Size; ++j)
+		{
+			for(int k = 0; k < lanes; ++k)
+			{
+				sample[j * count + i + k] = values[j][k];
+			}
+		}
+	}
+
+	for(; i < count; ++i)
+	{
+		const std::uint32_t index = computeIndexId(begin + i) ^ table.rank;
+
+		std::uint32_t value[Size];
+		shuffledScrambledSobol<Size>(index, table.key, value);
+
+		for(int j = 0; j < Size; ++j)
+		{
+			sample[j * count + i] = value[j];
+		}
+	}
+}
+
+inline State64Bit SobolStBnImpl::rndDomain() const
+{
+	return state.newDomain(state.pixelId);
+}
+
+template <int Size>
+void SobolStBnImpl::drawRnd(std::uint32_t rnd[Size]) const
+{
+	rndDomain().drawRnd<Size>(rnd);
+}
+/// @endcond
+
+/// Spatio-temporal blue noise variant of sobol sampler.
+///
+/// Same as oqmc::SobolBnSampler, with the frame index along the Z axis of the
+/// oqmc::bntables::temporal tables.
+///
+/// @ingroup samplers
+using SobolStBnSampler = SamplerInterface<SobolStBnImpl>;
+
+} // namespace oqmc
@@ -16,6 +16,69 @@
 namespace oqmc
 {
 
+/// Precomputed path of domain keys.
+///
+/// Deriving a domain is an affine transition of the patternId, so a sequence of
+/// newDomain calls folds into a single multiply and add. Passing a path to
+/// newDomainPath gives the same domain as the chain of newDomain calls, but
+/// without the serial dependency between each transition. Construct a path
+/// using oqmc::domainPath(), which folds the keys at compile time.
+struct DomainPath
+{
+	/// Append a key to the path.
+	///
+	/// @param [in] key Index key of next domain.
+	/// @return Path equal to this path followed by newDomain with the key.
+	OQMC_HOST_DEVICE constexpr DomainPath newDomain(int key) const;
+
+	/// Transition a patternId along the path.
+	///
+	/// @param [in] patternId Identifier for domain pattern.
+	/// @return Identifier after a newDomain call for each key in the path.
+	OQMC_HOST_DEVICE constexpr std::uint32_t
+	transition(std::uint32_t patternId) const;
+
+	std::uint32_t multiplier; ///< Folded LCG multiplier.
+	std::uint32_t increment;  ///< Folded LCG increment.
+};
+
+constexpr DomainPath DomainPath::newDomain(int key) const
+{
+	// Composing x -> m * x + c with a transition of x + key gives a multiplier
+	// of m * A and an increment of A * (c + key) + C for the LCG constants.
+	return {pcg::stateTransition(multiplier) - pcg::stateTransition(0),
+	        pcg::stateTransition(increment + key)};
+}
+
+constexpr std::uint32_t DomainPath::transition(std::uint32_t patternId) const
+{
+	return patternId * multiplier + increment;
+}
+
+/// Fold a sequence of domain keys.
+///
+/// Compute a path equal to calling newDomain once for each key in order. Keys
+/// are template arguments so that the result is always a constant expression,
+/// for example 'oqmc::domainPath<cameraKey, lensKey>()'.
+///
+/// @tparam Keys Index keys of each domain in the path.
+/// @return Path that can be passed to newDomainPath.
+template <int... Keys>
+OQMC_HOST_DEVICE constexpr DomainPath domainPath()
+{
+	static_assert(sizeof...(Keys) > 0, "Path must have at least one key.");
+
+	const int keys[] = {Keys...};
+
+	DomainPath ret{1, 0};
+	for(const auto key : keys)
+	{
+		ret = ret.newDomain(key);
+	}
+
+	return ret;
+}
+
 /// Generic sampler state type.
 ///
 /// This type is used to represent the state of higher level sampler
@@ -72,10 +135,22 @@ struct State64Bit
 	/// @copydoc oqmc::SamplerInterface::newDomainDistrib()
 	OQMC_HOST_DEVICE State64Bit newDomainDistrib(int key, int index) const;
 
+	/// @copydoc oqmc::SamplerInterface::newDomainPath()
+	OQMC_HOST_DEVICE State64Bit newDomainPath(DomainPath path) const;
+
 	/// @copydoc oqmc::SamplerInterface::drawRnd()
 	template <int Size>
 	OQMC_HOST_DEVICE void drawRnd(std::uint32_t rnd[Size]) const;
 
+	/// Compute sampleId from index.
+	///
+	/// Given a sample index, compute the sampleId of a state constructed with
+	/// that index. This is equal to computeIndexId().
+	///
+	/// @param [in] index Sample index.
+	/// @return Sample identifier.
+	OQMC_HOST_DEVICE static constexpr std::uint32_t computeSampleId(int index);
+
 	std::uint32_t patternId; ///< Identifier for domain pattern.
 	std::uint16_t sampleId;  ///< Identifier for sample index.
 	std::uint16_t pixelId;   ///< Identifier for pixel position.
@@ -109,6 +184,11 @@ OQMC_HOST_DEVICE constexpr int computeIndexId(int index)
 	return index & mask;
 }
 
+constexpr std::uint32_t State64Bit::computeSampleId(int index)
+{
+	return computeIndexId(index);
+}
+
 inline State64Bit::State64Bit(int x, int y, int frame, int index)
 {
 	assert(index >= 0);
@@ -166,6 +246,14 @@ inline State64Bit State64Bit::newDomainDistrib(int key, int index) const
 	return ret;
 }
 
+inline State64Bit State64Bit::newDomainPath(DomainPath path) const
+{
+	auto ret = *this;
+	ret.patternId = path.transition(patternId);
+
+	return ret;
+}
+
 template <int Size>
 void State64Bit::drawRnd(std::uint32_t rnd[Size]) const
 {
@@ -181,4 +269,149 @@ void State64Bit::drawRnd(std::uint32_t rnd[Size]) const
 
 static_assert(sizeof(State64Bit) == 8, "State64Bit must be 8 bytes in size.");
 
+/// Wide sampler state type.
+///
+/// An alternative to State64Bit that stores the full sample index, rather than
+/// folding the top 16 bits of the index into the patternId. Samplers that use
+/// this state keep progressive stratification for any positive index, rather
+/// than repeating with a new randomisation every 2^16 samples. This is useful
+/// for converged reference renders and light map bakes.
+///
+/// The cost is a larger state of 12 bytes, and more expensive sample draws for
+/// some samplers. Prefer State64Bit unless more than 2^16 samples are needed.
+/// Select the state using the template parameter of the sampler types that
+/// support it, for example oqmc::BasicSobolSampler<oqmc::State96Bit>.
+struct State96Bit
+{
+	static constexpr auto maxIndexBitSize = 32; ///< 2^32 index upper limit.
+	static constexpr auto spatialEncodeBitSizeX = 8; ///< 256 pixels in x.
+	static constexpr auto spatialEncodeBitSizeY = 8; ///< 256 pixels in y.
+
+	static_assert(spatialEncodeBitSizeX == spatialEncodeBitSizeY,
+	              "Encoding must have equal resolution in x and y");
+
+	/// @copydoc oqmc::State64Bit::State64Bit()
+	/*AUTO_DEFINED*/ State96Bit() = default;
+
+	/// @copydoc oqmc::State64Bit::State64Bit(int, int, int, int)
+	OQMC_HOST_DEVICE State96Bit(int x, int y, int frame, int index);
+
+	/// @copydoc oqmc::State64Bit::pixelDecorrelate()
+	OQMC_HOST_DEVICE State96Bit pixelDecorrelate() const;
+
+	/// @copydoc oqmc::SamplerInterface::newDomain()
+	OQMC_HOST_DEVICE State96Bit newDomain(int key) const;
+
+	/// @copydoc oqmc::SamplerInterface::newDomainSplit()
+	OQMC_HOST_DEVICE State96Bit newDomainSplit(int key, int size,
+	                                           int index) const;
+
+	/// @copydoc oqmc::SamplerInterface::newDomainDistrib()
+	OQMC_HOST_DEVICE State96Bit newDomainDistrib(int key, int index) const;
+
+	/// @copydoc oqmc::SamplerInterface::newDomainPath()
+	OQMC_HOST_DEVICE State96Bit newDomainPath(DomainPath path) const;
+
+	/// @copydoc oqmc::SamplerInterface::drawRnd()
+	template <int Size>
+	OQMC_HOST_DEVICE void drawRnd(std::uint32_t rnd[Size]) const;
+
+	/// Compute sampleId from index.
+	///
+	/// Given a sample index, compute the sampleId of a state constructed with
+	/// that index. This is the index itself.
+	///
+	/// @param [in] index Sample index.
+	/// @return Sample identifier.
+	OQMC_HOST_DEVICE static constexpr std::uint32_t computeSampleId(int index);
+
+	std::uint32_t patternId; ///< Identifier for domain pattern.
+	std::uint32_t sampleId;  ///< Identifier for sample index.
+	std::uint32_t pixelId;   ///< Identifier for pixel position.
+};
+
+constexpr std::uint32_t State96Bit::computeSampleId(int index)
+{
+	return index;
+}
+
+inline State96Bit::State96Bit(int x, int y, int frame, int index)
+{
+	assert(index >= 0);
+
+	constexpr auto xBits = State96Bit::spatialEncodeBitSizeX;
+	constexpr auto yBits = State96Bit::spatialEncodeBitSizeY;
+
+	const auto pixelId = encodeBits16<xBits, yBits, 0>({x, y, 0});
+
+	this->patternId = pcg::init(frame);
+	this->sampleId = index;
+	this->pixelId = pixelId;
+}
+
+inline State96Bit State96Bit::pixelDecorrelate() const
+{
+	return newDomain(pixelId);
+}
+
+inline State96Bit State96Bit::newDomain(int key) const
+{
+	auto ret = *this;
+	ret.patternId = pcg::stateTransition(patternId + key);
+
+	return ret;
+}
+
+inline State96Bit State96Bit::newDomainSplit(int key, int size,
+                                             int index) const
+{
+	assert(size > 0);
+	assert(index >= 0);
+
+	// Compute the split index at 64 bits, so that any overflow past 2^32 can
+	// be folded into the domain key like State64Bit does past 2^16.
+	const auto splitIndex = std::uint64_t(sampleId) * size + index;
+
+	const auto indexKey = static_cast<std::uint32_t>(splitIndex >> 32);
+	const auto indexId = static_cast<std::uint32_t>(splitIndex);
+
+	auto ret = newDomain(key).newDomain(indexKey);
+	ret.sampleId = indexId;
+
+	return ret;
+}
+
+inline State96Bit State96Bit::newDomainDistrib(int key, int index) const
+{
+	assert(index >= 0);
+
+	auto ret = newDomain(key).newDomain(sampleId);
+	ret.sampleId = index;
+
+	return ret;
+}
+
+inline State96Bit State96Bit::newDomainPath(DomainPath path) const
+{
+	auto ret = *this;
+	ret.patternId = path.transition(patternId);
+
+	return ret;
+}
+
+template <int Size>
+void State96Bit::drawRnd(std::uint32_t rnd[Size]) const
+{
+	static_assert(Size >= 0, "Draw size greater or equal to zero.");
+
+	auto rngState = patternId + sampleId;
+
+	for(int i = 0; i < Size; ++i)
+	{
+		rnd[i] = pcg::rng(rngState);
+	}
+}
+
+static_assert(sizeof(State96Bit) == 12, "State96Bit must be 12 bytes in size.");
+
 } // namespace oqmc
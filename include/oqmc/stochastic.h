@@ -11,6 +11,7 @@
 
 #pragma once
 
+#include "gpu.h"
 #include "lookup.h"
 #include "pcg.h"
 #include "unused.h"
@@ -21,23 +22,12 @@
 namespace oqmc
 {
 
-/// Initialise a table with a progressive mult-jittered (0,2) sequence.
-///
-/// Given a data array and size, compute the corresponding progressive
-/// multi-jittered (0,2) sequence value for each element of the array. Each
-/// element in the array is a 4 dimensional sample. Number of samples must be
-/// larger than zero and no more than 2^16.
-///
-/// @param [in] nsamples Size of the table array.
-/// @param [out] table Output array of 4 dimensional samples.
-inline void stochasticPmjInit(int nsamples, std::uint32_t table[][4])
+/// @cond
+// Each new point in a power of two level is paired with a point from the
+// previous levels. These XOR values select the pairing for each dimension.
+OQMC_HOST_DEVICE constexpr std::uint16_t stochasticPmjXor(int dimension,
+                                                         int logN)
 {
-	constexpr auto maxIndexSize = 0x10000; // 2^16 index upper limit.
-	OQMC_MAYBE_UNUSED(maxIndexSize);
-
-	assert(nsamples >= 1);
-	assert(nsamples <= maxIndexSize);
-
 	// clang-format off
 	constexpr std::uint16_t pmjXors[2][16] = {
 		{
@@ -80,41 +70,328 @@ inline void stochasticPmjInit(int nsamples, std::uint32_t table[][4])
 	};
 	// clang-format on
 
-	const auto buffer = new std::uint32_t[nsamples][2];
+	return pmjXors[dimension][logN];
+}
+/// @endcond
+
+/// Compute a range of a progressive multi-jittered (0,2) sequence.
+///
+/// Given a range of indices, compute the corresponding 2 dimensional points of
+/// the unscrambled sequence. Random values are drawn from a single PCG stream,
+/// which is jumped ahead to the start of the range. This means the result does
+/// not depend on how the sequence is partitioned into ranges.
+///
+/// All points prior to the range must be computed beforehand, which allows a
+/// sequence to be extended on demand. Points in a power of two level, the
+/// indices [2^n, 2^(n+1)), only depend on points in prior levels. So ranges
+/// within the same level can be computed concurrently.
+///
+/// @param [in] begin Index of the first point in the range.
+/// @param [in] end Index one past the last point, no more than 2^16.
+/// @param [in, out] sequence Array of 2 dimensional points.
+OQMC_HOST_DEVICE inline void stochasticPmjSequence(int begin, int end,
+                                                   std::uint32_t sequence[][2])
+{
+	constexpr auto maxIndexSize = 0x10000; // 2^16 index upper limit.
+	OQMC_MAYBE_UNUSED(maxIndexSize);
 
-	auto state = pcg::init();
+	assert(begin >= 0);
+	assert(begin <= end);
+	assert(end <= maxIndexSize);
 
-	for(int k = 0; k < 2; ++k)
+	// Each point draws two values from the stream.
+	auto state = pcg::advance(pcg::init(), begin * 2);
+
+	auto logN = 0;
+	while((2 << logN) <= begin)
 	{
-		buffer[0][k] = pcg::rng(state);
+		++logN;
 	}
 
-	for(int prevLen = 1, logN = 0; prevLen < nsamples; prevLen *= 2, ++logN)
+	for(int i = begin; i < end; ++i)
 	{
-		for(int i1 = 0, i2 = prevLen; i1 < prevLen && i2 < nsamples; ++i1, ++i2)
+		if(i == 0)
 		{
 			for(int k = 0; k < 2; ++k)
 			{
-				const auto swapBit = 0x80000000u >> logN;
-				const auto bitMask = swapBit - 1;
+				sequence[0][k] = pcg::rng(state);
+			}
 
-				const auto j = i1 ^ pmjXors[k][logN];
+			continue;
+		}
 
-				const auto prevStratum = buffer[j][k] & ~bitMask;
-				const auto nextStratum = prevStratum ^ swapBit;
+		if(i == 2 << logN)
+		{
+			++logN;
+		}
 
-				buffer[i2][k] = nextStratum | (pcg::rng(state) & bitMask);
-			}
+		const auto prevLen = 1 << logN;
+
+		for(int k = 0; k < 2; ++k)
+		{
+			const auto swapBit = 0x80000000u >> logN;
+			const auto bitMask = swapBit - 1;
+
+			const auto j = (i - prevLen) ^ stochasticPmjXor(k, logN);
+
+			const auto prevStratum = sequence[j][k] & ~bitMask;
+			const auto nextStratum = prevStratum ^ swapBit;
+
+			sequence[i][k] = nextStratum | (pcg::rng(state) & bitMask);
 		}
 	}
+}
+
+/// Compute a range of a table from a progressive multi-jittered (0,2) sequence.
+///
+/// Given a range of indices and a sequence, compute the corresponding 4
+/// dimensional samples of the table. The second pair of dimensions is a
+/// randomisation of the first. Each element only depends on the sequence, so
+/// ranges can be computed concurrently.
+///
+/// Indices are shuffled across the whole sequence, so the sequence must be
+/// computed for all 2^16 points, regardless of the range.
+///
+/// @param [in] begin Index of the first element in the range.
+/// @param [in] end Index one past the last element, no more than 2^16.
+/// @param [in] sequence Array of 2 dimensional points.
+/// @param [out] table Output array of 4 dimensional samples.
+OQMC_HOST_DEVICE inline void
+stochasticPmjScramble(int begin, int end, const std::uint32_t sequence[][2],
+                      std::uint32_t table[][4])
+{
+	assert(begin >= 0);
+	assert(begin <= end);
+
+	for(int i = begin; i < end; ++i)
+	{
+		shuffledScrambledLookup<2, 2>(i, pcg::hash(0), sequence, &table[i][0]);
+		shuffledScrambledLookup<2, 2>(i, pcg::hash(1), sequence, &table[i][2]);
+	}
+}
+
+/// Compute a range of a table from the levels of a progressive multi-jittered
+/// (0,2) sequence.
+///
+/// Same as stochasticPmjScramble(), but indices are shuffled using
+/// levelShuffle(), so that each element in a power of two level of the table
+/// only depends on the same level of the sequence. The sequence then only needs
+/// to be computed up to the smallest power of two no less than end. This table
+/// differs from the table of the function above.
+///
+/// @param [in] begin Index of the first element in the range.
+/// @param [in] end Index one past the last element, no more than 2^16.
+/// @param [in] sequence Array of 2 dimensional points.
+/// @param [out] table Output array of 4 dimensional samples.
+OQMC_HOST_DEVICE inline void
+stochasticPmjLevelScramble(int begin, int end,
+                           const std::uint32_t sequence[][2],
+                           std::uint32_t table[][4])
+{
+	assert(begin >= 0);
+	assert(begin <= end);
 
-	for(int i = 0; i < nsamples; ++i)
+	for(int i = begin; i < end; ++i)
 	{
-		shuffledScrambledLookup<2, 2>(i, pcg::hash(0), buffer, &table[i][0]);
-		shuffledScrambledLookup<2, 2>(i, pcg::hash(1), buffer, &table[i][2]);
+		shuffledScrambledLevelLookup<2, 2>(i, pcg::hash(0), sequence,
+		                                   &table[i][0]);
+		shuffledScrambledLevelLookup<2, 2>(i, pcg::hash(1), sequence,
+		                                   &table[i][2]);
 	}
+}
+
+/// Size of a progressive multi-jittered (0,2) sequence up to a whole level.
+///
+/// Smallest power of two no less than the number of points.
+///
+/// @param [in] npoints Number of points, no more than 2^16.
+/// @return Number of points up to the end of the level.
+OQMC_HOST_DEVICE constexpr int stochasticPmjLevelSize(int npoints)
+{
+	auto size = 1;
+	while(size < npoints)
+	{
+		size *= 2;
+	}
+
+	return size;
+}
+
+/// @cond
+// Large enough to amortise jumping the PCG stream ahead, and small enough to
+// balance the largest levels across threads.
+constexpr auto stochasticPmjRangeSize = 256;
+
+// Compute the first npoints of a sequence, where npoints is a power of two.
+// Ranges within each level are passed to the loop function.
+template <typename ForLoop>
+void stochasticPmjLevels(int npoints, std::uint32_t sequence[][2],
+                         ForLoop forloop)
+{
+	constexpr auto rangeSize = stochasticPmjRangeSize;
+
+	stochasticPmjSequence(0, 1, sequence);
+
+	for(int level = 1; level < npoints; level *= 2)
+	{
+		const auto nranges = (level + rangeSize - 1) / rangeSize;
+
+		forloop(nranges, [sequence, level](int index) {
+			const auto begin = level + index * rangeSize;
+			const auto end = begin + rangeSize < level * 2 ? begin + rangeSize
+			                                               : level * 2;
+
+			stochasticPmjSequence(begin, end, sequence);
+		});
+	}
+}
+
+// Run a scramble function over the range [begin, end) of a table, split into
+// ranges that are passed to the loop function.
+template <typename Scramble, typename ForLoop>
+void stochasticPmjRanges(int begin, int end, Scramble scramble, ForLoop forloop)
+{
+	constexpr auto rangeSize = stochasticPmjRangeSize;
+
+	const auto nranges = (end - begin + rangeSize - 1) / rangeSize;
+
+	forloop(nranges, [scramble, begin, end](int index) {
+		const auto rangeBegin = begin + index * rangeSize;
+		const auto rangeEnd =
+		    rangeBegin + rangeSize < end ? rangeBegin + rangeSize : end;
+
+		scramble(rangeBegin, rangeEnd);
+	});
+}
+
+// Serial loop function, computing all ranges on the calling thread.
+struct StochasticPmjSerialLoop
+{
+	template <typename Func>
+	void operator()(int size, Func func) const
+	{
+		for(int i = 0; i < size; ++i)
+		{
+			func(i);
+		}
+	}
+};
+/// @endcond
+
+/// Initialise a table with a progressive mult-jittered (0,2) sequence.
+///
+/// Given a data array and size, compute the corresponding progressive
+/// multi-jittered (0,2) sequence value for each element of the array. Each
+/// element in the array is a 4 dimensional sample. Number of samples must be
+/// larger than zero and no more than 2^16.
+///
+/// The work is split into ranges that are passed to a loop function. Ranges
+/// within a power of two level of the sequence, and all ranges of the table,
+/// are independent. The loop function is called as `forloop(size, func)`, and
+/// must call `func(index)` for each index in [0, size) before returning,
+/// possibly concurrently. The result does not depend on the loop function.
+///
+/// @param [in] nsamples Size of the table array.
+/// @param [out] table Output array of 4 dimensional samples.
+/// @param [in] forloop Loop function to run independent ranges.
+template <typename ForLoop>
+void stochasticPmjInit(int nsamples, std::uint32_t table[][4], ForLoop forloop)
+{
+	constexpr auto maxIndexSize = 0x10000; // 2^16 index upper limit.
+
+	assert(nsamples >= 1);
+	assert(nsamples <= maxIndexSize);
+
+	const auto buffer = new std::uint32_t[maxIndexSize][2];
+
+	stochasticPmjLevels(maxIndexSize, buffer, forloop);
+
+	stochasticPmjRanges(
+	    0, nsamples,
+	    [buffer, table](int begin, int end) {
+		    stochasticPmjScramble(begin, end, buffer, table);
+	    },
+	    forloop);
 
 	delete[] buffer;
 }
 
+/// Initialise a table with a progressive mult-jittered (0,2) sequence.
+///
+/// Serial version of the function above, computing all ranges on the calling
+/// thread.
+///
+/// @param [in] nsamples Size of the table array.
+/// @param [out] table Output array of 4 dimensional samples.
+inline void stochasticPmjInit(int nsamples, std::uint32_t table[][4])
+{
+	stochasticPmjInit(nsamples, table, StochasticPmjSerialLoop());
+}
+
+/// Extend a table with the levels of a progressive mult-jittered (0,2)
+/// sequence.
+///
+/// Given a table with the samples prior to begin already computed, compute the
+/// samples in the range [begin, end) using stochasticPmjLevelScramble(). This
+/// allows a table to be initialised for a small number of samples, and then
+/// extended on demand. The result is the same as computing the whole range at
+/// once.
+///
+/// The sequence is not stored in the table, so it is computed again from the
+/// start up to the level of end. When the table at least doubles in size each
+/// time, this costs no more than computing the new samples.
+///
+/// The work is split into ranges that are passed to a loop function, as with
+/// stochasticPmjInit().
+///
+/// @param [in] begin Index of the first sample to compute.
+/// @param [in] end Index one past the last sample, no more than 2^16.
+/// @param [in, out] table Array of 4 dimensional samples.
+/// @param [in] forloop Loop function to run independent ranges.
+template <typename ForLoop>
+void stochasticPmjLevelExtend(int begin, int end, std::uint32_t table[][4],
+                              ForLoop forloop)
+{
+	constexpr auto maxIndexSize = 0x10000; // 2^16 index upper limit.
+	OQMC_MAYBE_UNUSED(maxIndexSize);
+
+	assert(begin >= 0);
+	assert(begin <= end);
+	assert(end <= maxIndexSize);
+
+	if(begin == end)
+	{
+		return;
+	}
+
+	const auto npoints = stochasticPmjLevelSize(end);
+	const auto buffer = new std::uint32_t[npoints][2];
+
+	stochasticPmjLevels(npoints, buffer, forloop);
+
+	stochasticPmjRanges(
+	    begin, end,
+	    [buffer, table](int begin, int end) {
+		    stochasticPmjLevelScramble(begin, end, buffer, table);
+	    },
+	    forloop);
+
+	delete[] buffer;
+}
+
+/// Extend a table with the levels of a progressive mult-jittered (0,2)
+/// sequence.
+///
+/// Serial version of the function above, computing all ranges on the calling
+/// thread.
+///
+/// @param [in] begin Index of the first sample to compute.
+/// @param [in] end Index one past the last sample, no more than 2^16.
+/// @param [in, out] table Array of 4 dimensional samples.
+inline void stochasticPmjLevelExtend(int begin, int end,
+                                     std::uint32_t table[][4])
+{
+	stochasticPmjLevelExtend(begin, end, table, StochasticPmjSerialLoop());
+}
+
 } // namespace oqmc
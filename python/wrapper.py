@@ -14,14 +14,15 @@ module.oqmc_benchmark.argtypes = [
     ctypes.c_char_p,
     ctypes.c_int,
     ctypes.c_int,
+    ctypes.c_int,
     ctypes.POINTER(ctypes.c_int),
 ]
 
 
-def benchmark(sampler, measurement, nsamples, ndims):
+def benchmark(sampler, measurement, nsamples, ndims, nthreads=0):
     time = ctypes.c_int(0)
     valid = module.oqmc_benchmark(
-        sampler, measurement, nsamples, ndims, ctypes.byref(time)
+        sampler, measurement, nsamples, ndims, nthreads, ctypes.byref(time)
     )
 
     if not valid:
@@ -30,6 +31,195 @@ def benchmark(sampler, measurement, nsamples, ndims):
     return time.value
 
 
+module.oqmc_benchmark_trials.restype = ctypes.c_bool
+module.oqmc_benchmark_trials.argtypes = [
+    ctypes.c_char_p,
+    ctypes.c_char_p,
+    ctypes.c_int,
+    ctypes.c_char_p,
+    ctypes.c_int,
+    ctypes.c_int,
+    ctypes.c_int,
+    ctypes.c_int,
+    ctypes.c_int,
+    np.ctypeslib.ndpointer(),
+    np.ctypeslib.ndpointer(),
+]
+
+counter_names = [
+    "cycles",
+    "instructions",
+    "l1d_misses",
+    "llc_misses",
+    "branch_misses",
+]
+
+
+def benchmark_trials(
+    sampler,
+    measurement,
+    size,
+    derivation,
+    nsamples,
+    ndims,
+    nthreads,
+    nwarmups,
+    ntrials,
+):
+    times = np.zeros(ntrials, dtype=np.float64)
+    counters = np.zeros(len(counter_names), dtype=np.float64)
+    valid = module.oqmc_benchmark_trials(
+        sampler,
+        measurement,
+        size,
+        derivation,
+        nsamples,
+        ndims,
+        nthreads,
+        nwarmups,
+        ntrials,
+        times,
+        counters,
+    )
+
+    if not valid:
+        sys.exit()
+
+    return times, counters
+
+
+def benchmark_suite(
+    samplers,
+    measurements,
+    sizes,
+    derivations,
+    nsamples=1 << 14,
+    ndims=64,
+    ndepth=16,
+    nthreads=1,
+    nwarmups=3,
+    ntrials=21,
+):
+    results = []
+    render = ["tile", "random", "cold"]
+
+    # Cache measurements draw no samples, so they ignore the size and
+    # derivation, and have no cost per sample.
+    caches = ["init", "load"]
+    no_size = caches + ["derive", "enumerate"]
+    no_derivation = caches + ["enumerate"]
+
+    for sampler in samplers:
+        for measurement in measurements:
+            measurement_sizes = [None] if measurement in no_size else sizes
+            measurement_derivations = (
+                [None] if measurement in no_derivation else derivations
+            )
+
+            for size in measurement_sizes:
+                for derivation in measurement_derivations:
+                    times, counters = benchmark_trials(
+                        sampler.encode(),
+                        measurement.encode(),
+                        0 if size is None else size,
+                        (derivation or "domain").encode(),
+                        nsamples,
+                        ndepth if measurement in render else ndims,
+                        nthreads,
+                        nwarmups,
+                        ntrials,
+                    )
+
+                    sampling = measurement not in caches
+                    median = np.median(times)
+                    per_sample = {
+                        name + "_per_sample": (
+                            v if sampling and not np.isnan(v) else None
+                        )
+                        for name, v in zip(counter_names, counters)
+                    }
+
+                    results.append(
+                        {
+                            "sampler": sampler,
+                            "measurement": measurement,
+                            "size": size,
+                            "derivation": derivation,
+                            "min": np.min(times),
+                            "p5": np.percentile(times, 5),
+                            "p25": np.percentile(times, 25),
+                            "median": median,
+                            "p75": np.percentile(times, 75),
+                            "p95": np.percentile(times, 95),
+                            "max": np.max(times),
+                            "mad": np.median(np.abs(times - median)),
+                            **per_sample,
+                            "ns_per_sample": (
+                                median / nsamples if sampling else None
+                            ),
+                        }
+                    )
+
+    return {
+        "nsamples": nsamples,
+        "ndims": ndims,
+        "ndepth": ndepth,
+        "nthreads": nthreads,
+        "nwarmups": nwarmups,
+        "ntrials": ntrials,
+        "results": results,
+    }
+
+
+def benchmark_compare(suite, baseline, threshold=0.05):
+    keys = ["sampler", "measurement", "size", "derivation"]
+
+    # A value of None matches any value in the baseline, as older baselines
+    # repeat the same measurement for each size and derivation.
+    def match(result, record):
+        return all(
+            result[k] is None or result[k] == record.get(k) for k in keys
+        )
+
+    regressions = []
+
+    for result in suite["results"]:
+        base = next(
+            (r for r in baseline["results"] if match(result, r)), None
+        )
+
+        if base is None:
+            continue
+
+        noise = 3 * 1.4826 * np.hypot(result["mad"], base["mad"])
+        change = result["median"] - base["median"]
+
+        result["baseline"] = base["median"]
+        result["change"] = result["median"] / base["median"] - 1
+        result["regression"] = bool(
+            change > threshold * base["median"] and change > noise
+        )
+
+        if result["regression"]:
+            regressions.append(result)
+
+    return regressions
+
+
+module.oqmc_cache.restype = ctypes.c_bool
+module.oqmc_cache.argtypes = [
+    ctypes.c_char_p,
+    ctypes.c_char_p,
+]
+
+
+def cache(name, path):
+    valid = module.oqmc_cache(name, path)
+
+    if not valid:
+        sys.exit()
+
+
 module.oqmc_frequency_continuous.restype = ctypes.c_bool
 module.oqmc_frequency_continuous.argtypes = [
     ctypes.c_int,
@@ -75,6 +265,26 @@ def generate(name, nsequences, nsamples, ndims):
     return points
 
 
+module.oqmc_generate_file.restype = ctypes.c_bool
+module.oqmc_generate_file.argtypes = [
+    ctypes.c_char_p,
+    ctypes.c_int,
+    ctypes.c_int,
+    ctypes.c_int,
+    ctypes.c_char_p,
+    ctypes.c_char_p,
+]
+
+
+def generate_file(name, nsequences, nsamples, ndims, layout, path):
+    valid = module.oqmc_generate_file(
+        name, nsequences, nsamples, ndims, layout, path
+    )
+
+    if not valid:
+        sys.exit()
+
+
 module.oqmc_optimise.restype = ctypes.c_bool
 module.oqmc_optimise.argtypes = [
     ctypes.c_char_p,
@@ -84,6 +294,13 @@ module.oqmc_optimise.argtypes = [
     ctypes.c_int,
     ctypes.c_int,
     ctypes.c_int,
+    ctypes.c_int,
+    ctypes.c_float,
+    ctypes.c_float,
+    ctypes.c_int,
+    ctypes.c_char_p,
+    ctypes.c_int,
+    ctypes.c_bool,
     np.ctypeslib.ndpointer(),
     np.ctypeslib.ndpointer(),
     np.ctypeslib.ndpointer(),
@@ -91,13 +308,28 @@ module.oqmc_optimise.argtypes = [
 ]
 
 
-def optimise(name, ntests, niterations, nsamples, resolution, depth, seed):
+def optimise(
+    name,
+    ntests,
+    niterations,
+    nsamples,
+    resolution,
+    depth,
+    seed,
+    nlevels=1,
+    temperature_start=0.0,
+    temperature_end=0.0,
+    nreplicas=1,
+    checkpoint=None,
+    interval=600,
+    resume=False,
+):
     module.oqmc_progress_off()
 
-    keys = np.zeros((resolution, resolution, depth), dtype=np.uint32)
-    ranks = np.zeros((resolution, resolution, depth), dtype=np.uint32)
-    estimates = np.zeros((resolution, resolution, depth), dtype=np.float32)
-    frequencies = np.zeros((resolution, resolution, depth), dtype=np.float32)
+    keys = np.zeros((depth, resolution, resolution), dtype=np.uint32)
+    ranks = np.zeros((depth, resolution, resolution), dtype=np.uint32)
+    estimates = np.zeros((depth, resolution, resolution), dtype=np.float32)
+    frequencies = np.zeros((depth, resolution, resolution), dtype=np.float32)
     valid = module.oqmc_optimise(
         name,
         ntests,
@@ -105,7 +337,14 @@ def optimise(name, ntests, niterations, nsamples, resolution, depth, seed):
         nsamples,
         resolution,
         depth,
+        nlevels,
         seed,
+        temperature_start,
+        temperature_end,
+        nreplicas,
+        checkpoint,
+        interval,
+        resume,
         keys,
         ranks,
         estimates,
@@ -238,6 +477,7 @@ module.oqmc_trace.argtypes = [
     ctypes.c_char_p,
     ctypes.c_char_p,
     ctypes.c_char_p,
+    ctypes.c_char_p,
     ctypes.c_int,
     ctypes.c_int,
     ctypes.c_int,
@@ -246,6 +486,7 @@ module.oqmc_trace.argtypes = [
     ctypes.c_int,
     ctypes.c_int,
     np.ctypeslib.ndpointer(),
+    ctypes.POINTER(ctypes.c_double),
 ]
 
 
@@ -260,14 +501,17 @@ def trace(
     numLightSamples,
     maxDepth,
     maxOpacity,
+    schedule=b"tile",
 ):
     module.oqmc_progress_off()
 
+    time = ctypes.c_double(0)
     image = np.zeros((height, width, 3), dtype=np.float32)
     valid = module.oqmc_trace(
         name,
         scene,
         mode,
+        schedule,
         width,
         height,
         frame,
@@ -276,6 +520,7 @@ def trace(
         maxDepth,
         maxOpacity,
         image,
+        ctypes.byref(time),
     )
 
     module.oqmc_progress_on()
@@ -48,6 +48,50 @@ extern const std::uint32_t rankTable[] = {
 
 } // namespace lattice
 
+namespace temporal
+{
+
+namespace pmj
+{
+
+extern const std::uint32_t keyTable[] = {
+#include <oqmc/data/temporal/pmj/keys.txt>
+};
+
+extern const std::uint32_t rankTable[] = {
+#include <oqmc/data/temporal/pmj/ranks.txt>
+};
+
+} // namespace pmj
+
+namespace sobol
+{
+
+extern const std::uint32_t keyTable[] = {
+#include <oqmc/data/temporal/sobol/keys.txt>
+};
+
+extern const std::uint32_t rankTable[] = {
+#include <oqmc/data/temporal/sobol/ranks.txt>
+};
+
+} // namespace sobol
+
+namespace lattice
+{
+
+extern const std::uint32_t keyTable[] = {
+#include <oqmc/data/temporal/lattice/keys.txt>
+};
+
+extern const std::uint32_t rankTable[] = {
+#include <oqmc/data/temporal/lattice/ranks.txt>
+};
+
+} // namespace lattice
+
+} // namespace temporal
+
 } // namespace bntables
 
 } // namespace oqmc
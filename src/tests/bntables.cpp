@@ -7,6 +7,7 @@
 #include <gtest/gtest.h>
 
 #include <climits>
+#include <cstddef>
 #include <cstdint>
 
 namespace
@@ -285,4 +286,107 @@ TEST(BnTablesTest, KeyRankEqualTableValue)
 	}
 }
 
+TEST(BnTablesTest, PackTableEntry)
+{
+	const auto entry = oqmc::bntables::packTableEntry(0x12345678, 0xabcd);
+
+	EXPECT_EQ(entry.keyLow, 0x5678);
+	EXPECT_EQ(entry.keyHigh, 0x1234);
+	EXPECT_EQ(entry.rank, 0xabcd);
+}
+
+TEST(BnTablesTest, InterleavedEqualTableValue)
+{
+	constexpr auto size = sizeof(keys) / sizeof(keys[0]);
+
+	oqmc::bntables::TableEntry entries[size];
+	for(std::size_t i = 0; i < size; ++i)
+	{
+		// Offset the keys to make use of the high bits.
+		const auto key = keys[i] * 0x10001;
+		entries[i] = oqmc::bntables::packTableEntry(key, ranks[i]);
+	}
+
+	for(int x = 0; x < prime; ++x)
+	{
+		for(int y = 0; y < prime; ++y)
+		{
+			for(int z = 0; z < prime; ++z)
+			{
+				auto pixel = oqmc::encodeBits16<xBits, yBits, zBits>({x, y, z});
+				auto shift = oqmc::encodeBits16<xBits, yBits, zBits>({z, x, y});
+
+				auto valueA = oqmc::bntables::tableValue<xBits, yBits, zBits>(
+				    pixel, shift, keys, ranks);
+
+				auto valueB = oqmc::bntables::tableValue<xBits, yBits, zBits>(
+				    pixel, shift, entries);
+
+				EXPECT_EQ(valueA.key * 0x10001, valueB.key);
+				EXPECT_EQ(valueA.rank, valueB.rank);
+			}
+		}
+	}
+}
+
+TEST(BnTablesTest, CacheEqualTableValue)
+{
+	const auto cache = new oqmc::bntables::TableCache<oqmc::bntables::size>;
+	oqmc::bntables::initialiseTableCache(oqmc::bntables::sobol::keyTable,
+	                                     oqmc::bntables::sobol::rankTable,
+	                                     cache);
+
+	constexpr auto x = oqmc::bntables::xBits;
+	constexpr auto y = oqmc::bntables::yBits;
+
+	for(int i = 0; i < oqmc::bntables::size; i += prime)
+	{
+		const auto pixel = static_cast<std::uint16_t>(i);
+		const auto shift = static_cast<std::uint16_t>(i * prime);
+
+		const auto valueA = oqmc::bntables::tableValue<x, y, 0>(
+		    pixel, shift, oqmc::bntables::sobol::keyTable,
+		    oqmc::bntables::sobol::rankTable);
+
+		const auto valueB =
+		    oqmc::bntables::tableValue<x, y, 0>(pixel, shift, *cache);
+
+		EXPECT_EQ(valueA.key, valueB.key);
+		EXPECT_EQ(valueA.rank, valueB.rank);
+	}
+
+	delete cache;
+}
+
+TEST(BnTablesTest, TemporalCacheEqualTableValue)
+{
+	namespace temporal = oqmc::bntables::temporal;
+
+	const auto cache = new oqmc::bntables::TableCache<temporal::size>;
+	oqmc::bntables::initialiseTableCache(temporal::sobol::keyTable,
+	                                     temporal::sobol::rankTable, cache);
+
+	constexpr auto x = temporal::xBits;
+	constexpr auto y = temporal::yBits;
+	constexpr auto z = temporal::zBits;
+
+	for(int i = 0; i < temporal::size; i += prime)
+	{
+		const auto pixel = static_cast<std::uint16_t>(i);
+		const auto shift = static_cast<std::uint16_t>(i * prime);
+
+		const auto valueA = oqmc::bntables::tableValue<x, y, z>(
+		    pixel, shift, temporal::sobol::keyTable,
+		    temporal::sobol::rankTable);
+
+		const auto valueB =
+		    oqmc::bntables::tableValue<x, y, z>(pixel, shift, *cache);
+
+		EXPECT_EQ(valueA.key, valueB.key);
+		EXPECT_EQ(valueA.rank, valueB.rank);
+	}
+
+	delete cache;
+}
+
 } // namespace
@@ -0,0 +1,193 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Contributors to the OpenQMC Project.
+
+#include <oqmc/cachefile.h>
+#include <oqmc/latticebn.h>
+#include <oqmc/pmj.h>
+#include <oqmc/pmjbn.h>
+#include <oqmc/sobol.h>
+#include <oqmc/sobolhd.h>
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+
+constexpr auto frame = 2; // 1st prime
+
+template <typename Sampler>
+std::uint64_t* createFile()
+{
+	constexpr auto size = oqmc::cacheFileSize<Sampler>();
+
+	const auto file = new std::uint64_t[(size + 7) / 8];
+	oqmc::initialiseCacheFile<Sampler>(file);
+
+	return file;
+}
+
+template <typename Sampler>
+void checkSamples()
+{
+	constexpr auto size = oqmc::cacheFileSize<Sampler>();
+
+	const auto file = createFile<Sampler>();
+	const auto data = oqmc::cacheFileData<Sampler>(file, size);
+	ASSERT_NE(data, nullptr);
+
+	const auto cache = new char[Sampler::cacheSize];
+	Sampler::initialiseCache(cache);
+
+	for(int i = 0; i < 64; ++i)
+	{
+		const auto samplerA = Sampler(i, i * 3, frame, i, data);
+		const auto samplerB = Sampler(i, i * 3, frame, i, cache);
+
+		std::uint32_t sampleA[4];
+		std::uint32_t sampleB[4];
+		samplerA.template drawSample<4>(sampleA);
+		samplerB.template drawSample<4>(sampleB);
+
+		for(int j = 0; j < 4; ++j)
+		{
+			EXPECT_EQ(sampleA[j], sampleB[j]);
+		}
+	}
+
+	delete[] cache;
+	delete[] file;
+}
+
+TEST(CacheFileTest, Header)
+{
+	using Sampler = oqmc::PmjSampler;
+
+	const auto file = createFile<Sampler>();
+
+	oqmc::CacheFileHeader header;
+	std::memcpy(&header, file, sizeof(header));
+
+	const auto magic = oqmc::cacheFileMagic;
+	const auto version = oqmc::cacheFileVersion;
+	const auto cacheId = Sampler::cacheId;
+	const auto cacheVersion = Sampler::cacheVersion;
+	const auto cacheSize = Sampler::cacheSize;
+
+	EXPECT_EQ(header.magic, magic);
+	EXPECT_EQ(header.version, version);
+	EXPECT_EQ(header.cacheId, cacheId);
+	EXPECT_EQ(header.cacheVersion, cacheVersion);
+	EXPECT_EQ(header.cacheSize, cacheSize);
+
+	delete[] file;
+}
+
+TEST(CacheFileTest, UniqueCacheId)
+{
+	const auto pmj = oqmc::PmjSampler::cacheId;
+	const auto pmjbn = oqmc::PmjBnSampler::cacheId;
+	const auto sobol = oqmc::SobolSampler::cacheId;
+	const auto latticebn = oqmc::LatticeBnSampler::cacheId;
+
+	EXPECT_NE(pmj, pmjbn);
+	EXPECT_NE(pmj, sobol);
+	EXPECT_NE(pmjbn, latticebn);
+}
+
+TEST(CacheFileTest, RejectSize)
+{
+	using Sampler = oqmc::PmjSampler;
+	constexpr auto size = oqmc::cacheFileSize<Sampler>();
+
+	const auto file = createFile<Sampler>();
+
+	EXPECT_NE(oqmc::cacheFileData<Sampler>(file, size), nullptr);
+	EXPECT_EQ(oqmc::cacheFileData<Sampler>(file, size - 1), nullptr);
+	EXPECT_EQ(oqmc::cacheFileData<Sampler>(nullptr, size), nullptr);
+
+	delete[] file;
+}
+
+TEST(CacheFileTest, RejectSampler)
+{
+	using SamplerA = oqmc::SobolSampler;
+	using SamplerB = oqmc::SobolHdSampler;
+
+	// Neither type has cache data, so only the identifier differs.
+	constexpr auto size = oqmc::cacheFileSize<SamplerA>();
+	static_assert(size == oqmc::cacheFileSize<SamplerB>(), "");
+
+	const auto file = createFile<SamplerA>();
+
+	EXPECT_NE(oqmc::cacheFileData<SamplerA>(file, size), nullptr);
+	EXPECT_EQ(oqmc::cacheFileData<SamplerB>(file, size), nullptr);
+
+	delete[] file;
+}
+
+TEST(CacheFileTest, RejectVersion)
+{
+	using Sampler = oqmc::PmjSampler;
+	constexpr auto size = oqmc::cacheFileSize<Sampler>();
+
+	const auto file = createFile<Sampler>();
+
+	oqmc::CacheFileHeader header;
+	std::memcpy(&header, file, sizeof(header));
+	header.cacheVersion += 1;
+	std::memcpy(file, &header, sizeof(header));
+
+	EXPECT_EQ(oqmc::cacheFileData<Sampler>(file, size), nullptr);
+
+	delete[] file;
+}
+
+TEST(CacheFileTest, RejectChecksum)
+{
+	using Sampler = oqmc::PmjSampler;
+	constexpr auto size = oqmc::cacheFileSize<Sampler>();
+
+	const auto file = createFile<Sampler>();
+	const auto bytes = reinterpret_cast<unsigned char*>(file);
+	bytes[size - 1] ^= 1;
+
+	EXPECT_EQ(oqmc::cacheFileData<Sampler>(file, size, true), nullptr);
+	EXPECT_NE(oqmc::cacheFileData<Sampler>(file, size, false), nullptr);
+
+	delete[] file;
+}
+
+TEST(CacheFileTest, Checksum)
+{
+	const unsigned char data[] = {1, 2, 3, 4, 5, 6, 7};
+
+	EXPECT_EQ(oqmc::cacheChecksum(data, 0), 0x811c9dc5);
+	EXPECT_NE(oqmc::cacheChecksum(data, 7), oqmc::cacheChecksum(data, 6));
+	EXPECT_NE(oqmc::cacheChecksum(data, 4), oqmc::cacheChecksum(data + 1, 4));
+}
+
+TEST(CacheFileTest, PmjSamples)
+{
+	checkSamples<oqmc::PmjSampler>();
+}
+
+TEST(CacheFileTest, PmjBnSamples)
+{
+	checkSamples<oqmc::PmjBnSampler>();
+}
+
+TEST(CacheFileTest, SobolSamples)
+{
+	checkSamples<oqmc::SobolSampler>();
+}
+
+TEST(CacheFileTest, LatticeBnSamples)
+{
+	checkSamples<oqmc::LatticeBnSampler>();
+}
+
+} // namespace
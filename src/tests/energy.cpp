@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Contributors to the OpenQMC Project.
+
+#include "../tools/lib/energy.h"
+#include <oqmc/float.h>
+#include <oqmc/pcg.h>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+
+namespace
+{
+
+// Largest kernel of the optimiser, with 13x13 taps in a frame less the centre,
+// and 12 taps along Z.
+constexpr auto maxSize = 180;
+
+// Sizes with and without a tail of taps beyond a multiple of the lane count.
+constexpr std::array<int, 8> sizes{
+    0, 1, 3, 4, 8, 11, 168, maxSize,
+};
+
+struct Taps
+{
+	Taps()
+	{
+		auto state = oqmc::pcg::init(0);
+
+		for(int i = 0; i < maxSize; ++i)
+		{
+			weights[i] = oqmc::uintToFloat(oqmc::pcg::rng(state));
+			rowA[i] = oqmc::uintToFloat(oqmc::pcg::rng(state));
+			rowB[i] = oqmc::uintToFloat(oqmc::pcg::rng(state));
+			selected[i] = oqmc::pcg::rng(state) & 1;
+		}
+	}
+
+	float weights[maxSize];
+	float rowA[maxSize];
+	float rowB[maxSize];
+	bool selected[maxSize];
+};
+
+// Lanes are summed in a different order to a serial loop, so the sums are
+// compared with a tolerance relative to the serial sum.
+TEST(EnergyTest, KernelSumMatchScalar)
+{
+	const Taps taps;
+
+	for(const auto size : sizes)
+	{
+		auto expected = 0.0f;
+		for(int i = 0; i < size; ++i)
+		{
+			expected += taps.weights[i] * taps.rowA[i];
+		}
+
+		const auto actual = kernelSum(size, taps.weights,
+		                              [&](int tap) { return taps.rowA[tap]; });
+
+		EXPECT_NEAR(actual, expected, expected * 1e-5f);
+	}
+}
+
+TEST(EnergyTest, KernelSumRowsMatchScalar)
+{
+	const Taps taps;
+
+	for(const auto size : sizes)
+	{
+		auto expected = 0.0f;
+		for(int i = 0; i < size; ++i)
+		{
+			const auto distance =
+			    taps.selected[i] ? taps.rowB[i] : taps.rowA[i];
+
+			expected += taps.weights[i] * distance;
+		}
+
+		const auto actual =
+		    kernelSumRows(size, taps.weights, taps.rowA, taps.rowB,
+		                  [&](int tap) { return taps.selected[tap]; });
+
+		EXPECT_NEAR(actual, expected, expected * 1e-5f);
+	}
+}
+
+// Blending rows must give exactly the same sum as gathering the same distances,
+// so that the optimiser finds the same tables with either.
+TEST(EnergyTest, KernelSumRowsEqualGather)
+{
+	const Taps taps;
+
+	for(const auto size : sizes)
+	{
+		const auto expected = kernelSum(size, taps.weights, [&](int tap) {
+			return taps.selected[tap] ? taps.rowB[tap] : taps.rowA[tap];
+		});
+
+		const auto actual =
+		    kernelSumRows(size, taps.weights, taps.rowA, taps.rowB,
+		                  [&](int tap) { return taps.selected[tap]; });
+
+		EXPECT_EQ(actual, expected);
+	}
+}
+
+} // namespace
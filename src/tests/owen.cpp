@@ -104,6 +104,81 @@ TEST(OwenTest, 02Sequence)
 	}
 }
 
+TEST(OwenTest, 02Sequence32)
+{
+	constexpr auto m = 8;
+	constexpr auto n = 1 << m;
+
+	// Take a block beyond 2^16 indices, where the 16 bit variant repeats.
+	constexpr auto begin = 5 << 16;
+
+	std::array<bool, n> strata;
+	for(int i = 0; i < m + 1; ++i)
+	{
+		const int xResolution = 1 << i;
+		const int yResolution = 1 << (m - i);
+
+		ASSERT_EQ(xResolution * yResolution, n);
+
+		const std::uint32_t xWidth = UINT32_MAX / xResolution;
+		const std::uint32_t yWidth = UINT32_MAX / yResolution;
+
+		strata.fill(false);
+		for(int index = begin; index < begin + n; ++index)
+		{
+			std::uint32_t out[2];
+			oqmc::shuffledScrambledSobol32<2>(index, oqmc::pcg::hash(0), out);
+
+			const int x = out[0] / xWidth;
+			const int y = out[1] / yWidth;
+
+			const int coordinate = x + y * xResolution;
+			auto& stratum = strata[coordinate];
+
+			ASSERT_FALSE(stratum);
+
+			stratum = true;
+		}
+
+		for(auto stratum : strata)
+		{
+			EXPECT_TRUE(stratum);
+		}
+	}
+}
+
+TEST(OwenTest, ReversedIndex32MatchReversedIndex)
+{
+	for(int dimension = 0; dimension < 4; ++dimension)
+	{
+		for(std::uint32_t index = 0; index < 1 << 16; ++index)
+		{
+			const auto value = oqmc::sobolReversedIndex(index, dimension);
+			const auto high = index << 16;
+
+			ASSERT_EQ(oqmc::sobolReversedIndex32(high, dimension) & 0xffff,
+			          value);
+		}
+	}
+}
+
+TEST(OwenTest, Sobol32NoRepeat)
+{
+	constexpr auto seed = 7;
+	constexpr auto period = 1 << 16;
+
+	for(int index = 0; index < 1024; ++index)
+	{
+		std::uint32_t a[4];
+		std::uint32_t b[4];
+		oqmc::shuffledScrambledSobol32<4>(index, seed, a);
+		oqmc::shuffledScrambledSobol32<4>(index + period, seed, b);
+
+		EXPECT_FALSE(a[0] == b[0] && a[1] == b[1] && a[2] == b[2] &&
+		             a[3] == b[3]);
+	}
+}
+
 TEST(OwenTest, ShirleyRemapping)
 {
 	constexpr auto numStratum = 8;
@@ -142,4 +217,102 @@ TEST(OwenTest, ShirleyRemapping)
 	}
 }
 
+template <int Depth, int Lanes>
+void checkLanes()
+{
+	for(int n = 0; n < 64; ++n)
+	{
+		std::uint32_t index[Lanes];
+		std::uint32_t seed[Lanes];
+
+		for(int i = 0; i < Lanes; ++i)
+		{
+			index[i] = oqmc::pcg::hash(n * Lanes * 2 + i * 2 + 0);
+			seed[i] = oqmc::pcg::hash(n * Lanes * 2 + i * 2 + 1);
+		}
+
+		std::uint32_t sample[Depth][Lanes];
+		oqmc::shuffledScrambledSobolLanes<Depth, Lanes>(index, seed, sample);
+
+		for(int i = 0; i < Lanes; ++i)
+		{
+			std::uint32_t expected[Depth];
+			oqmc::shuffledScrambledSobol<Depth>(index[i], seed[i], expected);
+
+			for(int j = 0; j < Depth; ++j)
+			{
+				ASSERT_EQ(sample[j][i], expected[j]);
+			}
+		}
+	}
+}
+
+template <int Lanes>
+void checkLanesAllDepths()
+{
+	checkLanes<1, Lanes>();
+	checkLanes<2, Lanes>();
+	checkLanes<3, Lanes>();
+	checkLanes<4, Lanes>();
+}
+
+TEST(OwenTest, LanesMatchScalar)
+{
+	checkLanesAllDepths<1>();
+	checkLanesAllDepths<3>();
+	checkLanesAllDepths<4>();
+	checkLanesAllDepths<8>();
+	checkLanesAllDepths<13>();
+	checkLanesAllDepths<16>();
+}
+
+template <int Depth>
+void checkEnumerator(std::uint32_t begin, std::uint32_t seed)
+{
+	auto enumerator = oqmc::SobolEnumerator<Depth>(begin, seed);
+
+	for(int i = 0; i < 1024; ++i)
+	{
+		const std::uint32_t index = begin + i;
+
+		ASSERT_EQ(enumerator.index(), index);
+
+		std::uint32_t sample[Depth];
+		enumerator.drawSample(sample);
+
+		std::uint32_t expected[Depth];
+		oqmc::shuffledScrambledSobol<Depth>(index, seed, expected);
+
+		for(int j = 0; j < Depth; ++j)
+		{
+			ASSERT_EQ(sample[j], expected[j]);
+		}
+
+		enumerator.next();
+	}
+}
+
+TEST(OwenTest, EnumeratorMatchScalar)
+{
+	constexpr std::array<std::uint32_t, 4> begins{
+	    0,
+	    7,
+	    (1 << 16) - 512,
+	    UINT32_MAX - 512,
+	};
+
+	for(int i = 0; i < 8; ++i)
+	{
+		const auto seed = oqmc::pcg::hash(i);
+
+		for(auto begin : begins)
+		{
+			checkEnumerator<1>(begin, seed);
+			checkEnumerator<2>(begin, seed);
+			checkEnumerator<3>(begin, seed);
+			checkEnumerator<4>(begin, seed);
+		}
+	}
+}
+
 } // namespace
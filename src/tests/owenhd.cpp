@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Contributors to the OpenQMC Project.
+
+#include "hypothesis.h"
+#include <oqmc/owen.h>
+#include <oqmc/owenhd.h>
+#include <oqmc/pcg.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+namespace
+{
+
+template <int X, int Y>
+struct SamplerV1
+{
+	void initialise(int seed)
+	{
+		hash = oqmc::pcg::hash(seed);
+	}
+
+	void sample(int index, std::uint32_t out[2]) const
+	{
+		std::uint32_t rnd[oqmc::sobolHdMaxDepth];
+		oqmc::shuffledScrambledSobolHd<oqmc::sobolHdMaxDepth>(index, hash, rnd);
+
+		out[0] = rnd[X];
+		out[1] = rnd[Y];
+	}
+
+	std::uint32_t hash;
+};
+
+ALL_HYPOTHESIS_TESTS(OwenHdTest, SampleDims01, (SamplerV1<0, 1>()))
+ALL_HYPOTHESIS_TESTS(OwenHdTest, SampleDims34, (SamplerV1<3, 4>()))
+ALL_HYPOTHESIS_TESTS(OwenHdTest, SampleDims45, (SamplerV1<4, 5>()))
+ALL_HYPOTHESIS_TESTS(OwenHdTest, SampleDims1531, (SamplerV1<15, 31>()))
+ALL_HYPOTHESIS_TESTS(OwenHdTest, SampleDims3031, (SamplerV1<30, 31>()))
+
+template <int Depth>
+void checkReversedIndex()
+{
+	for(int i = 0; i < 1 << 16; ++i)
+	{
+		std::uint16_t sample[Depth];
+		oqmc::sobolReversedIndexHd<Depth>(i, sample);
+
+		for(int j = 0; j < Depth && j < 4; ++j)
+		{
+			ASSERT_EQ(sample[j], oqmc::sobolReversedIndex(i, j));
+		}
+	}
+}
+
+TEST(OwenHdTest, ReversedIndexMatchOwen)
+{
+	checkReversedIndex<1>();
+	checkReversedIndex<4>();
+	checkReversedIndex<9>();
+	checkReversedIndex<oqmc::sobolHdMaxDepth>();
+}
+
+template <int Depth>
+void checkShuffledScrambled()
+{
+	for(int i = 0; i < 1024; ++i)
+	{
+		const auto seed = oqmc::pcg::hash(i);
+
+		std::uint32_t sample[Depth];
+		oqmc::shuffledScrambledSobolHd<Depth>(i, seed, sample);
+
+		std::uint32_t expected[4];
+		oqmc::shuffledScrambledSobol<4>(i, seed, expected);
+
+		for(int j = 0; j < Depth && j < 4; ++j)
+		{
+			ASSERT_EQ(sample[j], expected[j]);
+		}
+	}
+}
+
+TEST(OwenHdTest, ShuffledScrambledMatchOwen)
+{
+	checkShuffledScrambled<1>();
+	checkShuffledScrambled<4>();
+	checkShuffledScrambled<9>();
+	checkShuffledScrambled<oqmc::sobolHdMaxDepth>();
+}
+
+TEST(OwenHdTest, Stratification)
+{
+	// Every 1D projection of a sobol sequence is stratified.
+	constexpr auto m = 8;
+	constexpr auto n = 1 << m;
+
+	std::uint32_t samples[n][oqmc::sobolHdMaxDepth];
+	for(int i = 0; i < n; ++i)
+	{
+		oqmc::shuffledScrambledSobolHd<oqmc::sobolHdMaxDepth>(
+		    i, oqmc::pcg::hash(0), samples[i]);
+	}
+
+	for(int j = 0; j < oqmc::sobolHdMaxDepth; ++j)
+	{
+		bool strata[n] = {};
+
+		for(int i = 0; i < n; ++i)
+		{
+			const auto stratum = samples[i][j] >> (32 - m);
+
+			ASSERT_FALSE(strata[stratum]);
+
+			strata[stratum] = true;
+		}
+	}
+}
+
+} // namespace
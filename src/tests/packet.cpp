@@ -0,0 +1,243 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Contributors to the OpenQMC Project.
+
+#include <oqmc/lattice.h>
+#include <oqmc/latticebn.h>
+#include <oqmc/latticestbn.h>
+#include <oqmc/packet.h>
+#include <oqmc/pmj.h>
+#include <oqmc/pmjbn.h>
+#include <oqmc/pmjstbn.h>
+#include <oqmc/sobol.h>
+#include <oqmc/sobolbn.h>
+#include <oqmc/sobolstbn.h>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+
+namespace
+{
+
+constexpr auto frame = 2;    // 1st prime
+constexpr auto lowValue = 5; // 3rd prime
+
+constexpr std::array<int, 8> primes{
+    3, 7, 13, 19, 29, 37, 43, 53,
+};
+
+template <typename Sampler, int Lanes>
+void checkLanes(const oqmc::PacketInterface<Sampler, Lanes>& packet,
+                const Sampler samplers[Lanes])
+{
+	std::uint32_t packetSample[4][Lanes];
+	packet.template drawSample<4>(packetSample);
+
+	std::uint32_t packetRnd[4][Lanes];
+	packet.template drawRnd<4>(packetRnd);
+
+	float packetFloat[4][Lanes];
+	packet.template drawSample<4>(packetFloat);
+
+	for(int i = 0; i < Lanes; ++i)
+	{
+		std::uint32_t sample[4];
+		samplers[i].template drawSample<4>(sample);
+
+		std::uint32_t rnd[4];
+		samplers[i].template drawRnd<4>(rnd);
+
+		float floats[4];
+		samplers[i].template drawSample<4>(floats);
+
+		for(int j = 0; j < 4; ++j)
+		{
+			EXPECT_EQ(packetSample[j][i], sample[j]);
+			EXPECT_EQ(packetRnd[j][i], rnd[j]);
+			EXPECT_EQ(packetFloat[j][i], floats[j]);
+		}
+	}
+}
+
+template <typename Sampler, int Lanes>
+void checkPacket()
+{
+	using Packet = oqmc::PacketInterface<Sampler, Lanes>;
+
+	static_assert(Packet::cacheSize == Sampler::cacheSize,
+	              "Packet cache size must match sampler.");
+
+	const auto cache = new char[Packet::cacheSize];
+	Packet::initialiseCache(cache);
+
+	int x[Lanes];
+	int y[Lanes];
+	int index[Lanes];
+
+	for(int i = 0; i < Lanes; ++i)
+	{
+		x[i] = primes[i % primes.size()] * (i + 1);
+		y[i] = primes[(i + 3) % primes.size()] * (i + 1);
+		index[i] = primes[(i + 5) % primes.size()] * (i + 1);
+	}
+
+	const auto packet = Packet(x, y, frame, index, cache);
+
+	Sampler samplers[Lanes];
+	for(int i = 0; i < Lanes; ++i)
+	{
+		samplers[i] = Sampler(x[i], y[i], frame, index[i], cache);
+	}
+
+	checkLanes<Sampler, Lanes>(packet, samplers);
+
+	for(int key = 0; key < lowValue; ++key)
+	{
+		Sampler other[Lanes];
+
+		for(int i = 0; i < Lanes; ++i)
+		{
+			other[i] = samplers[i].newDomain(key);
+		}
+
+		checkLanes<Sampler, Lanes>(packet.newDomain(key), other);
+
+		for(int i = 0; i < Lanes; ++i)
+		{
+			other[i] = samplers[i].newDomainSplit(key, lowValue, key);
+		}
+
+		checkLanes<Sampler, Lanes>(packet.newDomainSplit(key, lowValue, key),
+		                           other);
+
+		for(int i = 0; i < Lanes; ++i)
+		{
+			other[i] = samplers[i].newDomainDistrib(key, key);
+		}
+
+		checkLanes<Sampler, Lanes>(packet.newDomainDistrib(key, key), other);
+
+		for(int i = 0; i < Lanes; ++i)
+		{
+			other[i] = samplers[i].newDomainChain(key, key);
+		}
+
+		checkLanes<Sampler, Lanes>(packet.newDomainChain(key, key), other);
+	}
+
+	constexpr auto path = oqmc::domainPath<frame, lowValue>();
+
+	Sampler other[Lanes];
+	for(int i = 0; i < Lanes; ++i)
+	{
+		other[i] = samplers[i].newDomain(frame).newDomain(lowValue);
+	}
+
+	checkLanes<Sampler, Lanes>(packet.newDomainPath(path), other);
+
+	for(int i = 0; i < Lanes; ++i)
+	{
+		other[i] = samplers[i].newDomainPath(path);
+	}
+
+	checkLanes<Sampler, Lanes>(packet.newDomain(frame).newDomain(lowValue),
+	                           other);
+
+	delete[] cache;
+}
+
+TEST(PacketTest, StateLanes)
+{
+	constexpr auto lanes = 8;
+
+	oqmc::StatePacket<lanes> packet;
+	for(int i = 0; i < lanes; ++i)
+	{
+		packet.setLane(i, oqmc::State64Bit(i, i, frame, primes[i]));
+	}
+
+	for(int i = 0; i < lanes; ++i)
+	{
+		const auto state = oqmc::State64Bit(i, i, frame, primes[i]);
+		const auto lane = packet.newDomain(lowValue).getLane(i);
+
+		EXPECT_EQ(lane.patternId, state.newDomain(lowValue).patternId);
+		EXPECT_EQ(lane.sampleId, state.sampleId);
+		EXPECT_EQ(lane.pixelId, state.pixelId);
+	}
+}
+
+TEST(PacketTest, SobolLanes)
+{
+	checkPacket<oqmc::SobolSampler, 1>();
+	checkPacket<oqmc::SobolSampler, 4>();
+	checkPacket<oqmc::SobolSampler, 8>();
+	checkPacket<oqmc::SobolSampler, 13>();
+}
+
+TEST(PacketTest, SobolBnLanes)
+{
+	checkPacket<oqmc::SobolBnSampler, 1>();
+	checkPacket<oqmc::SobolBnSampler, 4>();
+	checkPacket<oqmc::SobolBnSampler, 8>();
+	checkPacket<oqmc::SobolBnSampler, 13>();
+}
+
+TEST(PacketTest, SobolStBnLanes)
+{
+	checkPacket<oqmc::SobolStBnSampler, 1>();
+	checkPacket<oqmc::SobolStBnSampler, 4>();
+	checkPacket<oqmc::SobolStBnSampler, 8>();
+	checkPacket<oqmc::SobolStBnSampler, 13>();
+}
+
+TEST(PacketTest, PmjLanes)
+{
+	checkPacket<oqmc::PmjSampler, 1>();
+	checkPacket<oqmc::PmjSampler, 4>();
+	checkPacket<oqmc::PmjSampler, 8>();
+	checkPacket<oqmc::PmjSampler, 13>();
+}
+
+TEST(PacketTest, PmjBnLanes)
+{
+	checkPacket<oqmc::PmjBnSampler, 1>();
+	checkPacket<oqmc::PmjBnSampler, 4>();
+	checkPacket<oqmc::PmjBnSampler, 8>();
+	checkPacket<oqmc::PmjBnSampler, 13>();
+}
+
+TEST(PacketTest, PmjStBnLanes)
+{
+	checkPacket<oqmc::PmjStBnSampler, 1>();
+	checkPacket<oqmc::PmjStBnSampler, 4>();
+	checkPacket<oqmc::PmjStBnSampler, 8>();
+	checkPacket<oqmc::PmjStBnSampler, 13>();
+}
+
+TEST(PacketTest, LatticeLanes)
+{
+	checkPacket<oqmc::LatticeSampler, 1>();
+	checkPacket<oqmc::LatticeSampler, 4>();
+	checkPacket<oqmc::LatticeSampler, 8>();
+	checkPacket<oqmc::LatticeSampler, 13>();
+}
+
+TEST(PacketTest, LatticeBnLanes)
+{
+	checkPacket<oqmc::LatticeBnSampler, 1>();
+	checkPacket<oqmc::LatticeBnSampler, 4>();
+	checkPacket<oqmc::LatticeBnSampler, 8>();
+	checkPacket<oqmc::LatticeBnSampler, 13>();
+}
+
+TEST(PacketTest, LatticeStBnLanes)
+{
+	checkPacket<oqmc::LatticeStBnSampler, 1>();
+	checkPacket<oqmc::LatticeStBnSampler, 4>();
+	checkPacket<oqmc::LatticeStBnSampler, 8>();
+	checkPacket<oqmc::LatticeStBnSampler, 13>();
+}
+
+} // namespace
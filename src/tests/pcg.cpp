@@ -88,6 +88,24 @@ TEST(PcgTest, StateTransitionOutputNotEqual)
 	}
 }
 
+TEST(PcgTest, AdvanceEqualStateTransition)
+{
+	for(auto seed : primes)
+	{
+		const auto init = oqmc::pcg::init(seed);
+
+		EXPECT_EQ(oqmc::pcg::advance(init, 0), init);
+
+		auto state = init;
+		for(std::uint32_t delta = 1; delta <= 1000; ++delta)
+		{
+			state = oqmc::pcg::stateTransition(state);
+
+			EXPECT_EQ(oqmc::pcg::advance(init, delta), state);
+		}
+	}
+}
+
 TEST(PcgTest, InitStateDefault)
 {
 	EXPECT_EQ(oqmc::pcg::init(), oqmc::pcg::init(0));
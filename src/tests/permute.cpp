@@ -117,6 +117,27 @@ TEST(PermuteTest, FullPermutation)
 	}
 }
 
+TEST(PermuteTest, LevelPermutation)
+{
+	for(const auto prime : primes)
+	{
+		for(int size = 1; size <= (1 << 8); size *= 2)
+		{
+			std::vector<bool> values(size, false);
+
+			for(int i = 0; i < size; ++i)
+			{
+				const auto shuffled = oqmc::levelShuffle(i, prime);
+
+				ASSERT_LT(shuffled, size);
+				ASSERT_FALSE(values[shuffled]);
+
+				values[shuffled] = true;
+			}
+		}
+	}
+}
+
 TEST(PermuteTest, ChangeSeed)
 {
 	for(const auto value : values)
@@ -1,12 +1,20 @@
 // SPDX-License-Identifier: Apache-2.0
 // Copyright Contributors to the OpenQMC Project.
 
+#include <oqmc/latticestbn.h>
+#include <oqmc/oqmc.h>
+#include <oqmc/pmjstbn.h>
 #include <oqmc/sampler.h>
+#include <oqmc/sobolstbn.h>
 #include <oqmc/unused.h>
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <array>
 #include <cstddef>
+#include <cstdint>
+#include <vector>
 
 namespace
 {
@@ -15,6 +23,9 @@ class MockImpl
 {
 	friend oqmc::SamplerInterface<MockImpl>;
 	static constexpr std::size_t cacheSize = 0;
+	static constexpr std::uint32_t cacheId = 0xafd071e5;
+	static constexpr std::uint32_t cacheVersion = 1;
+	static constexpr auto maxDrawValue = 4;
 };
 
 using MockSampler = oqmc::SamplerInterface<MockImpl>;
@@ -38,4 +49,213 @@ TEST(SamplerTest, Copyable)
 	OQMC_MAYBE_UNUSED(samplerB);
 }
 
+constexpr auto pixelX = 2; // 1st prime
+constexpr auto pixelY = 3; // 2nd prime
+constexpr auto frame = 5;  // 3rd prime
+constexpr auto range = 7;  // 4th prime
+
+// Ranges marked wide cross the 2^16 index period, and are only checked for
+// samplers with a state that supports indices beyond that limit.
+struct BatchRange
+{
+	int begin;
+	int end;
+	bool wide;
+};
+
+constexpr std::array<BatchRange, 5> batchRanges{{
+    {0, 0, false},
+    {0, 1, false},
+    {61, 67, false},   // 18th and 19th prime
+    {5, 1031, false},  // 3rd and 173rd prime
+    {(3 << 16) - 509, (3 << 16) + 521, true},
+}};
+
+template <typename Sampler, int Size, bool Wide = false>
+struct BatchCase
+{
+	using SamplerType = Sampler;
+	static constexpr auto size = Size;
+	static constexpr auto wide = Wide;
+};
+
+template <typename Case>
+class DrawSampleBatchTest : public testing::Test
+{
+};
+
+using BatchCases = testing::Types<
+    BatchCase<oqmc::LatticeSampler, 4>, BatchCase<oqmc::LatticeBnSampler, 4>,
+    BatchCase<oqmc::LatticeStBnSampler, 4>, BatchCase<oqmc::PmjSampler, 4>,
+    BatchCase<oqmc::PmjBnSampler, 4>, BatchCase<oqmc::PmjStBnSampler, 4>,
+    BatchCase<oqmc::SobolSampler, 4>, BatchCase<oqmc::SobolBnSampler, 4>,
+    BatchCase<oqmc::SobolStBnSampler, 4>, BatchCase<oqmc::SobolHdSampler, 1>,
+    BatchCase<oqmc::SobolHdSampler, 32>,
+    BatchCase<oqmc::BasicLatticeSampler<oqmc::State96Bit>, 4, true>,
+    BatchCase<oqmc::BasicSobolSampler<oqmc::State96Bit>, 4, true>>;
+
+TYPED_TEST_SUITE(DrawSampleBatchTest, BatchCases);
+
+TYPED_TEST(DrawSampleBatchTest, MatchDrawSample)
+{
+	using Sampler = typename TypeParam::SamplerType;
+	constexpr auto size = TypeParam::size;
+
+	const auto cache = new char[Sampler::cacheSize];
+	Sampler::initialiseCache(cache);
+
+	const auto base = Sampler(pixelX, pixelY, frame, 0, cache);
+	const auto domain = base.newDomain(0);
+
+	for(const auto& batchRange : batchRanges)
+	{
+		if(batchRange.wide && !TypeParam::wide)
+		{
+			continue;
+		}
+
+		const auto count = batchRange.end - batchRange.begin;
+
+		const auto integerBatch = new std::uint32_t[size * count];
+		const auto rangedBatch = new std::uint32_t[size * count];
+		const auto floatBatch = new float[size * count];
+
+		domain.template drawSampleBatch<size>(batchRange.begin, batchRange.end,
+		                                      integerBatch);
+		domain.template drawSampleBatch<size>(batchRange.begin, batchRange.end,
+		                                      range, rangedBatch);
+		domain.template drawSampleBatch<size>(batchRange.begin, batchRange.end,
+		                                      floatBatch);
+
+		for(int i = 0; i < count; ++i)
+		{
+			const auto index = batchRange.begin + i;
+			const auto other = Sampler(pixelX, pixelY, frame, index, cache);
+			const auto otherDomain = other.newDomain(0);
+
+			std::uint32_t integerSample[size];
+			otherDomain.template drawSample<size>(integerSample);
+
+			std::uint32_t rangedSample[size];
+			otherDomain.template drawSample<size>(range, rangedSample);
+
+			float floatSample[size];
+			otherDomain.template drawSample<size>(floatSample);
+
+			for(int j = 0; j < size; ++j)
+			{
+				EXPECT_EQ(integerBatch[j * count + i], integerSample[j]);
+				EXPECT_EQ(rangedBatch[j * count + i], rangedSample[j]);
+				EXPECT_EQ(floatBatch[j * count + i], floatSample[j]);
+			}
+		}
+
+		delete[] floatBatch;
+		delete[] rangedBatch;
+		delete[] integerBatch;
+	}
+
+	delete[] cache;
+}
+
+template <typename Sampler>
+class InitialiseCacheTest : public testing::Test
+{
+};
+
+using CacheSamplers =
+    testing::Types<oqmc::LatticeSampler, oqmc::LatticeBnSampler,
+                   oqmc::LatticeStBnSampler, oqmc::PmjSampler,
+                   oqmc::PmjBnSampler, oqmc::PmjStBnSampler, oqmc::SobolSampler,
+                   oqmc::SobolBnSampler, oqmc::SobolStBnSampler,
+                   oqmc::SobolHdSampler>;
+
+TYPED_TEST_SUITE(InitialiseCacheTest, CacheSamplers);
+
+TYPED_TEST(InitialiseCacheTest, LoopEqual)
+{
+	using Sampler = TypeParam;
+
+	std::vector<char> expected(Sampler::cacheSize);
+	Sampler::initialiseCache(expected.data());
+
+	// Run the ranges of each loop in reverse order, as could happen when
+	// computed concurrently.
+	std::vector<char> actual(Sampler::cacheSize);
+	Sampler::initialiseCache(actual.data(), [](int size, auto func) {
+		for(int i = size - 1; i >= 0; --i)
+		{
+			func(i);
+		}
+	});
+
+	EXPECT_EQ(actual, expected);
+}
+
+TYPED_TEST(InitialiseCacheTest, ExtendEqual)
+{
+	using Sampler = TypeParam;
+
+	std::vector<char> expected(Sampler::cacheSize);
+	Sampler::initialiseCache(expected.data());
+
+	std::vector<char> actual(Sampler::cacheSize);
+	Sampler::initialiseCache(actual.data(), 1);
+
+	for(const auto nsamples : {64, 100, 1024, 0x10000})
+	{
+		Sampler::extendCache(actual.data(), nsamples);
+	}
+
+	EXPECT_EQ(actual, expected);
+}
+
+TYPED_TEST(InitialiseCacheTest, PartialDrawEqual)
+{
+	using Sampler = TypeParam;
+
+	std::vector<char> full(Sampler::cacheSize);
+	Sampler::initialiseCache(full.data());
+
+	for(const auto nsamples : {1, 64, 1024})
+	{
+		// Allocate the partial cache with the minimum size, then extend it
+		// into a larger allocation.
+		const auto size = Sampler::partialCacheSize(nsamples);
+		ASSERT_LE(size, Sampler::cacheSize);
+
+		std::vector<char> partial(size);
+		Sampler::initialiseCache(partial.data(), nsamples);
+
+		std::vector<char> extended(Sampler::partialCacheSize(nsamples * 2));
+		std::copy(partial.begin(), partial.end(), extended.begin());
+		Sampler::extendCache(extended.data(), nsamples * 2);
+
+		for(int i = 0; i < nsamples * 2; ++i)
+		{
+			const auto expected = Sampler(3, 5, 7, i, full.data()).newDomain(11);
+			const auto actual =
+			    Sampler(3, 5, 7, i, extended.data()).newDomain(11);
+
+			std::uint32_t expectedSample[2];
+			std::uint32_t actualSample[2];
+			expected.template drawSample<2>(expectedSample);
+			actual.template drawSample<2>(actualSample);
+
+			ASSERT_EQ(actualSample[0], expectedSample[0]);
+			ASSERT_EQ(actualSample[1], expectedSample[1]);
+
+			if(i < nsamples)
+			{
+				Sampler(3, 5, 7, i, partial.data())
+				    .newDomain(11)
+				    .template drawSample<2>(actualSample);
+
+				ASSERT_EQ(actualSample[0], expectedSample[0]);
+				ASSERT_EQ(actualSample[1], expectedSample[1]);
+			}
+		}
+	}
+}
+
 } // namespace
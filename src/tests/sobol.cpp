@@ -54,4 +54,30 @@ ALL_HYPOTHESIS_TESTS(SobolTest, DrawSampleDims12, (SamplerV1<1, 2>()))
 ALL_HYPOTHESIS_TESTS(SobolTest, DrawSampleDims13, (SamplerV1<1, 3>()))
 ALL_HYPOTHESIS_TESTS(SobolTest, DrawSampleDims23, (SamplerV1<2, 3>()))
 
+TEST(SobolTest, WideNoRepeat)
+{
+	using Sampler = oqmc::BasicSobolSampler<oqmc::State96Bit>;
+
+	const auto cache = new char[Sampler::cacheSize];
+	Sampler::initialiseCache(cache);
+
+	constexpr auto period = 1 << 16;
+
+	for(int i = 0; i < 1024; ++i)
+	{
+		const auto first = Sampler(pixelX, pixelY, 0, i, cache);
+		const auto second = Sampler(pixelX, pixelY, 0, i + period, cache);
+
+		std::uint32_t a[4];
+		std::uint32_t b[4];
+		first.newDomain(0).drawSample<4>(a);
+		second.newDomain(0).drawSample<4>(b);
+
+		EXPECT_FALSE(a[0] == b[0] && a[1] == b[1] && a[2] == b[2] &&
+		             a[3] == b[3]);
+	}
+
+	delete[] cache;
+}
+
 } // namespace
@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Contributors to the OpenQMC Project.
+
+#include "hypothesis.h"
+#include <oqmc/sobol.h>
+#include <oqmc/sobolhd.h>
+
+#include <cstdint>
+
+namespace
+{
+
+constexpr auto pixelX = 2; // 1st prime
+constexpr auto pixelY = 3; // 2nd prime
+
+template <int X, int Y>
+struct SamplerV1
+{
+	SamplerV1() : seed(0)
+	{
+		cache = new char[oqmc::SobolHdSampler::cacheSize];
+		oqmc::SobolHdSampler::initialiseCache(cache);
+	}
+
+	~SamplerV1()
+	{
+		delete[] static_cast<char*>(cache);
+	}
+
+	void initialise(int seed)
+	{
+		this->seed = seed;
+	}
+
+	void sample(int index, std::uint32_t out[2]) const
+	{
+		const auto base =
+		    oqmc::SobolHdSampler(pixelX, pixelY, 0, index, cache);
+		const auto domain = base.newDomain(seed);
+
+		std::uint32_t rnd[32];
+		domain.template drawSample<32>(rnd);
+
+		out[0] = rnd[X];
+		out[1] = rnd[Y];
+	}
+
+	void* cache;
+	int seed;
+};
+
+ALL_HYPOTHESIS_TESTS(SobolHdTest, DrawSampleDims01, (SamplerV1<0, 1>()))
+ALL_HYPOTHESIS_TESTS(SobolHdTest, DrawSampleDims07, (SamplerV1<0, 7>()))
+ALL_HYPOTHESIS_TESTS(SobolHdTest, DrawSampleDims816, (SamplerV1<8, 16>()))
+ALL_HYPOTHESIS_TESTS(SobolHdTest, DrawSampleDims2331, (SamplerV1<23, 31>()))
+
+TEST(SobolHdTest, DrawSampleMatchSobol)
+{
+	const auto cache = new char[oqmc::SobolHdSampler::cacheSize];
+	oqmc::SobolHdSampler::initialiseCache(cache);
+
+	for(int i = 0; i < 1024; ++i)
+	{
+		const auto base = oqmc::SobolSampler(pixelX, pixelY, 0, i, cache);
+		const auto other = oqmc::SobolHdSampler(pixelX, pixelY, 0, i, cache);
+
+		std::uint32_t sample[4];
+		base.newDomain(i).drawSample<4>(sample);
+
+		std::uint32_t otherSample[32];
+		other.newDomain(i).drawSample<32>(otherSample);
+
+		for(int j = 0; j < 4; ++j)
+		{
+			EXPECT_EQ(otherSample[j], sample[j]);
+		}
+	}
+
+	delete[] cache;
+}
+
+} // namespace
@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Contributors to the OpenQMC Project.
+
+#include "hypothesis.h"
+#include <oqmc/sobolstbn.h>
+
+#include <cstdint>
+
+namespace
+{
+
+constexpr auto pixelX = 2; // 1st prime
+constexpr auto pixelY = 3; // 2nd prime
+constexpr auto frame = 5;  // 3rd prime
+
+template <int X, int Y>
+struct SamplerV1
+{
+	SamplerV1() : seed(0)
+	{
+		cache = new char[oqmc::SobolStBnSampler::cacheSize];
+		oqmc::SobolStBnSampler::initialiseCache(cache);
+	}
+
+	~SamplerV1()
+	{
+		delete[] static_cast<char*>(cache);
+	}
+
+	void initialise(int seed)
+	{
+		this->seed = seed;
+	}
+
+	void sample(int index, std::uint32_t out[2]) const
+	{
+		const auto base =
+		    oqmc::SobolStBnSampler(pixelX, pixelY, frame, index, cache);
+		const auto domain = base.newDomain(seed);
+
+		std::uint32_t rnd[4];
+		domain.template drawSample<4>(rnd);
+
+		out[0] = rnd[X];
+		out[1] = rnd[Y];
+	}
+
+	void* cache;
+	int seed;
+};
+
+ALL_HYPOTHESIS_TESTS(SobolStBnTest, DrawSampleDims01, (SamplerV1<0, 1>()))
+ALL_HYPOTHESIS_TESTS(SobolStBnTest, DrawSampleDims02, (SamplerV1<0, 2>()))
+ALL_HYPOTHESIS_TESTS(SobolStBnTest, DrawSampleDims03, (SamplerV1<0, 3>()))
+ALL_HYPOTHESIS_TESTS(SobolStBnTest, DrawSampleDims12, (SamplerV1<1, 2>()))
+ALL_HYPOTHESIS_TESTS(SobolStBnTest, DrawSampleDims13, (SamplerV1<1, 3>()))
+ALL_HYPOTHESIS_TESTS(SobolStBnTest, DrawSampleDims23, (SamplerV1<2, 3>()))
+
+TEST(SobolStBnTest, SpatialTiling)
+{
+	constexpr auto period = 1 << oqmc::bntables::temporal::xBits;
+	constexpr auto tileX = pixelX + period;
+	constexpr auto tileY = pixelY + period;
+
+	const auto cache = new char[oqmc::SobolStBnSampler::cacheSize];
+	oqmc::SobolStBnSampler::initialiseCache(cache);
+
+	for(int i = 0; i < 16; ++i)
+	{
+		const auto a = oqmc::SobolStBnSampler(pixelX, pixelY, frame, i, cache);
+		const auto b = oqmc::SobolStBnSampler(tileX, tileY, frame, i, cache);
+
+		std::uint32_t sampleA[4];
+		a.newDomain(0).drawSample<4>(sampleA);
+
+		std::uint32_t sampleB[4];
+		b.newDomain(0).drawSample<4>(sampleB);
+
+		for(int j = 0; j < 4; ++j)
+		{
+			EXPECT_EQ(sampleA[j], sampleB[j]);
+		}
+	}
+
+	delete[] cache;
+}
+
+} // namespace
@@ -2,6 +2,7 @@
 // Copyright Contributors to the OpenQMC Project.
 
 #include "hypothesis.h"
+#include <oqmc/pcg.h>
 #include <oqmc/state.h>
 
 #include <gtest/gtest.h>
@@ -210,6 +211,101 @@ TEST(StateTest, ComputeIndexId)
 	EXPECT_EQ(oqmc::computeIndexId(index), 5678);
 }
 
+TEST(StateTest, WideIndex)
+{
+	constexpr auto wideIndex = 1234 << 16 | 5678;
+
+	const auto narrow = oqmc::State64Bit(pixelX, pixelY, frame, wideIndex);
+	const auto wide = oqmc::State96Bit(pixelX, pixelY, frame, wideIndex);
+
+	EXPECT_EQ(narrow.sampleId, 5678);
+	EXPECT_EQ(wide.sampleId, wideIndex);
+	EXPECT_EQ(wide.pixelId, narrow.pixelId);
+
+	for(int i = 1; i < lowValue; ++i)
+	{
+		const auto other = oqmc::State96Bit(pixelX, pixelY, frame, i << 16);
+
+		EXPECT_EQ(other.patternId, wide.patternId);
+		EXPECT_EQ(other.sampleId, i << 16);
+	}
+}
+
+TEST(StateTest, WideNextDomainIndex)
+{
+	const oqmc::State96Bit wideState(pixelX, pixelY, frame, highValue << 16);
+
+	for(const auto prime : primes)
+	{
+		const auto distr = wideState.newDomainDistrib(prime, 0);
+		const auto split = wideState.newDomainSplit(prime, lowValue, 0);
+
+		EXPECT_EQ(split.sampleId, wideState.sampleId * lowValue);
+
+		for(int i = 0; i < lowValue; ++i)
+		{
+			const auto next = wideState.newDomainDistrib(prime, i);
+			EXPECT_EQ(next.sampleId, distr.sampleId + i);
+		}
+
+		for(int i = 0; i < lowValue; ++i)
+		{
+			const auto next = wideState.newDomainSplit(prime, lowValue, i);
+			EXPECT_EQ(next.sampleId, split.sampleId + i);
+		}
+	}
+}
+
+TEST(StateTest, WideSplitOverflow)
+{
+	const oqmc::State96Bit wideState(pixelX, pixelY, frame, INT32_MAX);
+
+	const auto fitSplit = wideState.newDomainSplit(0, 2, 1);
+	const auto fitDomain = wideState.newDomain(0).newDomain(0);
+
+	EXPECT_EQ(fitSplit.sampleId, UINT32_MAX);
+	EXPECT_EQ(fitSplit.patternId, fitDomain.patternId);
+
+	const auto overflowSplit = wideState.newDomainSplit(0, 4, 0);
+	const auto overflowDomain = wideState.newDomain(0).newDomain(1);
+
+	EXPECT_EQ(overflowSplit.sampleId, UINT32_MAX - 3);
+	EXPECT_EQ(overflowSplit.patternId, overflowDomain.patternId);
+}
+
+TEST(StateTest, DomainPath)
+{
+	constexpr auto single = oqmc::domainPath<lowValue>();
+	constexpr auto path = oqmc::domainPath<frame, index, pixelX, pixelY>();
+
+	static_assert(single.transition(0) == oqmc::pcg::stateTransition(lowValue),
+	              "Path must fold at compile time.");
+
+	const oqmc::State96Bit wideState(pixelX, pixelY, frame, highValue << 16);
+
+	for(const auto prime : primes)
+	{
+		const auto state = defaultState.newDomain(prime);
+		const auto wide = wideState.newDomain(prime);
+
+		const auto chain = state.newDomain(frame)
+		                       .newDomain(index)
+		                       .newDomain(pixelX)
+		                       .newDomain(pixelY);
+		const auto wideChain = wide.newDomain(frame)
+		                           .newDomain(index)
+		                           .newDomain(pixelX)
+		                           .newDomain(pixelY);
+
+		EXPECT_EQ(state.newDomainPath(single).patternId,
+		          state.newDomain(lowValue).patternId);
+		EXPECT_EQ(state.newDomainPath(path).patternId, chain.patternId);
+		EXPECT_EQ(state.newDomainPath(path).sampleId, state.sampleId);
+		EXPECT_EQ(wide.newDomainPath(path).patternId, wideChain.patternId);
+		EXPECT_EQ(wide.newDomainPath(path).sampleId, wide.sampleId);
+	}
+}
+
 template <int X, int Y>
 struct SamplerV1
 {
@@ -1,2 +1,178 @@
 // SPDX-License-Identifier: Apache-2.0
 // Copyright Contributors to the OpenQMC Project.
+
+#include <oqmc/stochastic.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+
+constexpr auto nsamples = 0x10000;
+
+using Point = std::uint32_t[2];
+
+std::vector<std::uint32_t> sequence(int size)
+{
+	std::vector<std::uint32_t> ret(size * 2);
+	oqmc::stochasticPmjSequence(0, size, reinterpret_cast<Point*>(ret.data()));
+
+	return ret;
+}
+
+TEST(StochasticTest, SequenceRangesEqual)
+{
+	const auto expected = sequence(nsamples);
+
+	// Compute each level in reverse order of ranges, as could happen when
+	// computed concurrently.
+	std::vector<std::uint32_t> actual(nsamples * 2);
+	const auto points = reinterpret_cast<Point*>(actual.data());
+
+	oqmc::stochasticPmjSequence(0, 1, points);
+
+	for(int level = 1; level < nsamples; level *= 2)
+	{
+		const auto step = level < 7 ? 1 : 7;
+
+		for(int end = level * 2; end > level; end -= step)
+		{
+			const auto begin = end - step > level ? end - step : level;
+			oqmc::stochasticPmjSequence(begin, end, points);
+		}
+	}
+
+	EXPECT_EQ(actual, expected);
+}
+
+TEST(StochasticTest, SequenceExtendEqual)
+{
+	const auto expected = sequence(nsamples);
+
+	std::vector<std::uint32_t> actual(nsamples * 2);
+	const auto points = reinterpret_cast<Point*>(actual.data());
+
+	oqmc::stochasticPmjSequence(0, 64, points);
+	oqmc::stochasticPmjSequence(64, 1024, points);
+	oqmc::stochasticPmjSequence(1024, nsamples, points);
+
+	EXPECT_EQ(actual, expected);
+}
+
+TEST(StochasticTest, SequenceStratified)
+{
+	const auto points = sequence(1024);
+
+	// Each power of two prefix must form a (0,m,2)-net, with a single point in
+	// each elementary interval.
+	for(int logN = 0; logN <= 10; ++logN)
+	{
+		const auto size = 1 << logN;
+
+		for(int xBits = 0; xBits <= logN; ++xBits)
+		{
+			const auto yBits = logN - xBits;
+
+			std::vector<int> counts(size);
+			for(int i = 0; i < size; ++i)
+			{
+				const auto x = xBits ? points[i * 2 + 0] >> (32 - xBits) : 0;
+				const auto y = yBits ? points[i * 2 + 1] >> (32 - yBits) : 0;
+
+				++counts[(x << yBits) | y];
+			}
+
+			for(const auto count : counts)
+			{
+				EXPECT_EQ(count, 1);
+			}
+		}
+	}
+}
+
+TEST(StochasticTest, InitEqualScramble)
+{
+	const auto points = sequence(nsamples);
+
+	std::vector<std::uint32_t> expected(nsamples * 4);
+	oqmc::stochasticPmjScramble(
+	    0, nsamples, reinterpret_cast<const Point*>(points.data()),
+	    reinterpret_cast<std::uint32_t(*)[4]>(expected.data()));
+
+	std::vector<std::uint32_t> actual(nsamples * 4);
+	oqmc::stochasticPmjInit(
+	    nsamples, reinterpret_cast<std::uint32_t(*)[4]>(actual.data()));
+
+	EXPECT_EQ(actual, expected);
+}
+
+TEST(StochasticTest, InitLoopEqual)
+{
+	std::vector<std::uint32_t> expected(nsamples * 4);
+	oqmc::stochasticPmjInit(
+	    nsamples, reinterpret_cast<std::uint32_t(*)[4]>(expected.data()));
+
+	// Run the ranges of each loop in reverse order, as could happen when
+	// computed concurrently.
+	std::vector<std::uint32_t> actual(nsamples * 4);
+	oqmc::stochasticPmjInit(
+	    nsamples, reinterpret_cast<std::uint32_t(*)[4]>(actual.data()),
+	    [](int size, auto func) {
+		    for(int i = size - 1; i >= 0; --i)
+		    {
+			    func(i);
+		    }
+	    });
+
+	EXPECT_EQ(actual, expected);
+}
+
+TEST(StochasticTest, LevelScrambleWithinLevel)
+{
+	const auto points = sequence(nsamples);
+
+	std::vector<std::uint32_t> expected(nsamples * 4);
+	oqmc::stochasticPmjLevelScramble(
+	    0, nsamples, reinterpret_cast<const Point*>(points.data()),
+	    reinterpret_cast<std::uint32_t(*)[4]>(expected.data()));
+
+	// Each level of the table only reads the same level of the sequence, so a
+	// shorter sequence gives the same first levels of the table.
+	for(int size = 1; size < nsamples; size *= 4)
+	{
+		const auto partial = sequence(size);
+
+		std::vector<std::uint32_t> actual(size * 4);
+		oqmc::stochasticPmjLevelScramble(
+		    0, size, reinterpret_cast<const Point*>(partial.data()),
+		    reinterpret_cast<std::uint32_t(*)[4]>(actual.data()));
+
+		EXPECT_TRUE(std::equal(actual.begin(), actual.end(), expected.begin()));
+	}
+}
+
+TEST(StochasticTest, LevelExtendEqual)
+{
+	std::vector<std::uint32_t> expected(nsamples * 4);
+	oqmc::stochasticPmjLevelExtend(
+	    0, nsamples, reinterpret_cast<std::uint32_t(*)[4]>(expected.data()));
+
+	// Extend in steps that end both on and within levels.
+	std::vector<std::uint32_t> actual(nsamples * 4);
+	const auto table = reinterpret_cast<std::uint32_t(*)[4]>(actual.data());
+
+	auto begin = 0;
+	for(const auto end : {1, 3, 64, 100, 1024, nsamples})
+	{
+		oqmc::stochasticPmjLevelExtend(begin, end, table);
+		begin = end;
+	}
+
+	EXPECT_EQ(actual, expected);
+}
+
+} // namespace
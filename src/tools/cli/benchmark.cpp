@@ -1,22 +1,229 @@
 // SPDX-License-Identifier: Apache-2.0
 // Copyright Contributors to the OpenQMC Project.
 
+#include "json.h"
+#include "stats.h"
+
 #include <benchmark.h>
 
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
 
-int main(int argc, char* argv[])
+namespace
 {
-	if(argc == 1)
+
+// Names of the hardware counters in the order given by oqmc_benchmark_trials.
+constexpr const char* counterNames[] = {
+    "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses",
+};
+
+constexpr auto numCounters = sizeof(counterNames) / sizeof(*counterNames);
+
+// Path depth in bounces of the render measurements, which is passed in place of
+// the number of dimensions.
+constexpr auto ndepth = 16;
+
+bool isRender(const std::string& measurement)
+{
+	return measurement == "tile" || measurement == "random" ||
+	       measurement == "cold";
+}
+
+// Cache measurements time a single operation, rather than drawing samples, so
+// they have no cost per sample and ignore the draw size and derivation method.
+bool isSampling(const std::string& measurement)
+{
+	return measurement != "init" && measurement != "load";
+}
+
+bool usesSize(const std::string& measurement)
+{
+	return isSampling(measurement) && measurement != "derive" &&
+	       measurement != "enumerate";
+}
+
+bool usesDerivation(const std::string& measurement)
+{
+	return isSampling(measurement) && measurement != "enumerate";
+}
+
+// The size and derivation are empty when the measurement ignores them.
+struct Result
+{
+	std::string sampler;
+	std::string measurement;
+	std::string size;
+	std::string derivation;
+	stats::Summary summary;
+	double counters[numCounters];
+	const json::Record* baseline;
+	bool regression;
+};
+
+// Split a comma separated list of options. The value 'all' is replaced with
+// the full list of options.
+std::vector<std::string> split(const char* list,
+                               const std::vector<std::string>& all)
+{
+	if(std::strcmp(list, "all") == 0)
 	{
-		std::fprintf(stderr,
-		             "No arguments passed; "
-		             "user must specify a sampler and a measurement.\n");
+		return all;
+	}
 
-		return EXIT_FAILURE;
+	std::vector<std::string> ret;
+	std::string item;
+
+	for(auto c = list;; ++c)
+	{
+		if(*c != ',' && *c != '\0')
+		{
+			item += *c;
+			continue;
+		}
+
+		if(!item.empty())
+		{
+			ret.push_back(item);
+			item.clear();
+		}
+
+		if(*c == '\0')
+		{
+			break;
+		}
 	}
 
+	return ret;
+}
+
+const json::Record* find(const std::vector<json::Record>& records,
+                         const Result& result)
+{
+	for(const auto& record : records)
+	{
+		// An empty value matches any value in the baseline, as older baselines
+		// repeat the same measurement for each size and derivation.
+		const auto match = [&record](const char* key, const std::string& val) {
+			const auto it = record.find(key);
+			return it != record.end() && (val.empty() || it->second == val);
+		};
+
+		if(match("sampler", result.sampler) &&
+		   match("measurement", result.measurement) &&
+		   match("size", result.size) &&
+		   match("derivation", result.derivation) &&
+		   record.count("median") && record.count("mad"))
+		{
+			return &record;
+		}
+	}
+
+	return nullptr;
+}
+
+void print(int nsamples, int ndims, int nthreads, int nwarmups, int ntrials,
+           const std::vector<Result>& results)
+{
+	std::printf("{\n");
+	std::printf("\t\"nsamples\": %i,\n", nsamples);
+	std::printf("\t\"ndims\": %i,\n", ndims);
+	std::printf("\t\"ndepth\": %i,\n", ndepth);
+	std::printf("\t\"nthreads\": %i,\n", nthreads);
+	std::printf("\t\"nwarmups\": %i,\n", nwarmups);
+	std::printf("\t\"ntrials\": %i,\n", ntrials);
+	std::printf("\t\"results\": [\n");
+
+	for(std::size_t i = 0; i < results.size(); ++i)
+	{
+		const auto& result = results[i];
+		const auto& summary = result.summary;
+
+		std::printf("\t\t{\n");
+		std::printf("\t\t\t\"sampler\": \"%s\",\n", result.sampler.c_str());
+		std::printf("\t\t\t\"measurement\": \"%s\",\n",
+		            result.measurement.c_str());
+		if(result.size.empty())
+		{
+			std::printf("\t\t\t\"size\": null,\n");
+		}
+		else
+		{
+			std::printf("\t\t\t\"size\": %s,\n", result.size.c_str());
+		}
+
+		if(result.derivation.empty())
+		{
+			std::printf("\t\t\t\"derivation\": null,\n");
+		}
+		else
+		{
+			std::printf("\t\t\t\"derivation\": \"%s\",\n",
+			            result.derivation.c_str());
+		}
+
+		std::printf("\t\t\t\"min\": %.1f,\n", summary.min);
+		std::printf("\t\t\t\"p5\": %.1f,\n", summary.p5);
+		std::printf("\t\t\t\"p25\": %.1f,\n", summary.p25);
+		std::printf("\t\t\t\"median\": %.1f,\n", summary.median);
+		std::printf("\t\t\t\"p75\": %.1f,\n", summary.p75);
+		std::printf("\t\t\t\"p95\": %.1f,\n", summary.p95);
+		std::printf("\t\t\t\"max\": %.1f,\n", summary.max);
+		std::printf("\t\t\t\"mad\": %.1f,\n", summary.mad);
+
+		if(result.baseline)
+		{
+			const auto base = std::atof(result.baseline->at("median").c_str());
+			const auto change = base > 0 ? summary.median / base - 1 : 0;
+
+			std::printf("\t\t\t\"baseline\": %.1f,\n", base);
+			std::printf("\t\t\t\"change\": %.4f,\n", change);
+			std::printf("\t\t\t\"regression\": %s,\n",
+			            result.regression ? "true" : "false");
+		}
+
+		// Counters that are unavailable, such as in a container, are null. So
+		// are all costs per sample of measurements that draw no samples.
+		const auto sampling = isSampling(result.measurement);
+
+		for(std::size_t j = 0; j < numCounters; ++j)
+		{
+			const auto value = result.counters[j];
+
+			if(!sampling || std::isnan(value))
+			{
+				std::printf("\t\t\t\"%s_per_sample\": null,\n",
+				            counterNames[j]);
+			}
+			else
+			{
+				std::printf("\t\t\t\"%s_per_sample\": %.3f,\n",
+				            counterNames[j], value);
+			}
+		}
+
+		if(sampling)
+		{
+			std::printf("\t\t\t\"ns_per_sample\": %.3f\n",
+			            summary.median / nsamples);
+		}
+		else
+		{
+			std::printf("\t\t\t\"ns_per_sample\": null\n");
+		}
+
+		std::printf("\t\t}%s\n", i + 1 < results.size() ? "," : "");
+	}
+
+	std::printf("\t]\n");
+	std::printf("}\n");
+}
+
+int single(int argc, char* argv[])
+{
 	if(argc < 3)
 	{
 		std::fprintf(stderr,
@@ -26,30 +233,239 @@ int main(int argc, char* argv[])
 		return EXIT_FAILURE;
 	}
 
-	if(argc > 3)
+	if(argc > 4)
 	{
-		std::fprintf(stderr,
-		             "Too many arguments passed; "
-		             "user must specify a sampler and a measurement.\n");
+		std::fprintf(stderr, "Too many arguments passed; "
+		                     "user must specify a sampler, a measurement and "
+		                     "a thread count.\n");
 
 		return EXIT_FAILURE;
 	}
 
 	constexpr auto nsamples = 1 << 15; // 32k
-	constexpr auto ndims = 256;
+	const auto ndims = isRender(argv[2]) ? ndepth : 256;
+
+	// Without a thread count, measure once using all available threads.
+	// Otherwise measure for each count from one thread up to the given count.
+	auto nthreads = 0;
+
+	if(argc == 4)
+	{
+		nthreads = std::atoi(argv[3]);
+
+		if(nthreads < 1)
+		{
+			std::fprintf(stderr, "Thread count that was requested is invalid; "
+			                     "count must be a positive integer.\n");
+
+			return EXIT_FAILURE;
+		}
+	}
+
+	const auto first = nthreads > 0 ? 1 : 0;
 
 	int time;
-	if(!oqmc_benchmark(argv[1], argv[2], nsamples, ndims, &time))
+	if(!oqmc_benchmark(argv[1], argv[2], nsamples, ndims, first, &time))
 	{
 		std::fprintf(stderr, "Configuration that was requested was not found; "
-		                     "sampler options are pmj, pmjbn, sobol, sobolbn, "
-		                     "lattice, latticebn; "
-		                     "measurement options are init, samples.\n");
+		                     "sampler options are pmj, pmjbn, pmjstbn, sobol, "
+		                     "sobolbn, sobolstbn, sobolhd, lattice, latticebn, "
+		                     "latticestbn; "
+		                     "measurement options are init, load, samples, "
+		                     "batch, derive, tile, random, cold, "
+		                     "enumerate (sobol only).\n");
 
 		return EXIT_FAILURE;
 	}
 
-	std::printf("%i\n", time);
+	if(nthreads == 0)
+	{
+		std::printf("%i\n", time);
+
+		return EXIT_SUCCESS;
+	}
+
+	// Print the thread count, time in microseconds and samples per second. The
+	// cache measurements draw no samples, so only print their time.
+	const auto sampling = isSampling(argv[2]);
+
+	for(int i = 1; i <= nthreads; ++i)
+	{
+		if(i > 1)
+		{
+			oqmc_benchmark(argv[1], argv[2], nsamples, ndims, i, &time);
+		}
+
+		if(!sampling)
+		{
+			std::printf("%i,%i\n", i, time);
+
+			continue;
+		}
+
+		const auto seconds = (time > 0 ? time : 1) * 1e-6;
+
+		std::printf("%i,%i,%.0f\n", i, time, nsamples / seconds);
+	}
+
+	return EXIT_SUCCESS;
+}
+
+int suite(int argc, char* argv[])
+{
+	if(argc < 6)
+	{
+		std::fprintf(stderr, "Too few arguments passed; "
+		                     "user must specify samplers, measurements, sizes "
+		                     "and derivations.\n");
+
+		return EXIT_FAILURE;
+	}
+
+	if(argc > 8)
+	{
+		std::fprintf(stderr, "Too many arguments passed; "
+		                     "user must specify samplers, measurements, sizes, "
+		                     "derivations, a baseline and a threshold.\n");
+
+		return EXIT_FAILURE;
+	}
+
+	// Fewer samples than a single measurement, as each configuration is
+	// repeated. A single thread gives the most stable per sample cost.
+	constexpr auto nsamples = 1 << 14; // 16k
+	constexpr auto ndims = 64;
+	constexpr auto nthreads = 1;
+	constexpr auto nwarmups = 3;
+	constexpr auto ntrials = 21;
+
+	const auto samplers = split(argv[2], {"pmj", "pmjbn", "pmjstbn", "sobol",
+	                                      "sobolbn", "sobolstbn", "sobolhd",
+	                                      "lattice", "latticebn",
+	                                      "latticestbn"});
+	const auto measurements =
+	    split(argv[3], {"init", "load", "samples", "batch", "derive", "tile",
+	                    "random", "cold"});
+	const auto sizes = split(argv[4], {"1", "2", "4", "0"});
+	const auto derivations =
+	    split(argv[5], {"domain", "split", "distrib", "chain", "path"});
+
+	std::vector<json::Record> baseline;
+
+	if(argc > 6 && !json::read(argv[6], baseline))
+	{
+		std::fprintf(stderr, "Baseline file could not be read.\n");
+
+		return EXIT_FAILURE;
+	}
+
+	const auto threshold = argc > 7 ? std::atof(argv[7]) : 0.05;
+
+	std::vector<Result> results;
+	auto regressions = 0;
+
+	// Measurements that ignore the size or derivation run once, with a single
+	// empty value in place of the list.
+	const std::vector<std::string> unused = {""};
+
+	for(const auto& sampler : samplers)
+	{
+		for(const auto& measurement : measurements)
+		{
+			const auto& measurementSizes =
+			    usesSize(measurement) ? sizes : unused;
+			const auto& measurementDerivations =
+			    usesDerivation(measurement) ? derivations : unused;
+
+			for(const auto& size : measurementSizes)
+			{
+				for(const auto& derivation : measurementDerivations)
+				{
+					std::vector<double> times(ntrials);
+					Result result;
+
+					const auto depth =
+					    isRender(measurement) ? ndepth : ndims;
+
+					if(!oqmc_benchmark_trials(
+					       sampler.c_str(), measurement.c_str(),
+					       std::atoi(size.c_str()),
+					       derivation.empty() ? "domain" : derivation.c_str(),
+					       nsamples, depth, nthreads, nwarmups, ntrials,
+					       times.data(), result.counters))
+					{
+						std::fprintf(
+						    stderr,
+						    "Configuration that was requested was not found; "
+						    "sampler options are pmj, pmjbn, pmjstbn, sobol, "
+						    "sobolbn, sobolstbn, sobolhd, lattice, latticebn, "
+						    "latticestbn; "
+						    "measurement options are init, load, samples, "
+						    "batch, derive, tile, random, cold, enumerate "
+						    "(sobol only); "
+						    "size options are 1, 2, 4, 0 (maximum); "
+						    "derivation options are domain, split, distrib, "
+						    "chain, path.\n");
+
+						return EXIT_FAILURE;
+					}
+
+					result.sampler = sampler;
+					result.measurement = measurement;
+					result.size = size;
+					result.derivation = derivation;
+					result.summary = stats::summarise(times);
+					result.baseline = find(baseline, result);
+					result.regression = false;
+
+					if(result.baseline)
+					{
+						const auto& record = *result.baseline;
+
+						result.regression = stats::regression(
+						    result.summary.median, result.summary.mad,
+						    std::atof(record.at("median").c_str()),
+						    std::atof(record.at("mad").c_str()), threshold);
+					}
+
+					regressions += result.regression;
+					results.push_back(result);
+				}
+			}
+		}
+	}
+
+	print(nsamples, ndims, nthreads, nwarmups, ntrials, results);
+
+	if(regressions > 0)
+	{
+		std::fprintf(stderr, "Performance regressed for %i of %i "
+		                     "configurations.\n",
+		             regressions, static_cast<int>(results.size()));
+
+		return EXIT_FAILURE;
+	}
 
 	return EXIT_SUCCESS;
 }
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+	if(argc == 1)
+	{
+		std::fprintf(stderr,
+		             "No arguments passed; "
+		             "user must specify a sampler and a measurement.\n");
+
+		return EXIT_FAILURE;
+	}
+
+	if(std::strcmp(argv[1], "suite") == 0)
+	{
+		return suite(argc, argv);
+	}
+
+	return single(argc, argv);
+}
@@ -0,0 +1,38 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Contributors to the OpenQMC Project.
+
+#include <cache.h>
+
+#include <cstdio>
+#include <cstdlib>
+
+int main(int argc, char* argv[])
+{
+	if(argc < 3)
+	{
+		std::fprintf(stderr, "Not enough arguments passed; "
+		                     "user must specify a sampler and a path.\n");
+
+		return EXIT_FAILURE;
+	}
+
+	if(argc > 3)
+	{
+		std::fprintf(stderr, "Too many arguments passed; "
+		                     "user must specify a sampler and a path.\n");
+
+		return EXIT_FAILURE;
+	}
+
+	if(!oqmc_cache(argv[1], argv[2]))
+	{
+		std::fprintf(stderr, "Cache file could not be written; "
+		                     "sampler options are pmj, pmjbn, pmjstbn, sobol, "
+		                     "sobolbn, sobolstbn, sobolhd, lattice, latticebn, "
+		                     "latticestbn; path must be writable.\n");
+
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -18,6 +18,45 @@ void stop(const float* out)
 	delete[] out;
 }
 
+// Stream a large point set to a file, one chunk at a time.
+int file(int argc, char* argv[])
+{
+	if(argc < 7)
+	{
+		std::fprintf(stderr, "Too few arguments passed; "
+		                     "user must specify a sampler, sequence count, "
+		                     "sample count, dimension count, layout and "
+		                     "path.\n");
+
+		return EXIT_FAILURE;
+	}
+
+	const auto nsequences = std::atoi(argv[2]);
+	const auto nsamples = std::atoi(argv[3]);
+	const auto ndims = std::atoi(argv[4]);
+
+	if(nsequences < 1 || nsamples < 1 || ndims < 1)
+	{
+		std::fprintf(stderr, "Count that was requested is invalid; "
+		                     "counts must be positive integers.\n");
+
+		return EXIT_FAILURE;
+	}
+
+	if(!oqmc_generate_file(argv[1], nsequences, nsamples, ndims, argv[5],
+	                       argv[6]))
+	{
+		std::fprintf(stderr, "File could not be generated; "
+		                     "sampler options are pmj, sobol, lattice; "
+		                     "layout options are aos, soa; "
+		                     "path must be writable.\n");
+
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
 int main(int argc, char* argv[])
 {
 	if(argc == 1)
@@ -28,14 +67,20 @@ int main(int argc, char* argv[])
 		return EXIT_FAILURE;
 	}
 
-	if(argc > 2)
+	if(argc > 7)
 	{
 		std::fprintf(stderr, "Too many arguments passed; "
-		                     "user must specify a single sampler.\n");
+		                     "user must specify a sampler, and optionally "
+		                     "counts, a layout and a path.\n");
 
 		return EXIT_FAILURE;
 	}
 
+	if(argc > 2)
+	{
+		return file(argc, argv);
+	}
+
 	constexpr auto nsequences = 2;
 	constexpr auto nsamples = 256;
 	constexpr auto ndims = 8;
@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Contributors to the OpenQMC Project.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace json
+{
+
+// Flat object of key value pairs. Values are stored as text, with the quotes
+// removed from strings.
+using Record = std::map<std::string, std::string>;
+
+inline Record parseRecord(const std::string& text)
+{
+	Record ret;
+
+	auto i = text.find('"');
+	while(i != std::string::npos)
+	{
+		const auto keyEnd = text.find('"', i + 1);
+		const auto colon = text.find(':', keyEnd);
+
+		if(keyEnd == std::string::npos || colon == std::string::npos)
+		{
+			break;
+		}
+
+		const auto key = text.substr(i + 1, keyEnd - i - 1);
+
+		auto begin = text.find_first_not_of(" \t\r\n", colon + 1);
+		auto end = begin;
+
+		if(begin == std::string::npos)
+		{
+			break;
+		}
+
+		if(text[begin] == '"')
+		{
+			++begin;
+			end = text.find('"', begin);
+			ret[key] = text.substr(begin, end - begin);
+			end = end == std::string::npos ? end : end + 1;
+		}
+		else
+		{
+			end = text.find_first_of(", \t\r\n", begin);
+			ret[key] = text.substr(begin, end - begin);
+		}
+
+		i = end == std::string::npos ? end : text.find('"', end);
+	}
+
+	return ret;
+}
+
+// Read all innermost objects from a file as flat records. This is not a general
+// JSON parser, it only supports files written by the tools, where records are
+// objects with string and number values that do not contain escape sequences.
+inline bool read(const char* name, std::vector<Record>& records)
+{
+	auto file = std::fopen(name, "r");
+
+	if(file == nullptr)
+	{
+		return false;
+	}
+
+	std::string text;
+
+	char buffer[4096];
+	std::size_t size;
+	while((size = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+	{
+		text.append(buffer, size);
+	}
+
+	std::fclose(file);
+
+	auto begin = text.find('{');
+	while(begin != std::string::npos)
+	{
+		const auto end = text.find_first_of("{}", begin + 1);
+
+		if(end == std::string::npos)
+		{
+			break;
+		}
+
+		if(text[end] == '}')
+		{
+			const auto inner = text.substr(begin + 1, end - begin - 1);
+			records.push_back(parseRecord(inner));
+		}
+
+		begin = text.find('{', text[end] == '{' ? end : end + 1);
+	}
+
+	return true;
+}
+
+} // namespace json
@@ -3,7 +3,9 @@
 
 // This file is used to compile a cli tool that will transform and print a
 // subset of the matrices below into an optimal format for the main library.
-// Resulting output is inlined into a header file include/oqmc/owen.h.
+// Resulting output is inlined into the header files include/oqmc/owen.h (using
+// the binary layout at 16 and 32 bits of precision) and include/oqmc/owenhd.h
+// (using the packed layout).
 //
 // Matrices in the source code below were copied from the source code provided
 // by Leonhard Gruenschloss at https://github.com/lgruen/sobol. These were in
@@ -36,6 +38,8 @@
 #include <cassert>
 #include <cstdint>
 #include <cstdio>
+#include <cstdlib>
+#include <string>
 
 constexpr auto numDimensions = 1024;
 constexpr auto size = 52;
@@ -13379,13 +13383,105 @@ void printMatrices(int dimensionSize, int indexSize)
 	}
 }
 
-int main()
+template <int SamplePrecision>
+void printPackedMatrices(int dimensionSize, int indexSize)
+{
+	static_assert(SamplePrecision >= 0, "Sample precision must be positive.");
+	static_assert(SamplePrecision <= 32, "Sample precision at most 32 bits.");
+
+	assert(dimensionSize >= 0);
+	assert(dimensionSize <= numDimensions);
+	assert(indexSize >= 0);
+
+	constexpr auto valuesPerLine = 8;
+	constexpr auto hexDigits = (SamplePrecision + 3) / 4;
+	constexpr auto mask = SamplePrecision < 32
+	                          ? (std::uint64_t(1) << SamplePrecision) - 1
+	                          : std::uint64_t(UINT32_MAX);
+
+	// Columns are grouped by index bit, so that the matrix columns for all
+	// dimensions of a given bit are contiguous. This allows a SIMD matrix
+	// multiply across dimensions, instead of across bits.
+	for(int j = 0; j < indexSize; ++j)
+	{
+		auto indexRev = indexSize - (j + 1);
+
+		std::printf("{\n");
+
+		for(int i = 0; i < dimensionSize; ++i)
+		{
+			auto valueRev = oqmc::reverseBits32(matrices[i][indexRev]);
+			valueRev &= mask;
+
+			const auto last = (i + 1) % valuesPerLine == 0;
+			const auto end = last || i + 1 == dimensionSize;
+
+			std::printf("0x%0*x,%s", hexDigits, valueRev, end ? "\n" : " ");
+		}
+
+		std::printf("},\n");
+	}
+}
+
+template <int SamplePrecision>
+int printLayout(const std::string& layout, int dimensionSize)
+{
+	constexpr auto indexSize = SamplePrecision;
+
+	if(layout == "binary")
+	{
+		printMatrices<SamplePrecision>(dimensionSize, indexSize);
+
+		return EXIT_SUCCESS;
+	}
+
+	if(layout == "packed")
+	{
+		printPackedMatrices<SamplePrecision>(dimensionSize, indexSize);
+
+		return EXIT_SUCCESS;
+	}
+
+	std::fprintf(stderr, "Layout that was requested was not found; "
+	                     "options are binary, packed.\n");
+
+	return EXIT_FAILURE;
+}
+
+int main(int argc, char* argv[])
 {
-	constexpr auto samplePrecision = 16;
-	constexpr auto dimensionSize = 4;
-	constexpr auto indexSize = 16;
+	if(argc > 4)
+	{
+		std::fprintf(stderr, "Too many arguments passed; user may specify a "
+		                     "layout, dimension size and precision.\n");
+
+		return EXIT_FAILURE;
+	}
+
+	const auto layout = argc > 1 ? std::string(argv[1]) : "binary";
+	const auto dimensionSize = argc > 2 ? std::atoi(argv[2]) : 4;
+	const auto precision = argc > 3 ? std::atoi(argv[3]) : 16;
+
+	if(dimensionSize < 1 || dimensionSize > numDimensions)
+	{
+		std::fprintf(stderr, "Dimension size must be within [1, %d].\n",
+		             numDimensions);
+
+		return EXIT_FAILURE;
+	}
+
+	if(precision == 16)
+	{
+		return printLayout<16>(layout, dimensionSize);
+	}
+
+	if(precision == 32)
+	{
+		return printLayout<32>(layout, dimensionSize);
+	}
 
-	printMatrices<samplePrecision>(dimensionSize, indexSize);
+	std::fprintf(stderr, "Precision that was requested was not found; "
+	                     "options are 16, 32.\n");
 
-	return 0;
+	return EXIT_FAILURE;
 }
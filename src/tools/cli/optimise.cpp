@@ -8,6 +8,7 @@
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 
 struct Output
 {
@@ -17,9 +18,9 @@ struct Output
 	float* frequencies;
 };
 
-Output start(int resolution)
+Output start(int resolution, int depth)
 {
-	const auto npixels = resolution * resolution;
+	const auto npixels = resolution * resolution * depth;
 
 	Output ret;
 	ret.keys = new std::uint32_t[npixels];
@@ -40,6 +41,63 @@ void stop(Output out)
 
 int main(int argc, char* argv[])
 {
+	// Options can be passed in any position, and are removed before the
+	// remaining arguments are read.
+	auto resume = false;
+	auto temperatureStart = 0.0f;
+	auto temperatureEnd = 0.0f;
+	auto nreplicas = 1;
+	auto nargs = 1;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		if(std::strcmp(argv[i], "--resume") == 0)
+		{
+			resume = true;
+		}
+		else if(std::strncmp(argv[i], "--anneal=", 9) == 0)
+		{
+			if(std::sscanf(argv[i] + 9, "%f,%f", &temperatureStart,
+			               &temperatureEnd) != 2 ||
+			   temperatureStart <= 0 || temperatureEnd <= 0 ||
+			   temperatureEnd > temperatureStart)
+			{
+				std::fprintf(stderr, "Temperatures that were requested are "
+				                     "not valid; the start and end must be "
+				                     "positive, and the end no higher than "
+				                     "the start.\n");
+
+				return EXIT_FAILURE;
+			}
+		}
+		else if(std::strncmp(argv[i], "--replicas=", 11) == 0)
+		{
+			nreplicas = std::atoi(argv[i] + 11);
+
+			if(nreplicas < 1)
+			{
+				std::fprintf(stderr, "Number of replicas that was requested "
+				                     "is not valid; it must be at least 1.\n");
+
+				return EXIT_FAILURE;
+			}
+		}
+		else
+		{
+			argv[nargs++] = argv[i];
+		}
+	}
+
+	argc = nargs;
+
+	if(nreplicas > 1 && temperatureStart == 0)
+	{
+		std::fprintf(stderr, "Replicas that were requested need a temperature; "
+		                     "user must also pass the anneal option.\n");
+
+		return EXIT_FAILURE;
+	}
+
 	if(argc == 1)
 	{
 		std::fprintf(stderr, "No arguments passed; "
@@ -48,44 +106,112 @@ int main(int argc, char* argv[])
 		return EXIT_FAILURE;
 	}
 
-	if(argc > 2)
+	if(argc > 4)
 	{
 		std::fprintf(stderr, "Too many arguments passed; "
-		                     "user must specify a single sampler.\n");
+		                     "user must specify a sampler, a layout and "
+		                     "optionally a number of levels.\n");
 
 		return EXIT_FAILURE;
 	}
 
-	constexpr auto xBits = 8;
-	constexpr auto yBits = 8;
+	// Spatial tables are 256x256 pixels, and temporal tables are 32x32 pixels
+	// with 16 frames along Z. These must match include/oqmc/bntables.h.
+	constexpr auto spatialBits = 8;
+	constexpr auto temporalBits = 5;
+	constexpr auto temporalDepthBits = 4;
+
+	// Larger temporal tables, either 64x64 pixels with 16 frames, or 128x128
+	// pixels with 4 frames. These are not yet shipped in bntables.h.
+	constexpr auto temporal64Bits = 6;
+	constexpr auto temporal64DepthBits = 4;
+	constexpr auto temporal128Bits = 7;
+	constexpr auto temporal128DepthBits = 2;
+
+	auto resolution = 1 << spatialBits;
+	auto depth = 1;
+
+	if(argc > 2)
+	{
+		if(std::strcmp(argv[2], "temporal") == 0)
+		{
+			resolution = 1 << temporalBits;
+			depth = 1 << temporalDepthBits;
+		}
+		else if(std::strcmp(argv[2], "temporal-64") == 0)
+		{
+			resolution = 1 << temporal64Bits;
+			depth = 1 << temporal64DepthBits;
+		}
+		else if(std::strcmp(argv[2], "temporal-128") == 0)
+		{
+			resolution = 1 << temporal128Bits;
+			depth = 1 << temporal128DepthBits;
+		}
+		else if(std::strcmp(argv[2], "spatial") != 0)
+		{
+			std::fprintf(stderr, "Layout that was requested was not found; "
+			                     "options are spatial, temporal, temporal-64, "
+			                     "temporal-128.\n");
+
+			return EXIT_FAILURE;
+		}
+	}
+
+	auto nlevels = 1;
 
-	static_assert(xBits == yBits,
-	              "Optimisation tables have equal resolution in x and y");
+	if(argc > 3)
+	{
+		nlevels = std::atoi(argv[3]);
+
+		// The coarsest level must still be large enough to hold a block of
+		// swaps.
+		if(nlevels < 1 || (resolution >> (nlevels - 1)) < 8)
+		{
+			std::fprintf(stderr, "Number of levels that was requested is not "
+			                     "valid; the coarsest level must be at least 8 "
+			                     "pixels wide.\n");
+
+			return EXIT_FAILURE;
+		}
+	}
 
 	constexpr auto ntests = 8192;
 	constexpr auto niterations = 262144;
 	constexpr auto nsamples = 128;
-	constexpr auto resolution = 1 << xBits;
 	constexpr auto seed = 0;
 
-	auto out = start(resolution);
+	// State is written to the checkpoint file every ten minutes, and removed
+	// once the outputs have been written.
+	constexpr auto checkpoint = "checkpoint.bin";
+	constexpr auto interval = 600;
+
+	const auto npixels = resolution * resolution * depth;
 
-	if(!oqmc_optimise(argv[1], ntests, niterations, nsamples, resolution, seed,
-	                  out.keys, out.ranks, out.estimates, out.frequencies))
+	auto out = start(resolution, depth);
+
+	if(!oqmc_optimise(argv[1], ntests, niterations, nsamples, resolution, depth,
+	                  nlevels, seed, temperatureStart, temperatureEnd,
+	                  nreplicas, checkpoint, interval, resume, out.keys,
+	                  out.ranks, out.estimates, out.frequencies))
 	{
-		std::fprintf(stderr, "Sampler that was requested was not found; "
-		                     "options are pmj, sobol, lattice.\n");
+		std::fprintf(stderr, "Optimisation that was requested could not run; "
+		                     "sampler options are pmj, sobol, lattice.\n");
 
 		goto failure;
 	}
 
-	write::integers("keys.txt", resolution * resolution, out.keys);
-	write::integers("ranks.txt", resolution * resolution, out.ranks);
+	write::integers("keys.txt", npixels, out.keys);
+	write::integers("ranks.txt", npixels, out.ranks);
 
-	write::greyscales("estimates.pfm", resolution, resolution, out.estimates);
-	write::greyscales("frequencies.pfm", resolution, resolution,
+	// Frames along Z are stacked vertically in the image outputs.
+	write::greyscales("estimates.pfm", resolution, resolution * depth,
+	                  out.estimates);
+	write::greyscales("frequencies.pfm", resolution, resolution * depth,
 	                  out.frequencies);
 
+	std::remove(checkpoint);
+
 	stop(out);
 	return EXIT_SUCCESS;
 
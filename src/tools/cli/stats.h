@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Contributors to the OpenQMC Project.
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace stats
+{
+
+// Robust summary of repeated timings. Order statistics are used rather than
+// the mean and standard deviation, as timings are skewed by interruptions.
+struct Summary
+{
+	double min;
+	double p5;
+	double p25;
+	double median;
+	double p75;
+	double p95;
+	double max;
+	double mad;
+};
+
+// Percentile of sorted values, linearly interpolating between ranks.
+inline double percentile(const std::vector<double>& sorted, double fraction)
+{
+	assert(!sorted.empty());
+
+	const auto rank = fraction * (sorted.size() - 1);
+	const auto lower = static_cast<std::size_t>(std::floor(rank));
+	const auto upper = std::min(lower + 1, sorted.size() - 1);
+	const auto weight = rank - lower;
+
+	return sorted[lower] * (1 - weight) + sorted[upper] * weight;
+}
+
+inline Summary summarise(std::vector<double> values)
+{
+	std::sort(values.begin(), values.end());
+
+	Summary ret;
+	ret.min = values.front();
+	ret.p5 = percentile(values, 0.05);
+	ret.p25 = percentile(values, 0.25);
+	ret.median = percentile(values, 0.5);
+	ret.p75 = percentile(values, 0.75);
+	ret.p95 = percentile(values, 0.95);
+	ret.max = values.back();
+
+	for(auto& value : values)
+	{
+		value = std::abs(value - ret.median);
+	}
+
+	std::sort(values.begin(), values.end());
+	ret.mad = percentile(values, 0.5);
+
+	return ret;
+}
+
+// Test whether a median is slower than a baseline median. The relative change
+// must exceed the threshold, and the absolute change must exceed the noise of
+// both measurements, estimated from the median absolute deviation.
+inline bool regression(double median, double mad, double baseMedian,
+                       double baseMad, double threshold)
+{
+	constexpr auto sigmaScale = 1.4826; // MAD to standard deviation.
+	constexpr auto sigmaCount = 3.0;
+
+	const auto noise =
+	    sigmaCount * sigmaScale * std::sqrt(mad * mad + baseMad * baseMad);
+
+	const auto change = median - baseMedian;
+
+	return change > threshold * baseMedian && change > noise;
+}
+
+} // namespace stats
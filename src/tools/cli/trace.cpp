@@ -8,6 +8,8 @@
 
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <string>
 
 float3* start(int width, int height)
 {
@@ -19,6 +21,18 @@ void stop(float3* out)
 	delete[] out;
 }
 
+// Count the pixels that are not bit identical between two images.
+int mismatches(const float3* a, const float3* b, int size)
+{
+	auto count = 0;
+	for(int i = 0; i < size; ++i)
+	{
+		count += std::memcmp(&a[i], &b[i], sizeof(float3)) != 0;
+	}
+
+	return count;
+}
+
 int main(int argc, char* argv[])
 {
 	if(argc == 1)
@@ -37,14 +51,18 @@ int main(int argc, char* argv[])
 		return EXIT_FAILURE;
 	}
 
-	if(argc > 3)
+	if(argc > 4)
 	{
 		std::fprintf(stderr, "Too many arguments passed; "
-		                     "user must specify a sampler and a scene.\n");
+		                     "user must specify a sampler, a scene and "
+		                     "optionally a schedule.\n");
 
 		return EXIT_FAILURE;
 	}
 
+	const auto schedule = std::string(argc > 3 ? argv[3] : "tile");
+	const auto compare = schedule == "compare";
+
 	constexpr auto mode = "split";
 	constexpr auto width = 1080;
 	constexpr auto height = 720;
@@ -55,24 +73,80 @@ int main(int argc, char* argv[])
 	constexpr auto maxOpacity = 2;
 
 	auto out = start(width, height);
+	auto mismatch = false;
 
-	if(!oqmc_trace(argv[1], argv[2], mode, width, height, frame,
-	               numPixelSamples, numLightSamples, maxDepth, maxOpacity, out))
+	if(compare)
+	{
+		// Render with the reference schedule last, so that it is written out.
+		// The other schedules render to their own images, which must match.
+		const char* schedules[] = {"tile", "wavefront", "pass"};
+		float3* images[] = {start(width, height), start(width, height), out};
+		double times[3];
+		auto found = true;
+
+		for(int i = 0; i < 3 && found; ++i)
+		{
+			found = oqmc_trace(argv[1], argv[2], mode, schedules[i], width,
+			                   height, frame, numPixelSamples, numLightSamples,
+			                   maxDepth, maxOpacity, images[i], &times[i]);
+		}
+
+		for(int i = 0; i < 3 && found; ++i)
+		{
+			const auto count = mismatches(images[i], out, width * height);
+
+			std::printf("%s: %.3fs (speedup: %.2fx, mismatches: %i)\n",
+			            schedules[i], times[i], times[2] / times[i], count);
+
+			mismatch = mismatch || count > 0;
+		}
+
+		stop(images[0]);
+		stop(images[1]);
+
+		if(!found)
+		{
+			goto notFound;
+		}
+	}
+	else
 	{
-		std::fprintf(stderr, "Configuration that was requested was not found; "
-		                     "sampler options are pmj, pmjbn, sobol, sobolbn, "
-		                     "lattice, latticebn, rng; "
-		                     "scene options are box, presence, blur.\n");
+		double time;
+
+		if(!oqmc_trace(argv[1], argv[2], mode, schedule.c_str(), width,
+		               height, frame, numPixelSamples, numLightSamples,
+		               maxDepth, maxOpacity, out, &time))
+		{
+			goto notFound;
+		}
 
-		goto failure;
+		std::printf("%s: %.3fs\n", schedule.c_str(), time);
 	}
 
 	write::colours("image.pfm", width, height, out);
 
 	stop(out);
+
+	if(mismatch)
+	{
+		std::fprintf(stderr, "Images that were rendered do not match; "
+		                     "all schedules must produce the same image.\n");
+
+		return EXIT_FAILURE;
+	}
+
 	return EXIT_SUCCESS;
 
-failure:
+notFound:
+
+	std::fprintf(stderr, "Configuration that was requested was not found; "
+	                     "sampler options are pmj, pmjbn, pmjstbn, sobol, "
+	                     "sobolbn, sobolstbn, lattice, latticebn, "
+	                     "latticestbn, rng; "
+	                     "scene options are box, presence, blur, spheres, "
+	                     "blocks, terrain; "
+	                     "schedule options are tile, pass, wavefront, "
+	                     "compare.\n");
 
 	stop(out);
 	return EXIT_FAILURE;
@@ -4,159 +4,860 @@
 #include "benchmark.h"
 
 #include "abi.h"
+#include "counters.h"
 #include "parallel.h"
+#include <oqmc/cachefile.h>
+#include <oqmc/float.h>
 #include <oqmc/gpu.h>
 #include <oqmc/lattice.h>
 #include <oqmc/latticebn.h>
+#include <oqmc/latticestbn.h>
+#include <oqmc/owen.h>
+#include <oqmc/pcg.h>
 #include <oqmc/pmj.h>
 #include <oqmc/pmjbn.h>
+#include <oqmc/pmjstbn.h>
 #include <oqmc/sobol.h>
 #include <oqmc/sobolbn.h>
+#include <oqmc/sobolhd.h>
+#include <oqmc/sobolstbn.h>
+#include <oqmc/state.h>
 #include <oqmc/unused.h>
 
 #include <cassert>
 #include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <string>
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#endif
+
 namespace
 {
 
+// Number of dimensions drawn from each domain. High dimensional samplers draw
+// all dimensions from a single domain, instead of padding 4 dimensional
+// domains.
 template <typename Sampler>
+struct DrawSize
+{
+	static constexpr int value = 4;
+};
+
+template <>
+struct DrawSize<oqmc::SobolHdSampler>
+{
+	static constexpr int value = oqmc::sobolHdMaxDepth;
+};
+
+// Method used to derive the domain for each draw from the previous domain.
+enum class Derivation
+{
+	Domain,
+	Split,
+	Distrib,
+	Chain,
+	Path,
+};
+
+// Compile time configuration of a kernel. Wrapping the parameters in a single
+// type allows the kernel to be passed to the launch macros.
+template <typename SamplerType, int Size, Derivation Mode>
+struct Config
+{
+	using Sampler = SamplerType;
+	static constexpr int size = Size;
+	static constexpr Derivation mode = Mode;
+};
+
+template <Derivation Mode, typename Sampler>
+OQMC_HOST_DEVICE Sampler derive(Sampler domain, int depth)
+{
+	// Sample rate multiplier when splitting domains.
+	constexpr auto splitSize = 4;
+
+	// Path of keys that is folded at compile time into a single transition.
+	constexpr auto path = oqmc::domainPath<0, 1, 2, 3>();
+
+	const auto index = depth % splitSize;
+
+	switch(Mode)
+	{
+	case Derivation::Split:
+		return domain.newDomainSplit(0, splitSize, index);
+	case Derivation::Distrib:
+		return domain.newDomainDistrib(0, index);
+	case Derivation::Chain:
+		return domain.newDomainChain(0, index);
+	case Derivation::Path:
+		return domain.newDomainPath(path);
+	default:
+		return domain.newDomain(0);
+	}
+}
+
+template <typename Config>
 OQMC_HOST_DEVICE void loop(int nsamples, int ndims, int index, int stride,
                            const void* cache)
 {
+	using Sampler = typename Config::Sampler;
+	constexpr auto size = Config::size;
+
 	for(int i = index; i < nsamples; i += stride)
 	{
 		auto domain = Sampler(0, 0, 0, i, cache);
 
-		for(int j = 0; j < ndims; j += 4)
+		for(int j = 0; j < ndims; j += size)
+		{
+			domain = derive<Config::mode>(domain, j / size);
+
+			float sample[size];
+			domain.template drawSample<size>(sample);
+
+			for(int k = 0; k < size; ++k)
+			{
+				volatile float save;
+				save = sample[k];
+
+				OQMC_MAYBE_UNUSED(save);
+			}
+		}
+	}
+}
+
+template <typename Config>
+OQMC_HOST_DEVICE void loopBatch(int nsamples, int ndims, int index, int stride,
+                                const void* cache)
+{
+	using Sampler = typename Config::Sampler;
+	constexpr auto size = Config::size;
+	constexpr auto batchSize = 64;
+
+	for(int i = index * batchSize; i < nsamples; i += stride * batchSize)
+	{
+		const auto end = i + batchSize < nsamples ? i + batchSize : nsamples;
+
+		auto domain = Sampler(0, 0, 0, i, cache);
+
+		for(int j = 0; j < ndims; j += size)
+		{
+			domain = derive<Config::mode>(domain, j / size);
+
+			float sample[size * batchSize];
+			domain.template drawSampleBatch<size>(i, end, sample);
+
+			for(int k = 0; k < size * (end - i); ++k)
+			{
+				volatile float save;
+				save = sample[k];
+
+				OQMC_MAYBE_UNUSED(save);
+			}
+		}
+	}
+}
+
+// Derives a chain of domains for each sample without drawing from them, other
+// than a single random number from the last domain, to isolate the cost of the
+// derivation method.
+template <typename Config>
+OQMC_HOST_DEVICE void loopDerive(int nsamples, int ndims, int index,
+                                 int stride, const void* cache)
+{
+	using Sampler = typename Config::Sampler;
+
+	for(int i = index; i < nsamples; i += stride)
+	{
+		auto domain = Sampler(0, 0, 0, i, cache);
+
+		for(int j = 0; j < ndims; ++j)
+		{
+			domain = derive<Config::mode>(domain, j);
+		}
+
+		std::uint32_t rnd[1];
+		domain.template drawRnd<1>(rnd);
+
+		volatile std::uint32_t save;
+		save = rnd[0];
+
+		OQMC_MAYBE_UNUSED(save);
+	}
+}
+
+// Image resolution and sample count of the render measurements. The image is
+// larger than the blue noise tables, so that lookups spread across the tables.
+constexpr auto imageWidth = 1920;
+constexpr auto imageHeight = 1080;
+constexpr auto tileSize = 16;
+constexpr auto samplesPerPixel = 16;
+
+// Order in which the render measurements visit pixels.
+enum class Order
+{
+	Tile,
+	Random,
+};
+
+// Domain keys and light sample count of a simple path tracer. See the trace
+// tool for a complete example.
+enum Key
+{
+	cameraKey,
+	bsdfKey,
+	lightKey,
+	rouletteKey,
+	bounceKey,
+};
+
+constexpr auto lightSamples = 4;
+
+OQMC_HOST_DEVICE void pixelCoordinate(Order order, int pixel, int& x, int& y)
+{
+	if(order == Order::Random)
+	{
+		pixel = oqmc::pcg::hash(pixel) % (imageWidth * imageHeight);
+
+		x = pixel % imageWidth;
+		y = pixel / imageWidth;
+
+		return;
+	}
+
+	constexpr auto tilesInX = imageWidth / tileSize;
+	constexpr auto tilePixels = tileSize * tileSize;
+
+	const auto tile = pixel / tilePixels;
+	const auto local = pixel % tilePixels;
+
+	x = tile % tilesInX * tileSize + local % tileSize;
+	y = (tile / tilesInX * tileSize + local / tileSize) % imageHeight;
+}
+
+template <typename Config, typename Sampler>
+OQMC_HOST_DEVICE void consume(Sampler domain)
+{
+	constexpr auto size = Config::size;
+
+	float sample[size];
+	domain.template drawSample<size>(sample);
+
+	for(int k = 0; k < size; ++k)
+	{
+		volatile float save;
+		save = sample[k];
+
+		OQMC_MAYBE_UNUSED(save);
+	}
+}
+
+// Follows the domain tree of a path tracer for each sample, visiting pixels
+// in the given order. Each bounce draws from a BSDF domain, a fan out of light
+// domains using the configured derivation method, and a russian roulette
+// domain, before deriving the domain of the next bounce.
+template <typename Config>
+OQMC_HOST_DEVICE void loopRender(int nsamples, int depth, Order order,
+                                 int index, int stride, const void* cache)
+{
+	using Sampler = typename Config::Sampler;
+
+	for(int i = index; i < nsamples; i += stride)
+	{
+		int x, y;
+		pixelCoordinate(order, i / samplesPerPixel, x, y);
+
+		auto path = Sampler(x, y, 0, i % samplesPerPixel, cache);
+		consume<Config>(path.newDomain(cameraKey));
+
+		for(int j = 0; j < depth; ++j)
 		{
-			domain = domain.newDomain(0);
+			consume<Config>(path.newDomain(bsdfKey));
+
+			const auto light = path.newDomain(lightKey);
+			for(int k = 0; k < lightSamples; ++k)
+			{
+				consume<Config>(derive<Config::mode>(light, k));
+			}
 
-			float sample[4];
-			domain.template drawSample<4>(sample);
+			std::uint32_t rnd[1];
+			path.newDomain(rouletteKey).template drawRnd<1>(rnd);
 
-			volatile float save[4];
-			save[0] = sample[0];
-			save[1] = sample[1];
-			save[2] = sample[2];
-			save[3] = sample[3];
+			volatile std::uint32_t save;
+			save = rnd[0];
 
 			OQMC_MAYBE_UNUSED(save);
+
+			path = path.newDomain(bounceKey);
+		}
+	}
+}
+
+// Draws the same samples as the sobol sampler in loop, but enumerating
+// consecutive indices within each domain instead of constructing a new sampler
+// per index.
+OQMC_HOST_DEVICE void loopEnumerate(int nsamples, int ndims, int index,
+                                    int stride)
+{
+	constexpr auto batchSize = 64;
+
+	for(int i = index * batchSize; i < nsamples; i += stride * batchSize)
+	{
+		const auto end = i + batchSize < nsamples ? i + batchSize : nsamples;
+
+		auto state = oqmc::State64Bit(0, 0, 0, i).pixelDecorrelate();
+
+		for(int j = 0; j < ndims; j += 4)
+		{
+			state = state.newDomain(0);
+
+			const auto seed = oqmc::pcg::output(state.patternId);
+			auto enumerator = oqmc::SobolEnumerator<4>(i, seed);
+
+			for(int k = i; k < end; ++k)
+			{
+				std::uint32_t sample[4];
+				enumerator.drawSample(sample);
+				enumerator.next();
+
+				volatile float save[4];
+				save[0] = oqmc::uintToFloat(sample[0]);
+				save[1] = oqmc::uintToFloat(sample[1]);
+				save[2] = oqmc::uintToFloat(sample[2]);
+				save[3] = oqmc::uintToFloat(sample[3]);
+
+				OQMC_MAYBE_UNUSED(save);
+			}
 		}
 	}
 }
 
 #if defined(__CUDACC__)
-template <typename Sampler>
+template <typename Config>
 __global__ void kernal(int nsamples, int ndims, const void* cache)
 {
 	const int index = blockIdx.x * blockDim.x + threadIdx.x;
 	const int stride = blockDim.x * gridDim.x;
 
-	loop<Sampler>(nsamples, ndims, index, stride, cache);
+	loop<Config>(nsamples, ndims, index, stride, cache);
+}
+
+template <typename Config>
+__global__ void kernalBatch(int nsamples, int ndims, const void* cache)
+{
+	const int index = blockIdx.x * blockDim.x + threadIdx.x;
+	const int stride = blockDim.x * gridDim.x;
+
+	loopBatch<Config>(nsamples, ndims, index, stride, cache);
+}
+
+template <typename Config>
+__global__ void kernalDerive(int nsamples, int ndims, const void* cache)
+{
+	const int index = blockIdx.x * blockDim.x + threadIdx.x;
+	const int stride = blockDim.x * gridDim.x;
+
+	loopDerive<Config>(nsamples, ndims, index, stride, cache);
+}
+
+template <typename Config>
+__global__ void kernalRender(int nsamples, int depth, Order order,
+                             const void* cache)
+{
+	const int index = blockIdx.x * blockDim.x + threadIdx.x;
+	const int stride = blockDim.x * gridDim.x;
+
+	loopRender<Config>(nsamples, depth, order, index, stride, cache);
+}
+
+__global__ void kernalEnumerate(int nsamples, int ndims)
+{
+	const int index = blockIdx.x * blockDim.x + threadIdx.x;
+	const int stride = blockDim.x * gridDim.x;
+
+	loopEnumerate(nsamples, ndims, index, stride);
 }
 #else
-template <typename Sampler>
+template <typename Config>
 void kernal(int nsamples, int ndims, const void* cache)
 {
-	const int index = 0;
-	const int stride = 1;
+	strided([=](int index, int stride) {
+		loop<Config>(nsamples, ndims, index, stride, cache);
+	});
+}
+
+template <typename Config>
+void kernalBatch(int nsamples, int ndims, const void* cache)
+{
+	strided([=](int index, int stride) {
+		loopBatch<Config>(nsamples, ndims, index, stride, cache);
+	});
+}
 
-	loop<Sampler>(nsamples, ndims, index, stride, cache);
+template <typename Config>
+void kernalDerive(int nsamples, int ndims, const void* cache)
+{
+	strided([=](int index, int stride) {
+		loopDerive<Config>(nsamples, ndims, index, stride, cache);
+	});
+}
+
+template <typename Config>
+void kernalRender(int nsamples, int depth, Order order, const void* cache)
+{
+	strided([=](int index, int stride) {
+		loopRender<Config>(nsamples, depth, order, index, stride, cache);
+	});
+}
+
+void kernalEnumerate(int nsamples, int ndims)
+{
+	strided([=](int index, int stride) {
+		loopEnumerate(nsamples, ndims, index, stride);
+	});
 }
 #endif
 
+// Runtime parameters of a measurement.
+struct Options
+{
+	const char* measurement;
+	int nsamples;
+	int ndims;
+	int nwarmups;
+	int ntrials;
+	double* out;
+	Counters* counters;
+};
+
 template <typename Func>
-int benchmark(Func run)
+double benchmark(Func run)
 {
 	using namespace std::chrono;
 
-	const auto start = high_resolution_clock::now();
+	const auto start = steady_clock::now();
 
 	run();
 
-	const auto stop = high_resolution_clock::now();
+	const auto stop = steady_clock::now();
 
 	const auto duration = stop - start;
-	const auto time = duration_cast<microseconds>(duration);
+	const auto time = duration_cast<nanoseconds>(duration);
 
 	return time.count();
 }
 
-template <typename Sampler>
-bool run(const char* measurement, int nsamples, int ndims, int* out)
+// Run a function for a number of warm up iterations that are discarded, and
+// then time each of the following trials in nanoseconds. A preparation
+// function is called before every iteration, outside of the timing. Hardware
+// counters, if requested, accumulate over the timed trials only.
+template <typename Prepare, typename Func>
+void trials(Options options, Prepare prepare, Func run)
+{
+	for(int i = 0; i < options.nwarmups; ++i)
+	{
+		prepare();
+		run();
+	}
+
+	for(int i = 0; i < options.ntrials; ++i)
+	{
+		prepare();
+
+		if(options.counters)
+		{
+			options.counters->start();
+		}
+
+		options.out[i] = benchmark(run);
+
+		if(options.counters)
+		{
+			options.counters->stop();
+		}
+	}
+}
+
+template <typename Func>
+void trials(Options options, Func run)
+{
+	trials(options, []() {}, run);
+}
+
+// Cache file written to a temporary file on disk. Loading maps the file
+// read-only where memory mapping is available, or otherwise reads it into an
+// allocation, and then validates the contents. The file is removed on close.
+class CacheFile
+{
+  public:
+	CacheFile(const void* contents, std::size_t size)
+	    : stream(std::tmpfile()), size(size)
+	{
+		if(stream && (std::fwrite(contents, 1, size, stream) != size ||
+		              std::fflush(stream) != 0))
+		{
+			std::fclose(stream);
+			stream = nullptr;
+		}
+	}
+
+	~CacheFile()
+	{
+		if(stream)
+		{
+			std::fclose(stream);
+		}
+	}
+
+	CacheFile(const CacheFile&) = delete;
+	CacheFile& operator=(const CacheFile&) = delete;
+
+	bool valid() const
+	{
+		return stream != nullptr;
+	}
+
+	template <typename Sampler>
+	bool load()
+	{
+#if defined(__unix__) || defined(__APPLE__)
+		const auto file =
+		    mmap(nullptr, size, PROT_READ, MAP_SHARED, fileno(stream), 0);
+
+		if(file == MAP_FAILED)
+		{
+			return false;
+		}
+
+		const auto data = oqmc::cacheFileData<Sampler>(file, size);
+		munmap(file, size);
+#else
+		const auto file = new std::uint64_t[(size + 7) / 8];
+
+		std::rewind(stream);
+		const auto read = std::fread(file, 1, size, stream);
+
+		const auto data =
+		    read == size ? oqmc::cacheFileData<Sampler>(file, size) : nullptr;
+		delete[] file;
+#endif
+
+		return data != nullptr;
+	}
+
+  private:
+	std::FILE* stream;
+	std::size_t size;
+};
+
+// Evict the host caches by writing to a buffer larger than the last level
+// cache, so that the next iteration starts with a cold sampler cache.
+struct Evict
 {
+	static constexpr std::size_t size = 1 << 27; // 128MiB
+
+	Evict() : buffer(new char[size])
+	{
+	}
+
+	~Evict()
+	{
+		delete[] buffer;
+	}
+
+	Evict(const Evict&) = delete;
+	Evict& operator=(const Evict&) = delete;
+
+	void operator()()
+	{
+		std::memset(buffer, ++value, size);
+	}
+
+	char* buffer;
+	char value = 0;
+};
+
+template <typename Config>
+bool measure(Options options)
+{
+	using Sampler = typename Config::Sampler;
+
+	const auto nsamples = options.nsamples;
+	const auto ndims = options.ndims;
+	const auto measurement = std::string(options.measurement);
+
 	void* cache;
 	OQMC_ALLOCATE(&cache, Sampler::cacheSize);
+	Sampler::initialiseCache(cache, HostLoop());
 
-	const auto timeInit =
-	    benchmark([cache]() { Sampler::initialiseCache(cache); });
-
-	const auto timeSamples = benchmark([nsamples, ndims, cache]() {
-		OQMC_LAUNCH(kernal<Sampler>, nsamples, ndims, cache);
-	});
+	auto mesured = true;
 
-	OQMC_FREE(cache);
+	if(measurement == "init")
+	{
+		trials(options,
+		       [cache]() { Sampler::initialiseCache(cache, HostLoop()); });
+	}
+	else if(measurement == "load")
+	{
+		// The file is written once, and each trial maps it read-only and
+		// validates it, including the checksum which faults in every page.
+		constexpr auto fileSize = oqmc::cacheFileSize<Sampler>();
+		const auto file = new std::uint64_t[(fileSize + 7) / 8];
+		oqmc::initialiseCacheFile<Sampler>(file, HostLoop());
 
-	auto mesured = false;
-	*out = 0;
+		CacheFile stream(file, fileSize);
+		delete[] file;
 
-	if(std::string(measurement) == "init")
+		if(stream.valid())
+		{
+			trials(options, [&stream]() {
+				volatile auto loaded = stream.load<Sampler>();
+				OQMC_MAYBE_UNUSED(loaded);
+			});
+		}
+		else
+		{
+			mesured = false;
+		}
+	}
+	else if(measurement == "samples")
+	{
+		trials(options, [nsamples, ndims, cache]() {
+			OQMC_LAUNCH(kernal<Config>, nsamples, ndims, cache);
+		});
+	}
+	else if(measurement == "batch")
+	{
+		trials(options, [nsamples, ndims, cache]() {
+			OQMC_LAUNCH(kernalBatch<Config>, nsamples, ndims, cache);
+		});
+	}
+	else if(measurement == "derive")
 	{
-		mesured = true;
-		*out += timeInit;
+		trials(options, [nsamples, ndims, cache]() {
+			OQMC_LAUNCH(kernalDerive<Config>, nsamples, ndims, cache);
+		});
 	}
+	else if(measurement == "tile" || measurement == "random")
+	{
+		const auto order = measurement == "tile" ? Order::Tile : Order::Random;
 
-	if(std::string(measurement) == "samples")
+		trials(options, [nsamples, ndims, order, cache]() {
+			OQMC_LAUNCH(kernalRender<Config>, nsamples, ndims, order, cache);
+		});
+	}
+	else if(measurement == "cold")
 	{
-		mesured = true;
-		*out += timeSamples;
+		Evict evict;
+
+		trials(options, [&evict]() { evict(); }, [nsamples, ndims, cache]() {
+			OQMC_LAUNCH(kernalRender<Config>, nsamples, ndims, Order::Random,
+			            cache);
+		});
 	}
+	else
+	{
+		mesured = false;
+	}
+
+	OQMC_FREE(cache);
 
 	return mesured;
 }
 
-} // namespace
+bool measureEnumerate(Options options)
+{
+	if(std::string(options.measurement) != "enumerate")
+	{
+		return false;
+	}
 
-OQMC_CABI bool oqmc_benchmark(const char* sampler, const char* measurement,
-                              int nsamples, int ndims, int* out)
+	const auto nsamples = options.nsamples;
+	const auto ndims = options.ndims;
+
+	trials(options, [nsamples, ndims]() {
+		OQMC_LAUNCH(kernalEnumerate, nsamples, ndims);
+	});
+
+	return true;
+}
+
+template <typename Sampler, int Size>
+bool dispatchDerivation(const char* derivation, Options options)
 {
-	assert(sampler);
-	assert(measurement);
-	assert(nsamples >= 0);
-	assert(ndims >= 0);
-	assert(out);
+	if(std::string(derivation) == "domain")
+	{
+		return measure<Config<Sampler, Size, Derivation::Domain>>(options);
+	}
+
+	if(std::string(derivation) == "split")
+	{
+		return measure<Config<Sampler, Size, Derivation::Split>>(options);
+	}
+
+	if(std::string(derivation) == "distrib")
+	{
+		return measure<Config<Sampler, Size, Derivation::Distrib>>(options);
+	}
+
+	if(std::string(derivation) == "chain")
+	{
+		return measure<Config<Sampler, Size, Derivation::Chain>>(options);
+	}
 
+	if(std::string(derivation) == "path")
+	{
+		return measure<Config<Sampler, Size, Derivation::Path>>(options);
+	}
+
+	return false;
+}
+
+template <typename Sampler>
+bool dispatchSize(int size, const char* derivation, Options options)
+{
+	switch(size)
+	{
+	case 0:
+		return dispatchDerivation<Sampler, DrawSize<Sampler>::value>(derivation,
+		                                                             options);
+	case 1:
+		return dispatchDerivation<Sampler, 1>(derivation, options);
+	case 2:
+		return dispatchDerivation<Sampler, 2>(derivation, options);
+	case 4:
+		return dispatchDerivation<Sampler, 4>(derivation, options);
+	default:
+		return false;
+	}
+}
+
+bool dispatch(const char* sampler, int size, const char* derivation,
+              Options options)
+{
 	if(std::string(sampler) == "pmj")
 	{
-		return run<oqmc::PmjSampler>(measurement, nsamples, ndims, out);
+		return dispatchSize<oqmc::PmjSampler>(size, derivation, options);
 	}
 
 	if(std::string(sampler) == "pmjbn")
 	{
-		return run<oqmc::PmjBnSampler>(measurement, nsamples, ndims, out);
+		return dispatchSize<oqmc::PmjBnSampler>(size, derivation, options);
+	}
+
+	if(std::string(sampler) == "pmjstbn")
+	{
+		return dispatchSize<oqmc::PmjStBnSampler>(size, derivation, options);
 	}
 
 	if(std::string(sampler) == "sobol")
 	{
-		return run<oqmc::SobolSampler>(measurement, nsamples, ndims, out);
+		if(measureEnumerate(options))
+		{
+			return true;
+		}
+
+		return dispatchSize<oqmc::SobolSampler>(size, derivation, options);
 	}
 
 	if(std::string(sampler) == "sobolbn")
 	{
-		return run<oqmc::SobolBnSampler>(measurement, nsamples, ndims, out);
+		return dispatchSize<oqmc::SobolBnSampler>(size, derivation, options);
+	}
+
+	if(std::string(sampler) == "sobolstbn")
+	{
+		return dispatchSize<oqmc::SobolStBnSampler>(size, derivation, options);
+	}
+
+	if(std::string(sampler) == "sobolhd")
+	{
+		return dispatchSize<oqmc::SobolHdSampler>(size, derivation, options);
 	}
 
 	if(std::string(sampler) == "lattice")
 	{
-		return run<oqmc::LatticeSampler>(measurement, nsamples, ndims, out);
+		return dispatchSize<oqmc::LatticeSampler>(size, derivation, options);
 	}
 
 	if(std::string(sampler) == "latticebn")
 	{
-		return run<oqmc::LatticeBnSampler>(measurement, nsamples, ndims, out);
+		return dispatchSize<oqmc::LatticeBnSampler>(size, derivation, options);
+	}
+
+	if(std::string(sampler) == "latticestbn")
+	{
+		return dispatchSize<oqmc::LatticeStBnSampler>(size, derivation,
+		                                              options);
 	}
 
 	return false;
 }
+
+} // namespace
+
+OQMC_CABI bool oqmc_benchmark(const char* sampler, const char* measurement,
+                              int nsamples, int ndims, int nthreads, int* out)
+{
+	assert(out);
+
+	double time;
+	if(!oqmc_benchmark_trials(sampler, measurement, 0, "domain", nsamples,
+	                          ndims, nthreads, 0, 1, &time, nullptr))
+	{
+		return false;
+	}
+
+	*out = static_cast<int>(time / 1000);
+
+	return true;
+}
+
+OQMC_CABI bool oqmc_benchmark_trials(const char* sampler,
+                                     const char* measurement, int size,
+                                     const char* derivation, int nsamples,
+                                     int ndims, int nthreads, int nwarmups,
+                                     int ntrials, double* out,
+                                     double* counters)
+{
+	assert(sampler);
+	assert(measurement);
+	assert(size >= 0);
+	assert(derivation);
+	assert(nsamples >= 0);
+	assert(ndims >= 0);
+	assert(nthreads >= 0);
+	assert(nwarmups >= 0);
+	assert(ntrials >= 0);
+	assert(out);
+
+	// Counters only follow the calling thread, so they are only opened when
+	// the measurement runs on a single thread.
+	Counters events;
+	const auto count = counters && nthreads == 1;
+
+	const auto options = Options{measurement, nsamples, ndims,
+	                             nwarmups,    ntrials,  out,
+	                             count ? &events : nullptr};
+
+	const auto valid = limitThreads(nthreads, [=]() {
+		return dispatch(sampler, size, derivation, options);
+	});
+
+	if(counters)
+	{
+		const double draws = static_cast<double>(nsamples) * ntrials;
+
+		for(int i = 0; i < numCounters; ++i)
+		{
+			const auto value = events.value(static_cast<Counter>(i));
+			counters[i] = count && draws > 0 ? value / draws : NAN;
+		}
+	}
+
+	return valid;
+}
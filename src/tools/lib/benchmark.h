@@ -7,4 +7,12 @@
 
 // NOLINTNEXTLINE: C style naming
 OQMC_CABI bool oqmc_benchmark(const char* sampler, const char* measurement,
-                              int nsamples, int ndims, int* out);
+                              int nsamples, int ndims, int nthreads, int* out);
+
+// NOLINTNEXTLINE: C style naming
+OQMC_CABI bool oqmc_benchmark_trials(const char* sampler,
+                                     const char* measurement, int size,
+                                     const char* derivation, int nsamples,
+                                     int ndims, int nthreads, int nwarmups,
+                                     int ntrials, double* out,
+                                     double* counters);
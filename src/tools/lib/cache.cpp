@@ -0,0 +1,109 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Contributors to the OpenQMC Project.
+
+#include "cache.h"
+
+#include "abi.h"
+#include "parallel.h"
+#include <oqmc/cachefile.h>
+#include <oqmc/lattice.h>
+#include <oqmc/latticebn.h>
+#include <oqmc/latticestbn.h>
+#include <oqmc/pmj.h>
+#include <oqmc/pmjbn.h>
+#include <oqmc/pmjstbn.h>
+#include <oqmc/sobol.h>
+#include <oqmc/sobolbn.h>
+#include <oqmc/sobolhd.h>
+#include <oqmc/sobolstbn.h>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace
+{
+
+template <typename Sampler>
+bool run(const char* path)
+{
+	constexpr auto size = oqmc::cacheFileSize<Sampler>();
+
+	// Allocate in 64 bit words to align the header and cache data.
+	const auto file = new std::uint64_t[(size + 7) / 8];
+	oqmc::initialiseCacheFile<Sampler>(file, HostLoop());
+
+	auto success = false;
+
+	if(auto stream = std::fopen(path, "wb"))
+	{
+		success = std::fwrite(file, 1, size, stream) == size;
+		success = std::fclose(stream) == 0 && success;
+	}
+
+	delete[] file;
+
+	return success;
+}
+
+} // namespace
+
+OQMC_CABI bool oqmc_cache(const char* name, const char* path)
+{
+	assert(name);
+	assert(path);
+
+	if(std::string(name) == "pmj")
+	{
+		return run<oqmc::PmjSampler>(path);
+	}
+
+	if(std::string(name) == "pmjbn")
+	{
+		return run<oqmc::PmjBnSampler>(path);
+	}
+
+	if(std::string(name) == "pmjstbn")
+	{
+		return run<oqmc::PmjStBnSampler>(path);
+	}
+
+	if(std::string(name) == "sobol")
+	{
+		return run<oqmc::SobolSampler>(path);
+	}
+
+	if(std::string(name) == "sobolbn")
+	{
+		return run<oqmc::SobolBnSampler>(path);
+	}
+
+	if(std::string(name) == "sobolstbn")
+	{
+		return run<oqmc::SobolStBnSampler>(path);
+	}
+
+	if(std::string(name) == "sobolhd")
+	{
+		return run<oqmc::SobolHdSampler>(path);
+	}
+
+	if(std::string(name) == "lattice")
+	{
+		return run<oqmc::LatticeSampler>(path);
+	}
+
+	if(std::string(name) == "latticebn")
+	{
+		return run<oqmc::LatticeBnSampler>(path);
+	}
+
+	if(std::string(name) == "latticestbn")
+	{
+		return run<oqmc::LatticeStBnSampler>(path);
+	}
+
+	return false;
+}
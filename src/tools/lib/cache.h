@@ -0,0 +1,9 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Contributors to the OpenQMC Project.
+
+#pragma once
+
+#include "abi.h"
+
+// NOLINTNEXTLINE: C style naming
+OQMC_CABI bool oqmc_cache(const char* name, const char* path);
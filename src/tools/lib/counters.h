@@ -0,0 +1,173 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Contributors to the OpenQMC Project.
+
+#pragma once
+
+#include <oqmc/unused.h>
+
+#include <cmath>
+#include <cstdint>
+
+#if defined(__linux__) && !defined(__CUDACC__)
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Hardware events counted for the calling thread. The order matches the output
+// of the oqmc_benchmark_trials function.
+enum Counter
+{
+	counterCycles,
+	counterInstructions,
+	counterL1dMisses,
+	counterLlcMisses,
+	counterBranchMisses,
+	numCounters,
+};
+
+// Hardware performance counters using the Linux perf_event_open interface.
+// Each counter is opened independently, so that a counter that is not
+// supported by the hardware, or not permitted in a container, only disables
+// that single value. On other platforms all counters are unavailable.
+class Counters
+{
+  public:
+	Counters();
+	~Counters();
+
+	Counters(const Counters&) = delete;
+	Counters& operator=(const Counters&) = delete;
+
+	void start();
+	void stop();
+
+	// Accumulated count for all start and stop pairs, scaled to account for
+	// time when the kernel multiplexed the counter. Returns NaN when the
+	// counter is not available.
+	double value(Counter counter) const;
+
+  private:
+	int fds[numCounters];
+	double totals[numCounters];
+};
+
+#if defined(__linux__) && !defined(__CUDACC__)
+inline Counters::Counters()
+{
+	struct Event
+	{
+		std::uint32_t type;
+		std::uint64_t config;
+	};
+
+	constexpr auto cacheRead = PERF_COUNT_HW_CACHE_OP_READ << 8;
+	constexpr auto cacheMiss = PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+
+	const Event events[numCounters] = {
+	    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+	    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+	    {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | cacheRead | cacheMiss},
+	    {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | cacheRead | cacheMiss},
+	    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+	};
+
+	for(int i = 0; i < numCounters; ++i)
+	{
+		perf_event_attr attr;
+		std::memset(&attr, 0, sizeof(attr));
+
+		attr.size = sizeof(attr);
+		attr.type = events[i].type;
+		attr.config = events[i].config;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format =
+		    PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+		totals[i] = 0;
+	}
+}
+
+inline Counters::~Counters()
+{
+	for(int i = 0; i < numCounters; ++i)
+	{
+		if(fds[i] >= 0)
+		{
+			close(fds[i]);
+		}
+	}
+}
+
+inline void Counters::start()
+{
+	for(int i = 0; i < numCounters; ++i)
+	{
+		if(fds[i] >= 0)
+		{
+			ioctl(fds[i], PERF_EVENT_IOC_RESET, 0);
+			ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+		}
+	}
+}
+
+inline void Counters::stop()
+{
+	for(int i = 0; i < numCounters; ++i)
+	{
+		if(fds[i] < 0)
+		{
+			continue;
+		}
+
+		ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+
+		// Value, time enabled and time running.
+		std::uint64_t data[3];
+		if(read(fds[i], data, sizeof(data)) != sizeof(data) || data[2] == 0)
+		{
+			continue;
+		}
+
+		totals[i] += static_cast<double>(data[0]) * data[1] / data[2];
+	}
+}
+
+inline double Counters::value(Counter counter) const
+{
+	return fds[counter] >= 0 ? totals[counter] : NAN;
+}
+#else
+inline Counters::Counters()
+{
+	for(int i = 0; i < numCounters; ++i)
+	{
+		fds[i] = -1;
+		totals[i] = 0;
+	}
+}
+
+inline Counters::~Counters()
+{
+}
+
+inline void Counters::start()
+{
+}
+
+inline void Counters::stop()
+{
+}
+
+inline double Counters::value(Counter counter) const
+{
+	OQMC_MAYBE_UNUSED(counter);
+
+	return NAN;
+}
+#endif
@@ -0,0 +1,243 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Contributors to the OpenQMC Project.
+
+#pragma once
+
+#include <oqmc/arch.h>
+#include <oqmc/gpu.h>
+
+#include <cstdint>
+
+#if defined(OQMC_ARCH_AVX)
+#include <immintrin.h>
+#endif
+
+#if defined(OQMC_ARCH_SSE)
+#include <emmintrin.h>
+#endif
+
+#if defined(OQMC_ARCH_ARM)
+#include <arm_neon.h>
+#endif
+
+// Sums over the taps of the energy kernel of the optimiser. Each tap has a
+// weight, and a distance to the neighbour at that tap. These sums are the inner
+// loop of the optimiser, so taps are summed in lanes using CPU vector
+// intrinsics when available. Both functions sum the lanes in the same order,
+// so that they give the same result for the same distances.
+
+#if defined(OQMC_ARCH_AVX)
+inline float laneSum(__m256 lanes)
+{
+	__m128 half = _mm_add_ps(_mm256_castps256_ps128(lanes),
+	                         _mm256_extractf128_ps(lanes, 1));
+
+	half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+	half = _mm_add_ss(half, _mm_shuffle_ps(half, half, 1));
+
+	return _mm_cvtss_f32(half);
+}
+#endif
+
+#if defined(OQMC_ARCH_SSE)
+inline float laneSum(__m128 lanes)
+{
+	lanes = _mm_add_ps(lanes, _mm_movehl_ps(lanes, lanes));
+	lanes = _mm_add_ss(lanes, _mm_shuffle_ps(lanes, lanes, 1));
+
+	return _mm_cvtss_f32(lanes);
+}
+#endif
+
+#if defined(OQMC_ARCH_ARM)
+inline float laneSum(float32x4_t lanes)
+{
+	const float32x2_t half =
+	    vadd_f32(vget_low_f32(lanes), vget_high_f32(lanes));
+
+	return vget_lane_f32(vpadd_f32(half, half), 0);
+}
+#endif
+
+// Sum the weighted distances of all taps, where the distance of a tap is given
+// by a function. Distances are gathered into lanes, as the neighbours of a tap
+// are not stored in order.
+template <typename Distance>
+OQMC_HOST_DEVICE float kernelSum(int size, const float* weights,
+                                 Distance distance)
+{
+	int i = 0;
+	auto sum = 0.0f;
+
+#if defined(OQMC_ARCH_AVX)
+	constexpr auto stride = 8;
+
+	__m256 lanes = _mm256_setzero_ps();
+
+	for(; i + stride <= size; i += stride)
+	{
+		float gathered[stride];
+		for(int j = 0; j < stride; ++j)
+		{
+			gathered[j] = distance(i + j);
+		}
+
+		const __m256 weight = _mm256_loadu_ps(weights + i);
+		const __m256 values = _mm256_loadu_ps(gathered);
+
+		lanes = _mm256_add_ps(lanes, _mm256_mul_ps(weight, values));
+	}
+
+	sum = laneSum(lanes);
+#endif
+
+#if defined(OQMC_ARCH_SSE)
+	constexpr auto stride = 4;
+
+	__m128 lanes = _mm_setzero_ps();
+
+	for(; i + stride <= size; i += stride)
+	{
+		float gathered[stride];
+		for(int j = 0; j < stride; ++j)
+		{
+			gathered[j] = distance(i + j);
+		}
+
+		const __m128 weight = _mm_loadu_ps(weights + i);
+		const __m128 values = _mm_loadu_ps(gathered);
+
+		lanes = _mm_add_ps(lanes, _mm_mul_ps(weight, values));
+	}
+
+	sum = laneSum(lanes);
+#endif
+
+#if defined(OQMC_ARCH_ARM)
+	constexpr auto stride = 4;
+
+	float32x4_t lanes = vdupq_n_f32(0);
+
+	for(; i + stride <= size; i += stride)
+	{
+		float gathered[stride];
+		for(int j = 0; j < stride; ++j)
+		{
+			gathered[j] = distance(i + j);
+		}
+
+		const float32x4_t weight = vld1q_f32(weights + i);
+		const float32x4_t values = vld1q_f32(gathered);
+
+		lanes = vmlaq_f32(lanes, weight, values);
+	}
+
+	sum = laneSum(lanes);
+#endif
+
+	for(; i < size; ++i)
+	{
+		sum += weights[i] * distance(i);
+	}
+
+	return sum;
+}
+
+// Sum the weighted distances of all taps, where the distances are stored in two
+// rows in the order of the taps, and a function selects the second row for a
+// tap. Both rows are loaded directly into lanes, and blended with a mask of the
+// selections.
+template <typename Select>
+OQMC_HOST_DEVICE float kernelSumRows(int size, const float* weights,
+                                     const float* rowA, const float* rowB,
+                                     Select select)
+{
+	int i = 0;
+	auto sum = 0.0f;
+
+#if defined(OQMC_ARCH_AVX)
+	constexpr auto stride = 8;
+
+	__m256 lanes = _mm256_setzero_ps();
+
+	for(; i + stride <= size; i += stride)
+	{
+		std::int32_t selected[stride];
+		for(int j = 0; j < stride; ++j)
+		{
+			selected[j] = select(i + j) ? -1 : 0;
+		}
+
+		const __m256 mask = _mm256_castsi256_ps(
+		    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(selected)));
+
+		const __m256 weight = _mm256_loadu_ps(weights + i);
+		const __m256 values = _mm256_blendv_ps(
+		    _mm256_loadu_ps(rowA + i), _mm256_loadu_ps(rowB + i), mask);
+
+		lanes = _mm256_add_ps(lanes, _mm256_mul_ps(weight, values));
+	}
+
+	sum = laneSum(lanes);
+#endif
+
+#if defined(OQMC_ARCH_SSE)
+	constexpr auto stride = 4;
+
+	__m128 lanes = _mm_setzero_ps();
+
+	for(; i + stride <= size; i += stride)
+	{
+		std::int32_t selected[stride];
+		for(int j = 0; j < stride; ++j)
+		{
+			selected[j] = select(i + j) ? -1 : 0;
+		}
+
+		// SSE2 has no blend instruction, so the rows are combined with masks.
+		const __m128 mask = _mm_castsi128_ps(
+		    _mm_loadu_si128(reinterpret_cast<const __m128i*>(selected)));
+
+		const __m128 weight = _mm_loadu_ps(weights + i);
+		const __m128 values =
+		    _mm_or_ps(_mm_andnot_ps(mask, _mm_loadu_ps(rowA + i)),
+		              _mm_and_ps(mask, _mm_loadu_ps(rowB + i)));
+
+		lanes = _mm_add_ps(lanes, _mm_mul_ps(weight, values));
+	}
+
+	sum = laneSum(lanes);
+#endif
+
+#if defined(OQMC_ARCH_ARM)
+	constexpr auto stride = 4;
+
+	float32x4_t lanes = vdupq_n_f32(0);
+
+	for(; i + stride <= size; i += stride)
+	{
+		std::uint32_t selected[stride];
+		for(int j = 0; j < stride; ++j)
+		{
+			selected[j] = select(i + j) ? 0xffffffff : 0;
+		}
+
+		const uint32x4_t mask = vld1q_u32(selected);
+
+		const float32x4_t weight = vld1q_f32(weights + i);
+		const float32x4_t values =
+		    vbslq_f32(mask, vld1q_f32(rowB + i), vld1q_f32(rowA + i));
+
+		lanes = vmlaq_f32(lanes, weight, values);
+	}
+
+	sum = laneSum(lanes);
+#endif
+
+	for(; i < size; ++i)
+	{
+		sum += weights[i] * (select(i) ? rowB[i] : rowA[i]);
+	}
+
+	return sum;
+}
@@ -10,14 +10,31 @@
 #include <oqmc/pmj.h>
 #include <oqmc/sobol.h>
 
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
 #include <string>
 
 namespace
 {
 
-struct Buffer
+// Order of points within each sequence, either sample major (array of
+// structures) or dimension major (structure of arrays).
+enum class Layout
 {
+	Aos,
+	Soa,
+};
+
+// Range of flat sequence * nsamples + sample indices, and the buffer that
+// receives the points of that range.
+struct Chunk
+{
+	std::int64_t begin;
+	std::int64_t end;
 	float* points;
 	void* cache;
 };
@@ -33,23 +50,33 @@ OQMC_HOST_DEVICE int aosIndex(int indexId, int depthId, int ndims)
 }
 
 template <typename Sampler>
-OQMC_HOST_DEVICE void loop(int nsamples, int ndims, int seed, int index,
-                           int stride, Buffer buffer)
+OQMC_HOST_DEVICE void loop(int nsamples, int ndims, Layout layout, int index,
+                           int stride, Chunk chunk)
 {
-	for(int i = index; i < nsamples; i += stride)
+	const auto count = static_cast<int>(chunk.end - chunk.begin);
+
+	for(int i = index; i < count; i += stride)
 	{
-		auto domain = Sampler(0, 0, 0, i, buffer.cache);
+		const auto flat = chunk.begin + i;
+		const auto sequence = static_cast<int>(flat / nsamples);
+		const auto sample = static_cast<int>(flat % nsamples);
+
+		auto domain = Sampler(0, 0, 0, sample, chunk.cache);
 
 		for(int j = 0; j < ndims; j += 4)
 		{
-			domain = domain.newDomain(seed);
+			domain = domain.newDomain(sequence);
 
-			float sample[4];
-			domain.template drawSample<4>(sample);
+			float value[4];
+			domain.template drawSample<4>(value);
 
 			for(int k = 0; k < 4 && j + k < ndims; ++k)
 			{
-				buffer.points[soaIndex(i, j + k, nsamples)] = sample[k];
+				const auto dst = layout == Layout::Aos
+				                     ? aosIndex(i, j + k, ndims)
+				                     : soaIndex(i, j + k, count);
+
+				chunk.points[dst] = value[k];
 			}
 		}
 	}
@@ -57,73 +84,208 @@ OQMC_HOST_DEVICE void loop(int nsamples, int ndims, int seed, int index,
 
 #if defined(__CUDACC__)
 template <typename Sampler>
-__global__ void kernal(int nsamples, int ndims, int seed, Buffer buffer)
+__global__ void kernal(int nsamples, int ndims, Layout layout, Chunk chunk)
 {
 	const int index = blockIdx.x * blockDim.x + threadIdx.x;
 	const int stride = blockDim.x * gridDim.x;
 
-	loop<Sampler>(nsamples, ndims, seed, index, stride, buffer);
+	loop<Sampler>(nsamples, ndims, layout, index, stride, chunk);
 }
 #else
 template <typename Sampler>
-void kernal(int nsamples, int ndims, int seed, Buffer buffer)
+void kernal(int nsamples, int ndims, Layout layout, Chunk chunk)
 {
-	const int index = 0;
-	const int stride = 1;
-
-	loop<Sampler>(nsamples, ndims, seed, index, stride, buffer);
+	strided([=](int index, int stride) {
+		loop<Sampler>(nsamples, ndims, layout, index, stride, chunk);
+	});
 }
 #endif
 
-void transpose(int nsamples, int ndims, const float* in, float* out)
+// Generate all points one chunk at a time, so that memory use is bounded by the
+// chunk size rather than the size of the output. In the AoS layout a chunk can
+// span multiple sequences, in the SoA layout it ends at a sequence boundary so
+// that each dimension is a contiguous row.
+template <typename Sampler>
+bool stream(int nsequences, int nsamples, int ndims, Layout layout,
+            int nchunk, oqmc_generate_sink sink, void* user)
 {
-	for(int i = 0; i < nsamples; ++i)
+	const auto total = static_cast<std::int64_t>(nsequences) * nsamples;
+
+	Chunk chunk;
+	OQMC_ALLOCATE(&chunk.points, static_cast<std::size_t>(nchunk) * ndims);
+	OQMC_ALLOCATE(&chunk.cache, Sampler::cacheSize);
+
+	Sampler::initialiseCache(chunk.cache);
+
+	auto success = true;
+
+	for(std::int64_t begin = 0; begin < total && success;)
 	{
-		for(int j = 0; j < ndims; ++j)
-		{
-			const auto src = soaIndex(i, j, nsamples);
-			const auto dst = aosIndex(i, j, ndims);
+		auto end = std::min<std::int64_t>(begin + nchunk, total);
 
-			out[dst] = in[src];
+		if(layout == Layout::Soa)
+		{
+			const auto sequenceEnd = (begin / nsamples + 1) * nsamples;
+			end = std::min<std::int64_t>(end, sequenceEnd);
 		}
+
+		chunk.begin = begin;
+		chunk.end = end;
+
+		OQMC_LAUNCH(kernal<Sampler>, nsamples, ndims, layout, chunk);
+
+		success = sink(begin, end, chunk.points, user);
+		begin = end;
 	}
+
+	OQMC_FREE(chunk.points);
+	OQMC_FREE(chunk.cache);
+
+	return success;
 }
 
-template <typename Sampler>
-Buffer start(int nsequences, int nsamples, int ndims)
+bool parseLayout(const char* name, Layout* layout)
 {
-	Buffer ret;
-	OQMC_ALLOCATE(&ret.points, nsequences * nsamples * ndims);
-	OQMC_ALLOCATE(&ret.cache, Sampler::cacheSize);
+	if(std::string(name) == "aos")
+	{
+		*layout = Layout::Aos;
+		return true;
+	}
+
+	if(std::string(name) == "soa")
+	{
+		*layout = Layout::Soa;
+		return true;
+	}
 
-	return ret;
+	return false;
 }
 
-void stop(Buffer out)
+// Output of oqmc_generate, filled from AoS chunks.
+struct Copy
+{
+	float* out;
+	int ndims;
+};
+
+bool copySink(std::int64_t begin, std::int64_t end, const float* points,
+              void* user)
 {
-	OQMC_FREE(out.points);
-	OQMC_FREE(out.cache);
+	const auto copy = static_cast<Copy*>(user);
+	const auto count = static_cast<std::size_t>(end - begin) * copy->ndims;
+
+	std::memcpy(copy->out + begin * copy->ndims, points, sizeof(float) * count);
+
+	return true;
 }
 
-template <typename Sampler>
-void run(int nsequences, int nsamples, int ndims, float* out)
+// Output of oqmc_generate_file, where the data starts after a header.
+struct File
 {
-	auto buffer = start<Sampler>(nsequences, nsamples, ndims);
+	std::ofstream stream;
+	std::streamoff header;
+	int nsamples;
+	int ndims;
+	Layout layout;
+};
 
-	Sampler::initialiseCache(buffer.cache);
+bool fileSink(std::int64_t begin, std::int64_t end, const float* points,
+              void* user)
+{
+	const auto file = static_cast<File*>(user);
+	const auto count = end - begin;
+	const auto ndims = file->ndims;
+	auto& stream = file->stream;
 
-	for(int i = 0; i < nsequences; ++i)
+	if(file->layout == Layout::Aos)
 	{
-		const auto offset = nsamples * ndims * i;
+		const auto size = sizeof(float) * count * ndims;
+		stream.write(reinterpret_cast<const char*>(points), size);
+
+		return stream.good();
+	}
+
+	// Each dimension of the chunk is written to its row within the sequence.
+	const auto nsamples = file->nsamples;
+	const auto sequence = begin / nsamples;
+	const auto sample = begin % nsamples;
 
-		auto ibuffer = Buffer{buffer.points + offset, buffer.cache};
-		auto iout = out + offset;
+	for(int i = 0; i < ndims; ++i)
+	{
+		const auto row = (sequence * ndims + i) * nsamples + sample;
+		const auto offset = file->header + std::streamoff(sizeof(float) * row);
+		const auto size = sizeof(float) * count;
 
-		OQMC_LAUNCH(kernal<Sampler>, nsamples, ndims, i, ibuffer);
-		transpose(nsamples, ndims, ibuffer.points, iout);
+		stream.seekp(offset);
+		stream.write(reinterpret_cast<const char*>(points + i * count), size);
 	}
 
-	stop(buffer);
+	return stream.good();
+}
+
+// Write a version 1.0 NPY header for a float array of the given shape. The
+// header is padded so that the data that follows is 64 byte aligned.
+void writeNpyHeader(std::ofstream& stream, int a, int b, int c)
+{
+	const std::uint16_t probe = 1;
+	const auto little = *reinterpret_cast<const char*>(&probe) == 1;
+
+	auto dict = std::string("{'descr': '") + (little ? "<f4" : ">f4") +
+	            "', 'fortran_order': False, 'shape': (" + std::to_string(a) +
+	            ", " + std::to_string(b) + ", " + std::to_string(c) + "), }";
+
+	constexpr auto prefix = 10; // Magic string, version and header length.
+	constexpr auto alignment = 64;
+
+	const auto padding = alignment - (prefix + dict.size() + 1) % alignment;
+	dict.append(padding % alignment, ' ');
+	dict += '\n';
+
+	const auto length = static_cast<std::uint16_t>(dict.size());
+	const char version[] = {'\x01', '\x00'};
+	const char size[] = {static_cast<char>(length & 0xff),
+	                     static_cast<char>(length >> 8)};
+
+	stream.write("\x93NUMPY", 6);
+	stream.write(version, 2);
+	stream.write(size, 2);
+	stream.write(dict.data(), dict.size());
+}
+
+bool dispatch(const char* name, int nsequences, int nsamples, int ndims,
+              Layout layout, int nchunk, oqmc_generate_sink sink, void* user)
+{
+	// Default to chunks of around 4MiB.
+	if(nchunk <= 0)
+	{
+		nchunk = std::max((1 << 20) / std::max(ndims, 1), 1);
+	}
+
+	if(std::string(name) == "pmj")
+	{
+		return stream<oqmc::PmjSampler>(nsequences, nsamples, ndims, layout,
+		                                nchunk, sink, user);
+	}
+
+	if(std::string(name) == "sobol")
+	{
+		return stream<oqmc::SobolSampler>(nsequences, nsamples, ndims, layout,
+		                                  nchunk, sink, user);
+	}
+
+	if(std::string(name) == "lattice")
+	{
+		return stream<oqmc::LatticeSampler>(nsequences, nsamples, ndims,
+		                                    layout, nchunk, sink, user);
+	}
+
+	return false;
+}
+
+bool isSampler(const char* name)
+{
+	return std::string(name) == "pmj" || std::string(name) == "sobol" ||
+	       std::string(name) == "lattice";
 }
 
 } // namespace
@@ -137,23 +299,83 @@ OQMC_CABI bool oqmc_generate(const char* name, int nsequences, int nsamples,
 	assert(ndims >= 0);
 	assert(out);
 
-	if(std::string(name) == "pmj")
+	auto copy = Copy{out, ndims};
+
+	return dispatch(name, nsequences, nsamples, ndims, Layout::Aos, 0,
+	                copySink, &copy);
+}
+
+OQMC_CABI bool oqmc_generate_stream(const char* name, int nsequences,
+                                    int nsamples, int ndims,
+                                    const char* layout, int nchunk,
+                                    oqmc_generate_sink sink, void* user)
+{
+	assert(name);
+	assert(nsequences >= 0);
+	assert(nsamples >= 0);
+	assert(ndims >= 0);
+	assert(layout);
+	assert(sink);
+
+	Layout value;
+	if(!parseLayout(layout, &value))
 	{
-		run<oqmc::PmjSampler>(nsequences, nsamples, ndims, out);
-		return true;
+		return false;
 	}
 
-	if(std::string(name) == "sobol")
+	return dispatch(name, nsequences, nsamples, ndims, value, nchunk, sink,
+	                user);
+}
+
+OQMC_CABI bool oqmc_generate_file(const char* name, int nsequences,
+                                  int nsamples, int ndims, const char* layout,
+                                  const char* path)
+{
+	assert(name);
+	assert(nsequences >= 0);
+	assert(nsamples >= 0);
+	assert(ndims >= 0);
+	assert(layout);
+	assert(path);
+
+	Layout value;
+	if(!parseLayout(layout, &value) || !isSampler(name))
 	{
-		run<oqmc::SobolSampler>(nsequences, nsamples, ndims, out);
-		return true;
+		return false;
 	}
 
-	if(std::string(name) == "lattice")
+	File file;
+	file.stream.open(path, std::ios::binary);
+
+	if(!file.stream)
 	{
-		run<oqmc::LatticeSampler>(nsequences, nsamples, ndims, out);
-		return true;
+		return false;
 	}
 
-	return false;
+	file.nsamples = nsamples;
+	file.ndims = ndims;
+	file.layout = value;
+
+	// Files with an NPY extension can be loaded directly with numpy.load, or
+	// mapped with numpy.memmap. Any other extension is written as raw floats.
+	const auto ext = std::string(path);
+	const auto npy = ext.size() >= 4 && ext.substr(ext.size() - 4) == ".npy";
+
+	if(npy && value == Layout::Aos)
+	{
+		writeNpyHeader(file.stream, nsequences, nsamples, ndims);
+	}
+	else if(npy)
+	{
+		writeNpyHeader(file.stream, nsequences, ndims, nsamples);
+	}
+
+	file.header = file.stream.tellp();
+
+	const auto success = dispatch(name, nsequences, nsamples, ndims, value, 0,
+	                              fileSink, &file);
+
+	file.stream.close();
+
+	return success && !file.stream.fail();
 }
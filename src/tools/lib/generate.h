@@ -5,6 +5,28 @@
 
 #include "abi.h"
 
+#include <cstdint>
+
+// Receives chunks of points from oqmc_generate_stream in order. Points cover
+// the flat range [begin, end) of sequence * nsamples + sample indices. With the
+// 'aos' layout a chunk holds the dimensions of each sample together, and with
+// the 'soa' layout a chunk is within a single sequence, and holds a row for
+// each dimension. Return false to stop generating.
+// NOLINTNEXTLINE: C style naming
+typedef bool (*oqmc_generate_sink)(std::int64_t begin, std::int64_t end,
+                                   const float* points, void* user);
+
 // NOLINTNEXTLINE: C style naming
 OQMC_CABI bool oqmc_generate(const char* name, int nsequences, int nsamples,
                              int ndims, float* out);
+
+// NOLINTNEXTLINE: C style naming
+OQMC_CABI bool oqmc_generate_stream(const char* name, int nsequences,
+                                    int nsamples, int ndims,
+                                    const char* layout, int nchunk,
+                                    oqmc_generate_sink sink, void* user);
+
+// NOLINTNEXTLINE: C style naming
+OQMC_CABI bool oqmc_generate_file(const char* name, int nsequences,
+                                  int nsamples, int ndims, const char* layout,
+                                  const char* path);
@@ -9,11 +9,13 @@
 
 #include "../../shapes.h"
 #include "abi.h"
+#include "energy.h"
 #include "frequency.h"
 #include "parallel.h"
 #include "progress.h"
 #include "vector.h"
 
+#include <oqmc/cachefile.h>
 #include <oqmc/float.h>
 #include <oqmc/gpu.h>
 #include <oqmc/lookup.h>
@@ -27,17 +29,29 @@
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 namespace
 {
 
 constexpr auto transactionSize = 262144; // found to be good for an A6000 GPU.
+constexpr auto kernelWidth = 6; // pixels either side read by the energy terms.
+constexpr auto travelWidth = 8; // pixels a key can move from where it started.
+constexpr auto blockWidth = 8;  // pixels along each side of a block of swaps.
 
 OQMC_HOST_DEVICE bool isPowerOfTwo(int x)
 {
@@ -53,6 +67,19 @@ OQMC_HOST_DEVICE int bitMask(int powerOfTwo)
 	return powerOfTwo - 1;
 }
 
+OQMC_HOST_DEVICE int bitShift(int powerOfTwo)
+{
+	assert(isPowerOfTwo(powerOfTwo));
+
+	int shift = 0;
+	while((1 << shift) < powerOfTwo)
+	{
+		++shift;
+	}
+
+	return shift;
+}
+
 OQMC_HOST_DEVICE bool operator==(const int3& a, const int3& b)
 {
 	return a.x == b.x && a.y == b.y && a.z == b.z;
@@ -113,14 +140,100 @@ int3 Array3d::coordinate(int index) const
 	        index / (shape.x * shape.y)};
 }
 
-// Provides indexing services into a strictly lower triangular matrix.
-// Indexing maps to continious and memory compact space, where each element
-// can represent an edge in a fully connected graph of nodes. Number of nodes
-// are based on the number of elements in a given 3D grid. Using this type
-// the caller can allocate an array of appropriate capacity to hold all edges,
-// and index in and out of the array using XYZ coordinates pairs (grid node
-// indices).
-struct FullyConnectedGraph
+// Provides indexing services into a window of a toroidal 3D grid, centred on
+// a grid coordinate. The window reaches the same number of elements in both
+// directions along each axis, unless that would cover the whole axis, in
+// which case the window is the size of the axis. Using this type the caller
+// can test if two coordinates are near each other, and index in and out of
+// the neighbours of a coordinate.
+struct Window
+{
+	OQMC_HOST_DEVICE Window(int3 shape, int reach);
+	OQMC_HOST_DEVICE int size() const;
+	OQMC_HOST_DEVICE bool contains(int3 centre, int3 coordinate) const;
+	OQMC_HOST_DEVICE int index(int3 centre, int3 coordinate) const;
+	OQMC_HOST_DEVICE int3 coordinate(int3 centre, int index) const;
+
+	OQMC_HOST_DEVICE static int extent(int size, int reach);
+	OQMC_HOST_DEVICE static int offset(int size, int reach);
+
+	const int3 shape;
+	const int3 origin;
+	const Array3d array;
+};
+
+Window::Window(int3 shape, int reach)
+    : shape(shape),
+      origin({offset(shape.x, reach), offset(shape.y, reach),
+              offset(shape.z, reach)}),
+      array({extent(shape.x, reach), extent(shape.y, reach),
+             extent(shape.z, reach)})
+{
+	assert(isPowerOfTwo(shape.x));
+	assert(isPowerOfTwo(shape.y));
+	assert(isPowerOfTwo(shape.z));
+	assert(reach >= 0);
+}
+
+int Window::size() const
+{
+	return array.size();
+}
+
+bool Window::contains(int3 centre, int3 coordinate) const
+{
+	const int3 local = {
+	    (coordinate.x - centre.x + origin.x) & bitMask(shape.x),
+	    (coordinate.y - centre.y + origin.y) & bitMask(shape.y),
+	    (coordinate.z - centre.z + origin.z) & bitMask(shape.z),
+	};
+
+	return local.x < array.shape.x && local.y < array.shape.y &&
+	       local.z < array.shape.z;
+}
+
+int Window::index(int3 centre, int3 coordinate) const
+{
+	assert(contains(centre, coordinate));
+
+	return array.index({
+	    (coordinate.x - centre.x + origin.x) & bitMask(shape.x),
+	    (coordinate.y - centre.y + origin.y) & bitMask(shape.y),
+	    (coordinate.z - centre.z + origin.z) & bitMask(shape.z),
+	});
+}
+
+int3 Window::coordinate(int3 centre, int index) const
+{
+	const auto local = array.coordinate(index);
+
+	return {
+	    (centre.x + local.x - origin.x) & bitMask(shape.x),
+	    (centre.y + local.y - origin.y) & bitMask(shape.y),
+	    (centre.z + local.z - origin.z) & bitMask(shape.z),
+	};
+}
+
+int Window::extent(int size, int reach)
+{
+	return reach * 2 + 1 < size ? reach * 2 + 1 : size;
+}
+
+int Window::offset(int size, int reach)
+{
+	return reach * 2 + 1 < size ? reach : 0;
+}
+
+// Provides indexing services into the edges of a graph, where each node is an
+// element in a given 3D grid, connected to the nodes in a window around it.
+// Every edge is stored once for each of its nodes, so that all the edges of a
+// node are continious in memory, and memory grows linearly with the number of
+// nodes. When the window covers the whole grid the graph is fully connected,
+// and each edge is instead stored once in a strictly lower triangular matrix,
+// which halves the memory. Using this type the caller can allocate an array of
+// appropriate capacity to hold all edges, index into the array using pairs of
+// grid node indices, and out of the array using XYZ coordinate pairs.
+struct WindowedGraph
 {
 	struct CoordinatePair
 	{
@@ -128,104 +241,801 @@ struct FullyConnectedGraph
 		int3 b;
 	};
 
-	OQMC_HOST_DEVICE FullyConnectedGraph(int3 shape);
+	OQMC_HOST_DEVICE WindowedGraph(int3 shape, int reach);
 	OQMC_HOST_DEVICE long int size() const;
-	OQMC_HOST_DEVICE long int index(CoordinatePair coordinates) const;
+	OQMC_HOST_DEVICE long int index(int a, int b) const;
 	OQMC_HOST_DEVICE CoordinatePair coordinates(long int index) const;
 
 	const Array3d array;
+	const Window window;
+	const bool triangular;
+	const int shiftY;
+	const int shiftZ;
+};
+
+WindowedGraph::WindowedGraph(int3 shape, int reach)
+    : array(shape), window(shape, reach),
+      triangular(window.size() == array.size()), shiftY(bitShift(shape.x)),
+      shiftZ(bitShift(shape.x) + bitShift(shape.y))
+{
+}
+
+long int WindowedGraph::size() const
+{
+	if(triangular)
+	{
+		return static_cast<long int>(array.size()) * (array.size() - 1) / 2;
+	}
+
+	return static_cast<long int>(array.size()) * window.size();
+}
+
+// Grid sizes are powers of two, so node indices are split into coordinates
+// with shifts and masks, rather than the division of an Array3d.
+long int WindowedGraph::index(int a, int b) const
+{
+	assert(a != b);
+
+	if(triangular)
+	{
+		if(a > b)
+		{
+			swap(a, b);
+		}
+
+		return a + static_cast<long int>(b) * (b - 1) / 2;
+	}
+
+	const auto& shape = array.shape;
+
+	const int3 aCoordinate = {
+	    a & bitMask(shape.x),
+	    (a >> shiftY) & bitMask(shape.y),
+	    a >> shiftZ,
+	};
+
+	const int3 bCoordinate = {
+	    b & bitMask(shape.x),
+	    (b >> shiftY) & bitMask(shape.y),
+	    b >> shiftZ,
+	};
+
+	const long int node = a;
+	const long int edge = window.index(aCoordinate, bCoordinate);
+
+	return node * window.size() + edge;
+}
+
+WindowedGraph::CoordinatePair WindowedGraph::coordinates(long int index) const
+{
+	assert(index >= 0);
+	assert(index < size());
+
+	if(triangular)
+	{
+		const int integerTerm = std::sqrt(static_cast<double>(8 * index + 1));
+		const int b = (integerTerm + 1) / 2;
+		const int a = index - static_cast<long int>(b) * (b - 1) / 2;
+
+		return {array.coordinate(a), array.coordinate(b)};
+	}
+
+	const int node = index / window.size();
+	const int edge = index % window.size();
+
+	const auto coordinate = array.coordinate(node);
+
+	return {coordinate, window.coordinate(coordinate, edge)};
+}
+
+// Provides the taps of the energy kernel for a given 3D grid. Each tap is an
+// offset from a pixel to a neighbour in the same frame within the kernel width,
+// or to the pixel at the same XY coordinate in a frame within the kernel width
+// along Z, with a Gaussian weight of the distance. Offsets wrap toroidally, and
+// those that wrap back onto the pixel itself are skipped. Using this type the
+// caller can sum the weighted distances to all neighbours of a pixel without
+// computing the weights each time.
+struct Kernel
+{
+	static constexpr auto maxSize =
+	    (kernelWidth * 2 + 1) * (kernelWidth * 2 + 1) - 1 + kernelWidth * 2;
+
+	Kernel(int3 shape);
+	OQMC_HOST_DEVICE int size() const;
+	OQMC_HOST_DEVICE int3 coordinate(int3 centre, int tap) const;
+
+	int3 shape;
+	int count;
+	int offsetsX[maxSize];
+	int offsetsY[maxSize];
+	int offsetsZ[maxSize];
+	float weights[maxSize];
+};
+
+Kernel::Kernel(int3 shape) : shape(shape), count(0)
+{
+	assert(isPowerOfTwo(shape.x));
+	assert(isPowerOfTwo(shape.y));
+	assert(isPowerOfTwo(shape.z));
+
+	constexpr auto sigma = 2.1f;
+	constexpr auto sigmaSqr = sigma * sigma;
+	constexpr auto sigmaSqrRcp = 1 / sigmaSqr;
+	constexpr auto sigmaSqrRcpNeg = -sigmaSqrRcp;
+
+	constexpr auto width = kernelWidth;
+	constexpr auto min = -width;
+	constexpr auto max = +width;
+
+	const auto add = [&](int x, int y, int z, int distanceSqr) {
+		assert(count < maxSize);
+
+		offsetsX[count] = x;
+		offsetsY[count] = y;
+		offsetsZ[count] = z;
+		weights[count] = std::exp(distanceSqr * sigmaSqrRcpNeg);
+		++count;
+	};
+
+	for(int j = min; j < max + 1; ++j)
+	{
+		for(int i = min; i < max + 1; ++i)
+		{
+			if((i & bitMask(shape.x)) == 0 && (j & bitMask(shape.y)) == 0)
+			{
+				continue;
+			}
+
+			add(i, j, 0, i * i + j * j);
+		}
+	}
+
+	// Only pixels at the same XY coordinate are considered along Z, which is
+	// toroidal. Each pixel then has a blue noise sequence over time, while the
+	// spatial taps keep each slice blue noise in XY.
+	for(int k = 1; k < shape.z; ++k)
+	{
+		const auto wrap = shape.z - k;
+		const auto time = k < wrap ? k : wrap;
+
+		if(time > width)
+		{
+			continue;
+		}
+
+		add(0, 0, k, time * time);
+	}
+}
+
+int Kernel::size() const
+{
+	return count;
+}
+
+int3 Kernel::coordinate(int3 centre, int tap) const
+{
+	assert(tap >= 0);
+	assert(tap < size());
+
+	return {
+	    (centre.x + offsetsX[tap]) & bitMask(shape.x),
+	    (centre.y + offsetsY[tap]) & bitMask(shape.y),
+	    (centre.z + offsetsZ[tap]) & bitMask(shape.z),
+	};
+}
+
+// Provides indexing services into the edges of a graph, where each node is an
+// element in a given 3D grid, connected to the nodes at the taps of the energy
+// kernel. All the edges of a node are continious in memory and in the order of
+// the taps, so that the energy of a node reads them in sequence. Using this
+// type the caller can allocate an array of appropriate capacity to hold all
+// edges, and index in and out of the array using a coordinate and tap.
+struct KernelGraph
+{
+	KernelGraph(int3 shape);
+	OQMC_HOST_DEVICE long int size() const;
+	OQMC_HOST_DEVICE long int index(int3 coordinate, int tap) const;
+	OQMC_HOST_DEVICE WindowedGraph::CoordinatePair
+	coordinates(long int index) const;
+
+	const Array3d array;
+	const Kernel kernel;
 };
 
-FullyConnectedGraph::FullyConnectedGraph(int3 shape) : array(shape)
+KernelGraph::KernelGraph(int3 shape) : array(shape), kernel(shape)
 {
 }
 
-long int FullyConnectedGraph::size() const
+long int KernelGraph::size() const
 {
-	return static_cast<long int>(array.size()) * (array.size() - 1) / 2;
+	return static_cast<long int>(array.size()) * kernel.size();
 }
 
-long int FullyConnectedGraph::index(CoordinatePair coordinates) const
-{
-	int i = array.index(coordinates.a);
-	int j = array.index(coordinates.b);
+long int KernelGraph::index(int3 coordinate, int tap) const
+{
+	assert(tap >= 0);
+	assert(tap < kernel.size());
+
+	const long int node = array.index(coordinate);
+
+	return node * kernel.size() + tap;
+}
+
+WindowedGraph::CoordinatePair KernelGraph::coordinates(long int index) const
+{
+	assert(index >= 0);
+	assert(index < size());
+
+	const int node = index / kernel.size();
+	const int tap = index % kernel.size();
+
+	const auto coordinate = array.coordinate(node);
+
+	return {coordinate, kernel.coordinate(coordinate, tap)};
+}
+
+// Sum the weighted distances to the neighbours at each tap of a kernel, where
+// the distance of a tap is given by a function.
+template <typename Distance>
+OQMC_HOST_DEVICE float kernelSum(const Kernel& kernelFrame, Distance distance)
+{
+	return ::kernelSum(kernelFrame.size(), kernelFrame.weights, distance);
+}
+
+void initialiseIndices(Array3d pixelFrame, int* indices)
+{
+	for(int i = 0; i < pixelFrame.size(); ++i)
+	{
+		indices[i] = i;
+	}
+}
+
+void initialiseSwaps(Array3d pixelFrame, bool* swaps)
+{
+	for(int i = 0; i < pixelFrame.size(); ++i)
+	{
+		swaps[i] = false;
+	}
+}
+
+void initialisePermutations(int& seed, Array3d pixelFrame, int* permutations)
+{
+	auto state = oqmc::pcg::init(seed++);
+
+	for(int i = 0; i < pixelFrame.size(); ++i)
+	{
+		permutations[i] = i;
+	}
+
+	for(int i = 0; i < pixelFrame.size(); ++i)
+	{
+		swap(permutations[i],
+		     permutations[oqmc::uintToRange(oqmc::pcg::rng(state), i,
+		                                    pixelFrame.size())]);
+	}
+}
+
+void initialiseKeys(int& seed, Array3d pixelFrame, std::uint32_t* keys)
+{
+	auto state = oqmc::pcg::init(seed++);
+
+	for(int i = 0; i < pixelFrame.size(); ++i)
+	{
+		keys[i] = oqmc::pcg::rng(state);
+	}
+}
+
+void initialiseRanks(Array3d pixelFrame, std::uint32_t* ranks)
+{
+	for(int i = 0; i < pixelFrame.size(); ++i)
+	{
+		ranks[i] = 0;
+	}
+}
+
+// Initialise keys and ranks from the result of a table with half the spatial
+// resolution. Each coarse key is kept at a random one of the pixels that it
+// covers, and the other pixels are given new random keys. Each coarse rank is
+// copied to all of the pixels that it covers.
+void initialiseUpsample(int& seed, Array3d pixelFrame,
+                        const std::uint32_t* coarseKeys,
+                        const std::uint32_t* coarseRanks, std::uint32_t* keys,
+                        std::uint32_t* ranks)
+{
+	const auto coarseFrame = Array3d({
+	    pixelFrame.shape.x / 2,
+	    pixelFrame.shape.y / 2,
+	    pixelFrame.shape.z,
+	});
+
+	auto state = oqmc::pcg::init(seed++);
+
+	for(int i = 0; i < pixelFrame.size(); ++i)
+	{
+		keys[i] = oqmc::pcg::rng(state);
+	}
+
+	for(int i = 0; i < coarseFrame.size(); ++i)
+	{
+		const auto coordinate = coarseFrame.coordinate(i);
+		const auto child = oqmc::uintToRange(oqmc::pcg::rng(state), 0, 4);
+
+		for(int j = 0; j < 4; ++j)
+		{
+			const auto index = pixelFrame.index({
+			    coordinate.x * 2 + (j & 1),
+			    coordinate.y * 2 + (j >> 1),
+			    coordinate.z,
+			});
+
+			if(j == static_cast<int>(child))
+			{
+				keys[index] = coarseKeys[i];
+			}
+
+			ranks[index] = coarseRanks[i];
+		}
+	}
+}
+
+// Temperature schedule of an optimise loop. Swaps that raise the energy are
+// always accepted, and swaps that lower it are accepted with a probability that
+// falls with the loss of energy over the temperature. The temperature cools
+// geometrically from the start to the end over the loop, and is relative to the
+// mean energy of a pixel before the loop, so that it does not depend on the
+// sampler or the number of tests. A start temperature of zero only accepts
+// swaps that raise the energy.
+//
+// With more than one replica, each replica is a separate state at a temperature
+// that is a multiple of the last, and replicas at neighbouring temperatures
+// exchange states at an interval. The state at the coldest temperature is the
+// result.
+struct Schedule
+{
+	float start;
+	float end;
+	int nreplicas;
+};
+
+constexpr auto replicaRatio = 2.0f;   // ratio of neighbouring temperatures.
+constexpr auto exchangeInterval = 64; // iterations between replica exchanges.
+
+// Temperature of the coldest replica at an iteration of an optimise loop.
+float scheduleTemperature(Schedule schedule, int iteration, int niterations)
+{
+	if(schedule.start == 0)
+	{
+		return 0;
+	}
+
+	const auto time = static_cast<float>(iteration) / niterations;
+
+	return schedule.start * std::pow(schedule.end / schedule.start, time);
+}
+
+// Fill the temperature of each replica in units of the energy of a swap. Slots
+// hold the replica at each temperature from the coldest to the hottest. A swap
+// changes the energy of the pixels at both ends of each edge it changes, so the
+// total energy changes by twice the energy of a swap.
+void replicaTemperatures(Schedule schedule, int iteration, int niterations,
+                         double scale, const int* slots, float* temperatures)
+{
+	auto temperature = scheduleTemperature(schedule, iteration, niterations);
+
+	for(int i = 0; i < schedule.nreplicas; ++i)
+	{
+		temperatures[slots[i]] = temperature * scale / 2;
+		temperature *= replicaRatio;
+	}
+}
+
+// Whether to accept a swap that changes the energy from last to next. Swaps
+// that lower the energy pass the Metropolis test with a random number that is
+// hashed from a key, so that the result does not depend on the order in which
+// swaps are tested.
+OQMC_HOST_DEVICE bool accept(float last, float next, float temperature,
+                             std::uint32_t key)
+{
+	if(next > last)
+	{
+		return true;
+	}
+
+	if(temperature <= 0)
+	{
+		return false;
+	}
+
+	const auto random = oqmc::uintToFloat(oqmc::pcg::hash(key));
+
+	return random < std::exp((next - last) / temperature);
+}
+
+// Exchange the states of replicas at neighbouring temperatures, by exchanging
+// their slots, with the probability that keeps the states at each temperature
+// in balance. Exchanges alternate between pairs that start at even and odd
+// slots, so that each pair is independent.
+void exchangeReplicas(Schedule schedule, int iteration, int niterations,
+                      int exchange, double scale, const double* totals,
+                      std::uint32_t& state, int* slots)
+{
+	auto colder = scheduleTemperature(schedule, iteration, niterations);
+	colder *= std::pow(replicaRatio, exchange & 1);
+
+	for(int i = exchange & 1; i + 1 < schedule.nreplicas; i += 2)
+	{
+		const auto hotter = colder * replicaRatio;
+
+		const auto gain = totals[slots[i + 1]] - totals[slots[i]];
+		const auto delta = gain * (1 / colder - 1 / hotter) / scale;
+		const auto random = oqmc::uintToFloat(oqmc::pcg::rng(state));
+
+		if(delta >= 0 || random < std::exp(delta))
+		{
+			swap(slots[i], slots[i + 1]);
+		}
+
+		colder *= replicaRatio * replicaRatio;
+	}
+}
+
+void initialiseSlots(Schedule schedule, int* slots)
+{
+	for(int i = 0; i < schedule.nreplicas; ++i)
+	{
+		slots[i] = i;
+	}
+}
+
+// Stage of a level that the optimiser is working on.
+enum class Stage
+{
+	Keys,
+	Ranks,
+};
+
+constexpr std::uint32_t checkpointMagic = 0x50434f51; // characters 'QOCP'.
+constexpr std::uint32_t checkpointVersion = 3;
+
+// Header at the start of a checkpoint file. It holds the parameters of the run,
+// which must match when resuming, and the position in the run. The header is
+// followed by the keys and ranks of the current level, the permutations of the
+// current stage, then the indices of the keys stage, or the swaps of the ranks
+// stage, for each replica, and then the slots of the replicas. Values are
+// stored in the byte order of the machine. The checksum covers the whole file,
+// including the header with the checksum itself set to zero.
+struct CheckpointHeader
+{
+	std::uint32_t magic;
+	std::uint32_t version;
+	std::uint32_t checksum;
+	std::uint32_t state;
+	char name[16];
+	std::int32_t ntests;
+	std::int32_t niterations;
+	std::int32_t nsamples;
+	std::int32_t resolution;
+	std::int32_t depth;
+	std::int32_t nlevels;
+	std::int32_t seed;
+	std::int32_t level;
+	std::int32_t stage;
+	std::int32_t count;
+	std::int32_t iteration;
+	std::int32_t counter;
+	std::int32_t npixels;
+	std::int32_t npermutations;
+	float start;
+	float end;
+	std::int32_t nreplicas;
+	std::uint32_t reserved[3];
+};
+
+static_assert(sizeof(CheckpointHeader) == 112, "Header must be 112 bytes.");
+
+// State of a run that is written to a checkpoint file at an interval, so that
+// a run that is interrupted can continue from the last checkpoint and produce
+// the same result. Arrays point to the memory of the current level and stage,
+// and are set as that memory is allocated. When resuming, the arrays that are
+// read from file are held until they are restored at the same position.
+struct Checkpoint
+{
+	const char* path;
+	int interval;
+	bool resume;
+	std::chrono::steady_clock::time_point last;
+	CheckpointHeader header;
+
+	const std::uint32_t* keys;
+	const std::uint32_t* ranks;
+	const int* permutations;
+	const int* indices;
+	const bool* swaps;
+	const int* slots;
+
+	std::vector<std::uint32_t> savedKeys;
+	std::vector<std::uint32_t> savedRanks;
+	std::vector<int> savedPermutations;
+	std::vector<int> savedIndices;
+	std::vector<bool> savedSwaps;
+	std::vector<int> savedSlots;
+};
+
+// Whether a run is resuming from a checkpoint that was written in a stage.
+bool resumes(const Checkpoint& checkpoint, Stage stage)
+{
+	return checkpoint.resume &&
+	       checkpoint.header.stage == static_cast<int>(stage);
+}
+
+// Checksum of a checkpoint file, given the header and the data that follows it
+// in a single buffer. The checksum field of the header is read as zero, and is
+// restored before returning.
+std::uint32_t checkpointChecksum(std::vector<char>& file)
+{
+	const auto field = file.data() + offsetof(CheckpointHeader, checksum);
+
+	std::uint32_t stored;
+	std::memcpy(&stored, field, sizeof(stored));
+	std::memset(field, 0, sizeof(stored));
+
+	const auto checksum = oqmc::cacheChecksum(file.data(), file.size());
+	std::memcpy(field, &stored, sizeof(stored));
+
+	return checksum;
+}
+
+// Flush a file that was written, and ask the system to write it to the disk,
+// so that the contents are in place before the file is renamed.
+bool syncFile(std::FILE* stream)
+{
+	if(std::fflush(stream) != 0)
+	{
+		return false;
+	}
+
+#if defined(_WIN32)
+	return _commit(_fileno(stream)) == 0;
+#else
+	return fsync(fileno(stream)) == 0;
+#endif
+}
+
+// Write the position and arrays of a run to the checkpoint file. The file is
+// first written in full to a temporary file and synced to disk, which is then
+// renamed over the previous checkpoint, so that an interruption at any point
+// leaves a complete checkpoint file in place.
+bool writeCheckpoint(Checkpoint& checkpoint)
+{
+	auto& header = checkpoint.header;
+
+	// The header is written last, once the checksum is known.
+	std::vector<char> payload(sizeof(header));
+	const auto append = [&](const void* data, std::size_t size) {
+		const auto bytes = static_cast<const char*>(data);
+		payload.insert(payload.end(), bytes, bytes + size);
+	};
+
+	const auto npixels = static_cast<std::size_t>(header.npixels);
+	const auto nstates = npixels * header.nreplicas;
+	append(checkpoint.keys, sizeof(std::uint32_t) * npixels);
+	append(checkpoint.ranks, sizeof(std::uint32_t) * npixels);
+	append(checkpoint.permutations, sizeof(int) * header.npermutations);
+
+	if(header.stage == static_cast<int>(Stage::Keys))
+	{
+		append(checkpoint.indices, sizeof(int) * nstates);
+	}
+	else
+	{
+		for(std::size_t i = 0; i < nstates; ++i)
+		{
+			payload.push_back(checkpoint.swaps[i]);
+		}
+	}
+
+	append(checkpoint.slots, sizeof(int) * header.nreplicas);
+
+	std::memcpy(payload.data(), &header, sizeof(header));
+	header.checksum = checkpointChecksum(payload);
+	std::memcpy(payload.data(), &header, sizeof(header));
+
+	const auto temporary = std::string(checkpoint.path) + ".tmp";
+
+	auto success = false;
+	if(auto stream = std::fopen(temporary.c_str(), "wb"))
+	{
+		success = std::fwrite(payload.data(), 1, payload.size(), stream) ==
+		          payload.size();
+		success = success && syncFile(stream);
+		success = std::fclose(stream) == 0 && success;
+	}
+
+	if(!success)
+	{
+		std::remove(temporary.c_str());
+		return false;
+	}
+
+	// Renaming over an existing file is atomic on POSIX systems. Other systems
+	// may fail to rename over an existing file, so it is removed first.
+	if(std::rename(temporary.c_str(), checkpoint.path) != 0)
+	{
+		std::remove(checkpoint.path);
+		return std::rename(temporary.c_str(), checkpoint.path) == 0;
+	}
+
+	return true;
+}
+
+// Read the position and arrays of a run from the checkpoint file, and check
+// that the file is complete and was written by a run with the same parameters.
+// The position must also be consistent with the parameters, so that the arrays
+// match the size of the level and stage that they are restored to.
+bool readCheckpoint(Checkpoint& checkpoint, const CheckpointHeader& expected)
+{
+	auto stream = std::fopen(checkpoint.path, "rb");
+
+	if(!stream)
+	{
+		return false;
+	}
+
+	auto& header = checkpoint.header;
+	auto success = std::fread(&header, sizeof(header), 1, stream) == 1;
+
+	success = success && header.magic == checkpointMagic &&
+	          header.version == checkpointVersion &&
+	          std::strncmp(header.name, expected.name, sizeof(header.name)) ==
+	              0 &&
+	          header.ntests == expected.ntests &&
+	          header.niterations == expected.niterations &&
+	          header.nsamples == expected.nsamples &&
+	          header.resolution == expected.resolution &&
+	          header.depth == expected.depth &&
+	          header.nlevels == expected.nlevels &&
+	          header.seed == expected.seed &&
+	          header.start == expected.start && header.end == expected.end &&
+	          header.nreplicas == expected.nreplicas;
+
+	const auto keysStage = header.stage == static_cast<int>(Stage::Keys);
+	const auto ranksStage = header.stage == static_cast<int>(Stage::Ranks);
+
+	if(success)
+	{
+		success = header.level >= 0 && header.level < header.nlevels &&
+		          (keysStage || ranksStage);
+	}
+
+	if(success)
+	{
+		const auto levelResolution = header.resolution >> header.level;
+		const auto levelBlock = std::min(blockWidth, levelResolution);
+		const auto levelDepth = std::min(blockWidth, header.depth);
+
+		const auto npixels = levelResolution * levelResolution * header.depth;
+		const auto npermutations =
+		    keysStage ? levelBlock * levelBlock * levelDepth : npixels;
+
+		success = header.npixels == npixels &&
+		          header.npermutations == npermutations;
+	}
+
+	std::vector<char> file;
+	if(success)
+	{
+		const auto npixels = static_cast<std::size_t>(header.npixels);
+		const auto nstates = npixels * header.nreplicas;
+		const auto nstage =
+		    keysStage ? sizeof(int) * nstates : sizeof(char) * nstates;
+
+		file.resize(sizeof(header) + sizeof(std::uint32_t) * npixels * 2 +
+		            sizeof(int) * header.npermutations + nstage +
+		            sizeof(int) * header.nreplicas);
+
+		std::memcpy(file.data(), &header, sizeof(header));
 
-	assert(i != j);
+		const auto payload = file.size() - sizeof(header);
 
-	if(i > j)
-	{
-		swap(i, j);
+		success = std::fread(file.data() + sizeof(header), 1, payload,
+		                     stream) == payload &&
+		          std::fgetc(stream) == EOF &&
+		          checkpointChecksum(file) == header.checksum;
 	}
 
-	assert(i < j);
-
-	return i + FullyConnectedGraph({j, 1, 1}).size();
-}
+	std::fclose(stream);
 
-FullyConnectedGraph::CoordinatePair
-FullyConnectedGraph::coordinates(long int index) const
-{
-	assert(index >= 0);
-	assert(index < size());
+	if(!success)
+	{
+		return false;
+	}
 
-	const int integerTerm = std::sqrt(static_cast<double>(8 * index + 1)) + 1;
-	const int subGraphSize = integerTerm / 2;
+	const auto npixels = static_cast<std::size_t>(header.npixels);
+	const auto nstates = npixels * header.nreplicas;
+	auto offset = file.data() + sizeof(header);
+	const auto extract = [&](void* data, std::size_t size) {
+		std::memcpy(data, offset, size);
+		offset += size;
+	};
 
-	const int i = index - FullyConnectedGraph({subGraphSize, 1, 1}).size();
-	const int j = subGraphSize;
+	checkpoint.savedKeys.resize(npixels);
+	checkpoint.savedRanks.resize(npixels);
+	checkpoint.savedPermutations.resize(header.npermutations);
 
-	return {array.coordinate(i), array.coordinate(j)};
-}
+	extract(checkpoint.savedKeys.data(), sizeof(std::uint32_t) * npixels);
+	extract(checkpoint.savedRanks.data(), sizeof(std::uint32_t) * npixels);
+	extract(checkpoint.savedPermutations.data(),
+	        sizeof(int) * header.npermutations);
 
-void initialiseIndices(Array3d pixelFrame, int* indices)
-{
-	for(int i = 0; i < pixelFrame.size(); ++i)
+	if(keysStage)
 	{
-		indices[i] = i;
+		checkpoint.savedIndices.resize(nstates);
+		extract(checkpoint.savedIndices.data(), sizeof(int) * nstates);
 	}
-}
-
-void initialiseSwaps(Array3d pixelFrame, bool* swaps)
-{
-	for(int i = 0; i < pixelFrame.size(); ++i)
+	else
 	{
-		swaps[i] = false;
+		checkpoint.savedSwaps.resize(nstates);
+		for(std::size_t i = 0; i < nstates; ++i)
+		{
+			checkpoint.savedSwaps[i] = offset[i] != 0;
+		}
+
+		offset += nstates;
 	}
+
+	checkpoint.savedSlots.resize(header.nreplicas);
+	extract(checkpoint.savedSlots.data(), sizeof(int) * header.nreplicas);
+
+	return true;
 }
 
-void initialisePermutations(int& seed, Array3d pixelFrame, int* permutations)
+// Record the position of an optimise loop after an iteration, and write a
+// checkpoint if the interval has passed since the last one.
+void updateCheckpoint(Checkpoint& checkpoint, int iteration, int seed,
+                      std::uint32_t state)
 {
-	auto state = oqmc::pcg::init(seed++);
-
-	for(int i = 0; i < pixelFrame.size(); ++i)
+	if(!checkpoint.path)
 	{
-		permutations[i] = i;
+		return;
 	}
 
-	for(int i = 0; i < pixelFrame.size(); ++i)
+	const auto now = std::chrono::steady_clock::now();
+	const auto elapsed = now - checkpoint.last;
+
+	if(elapsed < std::chrono::seconds(checkpoint.interval))
 	{
-		swap(permutations[i],
-		     permutations[oqmc::uintToRange(oqmc::pcg::rng(state), i,
-		                                    pixelFrame.size())]);
+		return;
 	}
-}
 
-void initialiseKeys(int& seed, Array3d pixelFrame, std::uint32_t* keys)
-{
-	auto state = oqmc::pcg::init(seed++);
+	checkpoint.header.iteration = iteration;
+	checkpoint.header.counter = seed;
+	checkpoint.header.state = state;
+	checkpoint.last = now;
 
-	for(int i = 0; i < pixelFrame.size(); ++i)
+	if(!writeCheckpoint(checkpoint))
 	{
-		keys[i] = oqmc::pcg::rng(state);
+		fprintf(stderr, "\nCheckpoint file '%s' could not be written.\n",
+		        checkpoint.path);
 	}
 }
 
-void initialiseRanks(Array3d pixelFrame, std::uint32_t* ranks)
+// Start an optimise loop, either from the beginning with a new PRNG state, or
+// from the position that was read from a checkpoint file.
+int startCheckpoint(Checkpoint& checkpoint, int& seed, std::uint32_t& state)
 {
-	for(int i = 0; i < pixelFrame.size(); ++i)
+	if(checkpoint.resume)
 	{
-		ranks[i] = 0;
+		checkpoint.resume = false;
+
+		seed = checkpoint.header.counter;
+		state = checkpoint.header.state;
+
+		return checkpoint.header.iteration;
 	}
+
+	state = oqmc::pcg::init(seed++);
+
+	return 0;
 }
 
 template <typename Sampler, typename Shape>
@@ -386,7 +1196,7 @@ OQMC_HOST_DEVICE float squaredDistance(int offsetA, int offsetB, int3 size,
 }
 
 void initialiseDistances(Array3d pixelFrame, Array3d errorFrame,
-                         FullyConnectedGraph graphFrame, const float* errors,
+                         WindowedGraph graphFrame, const float* errors,
                          float* distances)
 {
 	auto start = oqmc_progress_start("Computing distances:", graphFrame.size());
@@ -418,7 +1228,7 @@ void initialiseDistances(Array3d pixelFrame, Array3d errorFrame,
 
 template <bool CrossErrors>
 void initialiseDistances(Array3d pixelFrame, Array3d errorFrame,
-                         FullyConnectedGraph graphFrame,
+                         const KernelGraph& graphFrame,
                          const float* errorsHold, const float* errorsSwap,
                          float* distances)
 {
@@ -472,297 +1282,546 @@ void initialiseDistances(Array3d pixelFrame, Array3d errorFrame,
 	oqmc_progress_end();
 }
 
+// Note that distances are indexed by the pixels that keys started at, and the
+// distances are already squared.
 template <bool SwapPixels>
-OQMC_HOST_DEVICE float
-keysEnergySpatial(Array3d pixelFrame, FullyConnectedGraph graphFrame,
-                  int3 pCoordinate, int3 swapCoordinate, const int* indicesA,
-                  const float* distances)
+OQMC_HOST_DEVICE float keysEnergy(Array3d pixelFrame, WindowedGraph graphFrame,
+                                  const Kernel& kernelFrame, int3 pCoordinate,
+                                  int3 swapCoordinate, const int* indicesA,
+                                  const float* distances)
 {
-	constexpr auto sigma = 2.1f;
-	constexpr auto sigmaSqr = sigma * sigma;
-	constexpr auto sigmaSqrRcp = 1 / sigmaSqr;
-	constexpr auto sigmaSqrRcpNeg = -sigmaSqrRcp;
+	int pIndex;
+	if(SwapPixels)
+	{
+		pIndex = indicesA[pixelFrame.index(swapCoordinate)];
+	}
+	else
+	{
+		pIndex = indicesA[pixelFrame.index(pCoordinate)];
+	}
 
-	constexpr auto width = 6;
-	constexpr auto min = -width;
-	constexpr auto max = +width;
+	return kernelSum(kernelFrame, [&](int tap) {
+		const auto qCoordinate = kernelFrame.coordinate(pCoordinate, tap);
 
-	auto sum = 0.0f;
-	for(int j = min; j < max + 1; ++j)
-	{
-		for(int i = min; i < max + 1; ++i)
+		int qIndex;
+		if(SwapPixels && qCoordinate == swapCoordinate)
 		{
-			const int3 qCoordinate = {
-			    (pCoordinate.x + i) & bitMask(pixelFrame.shape.x),
-			    (pCoordinate.y + j) & bitMask(pixelFrame.shape.y),
-			    pCoordinate.z,
-			};
+			qIndex = indicesA[pixelFrame.index(pCoordinate)];
+		}
+		else
+		{
+			qIndex = indicesA[pixelFrame.index(qCoordinate)];
+		}
 
-			if(pCoordinate == qCoordinate)
-			{
-				continue;
-			}
+		return distances[graphFrame.index(pIndex, qIndex)];
+	});
+}
 
-			int pIndex;
-			int qIndex;
-			if(SwapPixels)
-			{
-				if(qCoordinate == swapCoordinate)
-				{
-					pIndex = indicesA[pixelFrame.index(swapCoordinate)];
-					qIndex = indicesA[pixelFrame.index(pCoordinate)];
-				}
-				else
-				{
-					pIndex = indicesA[pixelFrame.index(swapCoordinate)];
-					qIndex = indicesA[pixelFrame.index(qCoordinate)];
-				}
-			}
-			else
-			{
-				pIndex = indicesA[pixelFrame.index(pCoordinate)];
-				qIndex = indicesA[pixelFrame.index(qCoordinate)];
-			}
+// Sum the energy of every pixel for each replica.
+void keysTotals(int nreplicas, Array3d pixelFrame, WindowedGraph graphFrame,
+                const Kernel& kernelFrame, const int* indices,
+                const float* distances, float* energies, double* totals)
+{
+	const auto npixels = pixelFrame.size();
+
+	const auto func = [=] OQMC_HOST_DEVICE(std::size_t idx) {
+		const auto replica = idx / npixels;
+		const auto coordinate = pixelFrame.coordinate(idx % npixels);
+
+		energies[idx] =
+		    keysEnergy<false>(pixelFrame, graphFrame, kernelFrame, coordinate,
+		                      coordinate, indices + replica * npixels,
+		                      distances);
+	};
 
-			const FullyConnectedGraph::CoordinatePair pair = {
-			    pixelFrame.coordinate(pIndex),
-			    pixelFrame.coordinate(qIndex),
-			};
+	const auto begin = 0;
+	const auto end = npixels * nreplicas;
 
-			// Note that distances are already squared.
-			const auto sampleDistance = distances[graphFrame.index(pair)];
-			const auto pixelDistance =
-			    std::exp((i * i + j * j) * sigmaSqrRcpNeg);
+	OQMC_FORLOOP(func, begin, end);
 
-			sum += sampleDistance * pixelDistance;
+	for(int i = 0; i < nreplicas; ++i)
+	{
+		totals[i] = 0;
+
+		for(int j = 0; j < npixels; ++j)
+		{
+			totals[i] += energies[i * npixels + j];
 		}
 	}
-
-	return sum;
 }
 
-template <bool SwapPixels>
-OQMC_HOST_DEVICE float
-keysEnergy(Array3d pixelFrame, FullyConnectedGraph graphFrame, int3 pCoordinate,
-           int3 swapCoordinate, const int* indicesA, const float* distances)
+// Map the index of a pixel within a block to an index in the pixel frame. The
+// block is given as a coordinate in a grid of blocks, which is shifted by an
+// offset and wraps toroidally.
+OQMC_HOST_DEVICE int blockIndex(Array3d pixelFrame, Array3d blockFrame,
+                                int3 block, int3 shift, int index)
 {
-	return keysEnergySpatial<SwapPixels>(pixelFrame, graphFrame, pCoordinate,
-	                                     swapCoordinate, indicesA, distances);
+	const auto local = blockFrame.coordinate(index);
+
+	return pixelFrame.index({
+	    (block.x * blockFrame.shape.x + local.x + shift.x) &
+	        bitMask(pixelFrame.shape.x),
+	    (block.y * blockFrame.shape.y + local.y + shift.y) &
+	        bitMask(pixelFrame.shape.y),
+	    (block.z * blockFrame.shape.z + local.z + shift.z) &
+	        bitMask(pixelFrame.shape.z),
+	});
 }
 
-void keysOptimise(int niterations, int& seed, Array3d pixelFrame,
-                  FullyConnectedGraph graphFrame, const int* permutations,
+// Keys are only swapped between pixels in the same block, and never further
+// than the travel width from the pixel they started at. This bounds the
+// distance between the starting pixels of any two neighbouring keys, so that
+// the graph only needs to hold edges for a window around each pixel. Indices
+// and slots hold the state of each replica.
+void keysOptimise(int niterations, int& seed, Schedule schedule,
+                  Array3d pixelFrame, Array3d blockFrame,
+                  WindowedGraph graphFrame, const Kernel& kernelFrame,
+                  const int* permutations,
                   const float* distances, int* indicesA, int* indicesB,
-                  std::uint32_t* keys)
+                  int* slots, Checkpoint& checkpoint)
 {
+	const auto gridFrame = Array3d({
+	    pixelFrame.shape.x / blockFrame.shape.x,
+	    pixelFrame.shape.y / blockFrame.shape.y,
+	    pixelFrame.shape.z / blockFrame.shape.z,
+	});
+
+	const auto travelFrame = Window(pixelFrame.shape, travelWidth);
+	const auto blockPairs = blockFrame.size() / 2 /*pairs*/ / 4 /*quarter*/;
+	const auto replicaPairs = gridFrame.size() * blockPairs;
+	const auto npixels = pixelFrame.size();
+	const auto annealing = schedule.start > 0;
+
+	float* temperatures;
+	OQMC_ALLOCATE(&temperatures, schedule.nreplicas);
+
+	float* energies;
+	OQMC_ALLOCATE(&energies, npixels * schedule.nreplicas);
+
+	std::vector<double> totals(schedule.nreplicas);
+
+	// Temperatures are relative to the mean energy of a pixel before any keys
+	// have moved, which is the same when resuming.
+	auto scale = 0.0;
+	if(annealing)
+	{
+		int* identity;
+		OQMC_ALLOCATE(&identity, npixels);
+
+		initialiseIndices(pixelFrame, identity);
+		keysTotals(1, pixelFrame, graphFrame, kernelFrame, identity, distances,
+		           energies, totals.data());
+		scale = totals[0] / npixels;
+
+		OQMC_FREE(identity);
+	}
+
+	std::uint32_t state;
+	const auto first = startCheckpoint(checkpoint, seed, state);
+
 	auto start = oqmc_progress_start("Optimising keys:", niterations);
-	auto state = oqmc::pcg::init(seed++);
 
-	for(int i = 0; i < niterations; ++i)
+	for(int i = first; i < niterations; ++i)
 	{
-		const auto rnd = oqmc::pcg::rng(state) & bitMask(pixelFrame.size());
+		const auto rnd = oqmc::pcg::rng(state) & bitMask(blockFrame.size());
+
+		// Blocks are shifted by a random amount each iteration, so that keys
+		// can move across block boundaries.
+		const int3 shift = {
+		    static_cast<int>(oqmc::pcg::rng(state)) &
+		        bitMask(blockFrame.shape.x),
+		    static_cast<int>(oqmc::pcg::rng(state)) &
+		        bitMask(blockFrame.shape.y),
+		    static_cast<int>(oqmc::pcg::rng(state)) &
+		        bitMask(blockFrame.shape.z),
+		};
+
+		const auto anneal = annealing ? oqmc::pcg::rng(state) : 0;
+
+		replicaTemperatures(schedule, i, niterations, scale, slots,
+		                    temperatures);
 
 		const auto func = [=] OQMC_HOST_DEVICE(std::size_t idx) {
-			const auto aIndex = permutations[idx * 2 + 0] ^ rnd;
-			const auto bIndex = permutations[idx * 2 + 1] ^ rnd;
+			const auto replica = idx / replicaPairs;
+			const auto block =
+			    gridFrame.coordinate(idx % replicaPairs / blockPairs);
+			const auto pair = idx % blockPairs;
+
+			const auto replicaA = indicesA + replica * npixels;
+			const auto replicaB = indicesB + replica * npixels;
+
+			const auto aIndex =
+			    blockIndex(pixelFrame, blockFrame, block, shift,
+			               permutations[pair * 2 + 0] ^ rnd);
+			const auto bIndex =
+			    blockIndex(pixelFrame, blockFrame, block, shift,
+			               permutations[pair * 2 + 1] ^ rnd);
 			const auto aCoordinate = pixelFrame.coordinate(aIndex);
 			const auto bCoordinate = pixelFrame.coordinate(bIndex);
 
+			const auto aOrigin = pixelFrame.coordinate(replicaA[aIndex]);
+			const auto bOrigin = pixelFrame.coordinate(replicaA[bIndex]);
+
+			if(!travelFrame.contains(aOrigin, bCoordinate) ||
+			   !travelFrame.contains(bOrigin, aCoordinate))
+			{
+				return;
+			}
+
 			const auto last =
-			    keysEnergy<false>(pixelFrame, graphFrame, aCoordinate,
-			                      bCoordinate, indicesA, distances) +
-			    keysEnergy<false>(pixelFrame, graphFrame, bCoordinate,
-			                      aCoordinate, indicesA, distances);
+			    keysEnergy<false>(pixelFrame, graphFrame, kernelFrame,
+			                      aCoordinate, bCoordinate, replicaA,
+			                      distances) +
+			    keysEnergy<false>(pixelFrame, graphFrame, kernelFrame,
+			                      bCoordinate, aCoordinate, replicaA,
+			                      distances);
 
 			const auto next =
-			    keysEnergy<true>(pixelFrame, graphFrame, aCoordinate,
-			                     bCoordinate, indicesA, distances) +
-			    keysEnergy<true>(pixelFrame, graphFrame, bCoordinate,
-			                     aCoordinate, indicesA, distances);
-
-			if(next > last)
+			    keysEnergy<true>(pixelFrame, graphFrame, kernelFrame,
+			                     aCoordinate, bCoordinate, replicaA,
+			                     distances) +
+			    keysEnergy<true>(pixelFrame, graphFrame, kernelFrame,
+			                     bCoordinate, aCoordinate, replicaA,
+			                     distances);
+
+			if(accept(last, next, temperatures[replica], anneal + idx))
 			{
-				swap(indicesB[aIndex], indicesB[bIndex]);
-				swap(keys[aIndex], keys[bIndex]);
+				swap(replicaB[aIndex], replicaB[bIndex]);
 			}
 		};
 
 		const auto begin = 0;
-		const auto end = pixelFrame.size() / 2 /*pairs*/ / 4 /*quarter image*/;
+		const auto end = replicaPairs * schedule.nreplicas;
 
 		OQMC_FORLOOP(func, begin, end);
-		OQMC_MEMCPY(indicesA, indicesB, sizeof(int) * pixelFrame.size());
+		OQMC_MEMCPY(indicesA, indicesB,
+		            sizeof(int) * npixels * schedule.nreplicas);
+
+		if(schedule.nreplicas > 1 && (i + 1) % exchangeInterval == 0)
+		{
+			keysTotals(schedule.nreplicas, pixelFrame, graphFrame, kernelFrame,
+			           indicesA, distances, energies, totals.data());
+			exchangeReplicas(schedule, i, niterations,
+			                 (i + 1) / exchangeInterval, scale, totals.data(),
+			                 state, slots);
+		}
+
+		updateCheckpoint(checkpoint, i + 1, seed, state);
 
 		oqmc_progress_add("Optimising keys:", niterations, i + 1, start);
 	}
 
 	oqmc_progress_end();
+
+	OQMC_FREE(temperatures);
+	OQMC_FREE(energies);
 }
 
 template <typename Sampler>
 void keysRun(int niterations, int nsamples, int& seed, const void* cache,
-             Array3d pixelFrame, Array3d errorFrame,
-             FullyConnectedGraph graphFrame, std::uint32_t* keys)
+             Schedule schedule, Array3d pixelFrame, Array3d errorFrame,
+             WindowedGraph graphFrame, std::uint32_t* keys,
+             Checkpoint& checkpoint)
 {
+	const auto blockFrame = Array3d({
+	    std::min(blockWidth, pixelFrame.shape.x),
+	    std::min(blockWidth, pixelFrame.shape.y),
+	    std::min(blockWidth, pixelFrame.shape.z),
+	});
+
+	const auto npixels = pixelFrame.size();
+	const auto nstates = npixels * schedule.nreplicas;
+
 	int* indicesA;
-	OQMC_ALLOCATE(&indicesA, pixelFrame.size());
+	OQMC_ALLOCATE(&indicesA, nstates);
 
 	int* indicesB;
-	OQMC_ALLOCATE(&indicesB, pixelFrame.size());
+	OQMC_ALLOCATE(&indicesB, nstates);
+
+	int* slots;
+	OQMC_ALLOCATE(&slots, schedule.nreplicas);
 
 	int* permutations;
-	OQMC_ALLOCATE(&permutations, pixelFrame.size());
+	OQMC_ALLOCATE(&permutations, blockFrame.size());
 
 	float* errors;
 	OQMC_ALLOCATE(&errors, errorFrame.size());
 
+	std::uint32_t* startKeys;
+	OQMC_ALLOCATE(&startKeys, npixels);
+
 	float* distances;
 	OQMC_ALLOCATE(&distances, graphFrame.size());
 
-	// Precompute the distances between all pixels and cache the result, this
-	// prevents the optimiser from needing to compute the distances on the fly
-	// for each iteration.
-	initialiseIndices(pixelFrame, indicesA);
-	initialiseIndices(pixelFrame, indicesB);
-	initialisePermutations(seed, pixelFrame, permutations);
-	initialiseKeys(seed, pixelFrame, keys);
-	initialiseErrors<Sampler>(nsamples, cache, errorFrame, keys, errors);
+	if(resumes(checkpoint, Stage::Keys))
+	{
+		for(int i = 0; i < nstates; ++i)
+		{
+			indicesA[i] = checkpoint.savedIndices[i];
+			indicesB[i] = checkpoint.savedIndices[i];
+		}
+
+		for(int i = 0; i < schedule.nreplicas; ++i)
+		{
+			slots[i] = checkpoint.savedSlots[i];
+		}
+
+		for(int i = 0; i < blockFrame.size(); ++i)
+		{
+			permutations[i] = checkpoint.savedPermutations[i];
+		}
+	}
+	else
+	{
+		for(int i = 0; i < schedule.nreplicas; ++i)
+		{
+			initialiseIndices(pixelFrame, indicesA + i * npixels);
+			initialiseIndices(pixelFrame, indicesB + i * npixels);
+		}
+
+		initialiseSlots(schedule, slots);
+		initialisePermutations(seed, blockFrame, permutations);
+	}
+
+	checkpoint.header.stage = static_cast<int>(Stage::Keys);
+	checkpoint.header.npermutations = blockFrame.size();
+	checkpoint.permutations = permutations;
+	checkpoint.indices = indicesA;
+	checkpoint.slots = slots;
+
+	// Keys stay at the pixel they started at until the end of the stage, as
+	// each replica only moves its indices.
+	for(int i = 0; i < npixels; ++i)
+	{
+		startKeys[i] = keys[i];
+	}
+
+	// Precompute the distances between nearby pixels and cache the result,
+	// this prevents the optimiser from needing to compute the distances on
+	// the fly for each iteration.
+	initialiseErrors<Sampler>(nsamples, cache, errorFrame, startKeys, errors);
 	initialiseDistances(pixelFrame, errorFrame, graphFrame, errors, distances);
 
-	keysOptimise(niterations, seed, pixelFrame, graphFrame, permutations,
-	             distances, indicesA, indicesB, keys);
+	const auto kernelFrame = Kernel(pixelFrame.shape);
+
+	keysOptimise(niterations, seed, schedule, pixelFrame, blockFrame,
+	             graphFrame, kernelFrame, permutations, distances, indicesA,
+	             indicesB, slots, checkpoint);
+
+	// The replica at the coldest temperature is the result.
+	const auto coldest = indicesA + slots[0] * npixels;
+
+	for(int i = 0; i < npixels; ++i)
+	{
+		keys[i] = startKeys[coldest[i]];
+	}
 
 	OQMC_FREE(indicesA);
 	OQMC_FREE(indicesB);
+	OQMC_FREE(slots);
 	OQMC_FREE(permutations);
 	OQMC_FREE(errors);
+	OQMC_FREE(startKeys);
 	OQMC_FREE(distances);
 }
 
-template <bool SwapOrder>
-OQMC_HOST_DEVICE float
-ranksEnergySpatial(Array3d pixelFrame, FullyConnectedGraph graphFrame,
-                   int3 pCoordinate, const bool* swapsA,
-                   const float* distancesHold, const float* distancesSwap)
+// Note that distances are already squared.
+OQMC_HOST_DEVICE float ranksEnergy(Array3d pixelFrame,
+                                   const KernelGraph& graphFrame,
+                                   int3 pCoordinate, const bool* swapsA,
+                                   const float* distancesHold,
+                                   const float* distancesSwap)
 {
-	constexpr auto sigma = 2.1f;
-	constexpr auto sigmaSqr = sigma * sigma;
-	constexpr auto sigmaSqrRcp = 1 / sigmaSqr;
-	constexpr auto sigmaSqrRcpNeg = -sigmaSqrRcp;
+	const auto& kernelFrame = graphFrame.kernel;
 
-	constexpr auto width = 6;
-	constexpr auto min = -width;
-	constexpr auto max = +width;
+	const bool pSwap = swapsA[pixelFrame.index(pCoordinate)];
+	const auto edges = graphFrame.index(pCoordinate, 0);
+	const auto edgesHold = distancesHold + edges;
+	const auto edgesSwap = distancesSwap + edges;
 
-	auto sum = 0.0f;
-	for(int j = min; j < max + 1; ++j)
-	{
-		for(int i = min; i < max + 1; ++i)
-		{
-			const int3 qCoordinate = {
-			    (pCoordinate.x + i) & bitMask(pixelFrame.shape.x),
-			    (pCoordinate.y + j) & bitMask(pixelFrame.shape.y),
-			    pCoordinate.z,
-			};
+	// Edges of both orders are stored in the order of the taps, and each tap
+	// takes the swapped order when only one of the pixels is swapped.
+	const auto swapped = [&](int tap) {
+		const auto qCoordinate = kernelFrame.coordinate(pCoordinate, tap);
 
-			if(pCoordinate == qCoordinate)
-			{
-				continue;
-			}
+		return pSwap != swapsA[pixelFrame.index(qCoordinate)];
+	};
 
-			const bool pSwap = swapsA[pixelFrame.index(pCoordinate)];
-			const bool qSwap = swapsA[pixelFrame.index(qCoordinate)];
+	return kernelSumRows(kernelFrame.size(), kernelFrame.weights, edgesHold,
+	                     edgesSwap, swapped);
+}
 
-			const float* distances;
-			if((pSwap == qSwap) != SwapOrder)
-			{
-				distances = distancesHold;
-			}
-			else
-			{
-				distances = distancesSwap;
-			}
+// Sum the weighted distances of both orders for each pixel. Each tap of the
+// energy of a pixel takes the distance of one order, and swapping the pixel
+// takes the other, so the energy of a swapped pixel is this sum less the
+// energy of the held pixel. This halves the work to test a swap.
+void initialiseSums(Array3d pixelFrame, const KernelGraph& graphFrame,
+                    const float* distancesHold, const float* distancesSwap,
+                    float* sums)
+{
+	const auto& kernelFrame = graphFrame.kernel;
 
-			const FullyConnectedGraph::CoordinatePair pair = {
-			    pCoordinate,
-			    qCoordinate,
-			};
+	const auto func = [=] OQMC_HOST_DEVICE(std::size_t idx) {
+		const auto coordinate = pixelFrame.coordinate(idx);
+		const auto edges = graphFrame.index(coordinate, 0);
 
-			// Note that distances are already squared.
-			const auto sampleDistance = distances[graphFrame.index(pair)];
-			const auto pixelDistance =
-			    std::exp((i * i + j * j) * sigmaSqrRcpNeg);
+		sums[idx] = kernelSum(kernelFrame, [&](int tap) {
+			return distancesHold[edges + tap] + distancesSwap[edges + tap];
+		});
+	};
 
-			sum += sampleDistance * pixelDistance;
-		}
-	}
+	const auto begin = 0;
+	const auto end = pixelFrame.size();
 
-	return sum;
+	OQMC_FORLOOP(func, begin, end);
 }
 
-template <bool SwapOrder>
-OQMC_HOST_DEVICE float
-ranksEnergy(Array3d pixelFrame, FullyConnectedGraph graphFrame,
-            int3 pCoordinate, const bool* swapsA, const float* distancesHold,
-            const float* distancesSwap)
+// Sum the energy of every pixel for each replica.
+void ranksTotals(int nreplicas, Array3d pixelFrame,
+                 const KernelGraph& graphFrame,
+                 const bool* swaps, const float* distancesHold,
+                 const float* distancesSwap, float* energies, double* totals)
 {
-	return ranksEnergySpatial<SwapOrder>(pixelFrame, graphFrame, pCoordinate,
-	                                     swapsA, distancesHold, distancesSwap);
+	const auto npixels = pixelFrame.size();
+
+	const auto func = [=] OQMC_HOST_DEVICE(std::size_t idx) {
+		const auto replica = idx / npixels;
+		const auto coordinate = pixelFrame.coordinate(idx % npixels);
+
+		energies[idx] = ranksEnergy(pixelFrame, graphFrame, coordinate,
+		                                   swaps + replica * npixels,
+		                                   distancesHold, distancesSwap);
+	};
+
+	const auto begin = 0;
+	const auto end = npixels * nreplicas;
+
+	OQMC_FORLOOP(func, begin, end);
+
+	for(int i = 0; i < nreplicas; ++i)
+	{
+		totals[i] = 0;
+
+		for(int j = 0; j < npixels; ++j)
+		{
+			totals[i] += energies[i * npixels + j];
+		}
+	}
 }
 
-void ranksOptimise(int niterations, int& seed, Array3d pixelFrame,
-                   FullyConnectedGraph graphFrame, const int* permutations,
-                   const float* distancesHold, const float* distancesSwap,
-                   bool* swapsA, bool* swapsB)
+// Swaps and slots hold the state of each replica.
+void ranksOptimise(int niterations, int& seed, Schedule schedule,
+                   Array3d pixelFrame, const KernelGraph& graphFrame,
+                   const int* permutations, const float* distancesHold,
+                   const float* distancesSwap, const float* sums,
+                   bool* swapsA, bool* swapsB, int* slots,
+                   Checkpoint& checkpoint)
 {
+	const auto replicaPixels = pixelFrame.size() / 4 /*quarter image*/;
+	const auto npixels = pixelFrame.size();
+	const auto annealing = schedule.start > 0;
+
+	float* temperatures;
+	OQMC_ALLOCATE(&temperatures, schedule.nreplicas);
+
+	float* energies;
+	OQMC_ALLOCATE(&energies, npixels * schedule.nreplicas);
+
+	std::vector<double> totals(schedule.nreplicas);
+
+	// Temperatures are relative to the mean energy of a pixel before any ranks
+	// have been swapped, which is the same when resuming.
+	auto scale = 0.0;
+	if(annealing)
+	{
+		bool* none;
+		OQMC_ALLOCATE(&none, npixels);
+
+		initialiseSwaps(pixelFrame, none);
+		ranksTotals(1, pixelFrame, graphFrame, none, distancesHold,
+		            distancesSwap, energies, totals.data());
+		scale = totals[0] / npixels;
+
+		OQMC_FREE(none);
+	}
+
+	std::uint32_t state;
+	const auto first = startCheckpoint(checkpoint, seed, state);
+
 	auto start = oqmc_progress_start("Optimising ranks:", niterations);
-	auto state = oqmc::pcg::init(seed++);
 
-	for(int i = 0; i < niterations; ++i)
+	for(int i = first; i < niterations; ++i)
 	{
 		const auto rnd = oqmc::pcg::rng(state) & bitMask(pixelFrame.size());
+		const auto anneal = annealing ? oqmc::pcg::rng(state) : 0;
+
+		replicaTemperatures(schedule, i, niterations, scale, slots,
+		                    temperatures);
 
 		const auto func = [=] OQMC_HOST_DEVICE(std::size_t idx) {
-			const auto index = permutations[idx] ^ rnd;
+			const auto replica = idx / replicaPixels;
+			const auto index = permutations[idx % replicaPixels] ^ rnd;
 			const auto coordinate = pixelFrame.coordinate(index);
 
+			const auto replicaA = swapsA + replica * npixels;
+			const auto replicaB = swapsB + replica * npixels;
+
 			const auto last =
-			    ranksEnergy<false>(pixelFrame, graphFrame, coordinate, swapsA,
-			                       distancesHold, distancesSwap);
+			    ranksEnergy(pixelFrame, graphFrame, coordinate, replicaA,
+			                distancesHold, distancesSwap);
 
-			const auto next =
-			    ranksEnergy<true>(pixelFrame, graphFrame, coordinate, swapsA,
-			                      distancesHold, distancesSwap);
+			const auto next = sums[index] - last;
 
-			if(next > last)
+			if(accept(last, next, temperatures[replica], anneal + idx))
 			{
-				swapsB[index] = !swapsB[index];
+				replicaB[index] = !replicaB[index];
 			}
 		};
 
 		const auto begin = 0;
-		const auto end = pixelFrame.size() / 4 /*quarter image*/;
+		const auto end = replicaPixels * schedule.nreplicas;
 
 		OQMC_FORLOOP(func, begin, end);
-		OQMC_MEMCPY(swapsA, swapsB, sizeof(bool) * pixelFrame.size());
+		OQMC_MEMCPY(swapsA, swapsB,
+		            sizeof(bool) * npixels * schedule.nreplicas);
+
+		if(schedule.nreplicas > 1 && (i + 1) % exchangeInterval == 0)
+		{
+			ranksTotals(schedule.nreplicas, pixelFrame, graphFrame, swapsA,
+			            distancesHold, distancesSwap, energies, totals.data());
+			exchangeReplicas(schedule, i, niterations,
+			                 (i + 1) / exchangeInterval, scale, totals.data(),
+			                 state, slots);
+		}
+
+		updateCheckpoint(checkpoint, i + 1, seed, state);
 
 		oqmc_progress_add("Optimising ranks:", niterations, i + 1, start);
 	}
 
 	oqmc_progress_end();
+
+	OQMC_FREE(temperatures);
+	OQMC_FREE(energies);
 }
 
 template <typename Sampler>
 void ranksRun(int niterations, int nsamples, int& seed, const void* cache,
-              Array3d pixelFrame, Array3d errorFrame,
-              FullyConnectedGraph graphFrame, const std::uint32_t* keys,
-              std::uint32_t* ranks)
+              Schedule schedule, Array3d pixelFrame, Array3d errorFrame,
+              const KernelGraph& graphFrame, const std::uint32_t* keys,
+              std::uint32_t* ranks, Checkpoint& checkpoint)
 {
+	const auto npixels = pixelFrame.size();
+	const auto nstates = npixels * schedule.nreplicas;
+
 	bool* swapsA;
-	OQMC_ALLOCATE(&swapsA, pixelFrame.size());
+	OQMC_ALLOCATE(&swapsA, nstates);
 
 	bool* swapsB;
-	OQMC_ALLOCATE(&swapsB, pixelFrame.size());
+	OQMC_ALLOCATE(&swapsB, nstates);
+
+	int* slots;
+	OQMC_ALLOCATE(&slots, schedule.nreplicas);
 
 	int* permutations;
 	OQMC_ALLOCATE(&permutations, pixelFrame.size());
@@ -779,16 +1838,64 @@ void ranksRun(int niterations, int nsamples, int& seed, const void* cache,
 	float* distancesSwap;
 	OQMC_ALLOCATE(&distancesSwap, graphFrame.size());
 
-	initialisePermutations(seed, pixelFrame, permutations);
-	initialiseRanks(pixelFrame, ranks);
+	float* sums;
+	OQMC_ALLOCATE(&sums, npixels);
+
+	if(resumes(checkpoint, Stage::Ranks))
+	{
+		for(int i = 0; i < pixelFrame.size(); ++i)
+		{
+			permutations[i] = checkpoint.savedPermutations[i];
+		}
+	}
+	else
+	{
+		initialisePermutations(seed, pixelFrame, permutations);
+	}
+
+	checkpoint.header.stage = static_cast<int>(Stage::Ranks);
+	checkpoint.header.npermutations = pixelFrame.size();
+	checkpoint.permutations = permutations;
+	checkpoint.swaps = swapsA;
+	checkpoint.slots = slots;
 
 	// Iterate over all power-of-two sample counts.
 	for(int i = nsamples >> 1; i > 0; i = i >> 1)
 	{
+		// Ranks already hold the result of sample counts that were completed
+		// before the checkpoint was written.
+		if(checkpoint.resume && i > checkpoint.header.count)
+		{
+			continue;
+		}
+
 		fprintf(stderr, "Processing ranks for %i samples.\n", i);
 
-		initialiseSwaps(pixelFrame, swapsA);
-		initialiseSwaps(pixelFrame, swapsB);
+		if(checkpoint.resume)
+		{
+			for(int j = 0; j < nstates; ++j)
+			{
+				swapsA[j] = checkpoint.savedSwaps[j];
+				swapsB[j] = checkpoint.savedSwaps[j];
+			}
+
+			for(int j = 0; j < schedule.nreplicas; ++j)
+			{
+				slots[j] = checkpoint.savedSlots[j];
+			}
+		}
+		else
+		{
+			for(int j = 0; j < schedule.nreplicas; ++j)
+			{
+				initialiseSwaps(pixelFrame, swapsA + j * npixels);
+				initialiseSwaps(pixelFrame, swapsB + j * npixels);
+			}
+
+			initialiseSlots(schedule, slots);
+		}
+
+		checkpoint.header.count = i;
 
 		constexpr auto hold = false;
 		constexpr auto swap = true;
@@ -798,7 +1905,7 @@ void ranksRun(int niterations, int nsamples, int& seed, const void* cache,
 		initialiseErrors<Sampler, swap>(i, cache, errorFrame, keys, ranks,
 		                                errorsSwap);
 
-		// Precompute the distances between all pixels and cache the result,
+		// Precompute the distances between nearby pixels and cache the result,
 		// this prevents the optimiser from needing to compute the distances on
 		// the fly for each iteration. Twice as many connections exist fort rank
 		// optimisation as there needs to be a distance for the swaped, and non
@@ -807,13 +1914,19 @@ void ranksRun(int niterations, int nsamples, int& seed, const void* cache,
 		                          errorsHold, errorsSwap, distancesHold);
 		initialiseDistances<swap>(pixelFrame, errorFrame, graphFrame,
 		                          errorsHold, errorsSwap, distancesSwap);
+		initialiseSums(pixelFrame, graphFrame, distancesHold, distancesSwap,
+		               sums);
 
-		ranksOptimise(niterations, seed, pixelFrame, graphFrame, permutations,
-		              distancesHold, distancesSwap, swapsA, swapsB);
+		ranksOptimise(niterations, seed, schedule, pixelFrame, graphFrame,
+		              permutations, distancesHold, distancesSwap, sums,
+		              swapsA, swapsB, slots, checkpoint);
 
-		for(int j = 0; j < pixelFrame.size(); ++j)
+		// The replica at the coldest temperature is the result.
+		const auto coldest = swapsA + slots[0] * npixels;
+
+		for(int j = 0; j < npixels; ++j)
 		{
-			if(swapsA[j])
+			if(coldest[j])
 			{
 				ranks[j] ^= i;
 			}
@@ -826,11 +1939,13 @@ void ranksRun(int niterations, int nsamples, int& seed, const void* cache,
 
 	OQMC_FREE(swapsA);
 	OQMC_FREE(swapsB);
+	OQMC_FREE(slots);
 	OQMC_FREE(permutations);
 	OQMC_FREE(errorsHold);
 	OQMC_FREE(errorsSwap);
 	OQMC_FREE(distancesHold);
 	OQMC_FREE(distancesSwap);
+	OQMC_FREE(sums);
 }
 
 struct Output
@@ -865,36 +1980,116 @@ void output(int nsamples, const void* cache, Array3d pixelFrame,
 }
 
 template <typename Sampler>
-void run(int ntests, int niterations, int nsamples, int resolution, int seed,
+void run(int ntests, int niterations, int nsamples, int resolution, int depth,
+         int nlevels, int seed, Schedule schedule, Checkpoint& checkpoint,
          Output out)
 {
 	const auto cache = Sampler::initialiseCache();
 
-	const auto pixelFrame = Array3d({resolution, resolution, 1});
+	const auto pixelFrame = Array3d({resolution, resolution, depth});
 	const auto errorFrame = Array3d({pixelFrame.size(), ntests, 1});
-	const auto graphFrame = FullyConnectedGraph(pixelFrame.shape);
 
-	const auto pixelCost = pixelFrame.size() * 4 * 5 / 1000000.f;
+	// Keys move, so the graph for keys must reach the pixels that neighbouring
+	// keys could have started at. Ranks stay at the same pixel.
+	const auto keysGraphFrame = WindowedGraph(
+	    pixelFrame.shape, kernelWidth + travelWidth * 2 /*both keys*/);
+	const auto ranksGraphFrame = KernelGraph(pixelFrame.shape);
+
+	const auto pixelCost =
+	    pixelFrame.size() * 4 * (3 + 3 * schedule.nreplicas) / 1000000.f;
 	const auto errorCost = errorFrame.size() * 4 * 2 / 1000000.f;
-	const auto graphCost = graphFrame.size() * 4 * 2 / 1000000.f;
+	const auto graphCost = std::max(keysGraphFrame.size() * 4 * 1,
+	                                ranksGraphFrame.size() * 4 * 2) /
+	                       1000000.f;
 
 	fprintf(stderr,
-	        "Using %i tests, %i iterations, %i samples, %i resolution"
-	        "; Memory cost is %.2fMB.\n",
-	        ntests, niterations, nsamples, resolution,
-	        pixelCost + errorCost + graphCost);
+	        "Using %i tests, %i iterations, %i samples, %i resolution, %i depth"
+	        ", %i levels, %i replicas; Memory cost is %.2fMB.\n",
+	        ntests, niterations, nsamples, resolution, depth, nlevels,
+	        schedule.nreplicas, pixelCost + errorCost + graphCost);
+
+	std::uint32_t* keys = nullptr;
+	std::uint32_t* ranks = nullptr;
+
+	// Optimise from the coarsest level to the finest, where each level has
+	// twice the resolution of the last, and starts from its upsampled result.
+	// Large scale structure is then found at a low cost on coarse levels, and
+	// only refined on fine levels. Iterations are shared between the levels,
+	// so that each level has a similar cost.
+	for(int level = nlevels - 1; level >= 0; --level)
+	{
+		if(checkpoint.resume && level > checkpoint.header.level)
+		{
+			continue;
+		}
 
-	std::uint32_t* keys;
-	OQMC_ALLOCATE(&keys, pixelFrame.size());
+		checkpoint.header.level = level;
 
-	std::uint32_t* ranks;
-	OQMC_ALLOCATE(&ranks, pixelFrame.size());
+		const auto levelResolution = resolution >> level;
+
+		// Each coarser level has a quarter of the pixels to process.
+		const auto levelIterations = std::max(niterations / nlevels, 1)
+		                             << (level * 2);
+
+		fprintf(stderr, "Processing level with %i resolution.\n",
+		        levelResolution);
+
+		const auto levelPixelFrame =
+		    Array3d({levelResolution, levelResolution, depth});
+		const auto levelErrorFrame =
+		    Array3d({levelPixelFrame.size(), ntests, 1});
+		const auto levelKeysGraphFrame =
+		    WindowedGraph(levelPixelFrame.shape, kernelWidth + travelWidth * 2);
+		const auto levelRanksGraphFrame = KernelGraph(levelPixelFrame.shape);
+
+		std::uint32_t* levelKeys;
+		OQMC_ALLOCATE(&levelKeys, levelPixelFrame.size());
+
+		std::uint32_t* levelRanks;
+		OQMC_ALLOCATE(&levelRanks, levelPixelFrame.size());
+
+		if(checkpoint.resume)
+		{
+			assert(checkpoint.header.npixels == levelPixelFrame.size());
+
+			for(int i = 0; i < levelPixelFrame.size(); ++i)
+			{
+				levelKeys[i] = checkpoint.savedKeys[i];
+				levelRanks[i] = checkpoint.savedRanks[i];
+			}
+		}
+		else if(keys)
+		{
+			initialiseUpsample(seed, levelPixelFrame, keys, ranks, levelKeys,
+			                   levelRanks);
+
+			OQMC_FREE(keys);
+			OQMC_FREE(ranks);
+		}
+		else
+		{
+			initialiseKeys(seed, levelPixelFrame, levelKeys);
+			initialiseRanks(levelPixelFrame, levelRanks);
+		}
+
+		keys = levelKeys;
+		ranks = levelRanks;
 
-	keysRun<Sampler>(niterations, nsamples, seed, cache, pixelFrame, errorFrame,
-	                 graphFrame, keys);
+		checkpoint.header.npixels = levelPixelFrame.size();
+		checkpoint.keys = keys;
+		checkpoint.ranks = ranks;
 
-	ranksRun<Sampler>(niterations, nsamples, seed, cache, pixelFrame,
-	                  errorFrame, graphFrame, keys, ranks);
+		if(!resumes(checkpoint, Stage::Ranks))
+		{
+			keysRun<Sampler>(levelIterations, nsamples, seed, cache, schedule,
+			                 levelPixelFrame, levelErrorFrame,
+			                 levelKeysGraphFrame, keys, checkpoint);
+		}
+
+		ranksRun<Sampler>(levelIterations, nsamples, seed, cache, schedule,
+		                  levelPixelFrame, levelErrorFrame,
+		                  levelRanksGraphFrame, keys, ranks, checkpoint);
+	}
 
 	output<Sampler>(nsamples, cache, pixelFrame, keys, ranks, out);
 
@@ -985,7 +2180,10 @@ struct Lattice
 // Note that not all randomisation methods optimise as well as others, for more
 // details see the original paper.
 OQMC_CABI bool oqmc_optimise(const char* name, int ntests, int niterations,
-                             int nsamples, int resolution, int seed,
+                             int nsamples, int resolution, int depth,
+                             int nlevels, int seed, float temperatureStart,
+                             float temperatureEnd, int nreplicas,
+                             const char* checkpoint, int interval, bool resume,
                              uint32_t* keys, uint32_t* ranks, float* estimates,
                              float* frequencies)
 {
@@ -995,6 +2193,16 @@ OQMC_CABI bool oqmc_optimise(const char* name, int ntests, int niterations,
 	assert(isPowerOfTwo(nsamples));
 	assert(resolution > 0);
 	assert(isPowerOfTwo(resolution));
+	assert(depth > 0);
+	assert(isPowerOfTwo(depth));
+	assert(nlevels > 0);
+	assert((resolution >> (nlevels - 1)) > 0);
+	assert(temperatureStart >= 0);
+	assert(temperatureStart == 0 || temperatureEnd > 0);
+	assert(nreplicas > 0);
+	assert(nreplicas == 1 || temperatureStart > 0);
+	assert(interval >= 0);
+	assert(checkpoint || !resume);
 	assert(keys);
 	assert(ranks);
 	assert(estimates);
@@ -1002,9 +2210,49 @@ OQMC_CABI bool oqmc_optimise(const char* name, int ntests, int niterations,
 
 	OQMC_MAYBE_UNUSED(isPowerOfTwo);
 
+	const auto schedule = Schedule{temperatureStart, temperatureEnd, nreplicas};
+
+	Checkpoint checkpointState = {};
+	checkpointState.path = checkpoint;
+	checkpointState.interval = interval;
+	checkpointState.last = std::chrono::steady_clock::now();
+
+	auto& header = checkpointState.header;
+	header.magic = checkpointMagic;
+	header.version = checkpointVersion;
+	std::strncpy(header.name, name, sizeof(header.name) - 1);
+	header.ntests = ntests;
+	header.niterations = niterations;
+	header.nsamples = nsamples;
+	header.resolution = resolution;
+	header.depth = depth;
+	header.nlevels = nlevels;
+	header.seed = seed;
+	header.start = temperatureStart;
+	header.end = temperatureEnd;
+	header.nreplicas = nreplicas;
+
+	if(resume)
+	{
+		const auto expected = header;
+
+		if(!readCheckpoint(checkpointState, expected))
+		{
+			fprintf(stderr,
+			        "Checkpoint file '%s' could not be read, or was written "
+			        "with different arguments.\n",
+			        checkpoint);
+
+			return false;
+		}
+
+		checkpointState.resume = true;
+	}
+
 	if(std::string(name) == "pmj")
 	{
-		run<Pmj>(ntests, niterations, nsamples, resolution, seed,
+		run<Pmj>(ntests, niterations, nsamples, resolution, depth, nlevels,
+		         seed, schedule, checkpointState,
 		         {keys, ranks, estimates, frequencies});
 
 		return true;
@@ -1012,7 +2260,8 @@ OQMC_CABI bool oqmc_optimise(const char* name, int ntests, int niterations,
 
 	if(std::string(name) == "sobol")
 	{
-		run<Sobol>(ntests, niterations, nsamples, resolution, seed,
+		run<Sobol>(ntests, niterations, nsamples, resolution, depth, nlevels,
+		           seed, schedule, checkpointState,
 		           {keys, ranks, estimates, frequencies});
 
 		return true;
@@ -1020,7 +2269,8 @@ OQMC_CABI bool oqmc_optimise(const char* name, int ntests, int niterations,
 
 	if(std::string(name) == "lattice")
 	{
-		run<Lattice>(ntests, niterations, nsamples, resolution, seed,
+		run<Lattice>(ntests, niterations, nsamples, resolution, depth, nlevels,
+		             seed, schedule, checkpointState,
 		             {keys, ranks, estimates, frequencies});
 
 		return true;
@@ -9,6 +9,9 @@
 
 // NOLINTNEXTLINE: C style naming
 OQMC_CABI bool oqmc_optimise(const char* name, int ntests, int niterations,
-                             int nsamples, int resolution, int seed,
+                             int nsamples, int resolution, int depth,
+                             int nlevels, int seed, float temperatureStart,
+                             float temperatureEnd, int nreplicas,
+                             const char* checkpoint, int interval, bool resume,
                              uint32_t* keys, uint32_t* ranks, float* estimates,
                              float* frequencies);
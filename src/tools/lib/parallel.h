@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <oqmc/unused.h>
+
 #include <cassert>
 #include <cstddef>
 #include <cstdlib>
@@ -65,6 +67,30 @@ __global__ void kernel(Func func, size_t begin, size_t end)
 	}
 }
 
+// Device threads are managed by the launch configuration, so the host thread
+// count has no effect.
+template <typename Func>
+auto limitThreads(int nthreads, Func func) -> decltype(func())
+{
+	OQMC_MAYBE_UNUSED(nthreads);
+
+	return func();
+}
+
+// Loop function passed to the initialisation of sampler caches. Caches are
+// initialised on the host, so ranges run serially in the calling thread.
+struct HostLoop
+{
+	template <typename Func>
+	void operator()(int size, Func func) const
+	{
+		for(int i = 0; i < size; ++i)
+		{
+			func(i);
+		}
+	}
+};
+
 #define OQMC_HANDLE_ERROR(ERROR) handleError(ERROR, __FILE__, __LINE__)
 #define OQMC_ALLOCATE(PTR, SIZE) OQMC_HANDLE_ERROR(allocate(PTR, SIZE))
 #define OQMC_FREE(PTR) OQMC_HANDLE_ERROR(cudaFree(PTR))
@@ -112,6 +138,45 @@ void kernel(Func func, size_t begin, size_t end)
 	oneapi::tbb::parallel_for(range, loop);
 }
 
+// Run a strided loop function, as would be called by each thread of a device
+// kernel, using all threads in the current arena. The number of strides is a
+// multiple of the thread count, so that the scheduler can balance the load.
+template <typename Func>
+void strided(Func func)
+{
+	const int stride = oneapi::tbb::this_task_arena::max_concurrency() * 4;
+
+	const auto loop = [func, stride](int index) { func(index, stride); };
+
+	oneapi::tbb::parallel_for(0, stride, loop);
+}
+
+// Run a function within an arena limited to a given number of threads. A value
+// of zero will use all available threads.
+template <typename Func>
+auto limitThreads(int nthreads, Func func) -> decltype(func())
+{
+	oneapi::tbb::task_arena arena;
+
+	if(nthreads > 0)
+	{
+		arena.initialize(nthreads);
+	}
+
+	return arena.execute(func);
+}
+
+// Loop function passed to the initialisation of sampler caches, which runs
+// independent ranges using all threads in the current arena.
+struct HostLoop
+{
+	template <typename Func>
+	void operator()(int size, Func func) const
+	{
+		oneapi::tbb::parallel_for(0, size, func);
+	}
+};
+
 #define OQMC_ALLOCATE(PTR, SIZE) allocate(PTR, SIZE)
 #define OQMC_FREE(PTR) free(PTR)
 #define OQMC_LAUNCH(kernel, ...) kernel(__VA_ARGS__)
@@ -10,11 +10,14 @@
 #include <oqmc/float.h>
 #include <oqmc/lattice.h>
 #include <oqmc/latticebn.h>
+#include <oqmc/latticestbn.h>
 #include <oqmc/pcg.h>
 #include <oqmc/pmj.h>
 #include <oqmc/pmjbn.h>
+#include <oqmc/pmjstbn.h>
 #include <oqmc/sobol.h>
 #include <oqmc/sobolbn.h>
+#include <oqmc/sobolstbn.h>
 
 #include <cassert>
 #include <cmath>
@@ -313,6 +316,14 @@ bool plotErrorFilterSpace(const char* sampler, Shape shape, int resolution,
 		return true;
 	}
 
+	if(std::string(sampler) == "pmjstbn")
+	{
+		plotErrorFilterSpace<Shape, oqmc::PmjStBnSampler>(
+		    shape, resolution, nsamples, nsigma, sigmaMin, sigmaStep, out);
+
+		return true;
+	}
+
 	if(std::string(sampler) == "sobol")
 	{
 		plotErrorFilterSpace<Shape, oqmc::SobolSampler>(
@@ -329,6 +340,14 @@ bool plotErrorFilterSpace(const char* sampler, Shape shape, int resolution,
 		return true;
 	}
 
+	if(std::string(sampler) == "sobolstbn")
+	{
+		plotErrorFilterSpace<Shape, oqmc::SobolStBnSampler>(
+		    shape, resolution, nsamples, nsigma, sigmaMin, sigmaStep, out);
+
+		return true;
+	}
+
 	if(std::string(sampler) == "lattice")
 	{
 		plotErrorFilterSpace<Shape, oqmc::LatticeSampler>(
@@ -345,6 +364,14 @@ bool plotErrorFilterSpace(const char* sampler, Shape shape, int resolution,
 		return true;
 	}
 
+	if(std::string(sampler) == "latticestbn")
+	{
+		plotErrorFilterSpace<Shape, oqmc::LatticeStBnSampler>(
+		    shape, resolution, nsamples, nsigma, sigmaMin, sigmaStep, out);
+
+		return true;
+	}
+
 	if(std::string(sampler) == "rng")
 	{
 		plotErrorFilterSpace<Shape, RngSampler>(
@@ -480,6 +507,15 @@ bool plotErrorFilterTime(const char* sampler, Shape shape, int resolution,
 		return true;
 	}
 
+	if(std::string(sampler) == "pmjstbn")
+	{
+		plotErrorFilterTime<Shape, oqmc::PmjStBnSampler>(
+		    shape, resolution, depth, nsamples, nsigma, sigmaMin, sigmaStep,
+		    out);
+
+		return true;
+	}
+
 	if(std::string(sampler) == "sobol")
 	{
 		plotErrorFilterTime<Shape, oqmc::SobolSampler>(
@@ -498,6 +534,15 @@ bool plotErrorFilterTime(const char* sampler, Shape shape, int resolution,
 		return true;
 	}
 
+	if(std::string(sampler) == "sobolstbn")
+	{
+		plotErrorFilterTime<Shape, oqmc::SobolStBnSampler>(
+		    shape, resolution, depth, nsamples, nsigma, sigmaMin, sigmaStep,
+		    out);
+
+		return true;
+	}
+
 	if(std::string(sampler) == "lattice")
 	{
 		plotErrorFilterTime<Shape, oqmc::LatticeSampler>(
@@ -516,6 +561,15 @@ bool plotErrorFilterTime(const char* sampler, Shape shape, int resolution,
 		return true;
 	}
 
+	if(std::string(sampler) == "latticestbn")
+	{
+		plotErrorFilterTime<Shape, oqmc::LatticeStBnSampler>(
+		    shape, resolution, depth, nsamples, nsigma, sigmaMin, sigmaStep,
+		    out);
+
+		return true;
+	}
+
 	if(std::string(sampler) == "rng")
 	{
 		plotErrorFilterTime<Shape, RngSampler>(shape, resolution, depth,
@@ -621,6 +675,13 @@ OQMC_CABI bool oqmc_plot_zoneplate(const char* sampler, int nsamples,
 		return true;
 	}
 
+	if(std::string(sampler) == "pmjstbn")
+	{
+		plotZoneplate<oqmc::PmjStBnSampler>(nsamples, resolution, out);
+
+		return true;
+	}
+
 	if(std::string(sampler) == "sobol")
 	{
 		plotZoneplate<oqmc::SobolSampler>(nsamples, resolution, out);
@@ -635,6 +696,13 @@ OQMC_CABI bool oqmc_plot_zoneplate(const char* sampler, int nsamples,
 		return true;
 	}
 
+	if(std::string(sampler) == "sobolstbn")
+	{
+		plotZoneplate<oqmc::SobolStBnSampler>(nsamples, resolution, out);
+
+		return true;
+	}
+
 	if(std::string(sampler) == "lattice")
 	{
 		plotZoneplate<oqmc::LatticeSampler>(nsamples, resolution, out);
@@ -649,6 +717,13 @@ OQMC_CABI bool oqmc_plot_zoneplate(const char* sampler, int nsamples,
 		return true;
 	}
 
+	if(std::string(sampler) == "latticestbn")
+	{
+		plotZoneplate<oqmc::LatticeStBnSampler>(nsamples, resolution, out);
+
+		return true;
+	}
+
 	if(std::string(sampler) == "rng")
 	{
 		plotZoneplate<RngSampler>(nsamples, resolution, out);
@@ -4,6 +4,7 @@
 #pragma once
 
 #include <oqmc/gpu.h>
+#include <oqmc/packet.h>
 #include <oqmc/sampler.h>
 #include <oqmc/state.h>
 #include <oqmc/unused.h>
@@ -15,7 +16,14 @@ class RngImpl
 {
 	friend oqmc::SamplerInterface<RngImpl>;
 
+	// See PacketInterface for public API documentation.
+	template <typename, int>
+	friend class oqmc::PacketInterface;
+
 	static constexpr std::size_t cacheSize = 0;
+	static constexpr std::uint32_t cacheId = 0x241029b2;
+	static constexpr std::uint32_t cacheVersion = 1;
+	static constexpr auto maxDrawValue = 4;
 	static void initialiseCache(void* cache);
 
 	OQMC_HOST_DEVICE RngImpl() = default;
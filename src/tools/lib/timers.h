@@ -0,0 +1,323 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Contributors to the OpenQMC Project.
+
+#pragma once
+
+#include <oqmc/gpu.h>
+#include <oqmc/unused.h>
+
+#include <cstdint>
+#include <cstdio>
+
+#if defined(OQMC_TRACE_TIMERS) && !defined(__CUDACC__)
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#endif
+#endif
+
+// Stages of the path tracer that time is attributed to. Time spent outside of
+// a render function is idle, and is not reported.
+enum Stage
+{
+	stageCamera,
+	stageSampling,
+	stageIntersection,
+	stageLighting,
+	stageMaterial,
+	stageRoulette,
+	stageOther,
+	stageIdle,
+	numStages,
+};
+
+// Scope that attributes the time until it ends to a stage, on the calling
+// thread. Scopes nest, and the time of an inner scope is excluded from the
+// outer scope, so that the stages partition the total time. Each thread keeps
+// its own counts, which are combined when reported.
+//
+// Reading the counter on every scope costs about as much as a small sampler
+// call, so the cost of a scope is measured when the counts are reset, and is
+// subtracted from each stage for the number of times it was entered.
+//
+// Timing is only enabled with the OQMC_TRACE_TIMERS definition on the CPU,
+// otherwise scopes are empty and have no cost.
+class StageScope
+{
+  public:
+	OQMC_HOST_DEVICE explicit StageScope(Stage stage);
+	OQMC_HOST_DEVICE ~StageScope();
+
+	StageScope(const StageScope&) = delete;
+	StageScope& operator=(const StageScope&) = delete;
+
+#if defined(OQMC_TRACE_TIMERS) && !defined(__CUDACC__)
+  private:
+	Stage previous;
+#endif
+};
+
+// Reset the counts of all threads, and measure the cost of a scope.
+void resetStages();
+
+// Print the counts of all threads combined, less the cost of the scopes, as a
+// table of ticks and the share of the total time for each stage.
+void printStages(std::FILE* file);
+
+#if defined(OQMC_TRACE_TIMERS) && !defined(__CUDACC__)
+namespace timers
+{
+
+// Read the time stamp counter. On x86 this counts reference cycles, on ARM it
+// counts the ticks of the generic timer, and elsewhere nanoseconds.
+inline std::uint64_t ticks()
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) ||            \
+    defined(_M_IX86)
+	return __rdtsc();
+#elif defined(__aarch64__)
+	std::uint64_t value;
+	asm volatile("mrs %0, cntvct_el0" : "=r"(value));
+	return value;
+#else
+	using namespace std::chrono;
+	const auto time = steady_clock::now().time_since_epoch();
+	return duration_cast<nanoseconds>(time).count();
+#endif
+}
+
+struct ThreadCounts;
+
+// Counts of threads that are alive, as well as the combined counts of threads
+// that have exited.
+struct Registry
+{
+	std::mutex mutex;
+	std::vector<ThreadCounts*> threads;
+	std::uint64_t retired[numStages] = {};
+	std::uint64_t retiredEntries[numStages] = {};
+	double overhead = 0; // ticks per stage transition
+};
+
+inline Registry& registry()
+{
+	static Registry instance;
+	return instance;
+}
+
+struct ThreadCounts
+{
+	std::uint64_t counts[numStages] = {};
+	std::uint64_t entries[numStages] = {};
+	std::uint64_t last = ticks();
+	Stage current = stageIdle;
+
+	ThreadCounts()
+	{
+		auto& global = registry();
+		const std::lock_guard<std::mutex> lock(global.mutex);
+
+		global.threads.push_back(this);
+	}
+
+	~ThreadCounts()
+	{
+		auto& global = registry();
+		const std::lock_guard<std::mutex> lock(global.mutex);
+
+		for(int i = 0; i < numStages; ++i)
+		{
+			global.retired[i] += counts[i];
+			global.retiredEntries[i] += entries[i];
+		}
+
+		for(auto& thread : global.threads)
+		{
+			if(thread == this)
+			{
+				thread = global.threads.back();
+				global.threads.pop_back();
+				break;
+			}
+		}
+	}
+
+	void enter(Stage stage)
+	{
+		const auto now = ticks();
+
+		counts[current] += now - last;
+		last = now;
+		current = stage;
+
+		++entries[stage];
+	}
+};
+
+inline ThreadCounts& threadCounts()
+{
+	thread_local ThreadCounts instance;
+	return instance;
+}
+
+} // namespace timers
+
+inline StageScope::StageScope(Stage stage)
+{
+	auto& thread = timers::threadCounts();
+
+	previous = thread.current;
+	thread.enter(stage);
+}
+
+inline StageScope::~StageScope()
+{
+	timers::threadCounts().enter(previous);
+}
+
+namespace timers
+{
+
+// Measure the ticks added by each stage transition, using empty scopes on the
+// calling thread. All of the cost is counted towards some stage, so the total
+// of an empty scope is spread over the two transitions it makes. The minimum
+// over several runs excludes interruptions.
+inline double calibrate()
+{
+	constexpr int nruns = 8;
+	constexpr int nscopes = 4096;
+
+	auto best = ~std::uint64_t(0);
+
+	for(int i = 0; i < nruns; ++i)
+	{
+		const auto begin = ticks();
+
+		for(int j = 0; j < nscopes; ++j)
+		{
+			const StageScope scope(stageOther);
+		}
+
+		const auto end = ticks();
+
+		best = end - begin < best ? end - begin : best;
+	}
+
+	return static_cast<double>(best) / (2 * nscopes);
+}
+
+} // namespace timers
+
+inline void resetStages()
+{
+	// Scopes used to calibrate are counted, so this happens before the reset.
+	const auto overhead = timers::calibrate();
+
+	auto& global = timers::registry();
+	const std::lock_guard<std::mutex> lock(global.mutex);
+
+	global.overhead = overhead;
+
+	for(int i = 0; i < numStages; ++i)
+	{
+		global.retired[i] = 0;
+		global.retiredEntries[i] = 0;
+	}
+
+	for(const auto thread : global.threads)
+	{
+		for(int i = 0; i < numStages; ++i)
+		{
+			thread->counts[i] = 0;
+			thread->entries[i] = 0;
+		}
+	}
+}
+
+inline void printStages(std::FILE* file)
+{
+	constexpr const char* names[] = {
+	    "camera",   "sampling", "intersection", "lighting",
+	    "material", "roulette", "other",
+	};
+
+	std::uint64_t counts[numStages];
+	std::uint64_t entries[numStages];
+	double overhead;
+
+	{
+		auto& global = timers::registry();
+		const std::lock_guard<std::mutex> lock(global.mutex);
+
+		for(int i = 0; i < numStages; ++i)
+		{
+			counts[i] = global.retired[i];
+			entries[i] = global.retiredEntries[i];
+		}
+
+		for(const auto thread : global.threads)
+		{
+			for(int i = 0; i < numStages; ++i)
+			{
+				counts[i] += thread->counts[i];
+				entries[i] += thread->entries[i];
+			}
+		}
+
+		overhead = global.overhead;
+	}
+
+	// Remove the cost of the scopes from the stages they were counted in.
+	std::uint64_t removed = 0;
+	for(int i = 0; i < stageIdle; ++i)
+	{
+		const auto cost = static_cast<std::uint64_t>(overhead * entries[i]);
+		const auto clamped = cost < counts[i] ? cost : counts[i];
+
+		counts[i] -= clamped;
+		removed += clamped;
+	}
+
+	std::uint64_t total = 0;
+	for(int i = 0; i < stageIdle; ++i)
+	{
+		total += counts[i];
+	}
+
+	std::fprintf(file, "%-14s %14s %8s\n", "stage", "mticks", "share");
+
+	for(int i = 0; i < stageIdle; ++i)
+	{
+		const auto share = total > 0 ? 100.0 * counts[i] / total : 0.0;
+
+		std::fprintf(file, "%-14s %14.1f %7.2f%%\n", names[i], counts[i] / 1e6,
+		             share);
+	}
+
+	std::fprintf(file, "%-14s %14.1f %7.2f%%\n", "total", total / 1e6, 100.0);
+	std::fprintf(file, "%-14s %14.1f %8s\n", "timers", removed / 1e6, "-");
+}
+#else
+inline StageScope::StageScope(Stage stage)
+{
+	OQMC_MAYBE_UNUSED(stage);
+}
+
+inline StageScope::~StageScope()
+{
+}
+
+inline void resetStages()
+{
+}
+
+inline void printStages(std::FILE* file)
+{
+	OQMC_MAYBE_UNUSED(file);
+}
+#endif
@@ -7,14 +7,21 @@
 #include "parallel.h"
 #include "progress.h"
 #include "rng.h"
+#include "timers.h"
 #include "vector.h"
 #include <oqmc/gpu.h>
+#include <oqmc/float.h>
 #include <oqmc/lattice.h>
 #include <oqmc/latticebn.h>
+#include <oqmc/latticestbn.h>
+#include <oqmc/packet.h>
+#include <oqmc/pcg.h>
 #include <oqmc/pmj.h>
 #include <oqmc/pmjbn.h>
+#include <oqmc/pmjstbn.h>
 #include <oqmc/sobol.h>
 #include <oqmc/sobolbn.h>
+#include <oqmc/sobolstbn.h>
 #include <oqmc/unused.h>
 
 #pragma push
@@ -25,10 +32,16 @@
 #include <glm/gtx/intersect.hpp>
 #pragma pop
 
+#include <algorithm>
 #include <cassert>
+#include <cfloat>
+#include <chrono>
 #include <cmath>
 #include <cstddef>
+#include <cstdio>
+#include <mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace
@@ -45,6 +58,127 @@ OQMC_HOST_DEVICE void swap(T& a, T& b)
 	b = temp;
 }
 
+// Wraps a sampler so that all of its calls, including domain derivation, are
+// timed as the sampling stage. This is only used when timers are enabled.
+template <typename Sampler>
+class TimedSampler
+{
+	Sampler sampler;
+
+	OQMC_HOST_DEVICE TimedSampler(Sampler sampler);
+
+  public:
+	static constexpr std::size_t cacheSize = Sampler::cacheSize;
+	static void initialiseCache(void* cache);
+
+	template <typename ForLoop>
+	static void initialiseCache(void* cache, ForLoop forloop);
+
+	/*AUTO_DEFINED*/ TimedSampler() = default;
+	OQMC_HOST_DEVICE TimedSampler(int x, int y, int frame, int index,
+	                              const void* cache);
+
+	OQMC_HOST_DEVICE TimedSampler newDomain(int key) const;
+	OQMC_HOST_DEVICE TimedSampler newDomainSplit(int key, int size,
+	                                             int index) const;
+	OQMC_HOST_DEVICE TimedSampler newDomainDistrib(int key, int index) const;
+	OQMC_HOST_DEVICE TimedSampler newDomainChain(int key, int index) const;
+
+	template <int Size>
+	OQMC_HOST_DEVICE void drawSample(float sample[Size]) const;
+
+	template <int Size>
+	OQMC_HOST_DEVICE void drawRnd(float rnd[Size]) const;
+};
+
+template <typename Sampler>
+TimedSampler<Sampler>::TimedSampler(Sampler sampler) : sampler(sampler)
+{
+}
+
+template <typename Sampler>
+void TimedSampler<Sampler>::initialiseCache(void* cache)
+{
+	Sampler::initialiseCache(cache);
+}
+
+template <typename Sampler>
+template <typename ForLoop>
+void TimedSampler<Sampler>::initialiseCache(void* cache, ForLoop forloop)
+{
+	Sampler::initialiseCache(cache, forloop);
+}
+
+template <typename Sampler>
+TimedSampler<Sampler>::TimedSampler(int x, int y, int frame, int index,
+                                    const void* cache)
+{
+	const StageScope scope(stageSampling);
+
+	sampler = Sampler(x, y, frame, index, cache);
+}
+
+template <typename Sampler>
+TimedSampler<Sampler> TimedSampler<Sampler>::newDomain(int key) const
+{
+	const StageScope scope(stageSampling);
+
+	return {sampler.newDomain(key)};
+}
+
+template <typename Sampler>
+TimedSampler<Sampler> TimedSampler<Sampler>::newDomainSplit(int key, int size,
+                                                            int index) const
+{
+	const StageScope scope(stageSampling);
+
+	return {sampler.newDomainSplit(key, size, index)};
+}
+
+template <typename Sampler>
+TimedSampler<Sampler> TimedSampler<Sampler>::newDomainDistrib(int key,
+                                                              int index) const
+{
+	const StageScope scope(stageSampling);
+
+	return {sampler.newDomainDistrib(key, index)};
+}
+
+template <typename Sampler>
+TimedSampler<Sampler> TimedSampler<Sampler>::newDomainChain(int key,
+                                                            int index) const
+{
+	const StageScope scope(stageSampling);
+
+	return {sampler.newDomainChain(key, index)};
+}
+
+template <typename Sampler>
+template <int Size>
+void TimedSampler<Sampler>::drawSample(float sample[Size]) const
+{
+	const StageScope scope(stageSampling);
+
+	sampler.template drawSample<Size>(sample);
+}
+
+template <typename Sampler>
+template <int Size>
+void TimedSampler<Sampler>::drawRnd(float rnd[Size]) const
+{
+	const StageScope scope(stageSampling);
+
+	sampler.template drawRnd<Size>(rnd);
+}
+
+#if defined(OQMC_TRACE_TIMERS) && !defined(__CUDACC__)
+template <typename Sampler>
+using Traced = TimedSampler<Sampler>;
+#else
+template <typename Sampler>
+using Traced = Sampler;
+#endif
+
 struct Scene
 {
 	struct Quad
@@ -109,6 +243,13 @@ enum class Method
 	Chain,
 };
 
+enum class Schedule
+{
+	Pass,
+	Tile,
+	Wavefront,
+};
+
 struct Ray
 {
 	glm::vec3 origin;
@@ -208,6 +349,8 @@ template <typename Sampler>
 Ray Camera::generateRay(int x, int y, int xSize, int ySize,
                         Sampler cameraDomain) const
 {
+	const StageScope scope(stageCamera);
+
 	const auto sampleTent = [](float radius, float u) {
 		const auto sampleLinear = [](float u) { return 1 - std::sqrt(u); };
 
@@ -456,6 +599,8 @@ template <typename Sampler>
 Material::Sample Material::sample(const Interaction& event, const Ray& ray,
                                   Sampler materialDomain) const
 {
+	const StageScope scope(stageMaterial);
+
 	auto sample = Material::Sample{
 	    /*evaluation*/ {0, 0, 0},
 	    /*dir*/ {0, 0, 0},
@@ -522,6 +667,320 @@ bool Triangle::intersect(const Ray& ray, Hit& prim) const
 	return false;
 }
 
+struct Bounds
+{
+	glm::vec3 min;
+	glm::vec3 max;
+
+	OQMC_HOST_DEVICE bool intersect(glm::vec3 origin, glm::vec3 rcpDir,
+	                                float distance) const;
+
+	void extend(glm::vec3 point);
+	void extend(const Bounds& bounds);
+	float area() const;
+};
+
+// Slab test of a ray against an axis aligned box, limited to the distance of
+// the closest hit found so far. The min and max functions ignore the NaN values
+// that occur when the ray origin lies on a slab plane parallel to the ray.
+bool Bounds::intersect(glm::vec3 origin, glm::vec3 rcpDir,
+                       float distance) const
+{
+	float near = 0;
+	float far = distance;
+
+	for(int i = 0; i < 3; ++i)
+	{
+		const float t0 = (min[i] - origin[i]) * rcpDir[i];
+		const float t1 = (max[i] - origin[i]) * rcpDir[i];
+
+		near = std::fmax(near, std::fmin(t0, t1));
+		far = std::fmin(far, std::fmax(t0, t1));
+	}
+
+	return near <= far;
+}
+
+void Bounds::extend(glm::vec3 point)
+{
+	min = glm::min(min, point);
+	max = glm::max(max, point);
+}
+
+void Bounds::extend(const Bounds& bounds)
+{
+	min = glm::min(min, bounds.min);
+	max = glm::max(max, bounds.max);
+}
+
+float Bounds::area() const
+{
+	const auto extent = max - min;
+
+	if(extent.x < 0 || extent.y < 0 || extent.z < 0)
+	{
+		return 0;
+	}
+
+	return 2 * (extent.x * extent.y + extent.y * extent.z +
+	            extent.z * extent.x);
+}
+
+Bounds emptyBounds()
+{
+	return {glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX)};
+}
+
+// Bounds of a triangle over the whole shutter interval. Motion is linear, so
+// the union of the bounds at the start and the end encloses the swept volume.
+Bounds triangleBounds(const Triangle& triangle)
+{
+	auto bounds = emptyBounds();
+
+	for(const auto offset : {glm::vec3(), triangle.motion})
+	{
+		bounds.extend(triangle.p0 + offset);
+		bounds.extend(triangle.p1 + offset);
+		bounds.extend(triangle.p2 + offset);
+	}
+
+	return bounds;
+}
+
+// Node of a flattened bounding volume hierarchy. The first child of an interior
+// node directly follows its parent, and the offset gives the second child. A
+// leaf stores the range of triangles it contains.
+struct BvhNode
+{
+	Bounds bounds;
+	int offset; // first triangle of a leaf, or second child of an interior
+	int count;  // number of triangles in a leaf, or zero for an interior
+	int axis;   // split axis of an interior, used to order traversal
+};
+
+// Maximum depth of a leaf in the hierarchy. Traversal pushes one node for each
+// interior node on the path to a leaf, so this bounds the size of its stack.
+constexpr int maxBvhDepth = 64;
+
+// Bounding volume hierarchy construction uses the binned surface area
+// heuristic (SAH) described in 'On fast Construction of SAH-based Bounding
+// Volume Hierarchies' by Ingo Wald. Triangles are partitioned in place, so that
+// each leaf references a contiguous range of the triangle array.
+class BvhBuilder
+{
+	static constexpr int numBins = 16;
+	static constexpr int maxLeafSize = 4;
+	static constexpr float traversalCost = 1;
+	static constexpr float intersectCost = 1;
+
+	struct Primitive
+	{
+		Bounds bounds;
+		glm::vec3 centroid;
+	};
+
+	std::vector<Primitive> primitives;
+	std::vector<int> indices;
+	std::vector<BvhNode> nodes;
+
+	int build(int begin, int end, int depth);
+	int makeLeaf(int begin, int end, const Bounds& bounds);
+
+  public:
+	BvhBuilder(const Triangle* triangles, int numTriangles);
+
+	const std::vector<BvhNode>& getNodes() const;
+	const std::vector<int>& getOrder() const;
+};
+
+BvhBuilder::BvhBuilder(const Triangle* triangles, int numTriangles)
+{
+	primitives.resize(numTriangles);
+	indices.resize(numTriangles);
+
+	for(int i = 0; i < numTriangles; ++i)
+	{
+		const auto bounds = triangleBounds(triangles[i]);
+
+		primitives[i].bounds = bounds;
+		primitives[i].centroid = (bounds.min + bounds.max) * 0.5f;
+		indices[i] = i;
+	}
+
+	nodes.reserve(2 * numTriangles);
+
+	if(numTriangles > 0)
+	{
+		build(0, numTriangles, 0);
+	}
+}
+
+const std::vector<BvhNode>& BvhBuilder::getNodes() const
+{
+	return nodes;
+}
+
+const std::vector<int>& BvhBuilder::getOrder() const
+{
+	return indices;
+}
+
+int BvhBuilder::makeLeaf(int begin, int end, const Bounds& bounds)
+{
+	const int index = nodes.size();
+	nodes.push_back(BvhNode{bounds, begin, end - begin, 0});
+
+	return index;
+}
+
+int BvhBuilder::build(int begin, int end, int depth)
+{
+	auto bounds = emptyBounds();
+	auto centroidBounds = emptyBounds();
+
+	for(int i = begin; i < end; ++i)
+	{
+		bounds.extend(primitives[indices[i]].bounds);
+		centroidBounds.extend(primitives[indices[i]].centroid);
+	}
+
+	const int count = end - begin;
+
+	// Degenerate inputs, such as many coincident triangles, could otherwise
+	// split deeper than traversal supports, so these become a larger leaf.
+	if(count <= 1 || depth == maxBvhDepth)
+	{
+		return makeLeaf(begin, end, bounds);
+	}
+
+	struct Bin
+	{
+		Bounds bounds = emptyBounds();
+		int count = 0;
+	};
+
+	const auto extent = centroidBounds.max - centroidBounds.min;
+
+	const auto binIndex = [&](const Primitive& primitive, int axis) {
+		const auto offset = primitive.centroid[axis] - centroidBounds.min[axis];
+		const int index = numBins * (offset / extent[axis]);
+
+		return index < numBins ? index : numBins - 1;
+	};
+
+	int bestAxis = -1;
+	int bestSplit = 0;
+	float bestCost = intersectCost * count;
+
+	for(int axis = 0; axis < 3; ++axis)
+	{
+		if(extent[axis] <= 0)
+		{
+			continue;
+		}
+
+		Bin bins[numBins];
+
+		for(int i = begin; i < end; ++i)
+		{
+			const auto& primitive = primitives[indices[i]];
+
+			auto& bin = bins[binIndex(primitive, axis)];
+			bin.bounds.extend(primitive.bounds);
+			++bin.count;
+		}
+
+		// Sweep from the right to accumulate the area and count of each
+		// candidate right partition, then from the left to evaluate the cost.
+		float rightArea[numBins];
+		int rightCount[numBins];
+
+		auto accumulated = Bin{};
+		for(int i = numBins - 1; i > 0; --i)
+		{
+			accumulated.bounds.extend(bins[i].bounds);
+			accumulated.count += bins[i].count;
+
+			rightArea[i] = accumulated.bounds.area();
+			rightCount[i] = accumulated.count;
+		}
+
+		accumulated = Bin{};
+		for(int i = 0; i < numBins - 1; ++i)
+		{
+			accumulated.bounds.extend(bins[i].bounds);
+			accumulated.count += bins[i].count;
+
+			if(accumulated.count == 0 || rightCount[i + 1] == 0)
+			{
+				continue;
+			}
+
+			const auto leftCost = accumulated.bounds.area() * accumulated.count;
+			const auto rightCost = rightArea[i + 1] * rightCount[i + 1];
+
+			const auto cost = traversalCost + intersectCost *
+			                                      (leftCost + rightCost) /
+			                                      bounds.area();
+
+			if(cost < bestCost)
+			{
+				bestAxis = axis;
+				bestSplit = i;
+				bestCost = cost;
+			}
+		}
+	}
+
+	const auto median = bestAxis < 0;
+
+	if(median)
+	{
+		if(count <= maxLeafSize)
+		{
+			return makeLeaf(begin, end, bounds);
+		}
+
+		// Splitting is more expensive than intersecting all triangles, but the
+		// leaf would be too large, so fall back to a median split.
+		bestAxis = extent.x > extent.y ? 0 : 1;
+		bestAxis = extent[bestAxis] > extent.z ? bestAxis : 2;
+	}
+
+	const auto axis = bestAxis;
+	auto middle = begin + count / 2;
+
+	if(median)
+	{
+		const auto compare = [&](int a, int b) {
+			return primitives[a].centroid[axis] < primitives[b].centroid[axis];
+		};
+
+		std::nth_element(indices.begin() + begin, indices.begin() + middle,
+		                 indices.begin() + end, compare);
+	}
+	else
+	{
+		const auto isLeft = [&](int index) {
+			return binIndex(primitives[index], axis) <= bestSplit;
+		};
+
+		middle = std::partition(indices.begin() + begin,
+		                        indices.begin() + end, isLeft) -
+		         indices.begin();
+	}
+
+	const int index = nodes.size();
+	nodes.push_back(BvhNode{bounds, 0, 0, bestAxis});
+
+	build(begin, middle, depth + 1);
+	const auto second = build(middle, end, depth + 1);
+
+	nodes[index].offset = second;
+
+	return index;
+}
+
 struct Light
 {
 	glm::vec3 energy;
@@ -563,6 +1022,9 @@ struct Session
 	int numTriangles;
 	Triangle* triangles;
 
+	int numNodes;
+	BvhNode* nodes;
+
 	int numLights;
 	Light* lights;
 
@@ -706,6 +1168,26 @@ Session::Session(const Scene& scene)
 		materials[materialIndex].light = true;
 		++materialIndex;
 	}
+
+	const auto builder = BvhBuilder(triangles, numTriangles);
+	const auto& bvhNodes = builder.getNodes();
+	const auto& bvhOrder = builder.getOrder();
+
+	numNodes = bvhNodes.size();
+	OQMC_ALLOCATE(&nodes, numNodes);
+
+	for(int i = 0; i < numNodes; ++i)
+	{
+		nodes[i] = bvhNodes[i];
+	}
+
+	const auto unordered = std::vector<Triangle>(triangles,
+	                                             triangles + numTriangles);
+
+	for(int i = 0; i < numTriangles; ++i)
+	{
+		triangles[i] = unordered[bvhOrder[i]];
+	}
 }
 
 void Session::release() const
@@ -713,6 +1195,7 @@ void Session::release() const
 	OQMC_FREE(camera);
 	OQMC_FREE(materials);
 	OQMC_FREE(triangles);
+	OQMC_FREE(nodes);
 	OQMC_FREE(lights);
 }
 
@@ -722,6 +1205,8 @@ template <typename Sampler>
 OQMC_HOST_DEVICE bool russianRoulette(glm::vec3 throughput,
                                       Sampler rouletteDomain, float& weight)
 {
+	const StageScope scope(stageRoulette);
+
 	constexpr auto threshold = 0.05f;
 	constexpr auto lowProb = 1e-2f;
 
@@ -747,18 +1232,67 @@ OQMC_HOST_DEVICE bool russianRoulette(glm::vec3 throughput,
 OQMC_HOST_DEVICE bool intersect(const Session& session, const Ray& ray,
                                 Interaction& event)
 {
+	const StageScope scope(stageIntersection);
+
+	glm::vec3 rcpDir;
+	rcpDir.x = 1 / ray.dir.x;
+	rcpDir.y = 1 / ray.dir.y;
+	rcpDir.z = 1 / ray.dir.z;
+
+	int stack[maxBvhDepth];
+	int stackSize = 0;
+	int index = 0;
+
 	bool hit = false;
-	for(int i = 0; i < session.numTriangles; ++i)
+	float distance = FLT_MAX;
+
+	// Traverse the hierarchy depth first, visiting the child on the near side
+	// of the split plane first, so that distant nodes are more often culled.
+	while(session.numNodes > 0)
 	{
-		Hit prim;
-		if(session.triangles[i].intersect(ray, prim))
+		const auto& node = session.nodes[index];
+
+		if(node.bounds.intersect(ray.origin, rcpDir, distance))
 		{
-			if(!hit || prim.t < event.prim.t)
+			if(node.count == 0)
+			{
+				assert(stackSize < maxBvhDepth);
+
+				if(rcpDir[node.axis] < 0)
+				{
+					stack[stackSize++] = index + 1;
+					index = node.offset;
+				}
+				else
+				{
+					stack[stackSize++] = node.offset;
+					index = index + 1;
+				}
+
+				continue;
+			}
+
+			for(int i = node.offset; i < node.offset + node.count; ++i)
 			{
-				hit = true;
-				event.prim = prim;
+				Hit prim;
+				if(session.triangles[i].intersect(ray, prim))
+				{
+					if(!hit || prim.t < event.prim.t)
+					{
+						hit = true;
+						distance = prim.t;
+						event.prim = prim;
+					}
+				}
 			}
 		}
+
+		if(stackSize == 0)
+		{
+			break;
+		}
+
+		index = stack[--stackSize];
 	}
 
 	if(hit)
@@ -822,6 +1356,8 @@ directLighting(const Session& session, Method method, int numLightSamples,
                int maxOpacity, const Ray& pathRay, const Interaction& pathEvent,
                Sampler directDomain)
 {
+	const StageScope scope(stageLighting);
+
 	glm::vec3 direct = glm::vec3();
 	for(int i = 0; i < session.numLights; ++i)
 	{
@@ -882,6 +1418,34 @@ directLighting(const Session& session, Method method, int numLightSamples,
 	return direct;
 }
 
+// Keys of the domains derived for each pixel sample, and at each vertex of a
+// path. These are shared by the recursive and wavefront implementations, so
+// that both draw the same samples.
+namespace pixel
+{
+
+enum DomainKey
+{
+	Camera,
+	Trace,
+};
+
+} // namespace pixel
+
+namespace vertex
+{
+
+enum DomainKey
+{
+	Opacity,
+	Direct,
+	Material,
+	Roulette,
+	Next,
+};
+
+} // namespace vertex
+
 template <typename Sampler>
 OQMC_HOST_DEVICE glm::vec3 trace(const Session& session, Method method,
                                  int numLightSamples, int maxDepth,
@@ -893,14 +1457,7 @@ OQMC_HOST_DEVICE glm::vec3 trace(const Session& session, Method method,
 	glm::vec3 radiance = glm::vec3();
 	for(int depth = 0; depth <= maxDepth; ++depth)
 	{
-		enum DomainKey
-		{
-			Opacity,
-			Direct,
-			Material,
-			Roulette,
-			Next,
-		};
+		using vertex::DomainKey;
 
 		const auto opacityDomain = traceDomain.newDomain(DomainKey::Opacity);
 		const auto materialDomain = traceDomain.newDomain(DomainKey::Material);
@@ -978,17 +1535,516 @@ OQMC_HOST_DEVICE glm::vec3 trace(const Session& session, Method method,
 	return radiance;
 }
 
-namespace scenes
+// Stands in for a sampler domain in the wavefront schedule, and returns values
+// that an earlier stage has already drawn for a packet of paths. This allows
+// the material and roulette functions to be shared with the recursive
+// schedules.
+struct DrawnDomain
 {
+	const float* values;
 
-namespace cameras
+	template <int Size>
+	OQMC_HOST_DEVICE void drawSample(float sample[Size]) const;
+};
+
+template <int Size>
+void DrawnDomain::drawSample(float sample[Size]) const
 {
+	for(int i = 0; i < Size; ++i)
+	{
+		sample[i] = values[i];
+	}
+}
 
-const auto camera = Scene::Camera{
-    /*name*/ "camera",
-    /*pos*/ {278, 273, -2250},
-    /*dir*/ {0, 0, 1},
-    /*up*/ {0, 1, 0},
+// Path state for the wavefront schedule. Each path in a wave owns a fixed slot,
+// and each field is stored in its own array, so that a stage only touches the
+// data it needs. The queue holds the slots of paths that are still active, and
+// shadow rays are stored per queue entry, with a fixed count for each path.
+template <typename Sampler>
+struct Wavefront
+{
+	int capacity;
+	int numShadowRays;
+
+	// Path state, indexed by slot.
+	int* pixel;
+	glm::vec3* origin;
+	glm::vec3* dir;
+	float* time;
+	glm::vec3* throughput;
+	glm::vec3* radiance;
+	bool* computeEmission;
+	bool* doDirect;
+	bool* active;
+	Sampler* domain;
+	Interaction* event;
+	float* materialSample;
+	float* rouletteSample;
+
+	// Active path slots.
+	int size;
+	int* queue;
+
+	// Shadow ray state, indexed by queue entry and shadow ray.
+	glm::vec3* shadowOrigin;
+	glm::vec3* shadowDir;
+	float* shadowTime;
+	Sampler* shadowDomain;
+	glm::vec3* shadowContribution;
+	int* shadowMaterialId;
+	bool* shadowHit;
+
+	Wavefront(int capacity, int numShadowRays);
+	void release() const;
+
+	void compact();
+};
+
+template <typename Sampler>
+Wavefront<Sampler>::Wavefront(int capacity, int numShadowRays)
+    : capacity(capacity), numShadowRays(numShadowRays), size(0)
+{
+	const auto numShadowSlots = capacity * numShadowRays;
+
+	OQMC_ALLOCATE(&pixel, capacity);
+	OQMC_ALLOCATE(&origin, capacity);
+	OQMC_ALLOCATE(&dir, capacity);
+	OQMC_ALLOCATE(&time, capacity);
+	OQMC_ALLOCATE(&throughput, capacity);
+	OQMC_ALLOCATE(&radiance, capacity);
+	OQMC_ALLOCATE(&computeEmission, capacity);
+	OQMC_ALLOCATE(&doDirect, capacity);
+	OQMC_ALLOCATE(&active, capacity);
+	OQMC_ALLOCATE(&domain, capacity);
+	OQMC_ALLOCATE(&event, capacity);
+	OQMC_ALLOCATE(&materialSample, capacity * 2);
+	OQMC_ALLOCATE(&rouletteSample, capacity);
+	OQMC_ALLOCATE(&queue, capacity);
+	OQMC_ALLOCATE(&shadowOrigin, numShadowSlots);
+	OQMC_ALLOCATE(&shadowDir, numShadowSlots);
+	OQMC_ALLOCATE(&shadowTime, numShadowSlots);
+	OQMC_ALLOCATE(&shadowDomain, numShadowSlots);
+	OQMC_ALLOCATE(&shadowContribution, numShadowSlots);
+	OQMC_ALLOCATE(&shadowMaterialId, numShadowSlots);
+	OQMC_ALLOCATE(&shadowHit, numShadowSlots);
+}
+
+template <typename Sampler>
+void Wavefront<Sampler>::release() const
+{
+	OQMC_FREE(pixel);
+	OQMC_FREE(origin);
+	OQMC_FREE(dir);
+	OQMC_FREE(time);
+	OQMC_FREE(throughput);
+	OQMC_FREE(radiance);
+	OQMC_FREE(computeEmission);
+	OQMC_FREE(doDirect);
+	OQMC_FREE(active);
+	OQMC_FREE(domain);
+	OQMC_FREE(event);
+	OQMC_FREE(materialSample);
+	OQMC_FREE(rouletteSample);
+	OQMC_FREE(queue);
+	OQMC_FREE(shadowOrigin);
+	OQMC_FREE(shadowDir);
+	OQMC_FREE(shadowTime);
+	OQMC_FREE(shadowDomain);
+	OQMC_FREE(shadowContribution);
+	OQMC_FREE(shadowMaterialId);
+	OQMC_FREE(shadowHit);
+}
+
+// Remove the slots of inactive paths from the queue, keeping the order of the
+// remaining slots. This runs on the host after a stage has completed.
+template <typename Sampler>
+void Wavefront<Sampler>::compact()
+{
+	auto next = 0;
+	for(int i = 0; i < size; ++i)
+	{
+		if(active[queue[i]])
+		{
+			queue[next++] = queue[i];
+		}
+	}
+
+	size = next;
+}
+
+// Generate a camera ray for each pixel in the wave, and reset the path state.
+template <typename Sampler>
+void generateStage(const Session& session, Wavefront<Sampler> wave, int width,
+                   int height, int frame, int index, int firstPixel,
+                   const void* cache)
+{
+	const auto func = [=] OQMC_HOST_DEVICE(std::size_t slot) {
+		const StageScope scope(stageOther);
+
+		const int idx = firstPixel + slot;
+		const auto x = idx % width;
+		const auto y = idx / width;
+
+		const auto pixelDomain = Sampler(x, y, frame, index, cache);
+
+		const auto cameraDomain =
+		    pixelDomain.newDomain(pixel::DomainKey::Camera);
+		const auto traceDomain = pixelDomain.newDomain(pixel::DomainKey::Trace);
+
+		const auto ray =
+		    session.camera->generateRay(x, y, width, height, cameraDomain);
+
+		wave.pixel[slot] = idx;
+		wave.origin[slot] = ray.origin;
+		wave.dir[slot] = ray.dir;
+		wave.time[slot] = ray.time;
+		wave.throughput[slot] = glm::vec3(1);
+		wave.radiance[slot] = glm::vec3();
+		wave.computeEmission[slot] = true;
+		wave.domain[slot] = traceDomain;
+		wave.queue[slot] = slot;
+	};
+
+	const auto begin = 0;
+	const auto end = wave.size;
+
+	OQMC_FORLOOP(func, begin, end);
+}
+
+// Find the closest opaque hit for each active path.
+template <typename Sampler>
+void intersectStage(const Session& session, int maxOpacity,
+                    Wavefront<Sampler> wave)
+{
+	const auto func = [=] OQMC_HOST_DEVICE(std::size_t i) {
+		const StageScope scope(stageOther);
+
+		const auto slot = wave.queue[i];
+
+		const auto opacityDomain =
+		    wave.domain[slot].newDomain(vertex::DomainKey::Opacity);
+
+		Ray ray;
+		ray.origin = wave.origin[slot];
+		ray.dir = wave.dir[slot];
+		ray.time = wave.time[slot];
+
+		wave.active[slot] = intersectOpacityCheck(
+		    session, maxOpacity, ray, opacityDomain, wave.event[slot]);
+	};
+
+	const auto begin = 0;
+	const auto end = wave.size;
+
+	OQMC_FORLOOP(func, begin, end);
+}
+
+// Add emission for each path, and for materials that use direct lighting set
+// up a shadow ray for each light sample of the path.
+template <typename Sampler>
+void shadeStage(const Session& session, Method method, int numLightSamples,
+                Wavefront<Sampler> wave)
+{
+	const auto func = [=] OQMC_HOST_DEVICE(std::size_t i) {
+		const StageScope scope(stageOther);
+
+		const auto slot = wave.queue[i];
+		const auto& event = wave.event[slot];
+		const auto& material = session.materials[event.prim.materialId];
+
+		if((wave.computeEmission[slot] || !material.light) && !event.exit)
+		{
+			wave.radiance[slot] += wave.throughput[slot] * material.emission;
+		}
+
+		wave.doDirect[slot] = material.doDirectLighting();
+
+		if(!wave.doDirect[slot])
+		{
+			return;
+		}
+
+		const StageScope lighting(stageLighting);
+
+		const auto directDomain =
+		    wave.domain[slot].newDomain(vertex::DomainKey::Direct);
+
+		for(int j = 0; j < session.numLights; ++j)
+		{
+			const auto& light = session.lights[j];
+
+			for(int k = 0; k < numLightSamples; ++k)
+			{
+				auto root = Sampler{};
+
+				switch(method)
+				{
+				case Method::Split:
+					root = directDomain.newDomainSplit(j, numLightSamples, k);
+					break;
+				case Method::Distrib:
+					root = directDomain.newDomainDistrib(j, k);
+					break;
+				case Method::Chain:
+					root = directDomain.newDomainChain(j, k);
+					break;
+				};
+
+				enum DomainKey
+				{
+					Light,
+					Opacity,
+				};
+
+				const auto lightDomain = root.newDomain(DomainKey::Light);
+				const auto opacityDomain = root.newDomain(DomainKey::Opacity);
+
+				float lightSample[2];
+				lightDomain.template drawSample<2>(lightSample);
+
+				float rcpDistSqr;
+				const auto dir =
+				    light.sample(event.pos, lightSample, rcpDistSqr);
+
+				const auto shadowRay =
+				    Ray(event.pos, dir, wave.time[slot], event.normal);
+
+				const auto project = std::abs(glm::dot(dir, event.normal));
+				const auto illuminance = light.emission(dir) * rcpDistSqr;
+
+				const auto shadow =
+				    i * wave.numShadowRays + j * numLightSamples + k;
+
+				wave.shadowOrigin[shadow] = shadowRay.origin;
+				wave.shadowDir[shadow] = shadowRay.dir;
+				wave.shadowTime[shadow] = shadowRay.time;
+				wave.shadowDomain[shadow] = opacityDomain;
+				wave.shadowMaterialId[shadow] = light.materialId;
+				wave.shadowContribution[shadow] =
+				    project * illuminance / static_cast<float>(numLightSamples);
+			}
+		}
+	};
+
+	const auto begin = 0;
+	const auto end = wave.size;
+
+	OQMC_FORLOOP(func, begin, end);
+}
+
+// Trace all shadow rays of the wave, independently of the path they belong to.
+template <typename Sampler>
+void shadowStage(const Session& session, int maxOpacity,
+                 Wavefront<Sampler> wave)
+{
+	const auto func = [=] OQMC_HOST_DEVICE(std::size_t shadow) {
+		const StageScope scope(stageOther);
+
+		const auto slot = wave.queue[shadow / wave.numShadowRays];
+
+		if(!wave.doDirect[slot])
+		{
+			return;
+		}
+
+		const StageScope lighting(stageLighting);
+
+		Ray ray;
+		ray.origin = wave.shadowOrigin[shadow];
+		ray.dir = wave.shadowDir[shadow];
+		ray.time = wave.shadowTime[shadow];
+
+		Interaction shadowEvent;
+		const auto shadowHit =
+		    intersectOpacityCheck(session, maxOpacity, ray,
+		                          wave.shadowDomain[shadow], shadowEvent);
+
+		wave.shadowHit[shadow] =
+		    shadowHit &&
+		    shadowEvent.prim.materialId == wave.shadowMaterialId[shadow] &&
+		    !shadowEvent.exit;
+	};
+
+	const auto begin = 0;
+	const auto end = wave.size * wave.numShadowRays;
+
+	OQMC_FORLOOP(func, begin, end);
+}
+
+// Draw the material and roulette samples for all active paths, a packet of
+// paths at a time. Paths in the queue share the same domain keys up to this
+// vertex, so the domains of a packet are derived together from the pixel of
+// each lane, using the packet sampler API. Two dimensions are drawn for every
+// material, and a material that needs fewer uses the leading values.
+template <typename BaseSampler>
+void drawStage(Wavefront<Traced<BaseSampler>> wave, int width, int frame,
+               int index, int depth, const void* cache)
+{
+	constexpr auto lanes = 8;
+
+	using Packet = oqmc::PacketInterface<BaseSampler, lanes>;
+
+	const auto func = [=] OQMC_HOST_DEVICE(std::size_t packet) {
+		const StageScope scope(stageOther);
+
+		// Pad the last packet by repeating the last path in the queue.
+		int slots[lanes];
+		for(int i = 0; i < lanes; ++i)
+		{
+			const auto entry = static_cast<int>(packet) * lanes + i;
+			slots[i] = wave.queue[entry < wave.size ? entry : wave.size - 1];
+		}
+
+		int x[lanes];
+		int y[lanes];
+		int indices[lanes];
+		for(int i = 0; i < lanes; ++i)
+		{
+			x[i] = wave.pixel[slots[i]] % width;
+			y[i] = wave.pixel[slots[i]] / width;
+			indices[i] = index;
+		}
+
+		float materialSample[2][lanes];
+		float rouletteSample[1][lanes];
+
+		{
+			const StageScope sampling(stageSampling);
+
+			auto traceDomain = Packet(x, y, frame, indices, cache)
+			                       .newDomain(pixel::DomainKey::Trace);
+
+			for(int i = 0; i < depth; ++i)
+			{
+				traceDomain = traceDomain.newDomain(vertex::DomainKey::Next);
+			}
+
+			const auto materialDomain =
+			    traceDomain.newDomain(vertex::DomainKey::Material);
+			const auto rouletteDomain =
+			    traceDomain.newDomain(vertex::DomainKey::Roulette);
+
+			materialDomain.template drawSample<2>(materialSample);
+			rouletteDomain.template drawSample<1>(rouletteSample);
+		}
+
+		for(int i = 0; i < lanes; ++i)
+		{
+			const auto slot = slots[i];
+
+			wave.materialSample[slot * 2 + 0] = materialSample[0][i];
+			wave.materialSample[slot * 2 + 1] = materialSample[1][i];
+			wave.rouletteSample[slot] = rouletteSample[0][i];
+		}
+	};
+
+	const auto begin = 0;
+	const auto end = (wave.size + lanes - 1) / lanes;
+
+	OQMC_FORLOOP(func, begin, end);
+}
+
+// Gather the direct lighting of each path, then sample the material and apply
+// Russian roulette with the drawn samples to continue the path.
+template <typename Sampler>
+void scatterStage(const Session& session, int numLightSamples,
+                  Wavefront<Sampler> wave)
+{
+	const auto func = [=] OQMC_HOST_DEVICE(std::size_t i) {
+		const StageScope scope(stageOther);
+
+		const auto slot = wave.queue[i];
+		const auto& event = wave.event[slot];
+		const auto& material = session.materials[event.prim.materialId];
+
+		auto throughput = wave.throughput[slot];
+
+		if(wave.doDirect[slot])
+		{
+			const StageScope lighting(stageLighting);
+
+			glm::vec3 direct = glm::vec3();
+			for(int j = 0; j < session.numLights * numLightSamples; ++j)
+			{
+				const auto shadow = i * wave.numShadowRays + j;
+
+				if(wave.shadowHit[shadow])
+				{
+					direct += wave.shadowContribution[shadow];
+				}
+			}
+
+			const auto bsdf = glm::vec3(1 / pi) * material.colour;
+
+			wave.radiance[slot] += throughput * bsdf * direct;
+			wave.computeEmission[slot] = false;
+		}
+		else
+		{
+			wave.computeEmission[slot] = true;
+		}
+
+		wave.active[slot] = false;
+
+		Ray ray;
+		ray.origin = wave.origin[slot];
+		ray.dir = wave.dir[slot];
+		ray.time = wave.time[slot];
+
+		const auto materialDomain =
+		    DrawnDomain{wave.materialSample + slot * 2};
+
+		const auto sample = material.sample(event, ray, materialDomain);
+
+		if(!sample.successful)
+		{
+			return;
+		}
+
+		throughput *= sample.evaluation;
+
+		if(throughput == glm::vec3())
+		{
+			return;
+		}
+
+		const auto rouletteDomain = DrawnDomain{wave.rouletteSample + slot};
+
+		float rr;
+		if(!russianRoulette(throughput, rouletteDomain, rr))
+		{
+			return;
+		}
+
+		throughput *= rr;
+
+		const auto next = Ray(event.pos, sample.dir, ray.time, event.normal);
+
+		wave.origin[slot] = next.origin;
+		wave.dir[slot] = next.dir;
+		wave.throughput[slot] = throughput;
+		wave.domain[slot] = wave.domain[slot].newDomain(vertex::DomainKey::Next);
+
+		wave.active[slot] = true;
+	};
+
+	const auto begin = 0;
+	const auto end = wave.size;
+
+	OQMC_FORLOOP(func, begin, end);
+}
+
+namespace scenes
+{
+
+namespace cameras
+{
+
+const auto camera = Scene::Camera{
+    /*name*/ "camera",
+    /*pos*/ {278, 273, -2250},
+    /*dir*/ {0, 0, 1},
+    /*up*/ {0, 1, 0},
     /*filmSize*/ 24,
     /*focalLength*/ 100,
     /*focalDistance*/ 2550,
@@ -1307,6 +2363,208 @@ const auto light = Scene::Light{
 
 } // namespace lights
 
+namespace procedural
+{
+
+// Quad spanning the corner and two edges. The winding is such that the cross
+// product of the two edges gives the outward facing normal.
+Scene::Quad quad(glm::vec3 corner, glm::vec3 u, glm::vec3 v)
+{
+	return {corner, corner + u, corner + u + v, corner + v};
+}
+
+// Latitude and longitude tessellation of a sphere, with rings of quads running
+// from the top pole to the bottom pole. Quads at the poles have a degenerate
+// triangle, which is never intersected.
+Scene::Object sphere(const char* name, const char* material, glm::vec3 centre,
+                     float radius, int numRings, int numSegments)
+{
+	const auto point = [=](int ring, int segment) {
+		const float theta = pi * ring / numRings;
+		const float phi = 2 * pi * segment / numSegments;
+
+		glm::vec3 dir;
+		dir.x = std::sin(theta) * std::cos(phi);
+		dir.y = std::cos(theta);
+		dir.z = std::sin(theta) * std::sin(phi);
+
+		return centre + dir * radius;
+	};
+
+	auto object = Scene::Object{name, material, {0, 0, 0}, {}};
+	object.quads.reserve(numRings * numSegments);
+
+	for(int i = 0; i < numRings; ++i)
+	{
+		for(int j = 0; j < numSegments; ++j)
+		{
+			object.quads.push_back(Scene::Quad{
+			    point(i, j),
+			    point(i, j + 1),
+			    point(i + 1, j + 1),
+			    point(i + 1, j),
+			});
+		}
+	}
+
+	return object;
+}
+
+// Grid of boxes covering the floor of the Cornell box, each with a random
+// height. Boxes have no bottom face, as they sit on the floor.
+Scene::Object blocks(const char* name, const char* material, int gridSize,
+                     float maxHeight)
+{
+	constexpr auto sizeX = 552.0f;
+	constexpr auto sizeZ = 559.2f;
+	constexpr auto fill = 0.7f;
+
+	auto object = Scene::Object{name, material, {0, 0, 0}, {}};
+	object.quads.reserve(gridSize * gridSize * 5);
+
+	auto state = oqmc::pcg::init();
+
+	for(int i = 0; i < gridSize; ++i)
+	{
+		for(int j = 0; j < gridSize; ++j)
+		{
+			const auto rnd = oqmc::uintToFloat(oqmc::pcg::rng(state));
+
+			const auto cellX = sizeX / gridSize;
+			const auto cellZ = sizeZ / gridSize;
+
+			const auto dx = cellX * fill;
+			const auto dy = maxHeight * (0.1f + 0.9f * rnd * rnd);
+			const auto dz = cellZ * fill;
+
+			const auto x0 = cellX * (i + (1 - fill) / 2);
+			const auto z0 = cellZ * (j + (1 - fill) / 2);
+
+			const auto min = glm::vec3(x0, 0, z0);
+			const auto max = glm::vec3(x0 + dx, dy, z0 + dz);
+
+			const auto ex = glm::vec3(dx, 0, 0);
+			const auto ey = glm::vec3(0, dy, 0);
+			const auto ez = glm::vec3(0, 0, dz);
+
+			object.quads.push_back(quad({max.x, min.y, min.z}, ey, ez));
+			object.quads.push_back(quad({min.x, min.y, min.z}, ez, ey));
+			object.quads.push_back(quad({min.x, max.y, min.z}, ez, ex));
+			object.quads.push_back(quad({min.x, min.y, max.z}, ex, ey));
+			object.quads.push_back(quad({min.x, min.y, min.z}, ey, ex));
+		}
+	}
+
+	return object;
+}
+
+// Height field covering the floor of the Cornell box, made from a sum of
+// sinusoids so that it has both broad hills and fine ridges.
+Scene::Object terrain(const char* name, const char* material, int gridSize)
+{
+	constexpr auto sizeX = 552.0f;
+	constexpr auto sizeZ = 559.2f;
+
+	const auto point = [=](int i, int j) {
+		const float x = sizeX * i / gridSize;
+		const float z = sizeZ * j / gridSize;
+
+		float y = 0;
+		y += 20 * (std::sin(x * 0.031f) + 1) * (std::cos(z * 0.027f) + 1);
+		y += 15 * (std::sin(x * 0.11f + z * 0.07f) + 1);
+		y += 2 * (std::sin(x * 0.53f) * std::sin(z * 0.47f) + 1);
+
+		return glm::vec3(x, y, z);
+	};
+
+	auto object = Scene::Object{name, material, {0, 0, 0}, {}};
+	object.quads.reserve(gridSize * gridSize);
+
+	for(int i = 0; i < gridSize; ++i)
+	{
+		for(int j = 0; j < gridSize; ++j)
+		{
+			object.quads.push_back(Scene::Quad{
+			    point(i, j),
+			    point(i, j + 1),
+			    point(i + 1, j + 1),
+			    point(i + 1, j),
+			});
+		}
+	}
+
+	return object;
+}
+
+// Larger scenes place procedural geometry within the walls and light of the
+// Cornell box, so that samplers can be compared at realistic scene sizes.
+Scene cornellShell(std::vector<Scene::Material> materials,
+                   std::vector<Scene::Object> objects)
+{
+	auto scene = Scene{
+	    /*camera*/ cameras::camera,
+	    /*materials*/
+	    {
+	        materials::white,
+	        materials::green,
+	        materials::red,
+	    },
+	    /*objects*/
+	    {
+	        objects::floor,
+	        objects::ceiling,
+	        objects::backWall,
+	        objects::rightWall,
+	        objects::leftWall,
+	    },
+	    /*lights*/
+	    {
+	        lights::light,
+	    },
+	};
+
+	for(auto& material : materials)
+	{
+		scene.materials.push_back(std::move(material));
+	}
+
+	for(auto& object : objects)
+	{
+		scene.objects.push_back(std::move(object));
+	}
+
+	return scene;
+}
+
+// Three spheres of 128x64 quads each, around 49k triangles.
+Scene spheresExample()
+{
+	return cornellShell(
+	    {
+	        materials::metal,
+	        materials::glass,
+	    },
+	    {
+	        sphere("diffuse sphere", "white", {140, 100, 180}, 100, 64, 128),
+	        sphere("metal sphere", "metal", {400, 120, 380}, 120, 64, 128),
+	        sphere("glass sphere", "glass", {330, 80, 120}, 80, 64, 128),
+	    });
+}
+
+// Grid of 48x48 boxes, around 23k triangles.
+Scene blocksExample()
+{
+	return cornellShell({}, {blocks("blocks", "white", 48, 160)});
+}
+
+// Height field of 256x256 quads, around 131k triangles.
+Scene terrainExample()
+{
+	return cornellShell({}, {terrain("terrain", "white", 256)});
+}
+
+} // namespace procedural
+
 // http://www.graphics.cornell.edu/online/box/data.html
 const auto cornellBox = Scene{
     /*camera*/ cameras::camera,
@@ -1410,6 +2668,24 @@ bool getScene(const char* name, Scene& scene)
 		return true;
 	}
 
+	if(std::string(name) == "spheres")
+	{
+		scene = scenes::procedural::spheresExample();
+		return true;
+	}
+
+	if(std::string(name) == "blocks")
+	{
+		scene = scenes::procedural::blocksExample();
+		return true;
+	}
+
+	if(std::string(name) == "terrain")
+	{
+		scene = scenes::procedural::terrainExample();
+		return true;
+	}
+
 	return false;
 }
 
@@ -1436,11 +2712,196 @@ bool getMethod(const char* name, Method& method)
 	return false;
 }
 
-template <typename Sampler>
-bool run(const char* name, const char* mode, int width, int height, int frame,
-         int numPixelSamples, int numLightSamples, int maxDepth, int maxOpacity,
-         float3* out)
+bool getSchedule(const char* name, Schedule& schedule)
+{
+	if(std::string(name) == "pass")
+	{
+		schedule = Schedule::Pass;
+		return true;
+	}
+
+	if(std::string(name) == "tile")
+	{
+		schedule = Schedule::Tile;
+		return true;
+	}
+
+	if(std::string(name) == "wavefront")
+	{
+		schedule = Schedule::Wavefront;
+		return true;
+	}
+
+	return false;
+}
+
+// Render the image one pass at a time, where each pass computes a single
+// sample for all pixels, with a barrier between passes.
+template <typename Func>
+void renderPasses(Func render, int width, int height, int numPixelSamples)
+{
+	auto start = oqmc_progress_start("Tracing image:", numPixelSamples);
+
+	for(int i = 0; i < numPixelSamples; ++i)
+	{
+		const auto func = [=] OQMC_HOST_DEVICE(std::size_t idx) {
+			render(idx % width, idx / width, i);
+		};
+
+		const auto begin = 0;
+		const auto end = width * height;
+
+		OQMC_FORLOOP(func, begin, end);
+
+		oqmc_progress_add("Tracing image:", numPixelSamples, i + 1, start);
+	}
+
+	oqmc_progress_end();
+}
+
+#if defined(__CUDACC__)
+// Device threads are scheduled by the hardware, and a thread per tile would
+// not occupy the device, so tiles fall back to rendering passes.
+template <typename Func>
+void renderTiles(Func render, int width, int height, int numPixelSamples)
+{
+	renderPasses(render, width, height, numPixelSamples);
+}
+#else
+// Render the image one tile at a time, computing all samples of a tile before
+// moving on, so that the image rows and sampler table entries of a tile stay in
+// cache. Tiles are distributed by the TBB scheduler, which balances the load by
+// work stealing, and there is no barrier between samples. Samples of a pixel
+// are still accumulated in order, so the result matches the pass schedule.
+template <typename Func>
+void renderTiles(Func render, int width, int height, int numPixelSamples)
 {
+	constexpr auto tileSize = 16;
+
+	const auto numTilesX = (width + tileSize - 1) / tileSize;
+	const auto numTilesY = (height + tileSize - 1) / tileSize;
+	const auto numTiles = numTilesX * numTilesY;
+
+	auto start = oqmc_progress_start("Tracing image:", numTiles);
+
+	std::mutex mutex;
+	auto numDone = 0;
+
+	const auto loop = [&](const oneapi::tbb::blocked_range<int>& range) {
+		for(auto tile = range.begin(); tile != range.end(); ++tile)
+		{
+			const auto beginX = tile % numTilesX * tileSize;
+			const auto beginY = tile / numTilesX * tileSize;
+			const auto endX = std::min(beginX + tileSize, width);
+			const auto endY = std::min(beginY + tileSize, height);
+
+			for(int i = 0; i < numPixelSamples; ++i)
+			{
+				for(int y = beginY; y < endY; ++y)
+				{
+					for(int x = beginX; x < endX; ++x)
+					{
+						render(x, y, i);
+					}
+				}
+			}
+
+			const std::lock_guard<std::mutex> lock(mutex);
+			oqmc_progress_add("Tracing image:", numTiles, ++numDone, start);
+		}
+	};
+
+	const auto range = oneapi::tbb::blocked_range<int>(0, numTiles, 1);
+	oneapi::tbb::parallel_for(range, loop);
+
+	oqmc_progress_end();
+}
+#endif
+
+// Render the image as a wavefront, where the paths of a wave of pixels advance
+// together one stage at a time, rather than each path running to completion.
+// Terminated paths are removed from the queue between stages. The stages draw
+// the same samples as the recursive trace function, so that the image matches
+// the other schedules.
+template <typename BaseSampler>
+void renderWavefront(const Session& session, Method method,
+                     int numLightSamples, int maxDepth, int maxOpacity,
+                     int width, int height, int frame, int numPixelSamples,
+                     Buffer buffer)
+{
+	using Sampler = Traced<BaseSampler>;
+
+	constexpr auto waveSize = 1 << 16;
+
+	const auto numPixels = width * height;
+	const auto numWaves = (numPixels + waveSize - 1) / waveSize;
+
+	auto wave = Wavefront<Sampler>(std::min(numPixels, waveSize),
+	                               session.numLights * numLightSamples);
+
+	auto start =
+	    oqmc_progress_start("Tracing image:", numPixelSamples * numWaves);
+
+	for(int i = 0; i < numPixelSamples; ++i)
+	{
+		for(int j = 0; j < numWaves; ++j)
+		{
+			const auto firstPixel = j * waveSize;
+
+			wave.size = std::min(waveSize, numPixels - firstPixel);
+
+			const auto count = wave.size;
+
+			generateStage(session, wave, width, height, frame, i, firstPixel,
+			              buffer.cache);
+
+			for(int depth = 0; depth <= maxDepth && wave.size > 0; ++depth)
+			{
+				intersectStage(session, maxOpacity, wave);
+				wave.compact();
+
+				shadeStage(session, method, numLightSamples, wave);
+				shadowStage(session, maxOpacity, wave);
+				drawStage<BaseSampler>(wave, width, frame, i, depth,
+				                       buffer.cache);
+				scatterStage(session, numLightSamples, wave);
+				wave.compact();
+			}
+
+			const auto func = [=] OQMC_HOST_DEVICE(std::size_t slot) {
+				const auto idx = wave.pixel[slot];
+
+				const auto delta =
+				    session.camera->filmExposure(wave.radiance[slot]) -
+				    buffer.image[idx];
+
+				const auto deltaOverN = delta / (i + 1.0f);
+
+				buffer.image[idx] += deltaOverN;
+			};
+
+			const auto begin = 0;
+			const auto end = count;
+
+			OQMC_FORLOOP(func, begin, end);
+
+			oqmc_progress_add("Tracing image:", numPixelSamples * numWaves,
+			                  i * numWaves + j + 1, start);
+		}
+	}
+
+	oqmc_progress_end();
+
+	wave.release();
+}
+
+template <typename BaseSampler>
+bool run(const char* name, const char* mode, const char* order, int width,
+         int height, int frame, int numPixelSamples, int numLightSamples,
+         int maxDepth, int maxOpacity, float3* out, double* time)
+{
+	using Sampler = Traced<BaseSampler>;
+
 	Scene scene;
 	if(!getScene(name, scene))
 	{
@@ -1453,59 +2914,72 @@ bool run(const char* name, const char* mode, int width, int height, int frame,
 		return false;
 	}
 
+	Schedule schedule;
+	if(!getSchedule(order, schedule))
+	{
+		return false;
+	}
+
 	const auto session = Session(scene);
 	const auto numPixels = width * height;
 
 	auto buffer = start<Sampler>(numPixels);
-	Sampler::initialiseCache(buffer.cache);
-
-	auto start = oqmc_progress_start("Tracing image:", numPixelSamples);
+	Sampler::initialiseCache(buffer.cache, HostLoop());
 
 	for(int i = 0; i < numPixels; ++i)
 	{
 		buffer.image[i] = glm::vec3();
 	}
 
-	for(int i = 0; i < numPixelSamples; ++i)
-	{
-		const auto func = [=] OQMC_HOST_DEVICE(std::size_t idx) {
-			const auto x = idx % width;
-			const auto y = idx / width;
+	const auto render = [=] OQMC_HOST_DEVICE(int x, int y, int i) {
+		const StageScope scope(stageOther);
 
-			const auto pixelDomain = Sampler(x, y, frame, i, buffer.cache);
+		const auto idx = y * width + x;
 
-			enum DomainKey
-			{
-				Camera,
-				Trace,
-			};
+		const auto pixelDomain = Sampler(x, y, frame, i, buffer.cache);
 
-			const auto cameraDomain = pixelDomain.newDomain(DomainKey::Camera);
-			const auto traceDomain = pixelDomain.newDomain(DomainKey::Trace);
+		const auto cameraDomain =
+		    pixelDomain.newDomain(pixel::DomainKey::Camera);
+		const auto traceDomain = pixelDomain.newDomain(pixel::DomainKey::Trace);
 
-			const auto ray =
-			    session.camera->generateRay(x, y, width, height, cameraDomain);
+		const auto ray =
+		    session.camera->generateRay(x, y, width, height, cameraDomain);
 
-			const auto radiance = trace(session, method, numLightSamples,
-			                            maxDepth, maxOpacity, ray, traceDomain);
+		const auto radiance = trace(session, method, numLightSamples, maxDepth,
+		                            maxOpacity, ray, traceDomain);
 
-			const auto delta =
-			    session.camera->filmExposure(radiance) - buffer.image[idx];
+		const auto delta =
+		    session.camera->filmExposure(radiance) - buffer.image[idx];
 
-			const auto deltaOverN = delta / (i + 1.0f);
+		const auto deltaOverN = delta / (i + 1.0f);
 
-			buffer.image[idx] += deltaOverN;
-		};
+		buffer.image[idx] += deltaOverN;
+	};
 
-		const auto begin = 0;
-		const auto end = numPixels;
+	resetStages();
 
-		OQMC_FORLOOP(func, begin, end);
+	const auto begin = std::chrono::steady_clock::now();
 
-		oqmc_progress_add("Tracing image:", numPixelSamples, i + 1, start);
-	}
+	switch(schedule)
+	{
+	case Schedule::Pass:
+		renderPasses(render, width, height, numPixelSamples);
+		break;
+	case Schedule::Tile:
+		renderTiles(render, width, height, numPixelSamples);
+		break;
+	case Schedule::Wavefront:
+		renderWavefront<BaseSampler>(session, method, numLightSamples, maxDepth,
+		                         maxOpacity, width, height, frame,
+		                         numPixelSamples, buffer);
+		break;
+	};
 
-	oqmc_progress_end();
+	const auto end = std::chrono::steady_clock::now();
+
+	*time = std::chrono::duration<double>(end - begin).count();
+
+	printStages(stdout);
 
 	for(int i = 0; i < numPixels; ++i)
 	{
@@ -1523,12 +2997,15 @@ bool run(const char* name, const char* mode, int width, int height, int frame,
 } // namespace
 
 OQMC_CABI bool oqmc_trace(const char* name, const char* scene, const char* mode,
-                          int width, int height, int frame, int numPixelSamples,
-                          int numLightSamples, int maxDepth, int maxOpacity,
-                          float3* image)
+                          const char* schedule, int width, int height,
+                          int frame, int numPixelSamples, int numLightSamples,
+                          int maxDepth, int maxOpacity, float3* image,
+                          double* time)
 {
 	assert(name);
 	assert(scene);
+	assert(mode);
+	assert(schedule);
 	assert(width >= 0);
 	assert(height >= 0);
 	assert(numPixelSamples >= 0);
@@ -1536,54 +3013,82 @@ OQMC_CABI bool oqmc_trace(const char* name, const char* scene, const char* mode,
 	assert(maxDepth >= 0);
 	assert(maxOpacity >= 0);
 	assert(image);
+	assert(time);
 
 	if(std::string(name) == "pmj")
 	{
-		return run<oqmc::PmjSampler>(scene, mode, width, height, frame,
-		                             numPixelSamples, numLightSamples, maxDepth,
-		                             maxOpacity, image);
+		return run<oqmc::PmjSampler>(scene, mode, schedule, width, height,
+		                             frame, numPixelSamples, numLightSamples,
+		                             maxDepth, maxOpacity, image, time);
 	}
 
 	if(std::string(name) == "pmjbn")
 	{
-		return run<oqmc::PmjBnSampler>(scene, mode, width, height, frame,
-		                               numPixelSamples, numLightSamples,
-		                               maxDepth, maxOpacity, image);
+		return run<oqmc::PmjBnSampler>(scene, mode, schedule, width, height,
+		                               frame, numPixelSamples, numLightSamples,
+		                               maxDepth, maxOpacity, image, time);
+	}
+
+	if(std::string(name) == "pmjstbn")
+	{
+		return run<oqmc::PmjStBnSampler>(scene, mode, schedule, width, height,
+		                                 frame, numPixelSamples,
+		                                 numLightSamples, maxDepth, maxOpacity,
+		                                 image, time);
 	}
 
 	if(std::string(name) == "sobol")
 	{
-		return run<oqmc::SobolSampler>(scene, mode, width, height, frame,
-		                               numPixelSamples, numLightSamples,
-		                               maxDepth, maxOpacity, image);
+		return run<oqmc::SobolSampler>(scene, mode, schedule, width, height,
+		                               frame, numPixelSamples, numLightSamples,
+		                               maxDepth, maxOpacity, image, time);
 	}
 
 	if(std::string(name) == "sobolbn")
 	{
-		return run<oqmc::SobolBnSampler>(scene, mode, width, height, frame,
-		                                 numPixelSamples, numLightSamples,
-		                                 maxDepth, maxOpacity, image);
+		return run<oqmc::SobolBnSampler>(scene, mode, schedule, width, height,
+		                                 frame, numPixelSamples,
+		                                 numLightSamples, maxDepth, maxOpacity,
+		                                 image, time);
+	}
+
+	if(std::string(name) == "sobolstbn")
+	{
+		return run<oqmc::SobolStBnSampler>(scene, mode, schedule, width, height,
+		                                   frame, numPixelSamples,
+		                                   numLightSamples, maxDepth,
+		                                   maxOpacity, image, time);
 	}
 
 	if(std::string(name) == "lattice")
 	{
-		return run<oqmc::LatticeSampler>(scene, mode, width, height, frame,
-		                                 numPixelSamples, numLightSamples,
-		                                 maxDepth, maxOpacity, image);
+		return run<oqmc::LatticeSampler>(scene, mode, schedule, width, height,
+		                                 frame, numPixelSamples,
+		                                 numLightSamples, maxDepth, maxOpacity,
+		                                 image, time);
 	}
 
 	if(std::string(name) == "latticebn")
 	{
-		return run<oqmc::LatticeBnSampler>(scene, mode, width, height, frame,
-		                                   numPixelSamples, numLightSamples,
-		                                   maxDepth, maxOpacity, image);
+		return run<oqmc::LatticeBnSampler>(scene, mode, schedule, width, height,
+		                                   frame, numPixelSamples,
+		                                   numLightSamples, maxDepth,
+		                                   maxOpacity, image, time);
+	}
+
+	if(std::string(name) == "latticestbn")
+	{
+		return run<oqmc::LatticeStBnSampler>(scene, mode, schedule, width,
+		                                     height, frame, numPixelSamples,
+		                                     numLightSamples, maxDepth,
+		                                     maxOpacity, image, time);
 	}
 
 	if(std::string(name) == "rng")
 	{
-		return run<RngSampler>(scene, mode, width, height, frame,
+		return run<RngSampler>(scene, mode, schedule, width, height, frame,
 		                       numPixelSamples, numLightSamples, maxDepth,
-		                       maxOpacity, image);
+		                       maxOpacity, image, time);
 	}
 
 	return false;
@@ -8,6 +8,7 @@
 
 // NOLINTNEXTLINE: C style naming
 OQMC_CABI bool oqmc_trace(const char* name, const char* scene, const char* mode,
-                          int width, int height, int frame, int numPixelSamples,
-                          int numLightSamples, int maxDepth, int maxOpacity,
-                          float3* image);
+                          const char* schedule, int width, int height,
+                          int frame, int numPixelSamples, int numLightSamples,
+                          int maxDepth, int maxOpacity, float3* image,
+                          double* time);